@@ -0,0 +1,178 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// This benchmark runs the declutter engine on synthetic label sets of increasing size and reports
+// the time needed per label and frame for the projection and the overlap test, with and without
+// the incremental mode. Before measuring, the result of the engine is compared to a brute force
+// implementation of the overlap test to make sure that the optimizations do not change the
+// visible set.
+
+#include "../src/engine/Kernels.hpp"
+#include "../tests/SyntheticLabels.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace csp::anchorlabels;
+using namespace csp::anchorlabels::synthetic;
+
+namespace {
+
+// The sort keys have to stay within their range and must not increase with the distance. If
+// there are enough keys, each label has to get its own.
+bool validateSortKeys(DeclutterEngine const& engine, DeclutterSettings const& settings) {
+  auto const& keys   = engine.getSortKeys();
+  bool const  strict = keys.size() <= settings.mSortKeyRange;
+  int const   minKey = settings.mMaxSortKey - static_cast<int>(settings.mSortKeyRange) + 1;
+
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    if (keys[i] < minKey || keys[i] > settings.mMaxSortKey) {
+      return false;
+    }
+
+    if (i > 0 && (keys[i] > keys[i - 1] || (strict && keys[i] == keys[i - 1]))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Each label which collides with a visible label has to be a member of exactly one cluster.
+bool validateClusters(
+    DeclutterEngine const& engine, LabelStore const& store, DeclutterSettings const& settings) {
+  std::size_t clustered = 0;
+  std::size_t hidden    = 0;
+  for (std::size_t i = 0; i < store.size(); ++i) {
+    clustered += engine.getClusterSize(i);
+    hidden += engine.isVisible(i) || store.isHidden(i) ? 0 : 1;
+  }
+
+  return !settings.mEnableClustering || clustered == hidden;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool validate(LabelStore& store, DeclutterSettings const& settings) {
+  store.project(LABEL_SCALE, LABEL_WIDTH, LABEL_HEIGHT);
+
+  DeclutterEngine engine;
+  engine.update(store, settings);
+
+  if (!validateSortKeys(engine, settings)) {
+    return false;
+  }
+
+  auto reference = computeReference(store, settings);
+  for (std::size_t i = 0; i < store.size(); ++i) {
+    if (engine.isVisible(i) != (reference[i] != 0)) {
+      return false;
+    }
+  }
+
+  if (!validateClusters(engine, store, settings)) {
+    return false;
+  }
+
+  return true;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  std::mt19937 rng(42); // NOLINT
+
+  DeclutterSettings settings;
+  settings.mIgnoreOverlapThreshold = 0.025;
+  settings.mMaxSortKey             = 700;
+  settings.mSortKeyRange           = 50;
+
+  std::printf("Kernels: %s\n", kernels::getInstructionSet());
+  std::printf("%10s %14s %24s %10s %16s %16s\n", "labels", "depth overlap", "mode", "visible",
+      "ns/label/frame", "new keys/frame");
+
+  // In the static scenario, the observer only moves every 20th frame.
+  struct Mode {
+    char const* mName;
+    bool        mIncremental;
+    int         mMotionInterval;
+  };
+
+  std::vector<Mode> modes = {{"full", false, 1}, {"incremental, moving", true, 1},
+      {"incremental, mostly still", true, 20}};
+
+  for (std::size_t count : {10, 100, 1000, 10000, 50000, 100000}) {
+    LabelStore labels;
+    LabelStore store;
+    createLabelsInFront(count, rng, labels);
+
+    for (bool depthOverlap : {true, false}) {
+      settings.mEnableDepthOverlap = depthOverlap;
+
+      // The brute force reference is quadratic, so it is only used for the smaller sets. The
+      // incremental mode only kicks in from the second frame, so it is not used here.
+      if (count <= 10000) {
+        settings.mIncremental = false;
+        rotateLabels(labels, 0.0, store);
+
+        if (!validate(store, settings)) {
+          std::printf("Visible set differs from the reference for %zu labels!\n", count);
+          return 1;
+        }
+      }
+
+      for (auto const& mode : modes) {
+        settings.mIncremental = mode.mIncremental;
+
+        // Run enough frames to get a stable measurement also for the small sets.
+        std::size_t const frames = std::max<std::size_t>(20, 1000000 / count);
+
+        DeclutterEngine          engine;
+        std::chrono::nanoseconds total{0};
+        std::size_t              changedSortKeys = 0;
+
+        for (std::size_t frame = 0; frame < frames; ++frame) {
+          double angle = static_cast<double>(frame / mode.mMotionInterval) * 1e-3;
+          rotateLabels(labels, angle, store);
+
+          auto start = std::chrono::steady_clock::now();
+          store.project(LABEL_SCALE, LABEL_WIDTH, LABEL_HEIGHT);
+          engine.update(store, settings);
+          total += std::chrono::steady_clock::now() - start;
+
+          changedSortKeys += engine.getChangedSortKeyCount();
+          if (!validateSortKeys(engine, settings)) {
+            std::printf("Invalid sort keys for %zu labels!\n", count);
+            return 1;
+          }
+
+          if (!validateClusters(engine, store, settings)) {
+            std::printf("Invalid clusters for %zu labels!\n", count);
+            return 1;
+          }
+        }
+
+        double nsPerLabel =
+            static_cast<double>(total.count()) / static_cast<double>(frames * count);
+        std::printf("%10zu %14s %24s %10zu %16.2f %16.1f\n", count, depthOverlap ? "on" : "off",
+            mode.mName, engine.getVisibleLabels().size(), nsPerLabel,
+            static_cast<double>(changedSortKeys) / static_cast<double>(frames));
+      }
+    }
+  }
+
+  return 0;
+}
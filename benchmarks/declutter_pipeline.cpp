@@ -0,0 +1,250 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// This benchmark moves a synthetic label set in front of an observer and compares the time the
+// main thread spends per frame if the culling and the overlap test run on the main thread and if
+// they run in a DeclutterPipeline. Frames are paced to 90 Hz, so that the background thread has
+// about as much time as it would have in the plugin. Afterwards, some labels are removed, the
+// scene stops moving and the pipelined result is checked to converge to the one of a ViewDeclutter
+// run on the main thread.
+
+#include "../src/engine/DeclutterPipeline.hpp"
+#include "../tests/SyntheticLabels.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace csp::anchorlabels;
+using namespace csp::anchorlabels::synthetic;
+
+namespace {
+
+std::size_t const FRAMES = 90;
+
+auto const FRAME_TIME = std::chrono::microseconds(11111);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Removes every tenth label, like bodies which are unloaded by the solar system.
+void removeLabels(LabelStore& labels, std::vector<uint32_t>& ids) {
+  LabelStore            remaining;
+  std::vector<uint32_t> remainingIds;
+
+  for (std::size_t i = 0; i < labels.size(); ++i) {
+    if (i % 10 == 0) {
+      continue;
+    }
+
+    std::size_t const j = remaining.size();
+    remaining.resize(j + 1);
+    remaining.mPositionX[j] = labels.mPositionX[i];
+    remaining.mPositionY[j] = labels.mPositionY[i];
+    remaining.mPositionZ[j] = labels.mPositionZ[i];
+    remaining.mRadius[j]    = labels.mRadius[i];
+    remaining.mPriority[j]  = labels.mPriority[i];
+    remaining.mFlags[j]     = labels.mFlags[i];
+    remainingIds.push_back(ids[i]);
+  }
+
+  labels = std::move(remaining);
+  ids    = std::move(remainingIds);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// A symmetric perspective projection with a vertical field of view of 60 degrees.
+Transform createProjection() {
+  double const nearClip = 0.1;
+  double const farClip  = 1e13;
+  double const f        = 1.0 / std::tan(M_PI / 6.0);
+  double const aspect   = 16.0 / 9.0;
+
+  Transform p{};
+  p[0]  = f / aspect;
+  p[5]  = f;
+  p[10] = (farClip + nearClip) / (nearClip - farClip);
+  p[11] = -1.0;
+  p[14] = 2.0 * farClip * nearClip / (nearClip - farClip);
+  return p;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Fills the snapshot of the pipeline like Plugin::publishDeclutterSnapshot() and publishes it. The
+// positions have been written to the snapshot before.
+void publish(DeclutterPipeline& pipeline, std::vector<View> const& views,
+    std::vector<uint32_t> const& ids, uint64_t generation,
+    DeclutterSettings const& declutterSettings) {
+  auto& snapshot = pipeline.getSnapshot();
+  if (snapshot.mGeneration != generation) {
+    snapshot.mIds        = ids;
+    snapshot.mGeneration = generation;
+  }
+
+  snapshot.mViews             = views;
+  snapshot.mRadiusScale       = 1.0;
+  snapshot.mCullingSettings   = CullingSettings();
+  snapshot.mLabelScale        = LABEL_SCALE;
+  snapshot.mWidth             = LABEL_WIDTH;
+  snapshot.mHeight            = LABEL_HEIGHT;
+  snapshot.mDeclutterSettings = declutterSettings;
+
+  pipeline.publish();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Compares the visible labels, their placements and views to the ones of the declutter run on the
+// main thread. The labels are matched by their ids. The sort keys are not compared, as they are
+// kept stable from frame to frame and hence depend on the skipped snapshots.
+bool validate(DeclutterPipelineResult const& result, ViewDeclutter const& declutter,
+    std::vector<uint32_t> const& ids) {
+  auto const& visible = declutter.getVisibleLabels();
+  if (result.mResult.size() != visible.size()) {
+    return false;
+  }
+
+  for (std::size_t i = 0; i < visible.size(); ++i) {
+    if (result.mIds[result.mResult.mVisibleLabels[i]] != ids[visible[i]] ||
+        result.mResult.mPlacements[i] != declutter.getPlacement(visible[i]) ||
+        result.mResult.mViewMasks[i] != declutter.getViewMask(visible[i])) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  DeclutterSettings declutterSettings;
+  declutterSettings.mMaxSortKey = 700;
+
+  // The incremental overlap test depends on which snapshots have been skipped by the background
+  // thread, so the converged results are compared without it.
+  DeclutterSettings referenceSettings = declutterSettings;
+  referenceSettings.mIncremental      = false;
+
+  View view;
+  view.mModelView  = {1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0,
+      1.0};
+  view.mProjection = createProjection();
+  std::vector<View> const views = {view};
+
+  std::size_t const threads = std::max(1U, std::thread::hardware_concurrency());
+
+  std::printf("%10s %10s %8s %10s %12s %12s\n", "labels", "mode", "threads", "visible",
+      "ms/frame", "frames lag");
+
+  for (std::size_t count : {20000, 50000, 100000}) {
+    std::mt19937 rng(42); // NOLINT
+
+    // Each label gets an id which is its initial index.
+    LabelStore            labels;
+    std::vector<uint32_t> ids(count);
+    createLabelsAround(count, rng, labels);
+    std::iota(ids.begin(), ids.end(), 0U);
+
+    // The declutter pass runs on the main thread.
+    {
+      WorkerPool    pool(threads);
+      ViewDeclutter declutter;
+      LabelStore    store;
+      declutter.setViews(views);
+
+      std::chrono::nanoseconds total{0};
+
+      for (std::size_t frame = 1; frame <= FRAMES; ++frame) {
+        auto start = std::chrono::steady_clock::now();
+        rotateLabels(labels, frame * 1e-3, store);
+        declutter.cull(store, 1.0, CullingSettings(), pool);
+        declutter.update(LABEL_SCALE, LABEL_WIDTH, LABEL_HEIGHT, declutterSettings, pool);
+        DeclutterResult result;
+        result.assign(declutter);
+        total += std::chrono::steady_clock::now() - start;
+
+        std::this_thread::sleep_until(start + FRAME_TIME);
+      }
+
+      double msPerFrame = static_cast<double>(total.count()) * 1e-6 / static_cast<double>(FRAMES);
+      std::printf("%10zu %10s %8zu %10zu %12.2f %12.2f\n", count, "sync", threads,
+          declutter.getVisibleLabels().size(), msPerFrame, 0.0);
+    }
+
+    // The declutter pass runs in the pipeline. The main thread only writes the positions to the
+    // snapshot and copies the most recent result.
+    DeclutterPipeline pipeline;
+    pipeline.start(threads);
+
+    uint64_t                 generation = 1;
+    uint64_t                 sequence   = 0;
+    std::size_t              lag        = 0;
+    std::size_t              results    = 0;
+    DeclutterResult          result;
+    std::chrono::nanoseconds total{0};
+
+    for (std::size_t frame = 1; frame <= FRAMES; ++frame) {
+      auto start = std::chrono::steady_clock::now();
+      rotateLabels(labels, frame * 1e-3, pipeline.getSnapshot().mLabels);
+      publish(pipeline, views, ids, generation, declutterSettings);
+      ++sequence;
+
+      if (pipeline.fetch()) {
+        result = pipeline.getResult().mResult;
+        lag += sequence - pipeline.getResult().mSequence;
+        ++results;
+      }
+      total += std::chrono::steady_clock::now() - start;
+
+      std::this_thread::sleep_until(start + FRAME_TIME);
+    }
+
+    double msPerFrame = static_cast<double>(total.count()) * 1e-6 / static_cast<double>(FRAMES);
+    double averageLag =
+        results > 0 ? static_cast<double>(lag) / static_cast<double>(results) : 0.0;
+    std::printf("%10zu %10s %8zu %10zu %12.2f %12.2f\n", count, "pipelined", threads,
+        result.size(), msPerFrame, averageLag);
+
+    // Remove some labels and stop moving. The pipeline has to match the remaining labels by their
+    // ids and then converge to the result of the main thread.
+    removeLabels(labels, ids);
+    ++generation;
+
+    for (std::size_t frame = 0; frame < 3; ++frame) {
+      rotateLabels(labels, 0.0, pipeline.getSnapshot().mLabels);
+      publish(pipeline, views, ids, generation, referenceSettings);
+      ++sequence;
+    }
+
+    while (!pipeline.fetch() || pipeline.getResult().mSequence != sequence) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    WorkerPool    pool(threads);
+    ViewDeclutter reference;
+    reference.setViews(views);
+    reference.cull(labels, 1.0, CullingSettings(), pool);
+    reference.update(LABEL_SCALE, LABEL_WIDTH, LABEL_HEIGHT, referenceSettings, pool);
+
+    if (pipeline.getResult().mGeneration != generation ||
+        !validate(pipeline.getResult(), reference, ids)) {
+      std::printf("Pipelined result for %zu labels differs from the reference!\n", count);
+      return 1;
+    }
+  }
+
+  return 0;
+}
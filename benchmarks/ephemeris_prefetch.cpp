@@ -0,0 +1,248 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// This benchmark plays back the simulation time at several time speeds and compares the time the
+// main thread spends per frame on the ephemeris with and without the EphemerisPrefetcher. SPICE
+// is replaced by a synthetic ephemeris of bodies on elliptic orbits which rotate about their own
+// axis, seen from a reference frame which rotates once per day, like the frame of the Earth.
+// Frames are paced to 60 Hz. The prefetcher computes its samples on the main thread, so this time
+// is included. Every interpolated transformation is compared to the exact one, also after time
+// jumps and changes of the time speed, which must discard the samples.
+
+#include "../src/engine/EphemerisPrefetcher.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace csp::anchorlabels;
+
+namespace {
+
+double const PI  = 3.14159265358979323846;
+double const DAY = 86400.0;
+
+std::size_t const BODY_COUNT = 300;
+std::size_t const FRAMES     = 120;
+
+auto const FRAME_TIME = std::chrono::microseconds(16667);
+
+// The largest accepted position error relative to the distance of a body.
+double const MAX_ERROR = 2e-3;
+
+struct SyntheticBody {
+  double mRadius;
+  double mEccentricity;
+  double mOrbitRate;
+  double mRotationRate;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Creates bodies with orbital periods between a day and a year, which rotate once in a few hours
+// to a few days.
+std::vector<SyntheticBody> createBodies(std::mt19937& rng) {
+  std::uniform_real_distribution<double> logPeriod(std::log10(DAY), std::log10(365.0 * DAY));
+  std::uniform_real_distribution<double> logRotation(std::log10(0.2 * DAY), std::log10(5 * DAY));
+  std::uniform_real_distribution<double> eccentricity(0.0, 0.3);
+
+  std::vector<SyntheticBody> bodies(BODY_COUNT);
+  for (auto& body : bodies) {
+    double const period = std::pow(10.0, logPeriod(rng));
+    body.mRadius        = 4e8 * std::pow(period / (27.3 * DAY), 2.0 / 3.0);
+    body.mEccentricity  = eccentricity(rng);
+    body.mOrbitRate     = 2.0 * PI / period;
+    body.mRotationRate  = 2.0 * PI / std::pow(10.0, logRotation(rng));
+  }
+
+  return bodies;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Computes the transformation of a body relative to the rotating reference frame. Like SPICE, this
+// solves Kepler's equation with Newton's method.
+Transform computeTransform(SyntheticBody const& body, double time) {
+  double const meanAnomaly = std::fmod(time * body.mOrbitRate, 2.0 * PI);
+
+  double eccentricAnomaly = meanAnomaly;
+  for (int i = 0; i < 32; ++i) {
+    eccentricAnomaly -=
+        (eccentricAnomaly - body.mEccentricity * std::sin(eccentricAnomaly) - meanAnomaly) /
+        (1.0 - body.mEccentricity * std::cos(eccentricAnomaly));
+  }
+
+  double const x = body.mRadius * (std::cos(eccentricAnomaly) - body.mEccentricity);
+  double const y = body.mRadius * std::sqrt(1.0 - body.mEccentricity * body.mEccentricity) *
+                   std::sin(eccentricAnomaly);
+
+  // The reference frame rotates once per day about the z-axis.
+  double const referenceAngle = -2.0 * PI * time / DAY;
+  double const rc             = std::cos(referenceAngle);
+  double const rs             = std::sin(referenceAngle);
+
+  double const angle = std::fmod(time * body.mRotationRate, 2.0 * PI) + referenceAngle;
+  double const c     = std::cos(angle);
+  double const s     = std::sin(angle);
+
+  return {c, s, 0, 0, -s, c, 0, 0, 0, 0, 1, 0, rc * x - rs * y, rs * x + rc * y, 0, 1};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The distance between the positions of both transformations relative to the distance of the
+// body.
+double getError(Transform const& a, Transform const& exact) {
+  double const dx = a[12] - exact[12];
+  double const dy = a[13] - exact[13];
+  double const dz = a[14] - exact[14];
+
+  double const distance =
+      std::sqrt(exact[12] * exact[12] + exact[13] * exact[13] + exact[14] * exact[14]);
+  return std::sqrt(dx * dx + dy * dy + dz * dz) / distance;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Result {
+  double mMsPerFrame = 0.0;
+  double mHitRate    = 0.0;
+  double mMaxError   = 0.0;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Plays back the given number of frames at the given time speed, starting at the given time. Each
+// frame, the transformations of all bodies are queried from the prefetcher if one is given and
+// computed directly otherwise. The simulation time is advanced by the real time which has passed.
+Result playBack(std::vector<SyntheticBody> const& bodies,
+    std::vector<EphemerisFrame> const& frames, EphemerisPrefetcher* prefetcher,
+    PrefetchSettings const& settings, double& time, double timeSpeed, std::size_t frameCount) {
+  EphemerisFrame const reference{"Earth", "IAU_Earth"};
+
+  Result                   result;
+  std::size_t              hits = 0;
+  std::vector<Transform>   transforms(bodies.size());
+  std::chrono::nanoseconds total{0};
+  auto                     last = std::chrono::steady_clock::now();
+
+  for (std::size_t frame = 0; frame < frameCount; ++frame) {
+    auto start = std::chrono::steady_clock::now();
+    time += timeSpeed * std::chrono::duration<double>(start - last).count();
+    last = start;
+
+    if (prefetcher) {
+      prefetcher->update(reference, time, timeSpeed, settings);
+    }
+
+    for (std::size_t i = 0; i < bodies.size(); ++i) {
+      if (prefetcher && prefetcher->get(frames[i], time, transforms[i])) {
+        ++hits;
+      } else {
+        transforms[i] = computeTransform(bodies[i], time);
+      }
+    }
+
+    total += std::chrono::steady_clock::now() - start;
+
+    // The exact transformations are computed outside of the measured time.
+    for (std::size_t i = 0; i < bodies.size(); ++i) {
+      result.mMaxError =
+          std::max(result.mMaxError, getError(transforms[i], computeTransform(bodies[i], time)));
+    }
+
+    std::this_thread::sleep_until(last + FRAME_TIME);
+  }
+
+  result.mMsPerFrame = static_cast<double>(total.count()) * 1e-6 / static_cast<double>(frameCount);
+  result.mHitRate = static_cast<double>(hits) / static_cast<double>(frameCount * bodies.size());
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void print(char const* name, double timeSpeed, Result const& result) {
+  std::printf("%14s %12.0f %12.3f %10.1f %12.2e\n", name, timeSpeed, result.mMsPerFrame,
+      result.mHitRate * 100.0, result.mMaxError);
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  std::mt19937 rng(42); // NOLINT
+
+  auto const bodies = createBodies(rng);
+
+  std::vector<EphemerisFrame> frames(bodies.size());
+  for (std::size_t i = 0; i < bodies.size(); ++i) {
+    frames[i] = {"Body" + std::to_string(i), "IAU_Body" + std::to_string(i)};
+  }
+
+  EphemerisPrefetcher prefetcher;
+  prefetcher.setFrames(frames);
+  prefetcher.setEphemeris(
+      [&](EphemerisFrame const& /*reference*/, EphemerisFrame const& frame, double time) {
+        std::size_t const index = std::stoul(frame.mCenter.substr(4));
+        return computeTransform(bodies[index], time);
+      });
+
+  PrefetchSettings settings;
+  settings.mEnabled = true;
+
+  std::printf("%14s %12s %12s %10s %12s\n", "mode", "time speed", "ms/frame", "hits [%]",
+      "max error");
+
+  double time     = 0.0;
+  double maxError = 0.0;
+
+  for (double timeSpeed : {100.0, 1000.0, 10000.0}) {
+    print("direct", timeSpeed,
+        playBack(bodies, frames, nullptr, settings, time, timeSpeed, FRAMES));
+
+    Result result =
+        playBack(bodies, frames, &prefetcher, settings, time, timeSpeed, FRAMES);
+    print("prefetched", timeSpeed, result);
+    maxError = std::max(maxError, result.mMaxError);
+  }
+
+  // Stale samples would show up as large errors after these.
+  struct Change {
+    char const* mName;
+    double      mJump;
+    bool        mReverse;
+  };
+
+  std::vector<Change> changes = {{"steady", 0.0, false}, {"jump back", -DAY, false},
+      {"jump forward", 10.0 * DAY, false}, {"reverse", 0.0, true}};
+
+  double timeSpeed = 1000.0;
+
+  for (auto const& change : changes) {
+    time += change.mJump;
+    if (change.mReverse) {
+      timeSpeed = -timeSpeed;
+    }
+
+    Result result =
+        playBack(bodies, frames, &prefetcher, settings, time, timeSpeed, FRAMES);
+    print(change.mName, timeSpeed, result);
+    maxError = std::max(maxError, result.mMaxError);
+  }
+
+  if (maxError > MAX_ERROR) {
+    std::printf("Interpolated transformations differ from the exact ones!\n");
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,173 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// This benchmark compares the number of visible labels and the time per frame with and without
+// candidate placement for dense synthetic label sets. In each frame, the placed boxes of all
+// visible labels are checked to be free of overlaps.
+
+#include "../src/engine/DeclutterEngine.hpp"
+#include "../tests/SyntheticLabels.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace csp::anchorlabels;
+using namespace csp::anchorlabels::synthetic;
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Creates labels in a narrow field of view, so that many of them collide. The distances only vary
+// little, so that depth overlap does not resolve most collisions.
+void createLabels(std::size_t count, std::mt19937& rng, LabelStore& store) {
+  std::uniform_real_distribution<double> direction(-0.5, 0.5);
+  std::uniform_real_distribution<double> distance(1e6, 1.01e6);
+  std::uniform_real_distribution<double> logRadius(2.0, 8.0);
+
+  store.resize(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    double const z      = -distance(rng);
+    store.mPositionX[i] = direction(rng) * -z;
+    store.mPositionY[i] = direction(rng) * -z;
+    store.mPositionZ[i] = z;
+    store.mPriority[i]  = std::pow(10.0, logRadius(rng));
+    store.mFlags[i]     = 0;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Moves the observer sideways to simulate camera motion.
+void moveLabels(LabelStore& store, double offset) {
+  for (std::size_t i = 0; i < store.size(); ++i) {
+    store.mPositionX[i] += offset;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Shrinks the box like the hysteresis of the incremental mode does.
+BoundingBox shrink(BoundingBox bb, double hysteresis) {
+  bb.mX += bb.mWidth * hysteresis * 0.5;
+  bb.mY += bb.mHeight * hysteresis * 0.5;
+  bb.mWidth *= 1.0 - hysteresis;
+  bb.mHeight *= 1.0 - hysteresis;
+  return bb;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// No two visible labels may overlap at their placed positions, unless depth overlap allows it. In
+// incremental mode, visible labels may overlap by the hysteresis, and labels which did not move by
+// more than epsilon are compared at their previous position and distance.
+bool validate(
+    DeclutterEngine const& engine, LabelStore const& store, DeclutterSettings const& settings) {
+  auto const&  visible    = engine.getVisibleLabels();
+  double const epsilon    = settings.mIncremental ? settings.mEpsilon : 0.0;
+  double const hysteresis = settings.mIncremental ? settings.mHysteresis + 4.0 * epsilon : 0.0;
+  double const threshold  = 1 + settings.mIgnoreOverlapThreshold * 0.1 * (1.0 - 2.0 * epsilon);
+
+  for (std::size_t i = 0; i < visible.size(); ++i) {
+    BoundingBox const a =
+        getPlacedBox(store.getBoundingBox(visible[i]), engine.getPlacement(visible[i]));
+
+    for (std::size_t j = i + 1; j < visible.size(); ++j) {
+      double const distA = store.mDistance[visible[i]];
+      double const distB = store.mDistance[visible[j]];
+      double const ratio = distA < distB ? distB / distA : distA / distB;
+      if (settings.mEnableDepthOverlap && ratio > threshold) {
+        continue;
+      }
+
+      BoundingBox const b =
+          getPlacedBox(store.getBoundingBox(visible[j]), engine.getPlacement(visible[j]));
+      if (shrink(a, hysteresis).intersects(shrink(b, hysteresis))) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  std::mt19937 rng(42); // NOLINT
+
+  DeclutterSettings settings;
+  settings.mIgnoreOverlapThreshold = 0.025;
+  settings.mMaxSortKey             = 700;
+  settings.mSortKeyRange           = 50;
+
+  struct Mode {
+    char const* mName;
+    bool        mCandidatePlacement;
+    std::size_t mBudget;
+  };
+
+  std::vector<Mode> const modes = {{"default", false, 0}, {"placement, budget 100", true, 100},
+      {"placement, budget 1000", true, 1000}, {"placement, unlimited", true, SIZE_MAX}};
+
+  std::printf("%10s %24s %12s %10s %12s %16s\n", "labels", "mode", "incremental", "visible",
+      "tests/frame", "us/frame");
+
+  for (std::size_t count : {100, 1000, 10000}) {
+    LabelStore initial;
+    createLabels(count, rng, initial);
+
+    for (bool incremental : {false, true}) {
+      settings.mIncremental = incremental;
+
+      for (auto const& mode : modes) {
+        settings.mCandidatePlacement = mode.mCandidatePlacement;
+        settings.mPlacementBudget    = mode.mBudget;
+
+        std::size_t const frames = std::max<std::size_t>(20, 100000 / count);
+
+        DeclutterEngine          engine;
+        LabelStore               store = initial;
+        std::chrono::nanoseconds total{0};
+        std::size_t              visible = 0;
+        std::size_t              tests   = 0;
+
+        for (std::size_t frame = 0; frame < frames; ++frame) {
+          moveLabels(store, 20.0);
+
+          auto start = std::chrono::steady_clock::now();
+          store.project(LABEL_SCALE, LABEL_WIDTH, LABEL_HEIGHT);
+          engine.update(store, settings);
+          total += std::chrono::steady_clock::now() - start;
+
+          visible += engine.getVisibleLabels().size();
+          tests += engine.getPlacementTestCount();
+
+          // The check is quadratic in the number of visible labels, so it is done only once.
+          if (frame + 1 == frames && !validate(engine, store, settings)) {
+            std::printf("Visible labels overlap for %zu labels!\n", count);
+            return 1;
+          }
+        }
+
+        double const frameCount = static_cast<double>(frames);
+        std::printf("%10zu %24s %12s %10.1f %12.1f %16.2f\n", count, mode.mName,
+            incremental ? "yes" : "no", static_cast<double>(visible) / frameCount,
+            static_cast<double>(tests) / frameCount,
+            static_cast<double>(total.count()) * 1e-3 / frameCount);
+      }
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,152 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// This benchmark streams bodies in and out of a scene and measures how long it takes per frame to
+// keep the labels ordered by priority. The LabelRegistry is compared to the previous approach,
+// which re-sorted a vector of all labels after each batch of new bodies and searched it by center
+// name for each removed body. The order of both is compared after every frame.
+
+#include "../src/engine/LabelRegistry.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace csp::anchorlabels;
+
+namespace {
+
+std::size_t const FRAME_COUNT = 20;
+
+struct SyntheticBody {
+  std::string mCenterName;
+  double      mSize;
+};
+
+struct Timing {
+  double mMean = 0.0;
+  double mMax  = 0.0;
+
+  void add(std::chrono::steady_clock::duration duration) {
+    double ms = std::chrono::duration<double, std::milli>(duration).count();
+    mMean += ms / static_cast<double>(FRAME_COUNT);
+    mMax = std::max(mMax, ms);
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  std::mt19937 rng(42); // NOLINT
+
+  std::printf("%10s %10s %14s %14s %14s %14s\n", "bodies", "batch", "sorted mean", "sorted max",
+      "registry mean", "registry max");
+
+  for (std::size_t count : {1000, 10000, 100000}) {
+    for (std::size_t batch : {10, 100}) {
+      std::uniform_real_distribution<double> size(1.0, 1e7);
+
+      // All bodies which may be streamed in. Initially, the first count bodies are loaded.
+      std::vector<std::unique_ptr<SyntheticBody>> bodies;
+      for (std::size_t i = 0; i < count + batch * FRAME_COUNT; ++i) {
+        bodies.push_back(std::make_unique<SyntheticBody>(
+            SyntheticBody{"Body" + std::to_string(i), std::round(size(rng) / 1e5)}));
+      }
+
+      std::vector<SyntheticBody const*> sorted;
+      LabelRegistry                     registry;
+      std::vector<SyntheticBody const*> loaded;
+
+      for (std::size_t i = 0; i < count; ++i) {
+        sorted.push_back(bodies[i].get());
+        registry.add(bodies[i].get(), bodies[i]->mSize);
+        loaded.push_back(bodies[i].get());
+      }
+      std::stable_sort(sorted.begin(), sorted.end(),
+          [](auto const* a, auto const* b) { return a->mSize > b->mSize; });
+      registry.getOrder();
+
+      Timing sortedTiming;
+      Timing registryTiming;
+
+      for (std::size_t frame = 0; frame < FRAME_COUNT; ++frame) {
+        // Each frame, a batch of random bodies is unloaded and a batch of new ones is loaded.
+        std::vector<SyntheticBody const*> removed;
+        for (std::size_t i = 0; i < batch; ++i) {
+          std::uniform_int_distribution<std::size_t> distribution(0, loaded.size() - 1);
+          std::size_t                                index = distribution(rng);
+          removed.push_back(loaded[index]);
+          loaded[index] = loaded.back();
+          loaded.pop_back();
+        }
+
+        std::vector<SyntheticBody const*> added;
+        for (std::size_t i = 0; i < batch; ++i) {
+          added.push_back(bodies[count + frame * batch + i].get());
+          loaded.push_back(added.back());
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (auto const* body : removed) {
+          sorted.erase(std::remove_if(sorted.begin(), sorted.end(),
+                           [body](auto const* b) { return b->mCenterName == body->mCenterName; }),
+              sorted.end());
+        }
+        sorted.insert(sorted.end(), added.begin(), added.end());
+        std::stable_sort(sorted.begin(), sorted.end(),
+            [](auto const* a, auto const* b) { return a->mSize > b->mSize; });
+
+        sortedTiming.add(std::chrono::steady_clock::now() - start);
+        start = std::chrono::steady_clock::now();
+
+        std::vector<LabelRegistry::Key> keys(removed.begin(), removed.end());
+        registry.remove(keys);
+
+        std::vector<std::pair<LabelRegistry::Key, double>> entries;
+        for (auto const* body : added) {
+          entries.emplace_back(body, body->mSize);
+        }
+        std::vector<LabelHandle> handles;
+        registry.add(entries, handles);
+
+        auto const& order = registry.getOrder();
+
+        registryTiming.add(std::chrono::steady_clock::now() - start);
+
+        // Both approaches keep labels of the same size in the order in which they were added, so
+        // the orders have to be identical.
+        if (order.size() != sorted.size()) {
+          std::printf("The registry contains %zu instead of %zu labels!\n", order.size(),
+              sorted.size());
+          return 1;
+        }
+
+        for (std::size_t i = 0; i < order.size(); ++i) {
+          auto handle = registry.find(sorted[i]);
+          if (!handle || handle->mSlot != order[i]) {
+            std::printf("The registry order differs at index %zu!\n", i);
+            return 1;
+          }
+        }
+      }
+
+      std::printf("%10zu %10zu %14.3f %14.3f %14.3f %14.3f\n", count, batch, sortedTiming.mMean,
+          sortedTiming.mMax, registryTiming.mMean, registryTiming.mMax);
+    }
+  }
+
+  return 0;
+}
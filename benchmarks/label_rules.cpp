@@ -0,0 +1,229 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// This benchmark matches the center and frame names of many synthetic bodies against label rules
+// and reports the time per body. The compiled rule set is compared to translating each glob into a
+// regular expression, which is also only constructed once. Both have to come to the same decision
+// for every body.
+
+#include "../src/engine/LabelRuleSet.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace csp::anchorlabels;
+
+namespace {
+
+std::size_t const BODY_COUNT = 100000;
+
+struct SyntheticBody {
+  std::string mCenter;
+  std::string mFrame;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Names like those of planets, moons, barycenters, spacecraft, asteroids and comets.
+std::vector<SyntheticBody> createBodies(std::size_t count, std::mt19937& rng) {
+  std::vector<std::string> const planets = {"Mercury", "Venus", "Earth", "Mars", "Jupiter",
+      "Saturn", "Uranus", "Neptune"};
+
+  std::uniform_int_distribution<std::size_t> planet(0, planets.size() - 1);
+  std::uniform_int_distribution<int>         kind(0, 5);
+  std::uniform_int_distribution<int>         number(1, 999999);
+
+  std::vector<SyntheticBody> bodies(count);
+  for (auto& body : bodies) {
+    std::string const& p = planets[planet(rng)];
+
+    switch (kind(rng)) {
+    case 0:
+      body = {p, "IAU_" + p};
+      break;
+    case 1:
+      body = {p + " Barycenter", "J2000"};
+      break;
+    case 2:
+      body = {p + " " + std::to_string(number(rng) % 100), "IAU_" + p};
+      break;
+    case 3:
+      body = {"Spacecraft-" + std::to_string(number(rng)), "J2000"};
+      break;
+    case 4:
+      body = {std::to_string(number(rng)) + " Asteroid", "ECLIPJ2000"};
+      break;
+    default:
+      body = {"C/" + std::to_string(1900 + number(rng) % 125) + " A" + std::to_string(kind(rng)),
+          "ECLIPJ2000"};
+      break;
+    }
+  }
+
+  return bodies;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Rules as an operator might write them: hide barycenters, spacecraft and most small bodies, but
+// show and prioritize a few of them.
+std::vector<LabelRule> createRules() {
+  std::vector<LabelRule> rules;
+
+  auto add = [&rules](std::string center, std::string frame, std::optional<bool> show,
+                 std::optional<double> priority) {
+    LabelRule rule;
+    rule.mCenter   = std::move(center);
+    rule.mFrame    = std::move(frame);
+    rule.mShow     = show;
+    rule.mPriority = priority;
+    rules.push_back(rule);
+  };
+
+  add("Earth", "*", true, 1e12);
+  add("Mars ?", "IAU_Mars", true, 1e9);
+  add("/^Spacecraft-12/", "*", true, 1e8);
+  add("*Barycenter", "*", false, std::nullopt);
+  add("Spacecraft-*", "J2000", false, std::nullopt);
+  add("*Asteroid", "ECLIPJ2000", false, std::nullopt);
+  add("C/19??*", "*", false, std::nullopt);
+  add("/^C\\/20[01]/", "*", std::nullopt, 1.0);
+  add("*upiter*", "IAU_*", std::nullopt, 1e10);
+  add("*", "IAU_*", true, std::nullopt);
+
+  return rules;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Translates a glob into an equivalent regular expression.
+std::string globToRegex(std::string const& glob) {
+  if (glob.size() >= 2 && glob.front() == '/' && glob.back() == '/') {
+    return glob.substr(1, glob.size() - 2);
+  }
+
+  std::string result = "^";
+  for (char c : glob) {
+    if (c == '*') {
+      result += ".*";
+    } else if (c == '?') {
+      result += '.';
+    } else if (std::string("\\^$.|+()[]{}/").find(c) != std::string::npos) {
+      result += '\\';
+      result += c;
+    } else {
+      result += c;
+    }
+  }
+  return result + "$";
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The straightforward implementation: every pattern is a regular expression.
+class ReferenceRules {
+ public:
+  explicit ReferenceRules(std::vector<LabelRule> const& rules)
+      : mRules(rules) {
+    for (auto const& rule : rules) {
+      mCenters.emplace_back(globToRegex(rule.mCenter));
+      mFrames.emplace_back(globToRegex(rule.mFrame));
+    }
+  }
+
+  LabelRuleResult match(std::string const& center, std::string const& frame) const {
+    std::optional<bool>   show;
+    std::optional<double> priority;
+
+    for (std::size_t i = 0; i < mRules.size(); ++i) {
+      if (std::regex_search(center, mCenters[i]) && std::regex_search(frame, mFrames[i])) {
+        show     = show ? show : mRules[i].mShow;
+        priority = priority ? priority : mRules[i].mPriority;
+      }
+    }
+
+    return {show.value_or(true), priority};
+  }
+
+ private:
+  std::vector<LabelRule>  mRules;
+  std::vector<std::regex> mCenters;
+  std::vector<std::regex> mFrames;
+};
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  std::mt19937 rng(42); // NOLINT
+
+  auto bodies = createBodies(BODY_COUNT, rng);
+  auto rules  = createRules();
+
+  auto         start = std::chrono::steady_clock::now();
+  LabelRuleSet ruleSet;
+  ruleSet.compile(rules);
+  double compileTime =
+      std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+  if (!ruleSet.getInvalidRules().empty()) {
+    std::printf("Rule %zu could not be compiled!\n", ruleSet.getInvalidRules().front());
+    return 1;
+  }
+
+  ReferenceRules reference(rules);
+
+  // Only the results which matter for the plugin are compared: the priority of hidden bodies is
+  // never used.
+  std::size_t shown = 0;
+  for (auto const& body : bodies) {
+    auto const result   = ruleSet.match(body.mCenter, body.mFrame);
+    auto const expected = reference.match(body.mCenter, body.mFrame);
+
+    bool const differs =
+        result.mShow != expected.mShow || (result.mShow && result.mPriority != expected.mPriority);
+    if (differs) {
+      std::printf("The rules differ for '%s' in '%s'!\n", body.mCenter.c_str(),
+          body.mFrame.c_str());
+      return 1;
+    }
+
+    shown += result.mShow ? 1 : 0;
+  }
+
+  std::chrono::nanoseconds compiledTime{0};
+  std::chrono::nanoseconds referenceTime{0};
+  std::size_t              checksum = 0;
+
+  for (int round = 0; round < 5; ++round) {
+    start = std::chrono::steady_clock::now();
+    for (auto const& body : bodies) {
+      checksum += ruleSet.match(body.mCenter, body.mFrame).mShow ? 1 : 0;
+    }
+    compiledTime += std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (auto const& body : bodies) {
+      checksum += reference.match(body.mCenter, body.mFrame).mShow ? 1 : 0;
+    }
+    referenceTime += std::chrono::steady_clock::now() - start;
+  }
+
+  double const matches = 5.0 * static_cast<double>(bodies.size());
+
+  std::printf("%10s %10s %10s %14s %16s %16s\n", "bodies", "rules", "shown", "compile [us]",
+      "compiled ns/body", "regex ns/body");
+  std::printf("%10zu %10zu %10zu %14.1f %16.1f %16.1f\n", bodies.size(), rules.size(), shown,
+      compileTime, static_cast<double>(compiledTime.count()) / matches,
+      static_cast<double>(referenceTime.count()) / matches);
+
+  return checksum == 0 ? 1 : 0;
+}
@@ -0,0 +1,292 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// This benchmark writes a synthetic catalog with one million asteroids, ground stations and lunar
+// craters, maps it and builds the spatial index. Then it looks for the entries with the highest
+// priority in the view frustum of an observer which looks around in random directions. The result
+// of each query is compared to a brute force search over all entries.
+
+#include "../src/engine/PointCatalog.hpp"
+#include "../src/engine/PointCatalogIndex.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace csp::anchorlabels;
+
+namespace {
+
+std::size_t const ENTRY_COUNT = 1000000;
+std::size_t const QUERY_COUNT = 50;
+double const      PI          = 3.14159265358979323846;
+
+using Vector = std::array<double, 3>;
+
+struct Reference {
+  char const* mCenter;
+  char const* mFrame;
+  char const* mPrefix;
+  double      mShare;  ///< The fraction of all entries.
+  Vector      mOrigin; ///< The position of the center in a common space.
+};
+
+double getMilliseconds(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Creates a matrix which transforms positions relative to the given center to the observer. The
+// observer is at the given position, rotated by yaw and pitch and scaled by the given factor.
+Transform getToObserver(
+    Vector const& origin, Vector const& observer, double yaw, double pitch, double scale) {
+  double const cy = std::cos(yaw);
+  double const sy = std::sin(yaw);
+  double const cp = std::cos(pitch);
+  double const sp = std::sin(pitch);
+
+  // The rows of the inverse rotation of the observer.
+  std::array<Vector, 3> rows = {Vector{cy, 0.0, -sy}, Vector{sy * sp, cp, cy * sp},
+      Vector{sy * cp, -sp, cy * cp}};
+
+  Transform m{};
+  for (std::size_t row = 0; row < 3; ++row) {
+    double translation = 0.0;
+    for (std::size_t column = 0; column < 3; ++column) {
+      m[column * 4 + row] = rows[row][column] * scale;
+      translation += rows[row][column] * scale * (origin[column] - observer[column]);
+    }
+    m[12 + row] = translation;
+  }
+  m[15] = 1.0;
+
+  return m;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// A perspective projection with a horizontal field of view of about 90 degrees.
+Transform getProjection() {
+  double const aspect = 16.0 / 9.0;
+  double const f      = 1.0 / std::tan(0.5 * PI / 3.0);
+  double const near   = 0.1;
+  double const far    = 1e10;
+
+  Transform m{};
+  m[0]  = f / aspect;
+  m[5]  = f;
+  m[10] = (far + near) / (near - far);
+  m[11] = -1.0;
+  m[14] = 2.0 * far * near / (near - far);
+
+  return m;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The same test as in Culler::isOutsideFrustum().
+bool isOutside(Vector const& p, std::optional<Transform> const& viewProjection, double margin) {
+  if (!viewProjection) {
+    return !(p[2] < 0.0);
+  }
+
+  auto const&  m = *viewProjection;
+  double const x = m[0] * p[0] + m[4] * p[1] + m[8] * p[2] + m[12];
+  double const y = m[1] * p[0] + m[5] * p[1] + m[9] * p[2] + m[13];
+  double const w = m[3] * p[0] + m[7] * p[1] + m[11] * p[2] + m[15];
+
+  double const limit = w * (1.0 + 2.0 * margin);
+  return !(w > 0.0 && std::abs(x) <= limit && std::abs(y) <= limit);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void bruteForce(PointCatalog const&               catalog,
+    std::vector<std::optional<Transform>> const& toObserver,
+    std::optional<Transform> const& viewProjection, double margin, std::size_t maxCount,
+    std::vector<uint32_t>& entries) {
+
+  std::vector<std::pair<float, uint32_t>> candidates;
+
+  for (std::size_t i = 0; i < catalog.size(); ++i) {
+    auto const& m = *toObserver[catalog.getReference(i)];
+    auto const  p = catalog.getPosition(i);
+
+    Vector const q = {m[0] * p[0] + m[4] * p[1] + m[8] * p[2] + m[12],
+        m[1] * p[0] + m[5] * p[1] + m[9] * p[2] + m[13],
+        m[2] * p[0] + m[6] * p[1] + m[10] * p[2] + m[14]};
+
+    if (!isOutside(q, viewProjection, margin)) {
+      candidates.emplace_back(catalog.getPriority(i), static_cast<uint32_t>(i));
+    }
+  }
+
+  auto isBetter = [](auto const& a, auto const& b) {
+    return a.first > b.first || (a.first == b.first && a.second < b.second);
+  };
+
+  std::size_t const count = std::min(maxCount, candidates.size());
+  std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(), isBetter);
+
+  for (std::size_t i = 0; i < count; ++i) {
+    entries.push_back(candidates[i].second);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  std::mt19937 rng(42); // NOLINT
+
+  double const au = 1.496e11;
+
+  std::vector<Reference> const references = {
+      {"Sun", "ECLIPJ2000", "Asteroid", 0.7, {0.0, 0.0, 0.0}},
+      {"Earth", "IAU_Earth", "Station", 0.2, {au, 0.0, 0.0}},
+      {"Moon", "IAU_Moon", "Crater", 0.1, {au + 3.844e8, 0.0, 0.0}},
+  };
+
+  // Asteroids are distributed in a thick disk, stations and craters on the surface of their body.
+  std::uniform_real_distribution<double> angle(0.0, 2.0 * PI);
+  std::uniform_real_distribution<double> unit(-1.0, 1.0);
+  std::lognormal_distribution<float>     priority(8.F, 2.F);
+
+  std::vector<CatalogEntry> entries;
+  entries.reserve(ENTRY_COUNT);
+
+  for (auto const& reference : references) {
+    auto const count = static_cast<std::size_t>(reference.mShare * ENTRY_COUNT);
+
+    for (std::size_t i = 0; i < count && entries.size() < ENTRY_COUNT; ++i) {
+      CatalogEntry entry;
+      entry.mName   = std::string(reference.mPrefix) + " " + std::to_string(i);
+      entry.mCenter = reference.mCenter;
+      entry.mFrame  = reference.mFrame;
+
+      // The priorities are rounded, so that there are many labels with the same priority.
+      entry.mPriority = std::round(priority(rng));
+
+      double const phi = angle(rng);
+      if (reference.mCenter == std::string("Sun")) {
+        double const r  = au * (2.2 + 1.1 * (unit(rng) + 1.0));
+        entry.mPosition = {r * std::cos(phi), r * std::sin(phi), 0.1 * r * unit(rng)};
+      } else {
+        double const r  = reference.mCenter == std::string("Earth") ? 6.371e6 : 1.737e6;
+        double const z  = unit(rng);
+        double const s  = std::sqrt(1.0 - z * z);
+        entry.mPosition = {r * s * std::cos(phi), r * s * std::sin(phi), r * z};
+      }
+
+      entries.push_back(std::move(entry));
+    }
+  }
+
+  auto fileName = (std::filesystem::temp_directory_path() / "csp-anchor-labels-benchmark.catalog")
+                      .string();
+
+  auto start = std::chrono::steady_clock::now();
+  if (!PointCatalog::write(fileName, entries)) {
+    std::printf("Failed to write '%s'!\n", fileName.c_str());
+    return 1;
+  }
+  double const writeTime = getMilliseconds(std::chrono::steady_clock::now() - start);
+
+  PointCatalog catalog;
+  start = std::chrono::steady_clock::now();
+  if (!catalog.open(fileName)) {
+    std::printf("Failed to open '%s'!\n", fileName.c_str());
+    return 1;
+  }
+  double const openTime = getMilliseconds(std::chrono::steady_clock::now() - start);
+
+  PointCatalogIndex index;
+  start = std::chrono::steady_clock::now();
+  index.build(catalog);
+  double const buildTime = getMilliseconds(std::chrono::steady_clock::now() - start);
+
+  std::printf("entries:    %zu in %zu references, %.1f MB\n", catalog.size(),
+      catalog.getReferenceCount(),
+      static_cast<double>(std::filesystem::file_size(fileName)) / 1e6);
+  std::printf("write:      %.3f ms\n", writeTime);
+  std::printf("open:       %.3f ms\n", openTime);
+  std::printf("index:      %.3f ms for %zu nodes\n\n", buildTime, index.getNodeCount());
+
+  // The order of the references in the file may differ from the order above.
+  std::vector<Vector> origins(catalog.getReferenceCount());
+  for (std::size_t i = 0; i < origins.size(); ++i) {
+    for (auto const& reference : references) {
+      if (catalog.getCenterName(static_cast<uint32_t>(i)) == reference.mCenter) {
+        origins[i] = reference.mOrigin;
+      }
+    }
+  }
+
+  double const margin = 0.2;
+
+  std::printf("%10s %10s %14s %14s %14s\n", "labels", "frustum", "brute force", "index",
+      "visited nodes");
+
+  for (std::size_t maxCount : {100, 500, 2000}) {
+    for (bool useFrustum : {true, false}) {
+      std::optional<Transform> viewProjection;
+      if (useFrustum) {
+        viewProjection = getProjection();
+      }
+
+      double bruteForceTime = 0.0;
+      double indexTime      = 0.0;
+      double visitedNodes   = 0.0;
+
+      for (std::size_t query = 0; query < QUERY_COUNT; ++query) {
+        // The observer hovers above the Earth and looks in a random direction.
+        Vector const observer = {au + 2e7 * unit(rng), 2e7 * unit(rng), 2e7 * unit(rng)};
+        double const yaw      = angle(rng);
+        double const pitch    = 0.5 * PI * unit(rng);
+        double const scale    = 1e-6;
+
+        std::vector<std::optional<Transform>> toObserver(origins.size());
+        for (std::size_t i = 0; i < origins.size(); ++i) {
+          toObserver[i] = getToObserver(origins[i], observer, yaw, pitch, scale);
+        }
+
+        std::vector<uint32_t> expected;
+        start = std::chrono::steady_clock::now();
+        bruteForce(catalog, toObserver, viewProjection, margin, maxCount, expected);
+        bruteForceTime += getMilliseconds(std::chrono::steady_clock::now() - start);
+
+        std::vector<uint32_t> actual;
+        start = std::chrono::steady_clock::now();
+        index.query(catalog, toObserver, viewProjection, margin, maxCount, actual);
+        indexTime += getMilliseconds(std::chrono::steady_clock::now() - start);
+        visitedNodes += static_cast<double>(index.getVisitedNodeCount());
+
+        if (actual != expected) {
+          std::printf("The index returned %zu entries, the brute force search %zu!\n",
+              actual.size(), expected.size());
+          return 1;
+        }
+      }
+
+      std::printf("%10zu %10s %14.3f %14.3f %14.0f\n", maxCount, useFrustum ? "yes" : "no",
+          bruteForceTime / QUERY_COUNT, indexTime / QUERY_COUNT, visitedNodes / QUERY_COUNT);
+    }
+  }
+
+  catalog.close();
+  std::filesystem::remove(fileName);
+
+  return 0;
+}
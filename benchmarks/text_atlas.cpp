@@ -0,0 +1,239 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// This benchmark packs 10k synthetic label names into the text atlas, once as a batch and once
+// name by name, and prints the best time of several builds. Then it replaces a part of the names
+// in each round, as if labels were streamed in and out. After each step, the rectangles of all
+// entries are checked to lie within their page and not to overlap, and the layout of each entry is
+// checked to fit into the label area.
+
+#include "../src/engine/TextAtlas.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace csp::anchorlabels;
+
+namespace {
+
+std::size_t const NAME_COUNT  = 10000;
+std::size_t const BUILD_COUNT = 5;
+std::size_t const ROUND_COUNT = 50;
+uint32_t const    PADDING     = 2;
+
+// The size of the anchor label GUI area.
+double const LABEL_WIDTH  = 120.0;
+double const LABEL_HEIGHT = 30.0;
+
+double getMilliseconds(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Metrics similar to those of a 16pt sans-serif font.
+FontMetrics getMetrics() {
+  FontMetrics metrics;
+  for (int c = 32; c <= 126; ++c) {
+    float advance = 9.F;
+    if (c == ' ') {
+      advance = 5.F;
+    } else if (c >= 'A' && c <= 'Z') {
+      advance = 14.F;
+    } else if (c >= 'a' && c <= 'z') {
+      advance = c == 'i' || c == 'l' ? 5.F : (c == 'm' || c == 'w' ? 16.F : 11.F);
+    } else if (c >= '0' && c <= '9') {
+      advance = 12.F;
+    }
+    metrics.mAdvances[c - 32] = advance;
+  }
+  metrics.mDefaultAdvance = 14.F;
+  metrics.mLineHeight     = 25.F;
+  return metrics;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Creates names like those of catalog entries and bodies. Some names occur more than once.
+std::string createName(std::mt19937& rng) {
+  static char const* const prefixes[] = {"Asteroid", "Station", "Crater", "Comet", "Mons"};
+
+  std::uniform_int_distribution<int>    kind(0, 9);
+  std::uniform_int_distribution<int>    number(1, 99999);
+  std::uniform_int_distribution<int>    length(3, 14);
+  std::uniform_int_distribution<int>    letter(0, 25);
+  std::uniform_int_distribution<size_t> prefix(0, 4);
+
+  int const k = kind(rng);
+  if (k < 6) {
+    return std::string(prefixes[prefix(rng)]) + " " + std::to_string(number(rng));
+  }
+
+  std::string name(1, static_cast<char>('A' + letter(rng)));
+  int const   count = length(rng);
+  for (int i = 1; i < count; ++i) {
+    name += static_cast<char>('a' + letter(rng));
+  }
+
+  // Some names contain non-ASCII characters.
+  if (k == 9) {
+    name += " \xC3\xA9toile";
+  }
+
+  return name;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool validate(TextAtlas const& atlas, std::vector<std::string> const& names,
+    std::vector<uint32_t> const& entries) {
+
+  for (std::size_t i = 0; i < names.size(); ++i) {
+    if (atlas.getText(entries[i]) != names[i]) {
+      std::printf("Entry %u has the wrong text!\n", entries[i]);
+      return false;
+    }
+  }
+
+  uint32_t const size = atlas.getPageSize();
+
+  for (uint32_t page = 0; page < atlas.getPageCount(); ++page) {
+    std::vector<uint32_t> pageEntries;
+    atlas.getPageEntries(page, pageEntries);
+
+    std::sort(pageEntries.begin(), pageEntries.end(), [&](uint32_t a, uint32_t b) {
+      auto const& ra = atlas.getRect(a);
+      auto const& rb = atlas.getRect(b);
+      return ra.mY < rb.mY || (ra.mY == rb.mY && ra.mX < rb.mX);
+    });
+
+    for (std::size_t i = 0; i < pageEntries.size(); ++i) {
+      auto const& rect = atlas.getRect(pageEntries[i]);
+      if (rect.mX + rect.mWidth > size || rect.mY + rect.mHeight > size) {
+        std::printf("Entry %u exceeds its page!\n", pageEntries[i]);
+        return false;
+      }
+
+      // All entries have the same height, so they can only overlap their neighbour in the row.
+      if (i > 0) {
+        auto const& previous = atlas.getRect(pageEntries[i - 1]);
+        if (previous.mY + previous.mHeight > rect.mY &&
+            (previous.mY != rect.mY || previous.mX + previous.mWidth > rect.mX)) {
+          std::printf("Entries %u and %u overlap!\n", pageEntries[i - 1], pageEntries[i]);
+          return false;
+        }
+      }
+
+      auto const layout = atlas.getLayout(pageEntries[i], LABEL_WIDTH, LABEL_HEIGHT);
+      if (layout.mX < 0.0 || layout.mY < 0.0 || layout.mX + layout.mWidth > LABEL_WIDTH ||
+          layout.mY + layout.mHeight > LABEL_HEIGHT) {
+        std::printf("The layout of entry %u exceeds the label area!\n", pageEntries[i]);
+        return false;
+      }
+
+      double const minU = (rect.mX + atlas.getPadding()) / static_cast<double>(size);
+      double const maxU = (rect.mX + rect.mWidth - atlas.getPadding()) / static_cast<double>(size);
+      if (layout.mU < minU - 1e-9 || layout.mU + layout.mUWidth > maxU + 1e-9) {
+        std::printf("The layout of entry %u samples outside of its text!\n", pageEntries[i]);
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  std::mt19937 rng(42); // NOLINT
+
+  FontMetrics const metrics = getMetrics();
+
+  std::vector<std::string> names(NAME_COUNT);
+  for (auto& name : names) {
+    name = createName(rng);
+  }
+
+  std::printf("%10s %10s %12s %8s %8s %10s\n", "page size", "mode", "time [ms]", "pages", "fill",
+      "repacks");
+
+  for (uint32_t pageSize : {1024U, 2048U}) {
+    TextAtlas             atlas;
+    std::vector<uint32_t> entries;
+
+    // Batch build of all names. The best of several builds is printed.
+    double batchTime = std::numeric_limits<double>::max();
+    for (std::size_t i = 0; i < BUILD_COUNT; ++i) {
+      atlas.reset(metrics, pageSize, PADDING);
+      entries.clear();
+      auto start = std::chrono::steady_clock::now();
+      atlas.add(names, entries);
+      batchTime = std::min(batchTime, getMilliseconds(std::chrono::steady_clock::now() - start));
+    }
+
+    if (!validate(atlas, names, entries)) {
+      return 1;
+    }
+
+    std::printf("%10u %10s %12.3f %8zu %7.1f%% %10zu\n", pageSize, "batch", batchTime,
+        atlas.getPageCount(), 100.0 * atlas.getFillRatio(), atlas.getRepackCount());
+
+    // Adding the names one by one.
+    double singleTime = std::numeric_limits<double>::max();
+    for (std::size_t i = 0; i < BUILD_COUNT; ++i) {
+      atlas.reset(metrics, pageSize, PADDING);
+      entries.clear();
+      auto start = std::chrono::steady_clock::now();
+      for (auto const& name : names) {
+        entries.push_back(atlas.add(name));
+      }
+      singleTime = std::min(singleTime, getMilliseconds(std::chrono::steady_clock::now() - start));
+    }
+
+    if (!validate(atlas, names, entries)) {
+      return 1;
+    }
+
+    std::printf("%10u %10s %12.3f %8zu %7.1f%% %10zu\n", pageSize, "single", singleTime,
+        atlas.getPageCount(), 100.0 * atlas.getFillRatio(), atlas.getRepackCount());
+
+    // Replacing a tenth of the names in each round.
+    std::uniform_int_distribution<std::size_t> index(0, NAME_COUNT - 1);
+    auto                                       churnNames = names;
+
+    double churnTime = 0.0;
+    for (std::size_t round = 0; round < ROUND_COUNT; ++round) {
+      auto start = std::chrono::steady_clock::now();
+      for (std::size_t i = 0; i < NAME_COUNT / 10; ++i) {
+        std::size_t const j = index(rng);
+        atlas.release(entries[j]);
+        churnNames[j] = createName(rng);
+        entries[j]    = atlas.add(churnNames[j]);
+      }
+      churnTime += getMilliseconds(std::chrono::steady_clock::now() - start);
+
+      if (!validate(atlas, churnNames, entries)) {
+        return 1;
+      }
+    }
+
+    std::printf("%10u %10s %12.3f %8zu %7.1f%% %10zu\n", pageSize, "churn",
+        churnTime / ROUND_COUNT, atlas.getPageCount(), 100.0 * atlas.getFillRatio(),
+        atlas.getRepackCount());
+  }
+
+  return 0;
+}
@@ -0,0 +1,188 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// This benchmark compares the per-frame label update with and without the transform cache. SPICE
+// is replaced by a synthetic ephemeris which solves Kepler's equation for a chain of frames, which
+// roughly matches the cost of a SPICE query. Like in a real scene, many labels share the same
+// center and frame. Without the cache, each label queries two transformations per frame, with the
+// cache each combination of center and frame is queried once per frame.
+
+#include "../src/engine/TransformCache.hpp"
+#include "../src/engine/WorkerPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace csp::anchorlabels;
+
+namespace {
+
+// The number of frames between the observer and a label's frame.
+int const FRAME_CHAIN_LENGTH = 4;
+
+double const PI = 3.14159265358979323846;
+
+struct SyntheticLabel {
+  std::string mCenter;
+  std::string mFrame;
+  double      mOrbitId;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Multiplies two column-major 4x4 matrices.
+Transform multiply(Transform const& a, Transform const& b) {
+  Transform result{};
+  for (int col = 0; col < 4; ++col) {
+    for (int row = 0; row < 4; ++row) {
+      double sum = 0.0;
+      for (int i = 0; i < 4; ++i) {
+        sum += a[i * 4 + row] * b[col * 4 + i];
+      }
+      result[col * 4 + row] = sum;
+    }
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Computes the transformation of a synthetic orbit at the given time. Each step of the frame chain
+// solves Kepler's equation with Newton's method and appends a rotation and a translation.
+Transform computeTransform(double orbitId, double time) {
+  Transform result{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+
+  for (int step = 0; step < FRAME_CHAIN_LENGTH; ++step) {
+    double const eccentricity = 0.1 + 0.05 * step;
+    double const meanAnomaly  = std::fmod(time * 1e-6 * (orbitId + step + 1.0), 2.0 * PI);
+
+    double eccentricAnomaly = meanAnomaly;
+    for (int i = 0; i < 8; ++i) {
+      eccentricAnomaly -= (eccentricAnomaly - eccentricity * std::sin(eccentricAnomaly) -
+                              meanAnomaly) /
+                          (1.0 - eccentricity * std::cos(eccentricAnomaly));
+    }
+
+    double const c = std::cos(eccentricAnomaly);
+    double const s = std::sin(eccentricAnomaly);
+    double const r = 1e6 * (orbitId + 1.0) * (1.0 - eccentricity * c);
+
+    Transform const hop{c, s, 0, 0, -s, c, 0, 0, 0, 0, 1, 0, r * c, r * s, 0, 1};
+    result = multiply(result, hop);
+  }
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Distributes the labels over the given number of center and frame combinations. Like in a real
+// scene, a few combinations are used by most of the labels.
+std::vector<SyntheticLabel> createLabels(std::size_t count, std::size_t frames, std::mt19937& rng) {
+  std::geometric_distribution<std::size_t> frameIndex(4.0 / static_cast<double>(frames));
+
+  std::vector<SyntheticLabel> labels(count);
+  for (auto& label : labels) {
+    std::size_t index = frameIndex(rng) % frames;
+    label.mCenter     = "Center" + std::to_string(index);
+    label.mFrame      = "Frame" + std::to_string(index);
+    label.mOrbitId    = static_cast<double>(index);
+  }
+
+  return labels;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  std::mt19937 rng(42); // NOLINT
+
+  WorkerPool pool(0);
+  std::mutex spiceMutex;
+
+  // The cache is shared by all threads, so it is measured with one thread and with all of them.
+  std::vector<std::size_t> threadCounts = {1};
+  if (pool.getThreadCount() > 1) {
+    threadCounts.push_back(pool.getThreadCount());
+  }
+
+  std::printf("%10s %8s %10s %10s %10s %10s %16s\n", "labels", "frames", "mode", "threads",
+      "hits", "misses", "ns/label/frame");
+
+  for (std::size_t count : {100, 1000, 10000, 100000}) {
+    for (std::size_t frameCount : {10, 100, 1000}) {
+      auto                   labels = createLabels(count, frameCount, rng);
+      std::vector<Transform> results(count);
+      std::vector<Transform> reference(count);
+
+      for (bool cached : {false, true}) {
+        for (std::size_t threads : threadCounts) {
+          pool.setThreadCount(threads);
+
+          TransformCache           cache;
+          std::size_t const        iterations = std::max<std::size_t>(5, 200000 / count);
+          std::chrono::nanoseconds total{0};
+
+          for (std::size_t iteration = 0; iteration < iterations; ++iteration) {
+            double time = 1e5 * static_cast<double>(iteration);
+
+            auto start = std::chrono::steady_clock::now();
+
+            cache.clear();
+            pool.parallelFor(count, [&](std::size_t begin, std::size_t end) {
+              for (std::size_t i = begin; i < end; ++i) {
+                auto const& label = labels[i];
+
+                if (cached) {
+                  results[i] = cache.get(label.mCenter, label.mFrame, time, [&]() {
+                    std::lock_guard<std::mutex> lock(spiceMutex);
+                    return computeTransform(label.mOrbitId, time);
+                  });
+                } else {
+                  // Without the cache, the anchor position and the observer transformation were
+                  // queried separately.
+                  std::lock_guard<std::mutex> lock(spiceMutex);
+                  results[i] = computeTransform(label.mOrbitId, time);
+                  computeTransform(label.mOrbitId, -time);
+                }
+              }
+            });
+
+            total += std::chrono::steady_clock::now() - start;
+          }
+
+          // The cached results have to be identical to the uncached ones of the last iteration.
+          if (!cached && threads == 1) {
+            reference = results;
+          } else if (results != reference) {
+            std::printf("Cached transformations differ for %zu labels!\n", count);
+            return 1;
+          }
+
+          double nsPerLabel =
+              static_cast<double>(total.count()) / static_cast<double>(iterations * count);
+          std::printf("%10zu %8zu %10s %10zu %10llu %10llu %16.2f\n", count, frameCount,
+              cached ? "cached" : "uncached", threads,
+              static_cast<unsigned long long>(cache.getHits()),
+              static_cast<unsigned long long>(cache.getMisses()), nsPerLabel);
+        }
+      }
+    }
+  }
+
+  return 0;
+}
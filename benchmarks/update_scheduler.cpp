@@ -0,0 +1,199 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// This benchmark simulates an observer moving through a system of bodies on circular orbits while
+// turning and zooming. For each frame, it compares the positions produced by the UpdateScheduler
+// with the exact positions and prints the number of label updates per frame and the largest
+// angular error of the extrapolated positions. Halfway through, the time jumps ahead and all
+// labels are updated at once.
+
+#include "../src/engine/UpdateScheduler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace csp::anchorlabels;
+
+namespace {
+
+double const PI = 3.14159265358979323846;
+
+std::size_t const FRAME_COUNT = 600;
+std::size_t const JUMP_FRAME  = 300;
+
+struct Orbit {
+  double mRadius;
+  double mInclination;
+  double mPhase;
+  double mAngularVelocity;
+};
+
+struct Vec3 {
+  double x;
+  double y;
+  double z;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Vec3 orbitPosition(Orbit const& orbit, double time) {
+  double const angle = orbit.mPhase + orbit.mAngularVelocity * time;
+  double const c     = std::cos(orbit.mInclination);
+  double const s     = std::sin(orbit.mInclination);
+  double const x     = orbit.mRadius * std::cos(angle);
+  double const y     = orbit.mRadius * std::sin(angle);
+  return {x, y * c, y * s};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Bodies are placed between 0.3 and 40 units from the center, most of them far out. Their angular
+// velocity follows Kepler's third law.
+std::vector<Orbit> createOrbits(std::size_t count, std::mt19937& rng) {
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+  std::vector<Orbit> orbits(count);
+  for (auto& orbit : orbits) {
+    orbit.mRadius          = 0.3 * std::pow(40.0 / 0.3, std::sqrt(unit(rng)));
+    orbit.mInclination     = 0.2 * (unit(rng) - 0.5);
+    orbit.mPhase           = 2.0 * PI * unit(rng);
+    orbit.mAngularVelocity = 2.0 * PI / std::pow(orbit.mRadius, 1.5);
+  }
+
+  return orbits;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The observer circles the center at a distance of one unit. It turns around its y-axis and its
+// scale changes over time. Returns the matrix which converts observer-relative positions to the
+// frame of the center, without the translation.
+Transform observerState(std::size_t frame, double time, Vec3& position) {
+  Orbit const observer{1.0, 0.0, 0.0, 2.0 * PI};
+  position = orbitPosition(observer, time);
+
+  double const yaw   = 0.01 * static_cast<double>(frame);
+  double const scale = 1.0 + 0.5 * std::sin(0.02 * static_cast<double>(frame));
+  double const c     = std::cos(yaw) * scale;
+  double const s     = std::sin(yaw) * scale;
+
+  return {c, 0, -s, 0, 0, scale, 0, 0, s, 0, c, 0, 0, 0, 0, 1};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Converts a position relative to the observer in the center's frame to observer coordinates.
+// The matrix is a scaled rotation, so its inverse is the transpose divided by the squared scale.
+Vec3 toObserver(Transform const& m, Vec3 const& v) {
+  double const scale2 = m[0] * m[0] + m[1] * m[1] + m[2] * m[2];
+  return {(m[0] * v.x + m[1] * v.y + m[2] * v.z) / scale2,
+      (m[4] * v.x + m[5] * v.y + m[6] * v.z) / scale2,
+      (m[8] * v.x + m[9] * v.y + m[10] * v.z) / scale2};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Unlike acos, this is accurate for small angles as well.
+double angleBetween(Vec3 const& a, Vec3 const& b) {
+  double const cx = a.y * b.z - a.z * b.y;
+  double const cy = a.z * b.x - a.x * b.z;
+  double const cz = a.x * b.y - a.y * b.x;
+  return std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), a.x * b.x + a.y * b.y + a.z * b.z);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  std::mt19937 rng(42); // NOLINT
+
+  std::printf("%10s %10s %10s %14s %14s %12s %12s\n", "labels", "budget", "scheduled",
+      "updates/frame", "forced frame", "max error", "mean error");
+
+  for (std::size_t count : {1000, 10000, 100000}) {
+    auto orbits = createOrbits(count, rng);
+
+    for (uint32_t budget : {0U, 1000U}) {
+      for (bool scheduled : {false, true}) {
+        SchedulerSettings settings;
+        settings.mEnabled    = scheduled;
+        settings.mMaxUpdates = budget;
+
+        UpdateScheduler scheduler;
+        LabelStore      store;
+        store.resize(count);
+
+        std::vector<Vec3> exact(count);
+        std::size_t       totalUpdates  = 0;
+        std::size_t       forcedUpdates = 0;
+        double            maxError      = 0.0;
+        double            errorSum      = 0.0;
+
+        for (std::size_t frame = 0; frame < FRAME_COUNT; ++frame) {
+          // One frame advances the time by 1/3000 of the observer's orbit. Then the time jumps.
+          double const time =
+              static_cast<double>(frame) / 3000.0 + (frame >= JUMP_FRAME ? 0.37 : 0.0);
+
+          Vec3            observer{};
+          Transform const toScheduler = observerState(frame, time, observer);
+
+          for (std::size_t i = 0; i < count; ++i) {
+            Vec3 const p = orbitPosition(orbits[i], time);
+            exact[i] =
+                toObserver(toScheduler, {p.x - observer.x, p.y - observer.y, p.z - observer.z});
+          }
+
+          bool const  force = frame == JUMP_FRAME;
+          auto const& due   = scheduler.schedule(count, toScheduler, force, settings);
+          for (std::size_t label : due) {
+            scheduler.setPosition(label, exact[label].x, exact[label].y, exact[label].z);
+          }
+          scheduler.extrapolate(store);
+
+          totalUpdates += due.size();
+          if (force) {
+            forcedUpdates = due.size();
+          }
+
+          // A forced update has to produce the exact positions.
+          for (std::size_t i = 0; i < count; ++i) {
+            double const error = angleBetween(exact[i],
+                {store.mPositionX[i], store.mPositionY[i], store.mPositionZ[i]});
+
+            if (force && error > 1e-9) {
+              std::printf("Label %zu is not exact after a time jump!\n", i);
+              return 1;
+            }
+
+            maxError = std::max(maxError, error);
+            errorSum += error;
+          }
+        }
+
+        double const updatesPerFrame =
+            static_cast<double>(totalUpdates) / static_cast<double>(FRAME_COUNT);
+        double const meanError = errorSum / static_cast<double>(FRAME_COUNT * count);
+
+        std::printf("%10zu %10u %10s %14.1f %14zu %12.2e %12.2e\n", count, budget,
+            scheduled ? "yes" : "no", updatesPerFrame, forcedUpdates, maxError, meanError);
+
+        // Without scheduling and without a budget, all labels have to be exact.
+        if (!scheduled && budget == 0 && maxError > 1e-9) {
+          std::printf("Unscheduled positions are not exact!\n");
+          return 1;
+        }
+      }
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,228 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// This benchmark declutters a synthetic label set for one to eight views, which are arranged like
+// the eyes of a stereo setup in up to four windows looking in different directions. It reports the
+// time per frame with one thread and with one thread per hardware thread. Before measuring, the
+// visibility of each view is compared to a Culler and a DeclutterEngine run on that view alone.
+
+#include "../src/engine/ViewDeclutter.hpp"
+#include "../tests/SyntheticLabels.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace csp::anchorlabels;
+using namespace csp::anchorlabels::synthetic;
+
+namespace {
+
+// The distance between the eyes of a stereo setup in meters.
+double const EYE_DISTANCE = 0.064;
+
+std::size_t const LABEL_COUNT = 20000;
+std::size_t const FRAMES      = 30;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// A symmetric perspective projection with a vertical field of view of 60 degrees.
+Transform createProjection() {
+  double const nearClip = 0.1;
+  double const farClip  = 1e13;
+  double const f        = 1.0 / std::tan(M_PI / 6.0);
+  double const aspect   = 16.0 / 9.0;
+
+  Transform p{};
+  p[0]  = f / aspect;
+  p[5]  = f;
+  p[10] = (farClip + nearClip) / (nearClip - farClip);
+  p[11] = -1.0;
+  p[14] = 2.0 * farClip * nearClip / (nearClip - farClip);
+  return p;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The views of the given number of windows, which are rotated by 90 degrees around the y-axis
+// against each other. For stereo, each window has one view per eye. The whole setup is rotated by
+// the given angle to simulate camera motion.
+std::vector<View> createViews(std::size_t windows, bool stereo, double angle) {
+  std::vector<View> views;
+
+  for (std::size_t w = 0; w < windows; ++w) {
+    double const a = angle + static_cast<double>(w) * M_PI / 2.0;
+    double const c = std::cos(a);
+    double const s = std::sin(a);
+
+    std::vector<double> eyes = stereo ? std::vector<double>{-EYE_DISTANCE / 2, EYE_DISTANCE / 2}
+                                      : std::vector<double>{0.0};
+
+    for (double eye : eyes) {
+      View view;
+      view.mModelView  = {c, 0.0, -s, 0.0, 0.0, 1.0, 0.0, 0.0, s, 0.0, c, 0.0, -eye, 0.0, 0.0, 1.0};
+      view.mProjection = createProjection();
+      views.push_back(view);
+    }
+  }
+
+  return views;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Culls and declutters each view on its own and compares the result to the merged one.
+bool validate(ViewDeclutter const& declutter, std::vector<View> const& views,
+    LabelStore const& labels, CullingSettings const& cullingSettings,
+    DeclutterSettings const& declutterSettings) {
+
+  std::vector<uint32_t> masks(labels.size(), 0);
+
+  for (std::size_t v = 0; v < views.size(); ++v) {
+    Transform const& m = views[v].mModelView;
+
+    LabelStore store = labels;
+    for (std::size_t i = 0; i < labels.size(); ++i) {
+      double const x = labels.mPositionX[i];
+      double const y = labels.mPositionY[i];
+      double const z = labels.mPositionZ[i];
+
+      store.mPositionX[i] = m[0] * x + m[4] * y + m[8] * z + m[12];
+      store.mPositionY[i] = m[1] * x + m[5] * y + m[9] * z + m[13];
+      store.mPositionZ[i] = m[2] * x + m[6] * y + m[10] * z + m[14];
+    }
+
+    Culler culler;
+    culler.setViewProjection(views[v].mProjection);
+    culler.cull(store, 1.0, cullingSettings);
+    store.project(LABEL_SCALE, LABEL_WIDTH, LABEL_HEIGHT);
+
+    DeclutterEngine engine;
+    engine.update(store, declutterSettings);
+
+    for (std::size_t i = 0; i < labels.size(); ++i) {
+      if (engine.isVisible(i)) {
+        masks[i] |= 1U << v;
+      }
+
+      // The cluster size and the placement are taken from the first view showing the label.
+      bool const isPrimary = engine.isVisible(i) && (masks[i] & ((1U << v) - 1U)) == 0;
+      if (isPrimary && (engine.getClusterSize(i) != declutter.getClusterSize(i) ||
+                           engine.getPlacement(i) != declutter.getPlacement(i))) {
+        return false;
+      }
+    }
+  }
+
+  for (std::size_t i = 0; i < labels.size(); ++i) {
+    if (masks[i] != declutter.getViewMask(i) || (masks[i] != 0) != declutter.isVisible(i)) {
+      return false;
+    }
+  }
+
+  // Each label which is shown in any view has to be in the merged list exactly once.
+  auto const& visible = declutter.getVisibleLabels();
+  std::size_t count   = std::count_if(masks.begin(), masks.end(), [](uint32_t m) { return m; });
+
+  if (visible.size() != count || declutter.getSortKeys().size() != count ||
+      !std::all_of(visible.begin(), visible.end(),
+          [&declutter](std::size_t label) { return declutter.isVisible(label); })) {
+    return false;
+  }
+
+  // The merged labels are sorted by distance, so their sort keys have to be non-increasing over
+  // all views, and strictly decreasing if there are enough keys.
+  auto const& keys   = declutter.getSortKeys();
+  int const   maxKey = declutterSettings.mMaxSortKey;
+  int const   minKey = maxKey - static_cast<int>(declutterSettings.mSortKeyRange) + 1;
+  bool const  strict = count <= declutterSettings.mSortKeyRange;
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    if (keys[i] > maxKey || keys[i] < minKey) {
+      return false;
+    }
+
+    if (i > 0 && (keys[i] > keys[i - 1] || (strict && keys[i] == keys[i - 1]))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  std::mt19937 rng(42); // NOLINT
+
+  CullingSettings cullingSettings;
+
+  DeclutterSettings declutterSettings;
+  declutterSettings.mMaxSortKey         = 700;
+  declutterSettings.mCandidatePlacement = true;
+
+  LabelStore labels;
+  createLabelsAround(LABEL_COUNT, rng, labels);
+
+  struct Setup {
+    char const* mName;
+    std::size_t mWindows;
+    bool        mStereo;
+  };
+
+  std::vector<Setup> setups = {{"mono", 1, false}, {"stereo", 1, true},
+      {"2 windows, stereo", 2, true}, {"4 windows, stereo", 4, true}};
+
+  std::size_t const hardwareThreads = std::max(1U, std::thread::hardware_concurrency());
+
+  std::printf("%10s %20s %8s %10s %10s %12s\n", "labels", "setup", "threads", "visible", "culled",
+      "ms/frame");
+
+  std::vector<std::size_t> threadCounts = {1};
+  if (hardwareThreads > 1) {
+    threadCounts.push_back(hardwareThreads);
+  }
+
+  for (auto const& setup : setups) {
+    for (std::size_t threads : threadCounts) {
+      WorkerPool    pool(threads);
+      ViewDeclutter declutter;
+
+      auto views = createViews(setup.mWindows, setup.mStereo, 0.0);
+      declutter.setViews(views);
+      declutter.cull(labels, 1.0, cullingSettings, pool);
+      declutter.update(LABEL_SCALE, LABEL_WIDTH, LABEL_HEIGHT, declutterSettings, pool);
+
+      if (!validate(declutter, views, labels, cullingSettings, declutterSettings)) {
+        std::printf("Views of setup '%s' differ from the reference!\n", setup.mName);
+        return 1;
+      }
+
+      std::chrono::nanoseconds total{0};
+
+      for (std::size_t frame = 1; frame <= FRAMES; ++frame) {
+        declutter.setViews(createViews(setup.mWindows, setup.mStereo, frame * 1e-3));
+
+        auto start = std::chrono::steady_clock::now();
+        declutter.cull(labels, 1.0, cullingSettings, pool);
+        declutter.update(LABEL_SCALE, LABEL_WIDTH, LABEL_HEIGHT, declutterSettings, pool);
+        total += std::chrono::steady_clock::now() - start;
+      }
+
+      double msPerFrame = static_cast<double>(total.count()) * 1e-6 / static_cast<double>(FRAMES);
+      std::printf("%10zu %20s %8zu %10zu %10zu %12.2f\n", LABEL_COUNT, setup.mName, threads,
+          declutter.getVisibleLabels().size(), declutter.getCulledCount(), msPerFrame);
+    }
+  }
+
+  return 0;
+}
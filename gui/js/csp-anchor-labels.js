@@ -19,6 +19,42 @@
       CosmoScout.gui.initSlider('anchorLabels.setDepthScale', 0.0, 1.0, 0.01, [1.0]);
       CosmoScout.gui.initSlider('anchorLabels.setOffset', 0.0, 1.0, 0.01, [0.2]);
     }
+
+    /**
+     * Shows the estimated memory used by the labels.
+     *
+     * @param mainMemory {number} Main memory in MiB, including the web pages of the labels
+     * @param textureMemory {number} Texture memory in MiB
+     * @param perLabel {number} Average memory per label in KiB, including its share of the web
+     *                          pages
+     * @param budget {number} The memory budget in MiB, zero if there is none
+     */
+    setMemoryUsage(mainMemory, textureMemory, perLabel, budget) {
+      let text = `${mainMemory.toFixed(1)} MiB RAM, ${textureMemory.toFixed(1)} MiB GPU, ` +
+                 `${perLabel.toFixed(1)} KiB per label`;
+      if (budget > 0) {
+        text += ` (budget ${budget} MiB)`;
+      }
+
+      document.getElementById('anchorLabels-memoryUsage').textContent = text;
+    }
+
+    /**
+     * Shows how many frame transformations of the last label update were answered without
+     * querying SPICE.
+     *
+     * @param cacheHitRate {number} Hits of the transformation cache in percent
+     * @param prefetchHitRate {number} Hits of the prefetched samples in percent, -1 if they are
+     *                                 not used at the current time speed
+     */
+    setEphemerisStatistics(cacheHitRate, prefetchHitRate) {
+      let text = `${cacheHitRate} % cached`;
+      if (prefetchHitRate >= 0) {
+        text += `, ${prefetchHitRate} % prefetched`;
+      }
+
+      document.getElementById('anchorLabels-ephemerisStatistics').textContent = text;
+    }
   }
 
   CosmoScout.init(AnchorLabelApi);
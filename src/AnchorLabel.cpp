@@ -6,25 +6,15 @@
 
 #include "AnchorLabel.hpp"
 
-#include "../../../src/cs-core/GuiManager.hpp"
-#include "../../../src/cs-core/InputManager.hpp"
 #include "../../../src/cs-core/SolarSystem.hpp"
 #include "../../../src/cs-core/TimeControl.hpp"
-#include "../../../src/cs-gui/GuiItem.hpp"
-#include "../../../src/cs-gui/WorldSpaceGuiArea.hpp"
-#include "../../../src/cs-scene/CelestialAnchorNode.hpp"
 #include "../../../src/cs-scene/CelestialBody.hpp"
-#include "../../../src/cs-utils/FrameTimings.hpp"
-
-#include <GL/glew.h>
-#include <VistaKernel/GraphicsManager/VistaGraphicsManager.h>
-#include <VistaKernel/GraphicsManager/VistaOpenGLNode.h>
-#include <VistaKernel/GraphicsManager/VistaSceneGraph.h>
-#include <VistaKernel/GraphicsManager/VistaTransformNode.h>
-#include <VistaKernel/VistaSystem.h>
-#include <VistaKernelOpenSGExt/VistaOpenSGMaterialTools.h>
+
+#include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/norm.hpp>
+
+#include <algorithm>
 #include <utility>
 
 namespace csp::anchorlabels {
@@ -34,78 +24,76 @@ namespace csp::anchorlabels {
 AnchorLabel::AnchorLabel(cs::scene::CelestialBody const* const body,
     std::shared_ptr<Plugin::Settings>                          pluginSettings,
     std::shared_ptr<cs::core::SolarSystem>                     solarSystem,
-    std::shared_ptr<cs::core::GuiManager>                      guiManager,
     std::shared_ptr<cs::core::TimeControl>                     timeControl,
-    std::shared_ptr<cs::core::InputManager>                    inputManager)
+    std::optional<double>                                      priority)
     : mBody(body)
     , mPluginSettings(std::move(pluginSettings))
     , mSolarSystem(std::move(solarSystem))
-    , mGuiManager(std::move(guiManager))
     , mTimeControl(std::move(timeControl))
-    , mInputManager(std::move(inputManager))
-    , mGuiArea(std::make_unique<cs::gui::WorldSpaceGuiArea>(120, 30)) // NOLINT
-    , mGuiItem(
-          std::make_unique<cs::gui::GuiItem>("file://../share/resources/gui/anchor_label.html")) {
-  auto* sceneGraph = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
-
-  mAnchor = std::make_shared<cs::scene::CelestialAnchorNode>(sceneGraph->GetRoot(),
-      sceneGraph->GetNodeBridge(), "", mBody->getCenterName(), mBody->getFrameName());
-
-  mGuiTransform.reset(sceneGraph->NewTransformNode(mAnchor.get()));
-  mGuiTransform->SetScale(1.0F,
-      static_cast<float>(mGuiArea->getHeight()) / static_cast<float>(mGuiArea->getWidth()), 1.0F);
-  mGuiTransform->SetTranslation(
-      0.0F, static_cast<float>(mPluginSettings->mLabelOffset.get()), 0.0F);
-  mGuiTransform->Rotate(VistaAxisAndAngle(VistaVector3D(0.0, 1.0, 0.0), -glm::pi<float>() / 2.F));
-
-  mGuiNode.reset(sceneGraph->NewOpenGLNode(mGuiTransform.get(), mGuiArea.get()));
-  mInputManager->registerSelectable(mGuiNode.get());
-
-  mGuiArea->addItem(mGuiItem.get());
-  mGuiArea->setUseLinearDepthBuffer(true);
-  mGuiArea->setIgnoreDepth(false);
-
-  mGuiItem->setCanScroll(false);
-  mGuiItem->waitForFinishedLoading();
-
-  mGuiItem->registerCallback(
-      "flyToBody", "Makes the observer fly to the planet marked by this anchor label.", [this] {
-        mSolarSystem->flyObserverTo(mBody->getCenterName(), mBody->getFrameName(), 5.0);
-        mGuiManager->showNotification("Travelling", "to " + mBody->getCenterName(), "send");
-      });
-
-  mGuiItem->callJavascript("setLabelText", mBody->getCenterName());
-
-  mOffsetConnection = mPluginSettings->mLabelOffset.connect([this](double newOffset) {
-    mGuiTransform->SetTranslation(0.0F, static_cast<float>(newOffset), 0.0F);
-  });
+    , mAnchor(mBody->getCenterName(), mBody->getFrameName())
+    , mName(mBody->getCenterName())
+    , mPriority(priority) {
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-AnchorLabel::~AnchorLabel() {
-  mGuiItem->unregisterCallback("flyToBody");
-
-  mGuiTransform->DisconnectChild(mGuiNode.get());
-  auto* sceneGraph = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
-  sceneGraph->GetRoot()->DisconnectChild(mGuiTransform.get());
-
-  mInputManager->unregisterSelectable(mGuiNode.get());
-
-  mPluginSettings->mLabelOffset.disconnect(mOffsetConnection);
+AnchorLabel::AnchorLabel(std::string name, std::string const& centerName,
+    std::string const& frameName, glm::dvec3 const& position, double priority,
+    std::shared_ptr<Plugin::Settings>      pluginSettings,
+    std::shared_ptr<cs::core::SolarSystem> solarSystem,
+    std::shared_ptr<cs::core::TimeControl> timeControl)
+    : mBody(nullptr)
+    , mPluginSettings(std::move(pluginSettings))
+    , mSolarSystem(std::move(solarSystem))
+    , mTimeControl(std::move(timeControl))
+    , mAnchor(centerName, frameName)
+    , mName(std::move(name))
+    , mAnchorPosition(position)
+    , mPriority(priority) {
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void AnchorLabel::update() {
-  if (mBody->getIsInExistence()) {
-    double simulationTime(mTimeControl->pSimulationTime.get());
-
-    cs::scene::CelestialAnchor rawAnchor(mAnchor->getCenterName(), mAnchor->getFrameName());
-    rawAnchor.setAnchorPosition(mAnchor->getAnchorPosition());
-
-    mRelativeAnchorPosition =
-        mSolarSystem->getObserver().getRelativePosition(simulationTime, rawAnchor);
+void AnchorLabel::update(
+    TransformCache& transformCache, EphemerisPrefetcher const& prefetcher, std::mutex& spiceMutex) {
+  if (!shouldBeHidden()) {
+    double      simulationTime(mTimeControl->pSimulationTime.get());
+    auto const& observer = mSolarSystem->getObserver();
+
+    // The transformation of the anchor relative to the observer is shared by all labels with the
+    // same center and frame. Both the position of the anchor and the position of the observer
+    // relative to the anchor are derived from it, so SPICE is queried at most once per label.
+    Transform cached = transformCache.get(
+        mAnchor.getCenterName(), mAnchor.getFrameName(), simulationTime, [&]() {
+          Transform result{};
+
+          // The prefetched transformation is relative to the center and frame of the observer,
+          // the observer itself is placed in this frame afterwards.
+          if (prefetcher.get({mAnchor.getCenterName(), mAnchor.getFrameName()}, simulationTime,
+                  result)) {
+            glm::dmat4 observerTransform =
+                glm::translate(glm::dmat4(1.0), observer.getAnchorPosition()) *
+                glm::mat4_cast(observer.getAnchorRotation()) *
+                glm::scale(glm::dmat4(1.0), glm::dvec3(observer.getAnchorScale()));
+            glm::dmat4 transform = glm::inverse(observerTransform) * glm::make_mat4(result.data());
+
+            std::copy_n(glm::value_ptr(transform), result.size(), result.begin());
+            return result;
+          }
+
+          // SPICE is not thread-safe.
+          std::lock_guard<std::mutex> lock(spiceMutex);
+          glm::dmat4 transform = observer.getRelativeTransform(simulationTime, mAnchor);
+
+          std::copy_n(glm::value_ptr(transform), result.size(), result.begin());
+          return result;
+        });
+
+    // Points of a catalog are offset from their center.
+    glm::dmat4 anchorTransform = glm::translate(glm::make_mat4(cached.data()), mAnchorPosition);
+    mRelativeAnchorPosition    = glm::dvec3(anchorTransform[3]) / anchorTransform[3].w;
+
+    glm::dmat4 observerTransform = glm::inverse(anchorTransform);
 
     double distanceToObserver = distanceToCamera();
 
@@ -113,10 +101,8 @@ void AnchorLabel::update() {
     double       scale       = mSolarSystem->getObserver().getAnchorScale();
     scale *= glm::pow(distanceToObserver, mPluginSettings->mDepthScale.get()) *
              mPluginSettings->mLabelScale.get() * scaleFactor;
-    mAnchor->setAnchorScale(scale);
+    mAnchorScale = scale;
 
-    auto observerTransform =
-        rawAnchor.getRelativeTransform(simulationTime, mSolarSystem->getObserver());
     glm::dvec3 observerPos = observerTransform[3];
     glm::dvec3 y           = observerTransform * glm::dvec4(0, 1, 0, 0);
     glm::dvec3 camDir      = glm::normalize(observerPos);
@@ -128,57 +114,59 @@ void AnchorLabel::update() {
     y = glm::normalize(y);
     z = glm::normalize(z);
 
-    auto rot = glm::toQuat(glm::dmat3(x, y, z));
-    mAnchor->setAnchorRotation(rot);
+    mAnchorRotation = glm::toQuat(glm::dmat3(x, y, z));
 
-    mAnchor->update(simulationTime, mSolarSystem->getObserver());
+    mRelativeTransform = glm::scale(anchorTransform * glm::mat4_cast(mAnchorRotation),
+        glm::dvec3(mAnchorScale));
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-glm::dvec4 AnchorLabel::getScreenSpaceBB() const {
-  double const width =
-      mPluginSettings->mLabelScale.get() * static_cast<double>(mGuiArea->getWidth()) * 0.0005;
-  double const height =
-      mPluginSettings->mLabelScale.get() * static_cast<double>(mGuiArea->getHeight()) * 0.0005;
+std::string const& AnchorLabel::getName() const {
+  return mName;
+}
 
-  auto const screenPos = (mRelativeAnchorPosition.xyz() / mRelativeAnchorPosition.z).xy();
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-  double const x = screenPos.x - (width / 2.0);
-  double const y = screenPos.y - (height / 2.0);
+std::string const& AnchorLabel::getCenterName() const {
+  return mAnchor.getCenterName();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-  return {x, y, width, height};
+std::string const& AnchorLabel::getFrameName() const {
+  return mAnchor.getFrameName();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void AnchorLabel::enable() const {
-  mGuiItem->setIsEnabled(true);
+glm::dvec3 const& AnchorLabel::getAnchorPosition() const {
+  return mAnchorPosition;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void AnchorLabel::disable() const {
-  mGuiItem->setIsEnabled(false);
+double AnchorLabel::getPriority() const {
+  return mPriority ? *mPriority : bodySize();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::string const& AnchorLabel::getCenterName() const {
-  return mBody->getCenterName();
+std::optional<double> const& AnchorLabel::getFixedPriority() const {
+  return mPriority;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 bool AnchorLabel::shouldBeHidden() const {
-  return !mBody->getIsInExistence();
+  return mBody && !mBody->getIsInExistence();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 double AnchorLabel::bodySize() const {
-  return mBody->pVisibleRadius();
+  return mBody ? mBody->pVisibleRadius() : 0.0;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -189,8 +177,34 @@ double AnchorLabel::distanceToCamera() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void AnchorLabel::setSortKey(int key) const {
-  VistaOpenSGMaterialTools::SetSortKeyOnSubtree(mGuiTransform.get(), key);
+glm::dvec3 const& AnchorLabel::getRelativePosition() const {
+  return mRelativeAnchorPosition;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double AnchorLabel::getAnchorScale() const {
+  return mAnchorScale;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::dquat const& AnchorLabel::getAnchorRotation() const {
+  return mAnchorRotation;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::dmat4 const& AnchorLabel::getRelativeTransform() const {
+  return mRelativeTransform;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t AnchorLabel::getMemoryUsage() const {
+  // Short strings are stored inside the label, so this slightly overestimates them.
+  return sizeof(AnchorLabel) + mName.capacity() + getCenterName().capacity() +
+         getFrameName().capacity();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -7,75 +7,106 @@
 #ifndef CSP_ANCHOR_LABELS_ANCHOR_LABEL_HPP
 #define CSP_ANCHOR_LABELS_ANCHOR_LABEL_HPP
 
+#include "../../../src/cs-scene/CelestialAnchor.hpp"
 #include "../../../src/cs-scene/CelestialBody.hpp"
 #include "../../../src/cs-utils/Property.hpp"
 #include "Plugin.hpp"
+#include "engine/EphemerisPrefetcher.hpp"
+#include "engine/TransformCache.hpp"
 
-class VistaOpenGLNode;
-class VistaTransformNode;
+#include <mutex>
+#include <optional>
 
 namespace cs::scene {
 class CelestialBody;
-class CelestialAnchorNode;
 } // namespace cs::scene
 
-namespace cs::gui {
-class WorldSpaceGuiArea;
-class GuiItem;
-} // namespace cs::gui
-
 namespace cs::core {
 class SolarSystem;
-class GuiManager;
 class TimeControl;
-class InputManager;
 } // namespace cs::core
 
 namespace csp::anchorlabels {
+
+/// The AnchorLabel is the logical representation of the label of one celestial body or of one
+/// entry of a point catalog. It is cheap to create, as it only computes where the label would be
+/// placed. The GuiItem and the scene graph nodes which are required to actually draw the label are
+/// provided by a LabelVisualPool while the label is shown.
 class AnchorLabel {
  public:
+  /// Creates the label of a body. If a priority is given, it replaces the size of the body.
   AnchorLabel(cs::scene::CelestialBody const* body,
-      std::shared_ptr<Plugin::Settings>       pluginSettings,
-      std::shared_ptr<cs::core::SolarSystem>  solarSystem,
-      std::shared_ptr<cs::core::GuiManager>   guiManager,
-      std::shared_ptr<cs::core::TimeControl>  timeControl,
-      std::shared_ptr<cs::core::InputManager> inputManager);
+      std::shared_ptr<Plugin::Settings>      pluginSettings,
+      std::shared_ptr<cs::core::SolarSystem> solarSystem,
+      std::shared_ptr<cs::core::TimeControl> timeControl,
+      std::optional<double>                  priority = std::nullopt);
+
+  /// Creates the label of a point which does not belong to a body. The position is given in
+  /// meters relative to the center in the given frame.
+  AnchorLabel(std::string name, std::string const& centerName, std::string const& frameName,
+      glm::dvec3 const& position, double priority,
+      std::shared_ptr<Plugin::Settings>      pluginSettings,
+      std::shared_ptr<cs::core::SolarSystem> solarSystem,
+      std::shared_ptr<cs::core::TimeControl> timeControl);
+
+  /// Computes the observer-relative position, the scale and the rotation of the label. This does
+  /// not modify the scene graph, so it may be called for several labels in parallel. The frame
+  /// transformation is looked up in the given cache first, then it is interpolated from the
+  /// samples of the prefetcher. If SPICE has to be queried, this is serialized with the given
+  /// mutex.
+  void update(TransformCache& transformCache, EphemerisPrefetcher const& prefetcher,
+      std::mutex& spiceMutex);
+
+  /// The text of the label. For bodies, this is the name of their center.
+  std::string const& getName() const;
+  std::string const& getCenterName() const;
+  std::string const& getFrameName() const;
 
-  ~AnchorLabel();
+  /// The position of the labeled point relative to the center. This is zero for bodies.
+  glm::dvec3 const& getAnchorPosition() const;
 
-  void update();
+  /// Labels with a higher priority win if labels overlap. For bodies, this is their size unless
+  /// a priority was given on construction.
+  double getPriority() const;
 
-  std::string const& getCenterName() const;
+  /// The priority given on construction. This is always set for labels of points.
+  std::optional<double> const& getFixedPriority() const;
 
   bool   shouldBeHidden() const;
-  double bodySize() const;
+  double bodySize() const; ///< Zero for points which do not belong to a body.
   double distanceToCamera() const;
 
-  void setSortKey(int key) const;
+  /// The position, scale and rotation of the label's anchor as computed in the last call to
+  /// update(). The position is relative to the observer.
+  glm::dvec3 const& getRelativePosition() const;
+  double            getAnchorScale() const;
+  glm::dquat const& getAnchorRotation() const;
 
-  void enable() const;
-  void disable() const;
+  /// The combination of the above, it transforms from the local coordinate system of the label to
+  /// the observer. The LabelVisuals and the LabelBatch apply this to the scene graph, so SPICE is
+  /// only queried in update(), through the TransformCache and the EphemerisPrefetcher.
+  glm::dmat4 const& getRelativeTransform() const;
 
-  glm::dvec4 getScreenSpaceBB() const;
+  /// The number of bytes used by this label, including its strings. The LabelVisual which may be
+  /// bound to the label is not included.
+  std::size_t getMemoryUsage() const;
 
  private:
   cs::scene::CelestialBody const* const mBody;
 
-  std::shared_ptr<Plugin::Settings>       mPluginSettings;
-  std::shared_ptr<cs::core::SolarSystem>  mSolarSystem;
-  std::shared_ptr<cs::core::GuiManager>   mGuiManager;
-  std::shared_ptr<cs::core::TimeControl>  mTimeControl;
-  std::shared_ptr<cs::core::InputManager> mInputManager;
-
-  std::shared_ptr<cs::scene::CelestialAnchorNode> mAnchor;
+  std::shared_ptr<Plugin::Settings>      mPluginSettings;
+  std::shared_ptr<cs::core::SolarSystem> mSolarSystem;
+  std::shared_ptr<cs::core::TimeControl> mTimeControl;
 
-  std::unique_ptr<cs::gui::WorldSpaceGuiArea> mGuiArea;
-  std::unique_ptr<cs::gui::GuiItem>           mGuiItem;
-  std::unique_ptr<VistaOpenGLNode>            mGuiNode;
-  std::unique_ptr<VistaTransformNode>         mGuiTransform;
+  cs::scene::CelestialAnchor mAnchor;
+  std::string                mName;
+  glm::dvec3                 mAnchorPosition{};
+  std::optional<double>      mPriority;
 
   glm::dvec3 mRelativeAnchorPosition{};
-  int        mOffsetConnection = -1;
+  double     mAnchorScale = 1.0;
+  glm::dquat mAnchorRotation{1.0, 0.0, 0.0, 0.0};
+  glm::dmat4 mRelativeTransform{1.0};
 };
 } // namespace csp::anchorlabels
 
@@ -0,0 +1,108 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "CatalogLabelSource.hpp"
+
+#include "../../../src/cs-scene/CelestialObserver.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <iterator>
+
+namespace csp::anchorlabels {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool CatalogLabelSource::open(std::string const& fileName) {
+  mFileName = fileName;
+  mAnchors.clear();
+  mTransforms.clear();
+  mActiveEntries.clear();
+  mAddedEntries.clear();
+  mRemovedEntries.clear();
+  mIndex.clear();
+
+  if (!mCatalog.open(fileName)) {
+    return false;
+  }
+
+  for (uint32_t i = 0; i < mCatalog.getReferenceCount(); ++i) {
+    mAnchors.emplace_back(
+        std::string(mCatalog.getCenterName(i)), std::string(mCatalog.getFrameName(i)));
+  }
+  mTransforms.resize(mAnchors.size());
+
+  mIndex.build(mCatalog);
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string const& CatalogLabelSource::getFileName() const {
+  return mFileName;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+PointCatalog const& CatalogLabelSource::getCatalog() const {
+  return mCatalog;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void CatalogLabelSource::update(double simulationTime,
+    cs::scene::CelestialObserver const& observer, std::optional<Transform> const& viewProjection,
+    double frustumMargin, std::size_t maxCount) {
+
+  for (std::size_t i = 0; i < mAnchors.size(); ++i) {
+    try {
+      glm::dmat4 transform = observer.getRelativeTransform(simulationTime, mAnchors[i]);
+      Transform& result    = mTransforms[i].emplace();
+      std::copy_n(glm::value_ptr(transform), result.size(), result.begin());
+    } catch (std::exception const&) {
+      // The ephemeris of the center may not be loaded or may not cover the current time.
+      mTransforms[i].reset();
+    }
+  }
+
+  mQueriedEntries.clear();
+  mIndex.query(mCatalog, mTransforms, viewProjection, frustumMargin, maxCount, mQueriedEntries);
+  std::sort(mQueriedEntries.begin(), mQueriedEntries.end());
+
+  mAddedEntries.clear();
+  std::set_difference(mQueriedEntries.begin(), mQueriedEntries.end(), mActiveEntries.begin(),
+      mActiveEntries.end(), std::back_inserter(mAddedEntries));
+
+  mRemovedEntries.clear();
+  std::set_difference(mActiveEntries.begin(), mActiveEntries.end(), mQueriedEntries.begin(),
+      mQueriedEntries.end(), std::back_inserter(mRemovedEntries));
+
+  mActiveEntries.swap(mQueriedEntries);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<uint32_t> const& CatalogLabelSource::getActiveEntries() const {
+  return mActiveEntries;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<uint32_t> const& CatalogLabelSource::getAddedEntries() const {
+  return mAddedEntries;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<uint32_t> const& CatalogLabelSource::getRemovedEntries() const {
+  return mRemovedEntries;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
@@ -0,0 +1,67 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_CATALOG_LABEL_SOURCE_HPP
+#define CSP_ANCHOR_LABELS_CATALOG_LABEL_SOURCE_HPP
+
+#include "../../../src/cs-scene/CelestialAnchor.hpp"
+#include "engine/PointCatalog.hpp"
+#include "engine/PointCatalogIndex.hpp"
+#include "engine/Transform.hpp"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace cs::scene {
+class CelestialObserver;
+} // namespace cs::scene
+
+namespace csp::anchorlabels {
+
+/// The CatalogLabelSource provides the labels of a PointCatalog. As a catalog may contain millions
+/// of entries, only the entries with the highest priority in the field of view get a label. These
+/// are looked up once per frame in a PointCatalogIndex. The Plugin creates AnchorLabels for the
+/// entries which have been added and removes those of the entries which have been removed.
+class CatalogLabelSource {
+ public:
+  /// Maps the given catalog and builds its index. Returns false if the file is not a valid
+  /// catalog.
+  bool open(std::string const& fileName);
+
+  std::string const&  getFileName() const;
+  PointCatalog const& getCatalog() const;
+
+  /// Determines the entries which should have a label in this frame. The matrices of all centers
+  /// and frames of the catalog are computed once. Entries whose center is not available at the
+  /// given time are skipped.
+  void update(double simulationTime, cs::scene::CelestialObserver const& observer,
+      std::optional<Transform> const& viewProjection, double frustumMargin, std::size_t maxCount);
+
+  /// The entries which have a label, sorted by index.
+  std::vector<uint32_t> const& getActiveEntries() const;
+
+  /// The entries which got or lost their label in the last call to update(), sorted by index.
+  std::vector<uint32_t> const& getAddedEntries() const;
+  std::vector<uint32_t> const& getRemovedEntries() const;
+
+ private:
+  std::string       mFileName;
+  PointCatalog      mCatalog;
+  PointCatalogIndex mIndex;
+
+  /// One anchor and one observer-relative transformation per reference of the catalog.
+  std::vector<cs::scene::CelestialAnchor> mAnchors;
+  std::vector<std::optional<Transform>>   mTransforms;
+
+  std::vector<uint32_t> mActiveEntries;
+  std::vector<uint32_t> mQueriedEntries;
+  std::vector<uint32_t> mAddedEntries;
+  std::vector<uint32_t> mRemovedEntries;
+};
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_CATALOG_LABEL_SOURCE_HPP
@@ -0,0 +1,111 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "FrustumProbe.hpp"
+
+#include "../../../src/cs-utils/utils.hpp"
+
+#include <GL/glew.h>
+#include <VistaKernel/GraphicsManager/VistaGraphicsManager.h>
+#include <VistaKernel/GraphicsManager/VistaOpenGLNode.h>
+#include <VistaKernel/GraphicsManager/VistaSceneGraph.h>
+#include <VistaKernel/VistaSystem.h>
+#include <VistaKernelOpenSGExt/VistaOpenSGMaterialTools.h>
+#include <VistaMath/VistaBoundingBox.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+namespace csp::anchorlabels {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FrustumProbe::FrustumProbe() {
+  auto* sceneGraph = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
+  mNode.reset(sceneGraph->NewOpenGLNode(sceneGraph->GetRoot(), this));
+
+  // The labels are drawn as transparent items, so the probe is always drawn before them.
+  VistaOpenSGMaterialTools::SetSortKeyOnSubtree(
+      mNode.get(), static_cast<int>(cs::utils::DrawOrder::eOpaqueItems));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FrustumProbe::~FrustumProbe() {
+  auto* sceneGraph = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
+  sceneGraph->GetRoot()->DisconnectChild(mNode.get());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FrustumProbe::nextFrame() {
+  // If nothing was drawn, for example because the window is minimized, the views of the last
+  // drawn frame are kept.
+  if (!mRecordedViews.empty()) {
+    std::swap(mViews, mRecordedViews);
+    mRecordedViews.clear();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<View> const& FrustumProbe::getViews() const {
+  return mViews;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<Transform> FrustumProbe::getViewProjection() const {
+  if (mViews.empty() || !mViews.front().mProjection) {
+    return std::nullopt;
+  }
+
+  auto const& view = mViews.front();
+  glm::dmat4  viewProjection =
+      glm::make_mat4(view.mProjection->data()) * glm::make_mat4(view.mModelView.data());
+
+  Transform result{};
+  std::copy_n(glm::value_ptr(viewProjection), result.size(), result.begin());
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t FrustumProbe::getCurrentView() const {
+  return mRecordedViews.empty() ? 0 : mRecordedViews.size() - 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool FrustumProbe::Do() {
+  View      view;
+  Transform projection{};
+  glGetDoublev(GL_PROJECTION_MATRIX, projection.data());
+  glGetDoublev(GL_MODELVIEW_MATRIX, view.mModelView.data());
+  view.mProjection = projection;
+
+  mRecordedViews.push_back(view);
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool FrustumProbe::GetBoundingBox(VistaBoundingBox& bb) {
+  // The probe must never be culled, so it claims to fill the entire scene.
+  float const          extent = 1e10F;
+  std::array<float, 3> min{-extent, -extent, -extent};
+  std::array<float, 3> max{extent, extent, extent};
+  bb.SetBounds(min.data(), max.data());
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
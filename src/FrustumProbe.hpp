@@ -0,0 +1,69 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_FRUSTUM_PROBE_HPP
+#define CSP_ANCHOR_LABELS_FRUSTUM_PROBE_HPP
+
+#include "engine/Transform.hpp"
+#include "engine/ViewDeclutter.hpp"
+
+#include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+class VistaOpenGLNode;
+
+namespace csp::anchorlabels {
+
+/// The projection is only known while the scene is drawn. The FrustumProbe is attached to the
+/// root of the scene graph and records the view and projection matrices when it is traversed. It
+/// does not draw anything. The labels are placed in the update phase of the next frame, so the
+/// recorded matrices are one frame old.
+///
+/// In stereo, multi-window and multi-viewport setups, the scene is drawn once per view and frame.
+/// The views are identified by the order in which they are drawn. The probe is drawn before any
+/// label, so that the labels can ask it which view is currently drawn.
+class FrustumProbe : public IVistaOpenGLDraw {
+ public:
+  FrustumProbe();
+
+  FrustumProbe(FrustumProbe const& other) = delete;
+  FrustumProbe(FrustumProbe&& other)      = delete;
+
+  FrustumProbe& operator=(FrustumProbe const& other) = delete;
+  FrustumProbe& operator=(FrustumProbe&& other) = delete;
+
+  ~FrustumProbe() override;
+
+  /// Must be called once per frame before the scene is drawn. The views recorded while drawing the
+  /// last frame become available through getViews().
+  void nextFrame();
+
+  /// The views from which the scene was drawn in the last frame, in the order in which they were
+  /// drawn. This is empty until the scene has been drawn once.
+  std::vector<View> const& getViews() const;
+
+  /// The matrix which transforms observer-relative positions to clip space in the first view of
+  /// the last frame. This is empty until the scene has been drawn once.
+  std::optional<Transform> getViewProjection() const;
+
+  /// The index of the view which is drawn right now. This is only meaningful while the scene is
+  /// drawn.
+  std::size_t getCurrentView() const;
+
+  bool Do() override;
+  bool GetBoundingBox(VistaBoundingBox& bb) override;
+
+ private:
+  std::unique_ptr<VistaOpenGLNode> mNode;
+  std::vector<View>                mViews;
+  std::vector<View>                mRecordedViews; ///< The views drawn so far in this frame.
+};
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_FRUSTUM_PROBE_HPP
@@ -0,0 +1,571 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "LabelBatch.hpp"
+
+#include "AnchorLabel.hpp"
+#include "FrustumProbe.hpp"
+#include "LabelVisual.hpp"
+#include "logger.hpp"
+
+#include "../../../src/cs-gui/GuiItem.hpp"
+#include "../../../src/cs-gui/WorldSpaceGuiArea.hpp"
+#include "../../../src/cs-utils/utils.hpp"
+
+#include <GL/glew.h>
+#include <VistaKernel/GraphicsManager/VistaGraphicsManager.h>
+#include <VistaKernel/GraphicsManager/VistaOpenGLNode.h>
+#include <VistaKernel/GraphicsManager/VistaSceneGraph.h>
+#include <VistaKernel/VistaSystem.h>
+#include <VistaKernelOpenSGExt/VistaOpenSGMaterialTools.h>
+#include <VistaMath/VistaBoundingBox.h>
+#include <VistaOGLExt/VistaTexture.h>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <sstream>
+#include <utility>
+
+namespace csp::anchorlabels {
+
+namespace {
+
+/// The size of the atlas pages in pixels and the space around each text.
+uint32_t const PAGE_SIZE = 1024;
+uint32_t const PADDING   = 2;
+
+/// The number of frames a text stays in the atlas after its label has been hidden.
+uint64_t const TEXT_LIFETIME = 300;
+
+std::string const VERT_SHADER = R"(
+#version 330
+
+layout(location = 0) in vec2 iCorner;
+layout(location = 1) in mat4 iTransform;
+layout(location = 5) in vec4 iQuad;
+layout(location = 6) in vec4 iTexCoords;
+layout(location = 7) in uint iViewMask;
+
+uniform mat4 uMatModelView;
+uniform mat4 uMatProjection;
+uniform uint uViewBit;
+
+out vec2 vTexCoords;
+out vec3 vPosition;
+
+void main() {
+  // Labels which are hidden in the current view collapse to a point outside of the screen.
+  if ((iViewMask & uViewBit) == 0u) {
+    vTexCoords  = vec2(0);
+    vPosition   = vec3(0);
+    gl_Position = vec4(2, 2, 2, 1);
+    return;
+  }
+
+  vTexCoords  = mix(iTexCoords.xy, iTexCoords.zw, iCorner);
+  vPosition   = (uMatModelView * iTransform * vec4(mix(iQuad.xy, iQuad.zw, iCorner), 0, 1)).xyz;
+  gl_Position = uMatProjection * vec4(vPosition, 1);
+}
+)";
+
+std::string const FRAG_SHADER = R"(
+#version 330
+
+uniform sampler2D uTexture;
+uniform float     uFarClip;
+
+in vec2 vTexCoords;
+in vec3 vPosition;
+
+layout(location = 0) out vec4 oColor;
+
+void main() {
+  // Like the GuiAreas, the pages contain premultiplied colors.
+  vec4 color = texture(uTexture, vTexCoords);
+  if (color.a == 0.0) {
+    discard;
+  }
+
+  oColor = vec4(color.rgb / color.a, color.a);
+
+  // The LabelVisuals use a linear depth buffer as well.
+  gl_FragDepth = length(vPosition) / uFarClip;
+}
+)";
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+LabelBatch::LabelBatch(
+    std::shared_ptr<Plugin::Settings> pluginSettings, std::shared_ptr<FrustumProbe> frustumProbe)
+    : mPluginSettings(std::move(pluginSettings))
+    , mFrustumProbe(std::move(frustumProbe))
+    , mPageArea(std::make_unique<cs::gui::WorldSpaceGuiArea>(PAGE_SIZE, PAGE_SIZE)) {
+  auto* sceneGraph = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
+  mNode.reset(sceneGraph->NewOpenGLNode(sceneGraph->GetRoot(), this));
+
+  // The batch is drawn before the LabelVisuals, whose sort keys are all larger.
+  mSortKeyConnection = mPluginSettings->mSortKeyRange.connectAndTouch([this](uint32_t range) {
+    VistaOpenSGMaterialTools::SetSortKeyOnSubtree(mNode.get(),
+        static_cast<int>(cs::utils::DrawOrder::eTransparentItems) - static_cast<int>(range));
+  });
+
+  mShader.InitVertexShaderFromString(VERT_SHADER);
+  mShader.InitFragmentShaderFromString(FRAG_SHADER);
+  mShader.Link();
+
+  // All instances share the corners of the quad, everything else is specified per instance.
+  std::array<float, 8> const corners = {0.F, 0.F, 1.F, 0.F, 0.F, 1.F, 1.F, 1.F};
+
+  glGenVertexArrays(1, &mVertexArray);
+  glBindVertexArray(mVertexArray);
+
+  glGenBuffers(1, &mCornerBuffer);
+  glBindBuffer(GL_ARRAY_BUFFER, mCornerBuffer);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners.data(), GL_STATIC_DRAW);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+  glGenBuffers(1, &mInstanceBuffer);
+  for (GLuint i = 1; i <= 7; ++i) {
+    glEnableVertexAttribArray(i);
+    glVertexAttribDivisor(i, 1);
+  }
+
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  // The first page reports the metrics of the font, so it is created right away.
+  addPage();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+LabelBatch::~LabelBatch() {
+  for (auto const& item : mPageItems) {
+    item->unregisterCallback("onLoaded");
+    item->unregisterCallback("setFontMetrics");
+    mPageArea->removeItem(item.get());
+  }
+
+  glDeleteBuffers(1, &mInstanceBuffer);
+  glDeleteBuffers(1, &mCornerBuffer);
+  glDeleteVertexArrays(1, &mVertexArray);
+
+  auto* sceneGraph = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
+  sceneGraph->GetRoot()->DisconnectChild(mNode.get());
+
+  mPluginSettings->mSortKeyRange.disconnect(mSortKeyConnection);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LabelBatch::getIsReady() const {
+  return mIsReady;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelBatch::clear() {
+  if (!mInstances.empty()) {
+    mInstances.clear();
+    mIsDirty = true;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelBatch::add(AnchorLabel const* label, std::size_t clusterSize, LabelPlacement placement,
+    uint32_t viewMask) {
+  if (!mIsReady) {
+    return;
+  }
+
+  std::string text = label->getName();
+  if (clusterSize > 0) {
+    text += " +" + std::to_string(clusterSize);
+  }
+
+  auto& entry = mTexts[label];
+  if (entry.mEntry == TextAtlas::NO_ENTRY || entry.mText != text) {
+    if (entry.mEntry != TextAtlas::NO_ENTRY) {
+      mAtlas.release(entry.mEntry);
+    }
+
+    entry.mEntry = mAtlas.add(text);
+    entry.mText  = std::move(text);
+  }
+
+  // This is the same transformation as the one of the GuiArea of a LabelVisual.
+  PlacementOffset const offset = getPlacementOffset(placement);
+  double const          aspect = static_cast<double>(LabelVisual::HEIGHT) / LabelVisual::WIDTH;
+
+  glm::dmat4 transform = glm::translate(label->getRelativeTransform(),
+      glm::dvec3(0.0, mPluginSettings->mLabelOffset.get() + offset.mY * aspect, offset.mX));
+  transform = glm::rotate(transform, -glm::half_pi<double>(), glm::dvec3(0.0, 1.0, 0.0));
+  transform = glm::scale(transform, glm::dvec3(1.0, aspect, 1.0));
+
+  Instance instance;
+  instance.mLabel     = label;
+  instance.mEntry     = entry.mEntry;
+  instance.mViewMask  = viewMask;
+  instance.mTransform = transform;
+  mInstances.push_back(instance);
+
+  mIsDirty = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelBatch::setHiddenLabel(AnchorLabel const* label) {
+  if (label != mHiddenLabel) {
+    mHiddenLabel = label;
+    mIsDirty     = true;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelBatch::forget(AnchorLabel const* label) {
+  auto it = mTexts.find(label);
+  if (it == mTexts.end()) {
+    return;
+  }
+
+  mAtlas.release(it->second.mEntry);
+  mTexts.erase(it);
+
+  mInstances.erase(std::remove_if(mInstances.begin(), mInstances.end(),
+                       [label](Instance const& instance) { return instance.mLabel == label; }),
+      mInstances.end());
+
+  if (mHiddenLabel == label) {
+    mHiddenLabel = nullptr;
+  }
+
+  mIsDirty = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+AnchorLabel const* LabelBatch::pick(glm::dvec3 const& origin, glm::dvec3 const& direction) const {
+  AnchorLabel const* result  = nullptr;
+  double             closest = std::numeric_limits<double>::max();
+
+  // The ray is intersected with the plane of each quad in its local coordinate system. As the
+  // transformation is affine, the ray parameter is the same in both systems.
+  for (auto const& instance : mInstances) {
+    glm::dmat4 const inverse = glm::inverse(instance.mTransform);
+    glm::dvec3 const o       = inverse * glm::dvec4(origin, 1.0);
+    glm::dvec3 const d       = inverse * glm::dvec4(direction, 0.0);
+
+    double const t = -o.z / d.z;
+    if (!(t > 0.0 && t < closest)) {
+      continue;
+    }
+
+    glm::dvec2 const p    = glm::dvec2(o) + t * glm::dvec2(d);
+    auto const&      quad = instance.mQuad;
+    if (p.x >= quad.x && p.x <= quad.z && p.y >= quad.y && p.y <= quad.w) {
+      result  = instance.mLabel;
+      closest = t;
+    }
+  }
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t LabelBatch::flush() {
+  if (!mIsReady) {
+    return 0;
+  }
+
+  std::size_t mutations = 0;
+
+  // Texts which have not been shown for a while are released, so that their space in the atlas
+  // can be reused.
+  for (auto const& instance : mInstances) {
+    mTexts[instance.mLabel].mLastFrame = mFrameCount;
+  }
+
+  for (auto it = mTexts.begin(); it != mTexts.end();) {
+    if (it->second.mLastFrame + TEXT_LIFETIME < mFrameCount) {
+      mAtlas.release(it->second.mEntry);
+      it = mTexts.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  ++mFrameCount;
+
+  // New pages are loaded asynchronously. Pages which changed are rasterized again once they are
+  // loaded.
+  while (mPageItems.size() < mAtlas.getPageCount()) {
+    addPage();
+  }
+
+  for (uint32_t page = 0; page < mAtlas.getPageCount(); ++page) {
+    if (mIsPageLoaded[page] && mDrawnPageVersions[page] != mAtlas.getPageVersion(page)) {
+      drawPage(page);
+      ++mutations;
+    }
+  }
+
+  if (!mIsDirty) {
+    return mutations;
+  }
+
+  // The rectangles in the atlas may have moved if it has been repacked, so the layout is computed
+  // here and not in add().
+  double const width  = LabelVisual::WIDTH;
+  double const height = LabelVisual::HEIGHT;
+
+  for (auto& instance : mInstances) {
+    TextLayout const layout = mAtlas.getLayout(instance.mEntry, width, height);
+
+    // The quad of the GuiArea spans from -0.5 to 0.5, its y-axis points up.
+    instance.mPage      = mAtlas.getRect(instance.mEntry).mPage;
+    instance.mQuad      = glm::dvec4(layout.mX / width - 0.5,
+        0.5 - (layout.mY + layout.mHeight) / height, (layout.mX + layout.mWidth) / width - 0.5,
+        0.5 - layout.mY / height);
+    instance.mTexCoords = glm::dvec4(
+        layout.mU, layout.mV + layout.mVHeight, layout.mU + layout.mUWidth, layout.mV);
+  }
+
+  // The labels are drawn page by page. On each page, labels further away are drawn first.
+  std::vector<std::size_t> order;
+  for (std::size_t i = 0; i < mInstances.size(); ++i) {
+    if (mInstances[i].mLabel != mHiddenLabel) {
+      order.push_back(i);
+    }
+  }
+
+  std::sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) {
+    auto const& ia = mInstances[a];
+    auto const& ib = mInstances[b];
+    if (ia.mPage != ib.mPage) {
+      return ia.mPage < ib.mPage;
+    }
+    return glm::length(glm::dvec3(ia.mTransform[3])) > glm::length(glm::dvec3(ib.mTransform[3]));
+  });
+
+  mInstanceData.resize(order.size());
+  mPageRanges.clear();
+
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    auto const& instance = mInstances[order[i]];
+    auto&       data     = mInstanceData[i];
+
+    for (int column = 0; column < 4; ++column) {
+      for (int row = 0; row < 4; ++row) {
+        data.mTransform[column * 4 + row] = static_cast<float>(instance.mTransform[column][row]);
+      }
+      data.mQuad[column]      = static_cast<float>(instance.mQuad[column]);
+      data.mTexCoords[column] = static_cast<float>(instance.mTexCoords[column]);
+    }
+
+    data.mViewMask = instance.mViewMask;
+
+    if (mPageRanges.empty() || mPageRanges.back().mPage != instance.mPage) {
+      mPageRanges.push_back({instance.mPage, i, 0});
+    }
+    ++mPageRanges.back().mCount;
+  }
+
+  mUploadNeeded = true;
+  mIsDirty      = false;
+
+  return mutations + 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+MemoryUsage LabelBatch::getMemoryUsage() const {
+  MemoryUsage usage;
+
+  for (std::size_t page = 0; page < mPageItems.size(); ++page) {
+    usage += estimateGuiItemMemory(PAGE_SIZE, PAGE_SIZE);
+  }
+
+  // Each text is stored here and in the atlas.
+  for (auto const& text : mTexts) {
+    usage.mMainMemory += sizeof(text) + 2 * text.second.mText.capacity();
+  }
+
+  usage.mMainMemory += csp::anchorlabels::getMemoryUsage(mInstances) +
+                       csp::anchorlabels::getMemoryUsage(mInstanceData);
+  usage.mTextureMemory += mInstanceData.size() * sizeof(InstanceData);
+
+  return usage;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LabelBatch::Do() {
+  if (mUploadNeeded) {
+    glBindBuffer(GL_ARRAY_BUFFER, mInstanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER,
+        static_cast<GLsizeiptr>(mInstanceData.size() * sizeof(InstanceData)),
+        mInstanceData.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    mUploadNeeded = false;
+  }
+
+  if (mPageRanges.empty()) {
+    return true;
+  }
+
+  std::array<GLfloat, 16> glMatMV{};
+  std::array<GLfloat, 16> glMatP{};
+  glGetFloatv(GL_MODELVIEW_MATRIX, glMatMV.data());
+  glGetFloatv(GL_PROJECTION_MATRIX, glMatP.data());
+
+  glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glEnable(GL_DEPTH_TEST);
+  glDisable(GL_CULL_FACE);
+
+  mShader.Bind();
+  glUniformMatrix4fv(mShader.GetUniformLocation("uMatModelView"), 1, GL_FALSE, glMatMV.data());
+  glUniformMatrix4fv(mShader.GetUniformLocation("uMatProjection"), 1, GL_FALSE, glMatP.data());
+  mShader.SetUniform(mShader.GetUniformLocation("uTexture"), 0);
+
+  // Views beyond the bits of the mask are not decluttered, they show all visible labels.
+  std::size_t const view    = mFrustumProbe->getCurrentView();
+  GLuint const      viewBit = view < ViewDeclutter::MAX_VIEWS ? 1U << view : ~0U;
+  glUniform1ui(mShader.GetUniformLocation("uViewBit"), viewBit);
+  mShader.SetUniform(
+      mShader.GetUniformLocation("uFarClip"), cs::utils::getCurrentFarClipDistance());
+
+  glBindVertexArray(mVertexArray);
+  glBindBuffer(GL_ARRAY_BUFFER, mInstanceBuffer);
+
+  GLsizei const stride = sizeof(InstanceData);
+
+  for (auto const& range : mPageRanges) {
+    // The instance attributes start at the first instance of the page.
+    std::size_t const first = range.mFirst * sizeof(InstanceData);
+    for (GLuint column = 0; column < 4; ++column) {
+      glVertexAttribPointer(1 + column, 4, GL_FLOAT, GL_FALSE, stride,
+          reinterpret_cast<void*>(first + column * 4 * sizeof(float))); // NOLINT
+    }
+    glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, stride,
+        reinterpret_cast<void*>(first + offsetof(InstanceData, mQuad))); // NOLINT
+    glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, stride,
+        reinterpret_cast<void*>(first + offsetof(InstanceData, mTexCoords))); // NOLINT
+    glVertexAttribIPointer(7, 1, GL_UNSIGNED_INT, stride,
+        reinterpret_cast<void*>(first + offsetof(InstanceData, mViewMask))); // NOLINT
+
+    auto* texture = mPageItems[range.mPage]->getTexture();
+    texture->Bind(GL_TEXTURE0);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(range.mCount));
+    texture->Unbind(GL_TEXTURE0);
+  }
+
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+  mShader.Release();
+  glPopAttrib();
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LabelBatch::GetBoundingBox(VistaBoundingBox& bb) {
+  // The labels may be anywhere, so the batch claims to fill the entire scene.
+  float const          extent = 1e10F;
+  std::array<float, 3> min{-extent, -extent, -extent};
+  std::array<float, 3> max{extent, extent, extent};
+  bb.SetBounds(min.data(), max.data());
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelBatch::addPage() {
+  std::size_t const page = mPageItems.size();
+
+  auto item = std::make_unique<cs::gui::GuiItem>(
+      "file://../share/resources/gui/anchor_label_atlas.html");
+  item->setCanScroll(false);
+
+  // Like the LabelVisuals, we do not wait for the page to finish loading.
+  item->registerCallback("onLoaded", "Called by an anchor label atlas page once it is loaded.",
+      [this, page] { mIsPageLoaded[page] = true; });
+
+  item->registerCallback("setFontMetrics",
+      "Reports the widths of the characters and the line height of the anchor label font.",
+      std::function([this](std::string advances, double lineHeight) {
+        setFontMetrics(advances, lineHeight);
+      }));
+
+  mPageArea->addItem(item.get());
+  mPageItems.push_back(std::move(item));
+  mIsPageLoaded.push_back(false);
+  mDrawnPageVersions.push_back(0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelBatch::drawPage(uint32_t page) {
+  std::vector<uint32_t> entries;
+  mAtlas.getPageEntries(page, entries);
+
+  // The texts are passed with the top left corner of the text inside the padding.
+  auto texts = nlohmann::json::array();
+  for (uint32_t entry : entries) {
+    auto const& rect = mAtlas.getRect(entry);
+    texts.push_back(
+        {mAtlas.getText(entry), rect.mX + mAtlas.getPadding(), rect.mY + mAtlas.getPadding()});
+  }
+
+  mPageItems[page]->callJavascript("drawPage", texts.dump());
+  mDrawnPageVersions[page] = mAtlas.getPageVersion(page);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelBatch::setFontMetrics(std::string const& advances, double lineHeight) {
+  // All pages report the metrics, only the first report is used.
+  if (mIsReady) {
+    return;
+  }
+
+  std::vector<float> values;
+  std::stringstream  stream(advances);
+  std::string        value;
+  while (std::getline(stream, value, ',')) {
+    values.push_back(std::stof(value));
+  }
+
+  FontMetrics metrics;
+  if (values.size() != metrics.mAdvances.size() + 1) {
+    logger().warn("Received {} character widths for the text atlas, expected {}!", values.size(),
+        metrics.mAdvances.size() + 1);
+    return;
+  }
+
+  std::copy_n(values.begin(), metrics.mAdvances.size(), metrics.mAdvances.begin());
+  metrics.mDefaultAdvance = values.back();
+  metrics.mLineHeight     = static_cast<float>(lineHeight);
+
+  mAtlas.reset(metrics, PAGE_SIZE, PADDING);
+  mIsReady = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
@@ -0,0 +1,158 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_LABEL_BATCH_HPP
+#define CSP_ANCHOR_LABELS_LABEL_BATCH_HPP
+
+#include "Plugin.hpp"
+#include "engine/LabelPlacement.hpp"
+#include "engine/MemoryUsage.hpp"
+#include "engine/TextAtlas.hpp"
+
+#include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
+#include <VistaOGLExt/VistaGLSLShader.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class VistaOpenGLNode;
+
+namespace cs::gui {
+class WorldSpaceGuiArea;
+class GuiItem;
+} // namespace cs::gui
+
+namespace csp::anchorlabels {
+class AnchorLabel;
+class FrustumProbe;
+
+/// The LabelBatch draws the texts of many labels at once. The texts are packed into a TextAtlas
+/// whose pages are rasterized by GuiItems showing anchor_label_atlas.html. All labels on the same
+/// page are drawn with one instanced draw call, so the cost per label is a few floats instead of a
+/// web page. The labels look like those drawn by LabelVisuals, but they cannot be highlighted or
+/// clicked. The plugin therefore uses a LabelVisual for the label under the pointer.
+class LabelBatch : public IVistaOpenGLDraw {
+ public:
+  LabelBatch(std::shared_ptr<Plugin::Settings> pluginSettings,
+      std::shared_ptr<FrustumProbe>            frustumProbe);
+
+  LabelBatch(LabelBatch const& other) = delete;
+  LabelBatch(LabelBatch&& other)      = delete;
+
+  LabelBatch& operator=(LabelBatch const& other) = delete;
+  LabelBatch& operator=(LabelBatch&& other) = delete;
+
+  ~LabelBatch() override;
+
+  /// The atlas can only be packed once the first page has reported the metrics of its font. Until
+  /// then, all labels have to be drawn by LabelVisuals.
+  bool getIsReady() const;
+
+  /// Removes all labels from the batch. Their texts stay in the atlas for a while, so that they do
+  /// not have to be rasterized again if the labels are shown again soon.
+  void clear();
+
+  /// Adds a label which is drawn from now on. The position, scale and rotation are taken from the
+  /// last call to AnchorLabel::update(). The cluster size, the placement and the view mask have
+  /// the same meaning as for LabelVisuals.
+  void add(AnchorLabel const* label, std::size_t clusterSize, LabelPlacement placement,
+      uint32_t viewMask);
+
+  /// The given label is drawn by a LabelVisual. It is still considered by pick(), but not drawn.
+  void setHiddenLabel(AnchorLabel const* label);
+
+  /// Removes the text of the label from the atlas. This has to be called before the label is
+  /// deleted.
+  void forget(AnchorLabel const* label);
+
+  /// Returns the closest label whose text is hit by the given ray, or nullptr if there is none.
+  /// The ray is given relative to the observer.
+  AnchorLabel const* pick(glm::dvec3 const& origin, glm::dvec3 const& direction) const;
+
+  /// Releases texts which have not been shown for a while, rasterizes the pages which changed and
+  /// prepares the instances for drawing. Returns the number of modifications of the GuiItems and
+  /// the instance data, which is zero if nothing changed.
+  std::size_t flush();
+
+  /// An estimate of the memory used by the atlas pages, the texts and the instance data.
+  MemoryUsage getMemoryUsage() const;
+
+  bool Do() override;
+  bool GetBoundingBox(VistaBoundingBox& bb) override;
+
+ private:
+  struct Text {
+    std::string mText;
+    uint32_t    mEntry     = TextAtlas::NO_ENTRY;
+    uint64_t    mLastFrame = 0;
+  };
+
+  struct Instance {
+    AnchorLabel const* mLabel    = nullptr;
+    uint32_t           mEntry    = TextAtlas::NO_ENTRY;
+    uint32_t           mPage     = 0;
+    uint32_t           mViewMask = ~0U;
+    glm::dmat4         mTransform{1.0}; ///< From the GuiArea quad to the observer.
+    glm::dvec4         mQuad{};         ///< The drawn part of the quad, min and max corner.
+    glm::dvec4         mTexCoords{};    ///< The corresponding texture coordinates.
+  };
+
+  /// The per-instance vertex attributes.
+  struct InstanceData {
+    std::array<float, 16> mTransform;
+    std::array<float, 4>  mQuad;
+    std::array<float, 4>  mTexCoords;
+    uint32_t              mViewMask;
+  };
+
+  struct PageRange {
+    uint32_t    mPage  = 0;
+    std::size_t mFirst = 0;
+    std::size_t mCount = 0;
+  };
+
+  void addPage();
+  void drawPage(uint32_t page);
+  void setFontMetrics(std::string const& advances, double lineHeight);
+
+  std::shared_ptr<Plugin::Settings> mPluginSettings;
+  std::shared_ptr<FrustumProbe>     mFrustumProbe;
+
+  /// The texts of the labels which have been shown recently and the labels which are shown now.
+  TextAtlas                                    mAtlas;
+  bool                                         mIsReady = false;
+  std::unordered_map<AnchorLabel const*, Text> mTexts;
+  std::vector<Instance>                        mInstances;
+  AnchorLabel const*                           mHiddenLabel = nullptr;
+  bool                                         mIsDirty     = false;
+  uint64_t                                     mFrameCount  = 0;
+
+  /// Each page is rasterized by its own GuiItem. They are not part of the scene graph, the area
+  /// only gives them their size.
+  std::unique_ptr<cs::gui::WorldSpaceGuiArea>    mPageArea;
+  std::vector<std::unique_ptr<cs::gui::GuiItem>> mPageItems;
+  std::vector<bool>                              mIsPageLoaded;
+  std::vector<uint64_t>                          mDrawnPageVersions;
+
+  /// The instance data is uploaded by the next call to Do().
+  std::vector<InstanceData> mInstanceData;
+  std::vector<PageRange>    mPageRanges;
+  bool                      mUploadNeeded = false;
+
+  std::unique_ptr<VistaOpenGLNode> mNode;
+  VistaGLSLShader                  mShader;
+  unsigned int                     mVertexArray       = 0;
+  unsigned int                     mCornerBuffer      = 0;
+  unsigned int                     mInstanceBuffer    = 0;
+  int                              mSortKeyConnection = -1;
+};
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_LABEL_BATCH_HPP
@@ -0,0 +1,289 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "LabelVisual.hpp"
+
+#include "AnchorLabel.hpp"
+#include "FrustumProbe.hpp"
+
+#include "../../../src/cs-core/GuiManager.hpp"
+#include "../../../src/cs-core/InputManager.hpp"
+#include "../../../src/cs-core/SolarSystem.hpp"
+#include "../../../src/cs-gui/GuiItem.hpp"
+#include "../../../src/cs-gui/WorldSpaceGuiArea.hpp"
+
+#include <VistaKernel/GraphicsManager/VistaGraphicsManager.h>
+#include <VistaKernel/GraphicsManager/VistaOpenGLNode.h>
+#include <VistaKernel/GraphicsManager/VistaSceneGraph.h>
+#include <VistaKernel/GraphicsManager/VistaTransformNode.h>
+#include <VistaKernel/VistaSystem.h>
+#include <VistaKernelOpenSGExt/VistaOpenSGMaterialTools.h>
+#include <glm/gtc/type_ptr.hpp>
+#include <utility>
+
+namespace csp::anchorlabels {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The scene graph is the same for all views, so the GuiArea decides for itself whether it is drawn
+// in the view which is currently drawn. The InputManager still finds the node in all views.
+class LabelVisual::MaskedGuiArea : public cs::gui::WorldSpaceGuiArea {
+ public:
+  MaskedGuiArea(int width, int height, std::shared_ptr<FrustumProbe> frustumProbe)
+      : cs::gui::WorldSpaceGuiArea(width, height)
+      , mFrustumProbe(std::move(frustumProbe)) {
+  }
+
+  void setViewMask(uint32_t mask) {
+    mViewMask = mask;
+  }
+
+  bool Do() override {
+    // Views beyond the bits of the mask are not decluttered, they show all visible labels.
+    std::size_t const view = mFrustumProbe->getCurrentView();
+    if (view < ViewDeclutter::MAX_VIEWS && (mViewMask & (1U << view)) == 0) {
+      return true;
+    }
+
+    return cs::gui::WorldSpaceGuiArea::Do();
+  }
+
+ private:
+  std::shared_ptr<FrustumProbe> mFrustumProbe;
+  uint32_t                      mViewMask = ~0U;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+LabelVisual::LabelVisual(std::shared_ptr<Plugin::Settings> pluginSettings,
+    std::shared_ptr<cs::core::SolarSystem>                 solarSystem,
+    std::shared_ptr<cs::core::GuiManager>                  guiManager,
+    std::shared_ptr<cs::core::InputManager>                inputManager,
+    std::shared_ptr<FrustumProbe>                          frustumProbe)
+    : mPluginSettings(std::move(pluginSettings))
+    , mSolarSystem(std::move(solarSystem))
+    , mGuiManager(std::move(guiManager))
+    , mInputManager(std::move(inputManager))
+    , mGuiArea(std::make_unique<MaskedGuiArea>(WIDTH, HEIGHT, std::move(frustumProbe)))
+    , mGuiItem(
+          std::make_unique<cs::gui::GuiItem>("file://../share/resources/gui/anchor_label.html")) {
+  auto* sceneGraph = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
+
+  // The anchor is positioned relative to the observer by flush(), using the transformation which
+  // has been computed in AnchorLabel::update().
+  mAnchor.reset(sceneGraph->NewTransformNode(sceneGraph->GetRoot()));
+  mAnchor->SetIsEnabled(false);
+
+  mGuiTransform.reset(sceneGraph->NewTransformNode(mAnchor.get()));
+  mGuiTransform->SetScale(1.0F,
+      static_cast<float>(mGuiArea->getHeight()) / static_cast<float>(mGuiArea->getWidth()), 1.0F);
+  applyTranslation();
+  mGuiTransform->Rotate(VistaAxisAndAngle(VistaVector3D(0.0, 1.0, 0.0), -glm::pi<float>() / 2.F));
+
+  // The node is only registered with the InputManager while the visual is enabled, see flush().
+  mGuiNode.reset(sceneGraph->NewOpenGLNode(mGuiTransform.get(), mGuiArea.get()));
+
+  mGuiArea->addItem(mGuiItem.get());
+  mGuiArea->setUseLinearDepthBuffer(true);
+  mGuiArea->setIgnoreDepth(false);
+
+  mGuiItem->setCanScroll(false);
+  mGuiItem->setIsEnabled(false);
+
+  // We do not wait for the page to finish loading, as this would stall the main thread. Instead,
+  // the page notifies us once it is ready.
+  mGuiItem->registerCallback("onLoaded",
+      "Called by the anchor label page once it has been loaded.", [this] { mIsLoaded = true; });
+
+  mGuiItem->registerCallback(
+      "flyToBody", "Makes the observer fly to the planet marked by this anchor label.", [this] {
+        // Labels of catalog entries fly to the center of the entry.
+        if (mLabel) {
+          mSolarSystem->flyObserverTo(mLabel->getCenterName(), mLabel->getFrameName(), 5.0);
+          mGuiManager->showNotification("Travelling", "to " + mLabel->getName(), "send");
+        }
+      });
+
+  mOffsetConnection = mPluginSettings->mLabelOffset.connect([this](double /*newOffset*/) {
+    applyTranslation();
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+LabelVisual::~LabelVisual() {
+  mGuiItem->unregisterCallback("onLoaded");
+  mGuiItem->unregisterCallback("flyToBody");
+
+  mGuiTransform->DisconnectChild(mGuiNode.get());
+  mAnchor->DisconnectChild(mGuiTransform.get());
+  auto* sceneGraph = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
+  sceneGraph->GetRoot()->DisconnectChild(mAnchor.get());
+
+  if (mAppliedIsEnabled) {
+    mInputManager->unregisterSelectable(mGuiNode.get());
+  }
+
+  mPluginSettings->mLabelOffset.disconnect(mOffsetConnection);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+MemoryUsage LabelVisual::getMemoryUsage() {
+  MemoryUsage usage = estimateGuiItemMemory(WIDTH, HEIGHT);
+  usage.mMainMemory += sizeof(LabelVisual) + sizeof(MaskedGuiArea) + sizeof(cs::gui::GuiItem);
+  return usage;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LabelVisual::getIsLoaded() const {
+  return mIsLoaded;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelVisual::bind(AnchorLabel const* label) {
+  if (label == mLabel) {
+    return;
+  }
+
+  mLabel       = label;
+  mClusterSize = 0;
+  mPlacement   = LabelPlacement::eDefault;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+AnchorLabel const* LabelVisual::getLabel() const {
+  return mLabel;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelVisual::update() {
+  mIsUpdatePending = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelVisual::setSortKey(int key) {
+  mSortKey = key;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelVisual::setClusterSize(std::size_t size) {
+  mClusterSize = size;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelVisual::setViewMask(uint32_t mask) {
+  mViewMask = mask;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelVisual::setIsEnabled(bool enable) {
+  mIsEnabled = enable;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelVisual::setPlacement(LabelPlacement placement) {
+  mPlacement = placement;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LabelVisual::getIsEnabled() const {
+  return mIsEnabled;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t LabelVisual::flush() {
+  std::size_t mutations = 0;
+
+  // Hidden visuals are not moved, they will be updated again before they are shown.
+  if (mIsUpdatePending && mIsEnabled && mLabel) {
+    glm::fmat4 const transform(mLabel->getRelativeTransform());
+    mAnchor->SetTransform(VistaTransformMatrix(glm::value_ptr(transform), true));
+    ++mutations;
+  }
+
+  mIsUpdatePending = false;
+
+  // This traverses the entire subtree, so it is only done if the key actually changed.
+  if (mSortKey != mAppliedSortKey) {
+    VistaOpenSGMaterialTools::SetSortKeyOnSubtree(mGuiTransform.get(), mSortKey);
+    mAppliedSortKey = mSortKey;
+    ++mutations;
+  }
+
+  if (mViewMask != mAppliedViewMask) {
+    mGuiArea->setViewMask(mViewMask);
+    mAppliedViewMask = mViewMask;
+    ++mutations;
+  }
+
+  if (mPlacement != mAppliedPlacement) {
+    mAppliedPlacement = mPlacement;
+    applyTranslation();
+    ++mutations;
+  }
+
+  // The text is kept while the visual is released, so that it does not have to be sent again if
+  // the label is shown again.
+  if (mLabel && mIsEnabled) {
+    std::string text = mLabel->getName();
+    if (mClusterSize > 0) {
+      text += " +" + std::to_string(mClusterSize);
+    }
+
+    if (text != mAppliedText) {
+      mGuiItem->callJavascript("setLabelText", text);
+      mAppliedText = std::move(text);
+      ++mutations;
+    }
+  }
+
+  // Disabled nodes are neither drawn nor traversed when picking. They are not registered with the
+  // InputManager either, so that its intersection tests only consider the labels which are shown.
+  if (mIsEnabled != mAppliedIsEnabled) {
+    mGuiItem->setIsEnabled(mIsEnabled);
+    mAnchor->SetIsEnabled(mIsEnabled);
+
+    if (mIsEnabled) {
+      mInputManager->registerSelectable(mGuiNode.get());
+    } else {
+      mInputManager->unregisterSelectable(mGuiNode.get());
+    }
+
+    mAppliedIsEnabled = mIsEnabled;
+    ++mutations;
+  }
+
+  return mutations;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelVisual::applyTranslation() {
+  // The translation is given in units of the label width. The GuiArea is rotated around the
+  // y-axis, so that its horizontal axis is the z-axis of the anchor.
+  PlacementOffset const offset = getPlacementOffset(mAppliedPlacement);
+  double const          aspect = static_cast<double>(HEIGHT) / static_cast<double>(WIDTH);
+
+  mGuiTransform->SetTranslation(0.0F,
+      static_cast<float>(mPluginSettings->mLabelOffset.get() + offset.mY * aspect),
+      static_cast<float>(offset.mX));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
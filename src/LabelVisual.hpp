@@ -0,0 +1,144 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_LABEL_VISUAL_HPP
+#define CSP_ANCHOR_LABELS_LABEL_VISUAL_HPP
+
+#include "Plugin.hpp"
+#include "engine/LabelPlacement.hpp"
+#include "engine/MemoryUsage.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+class VistaOpenGLNode;
+class VistaTransformNode;
+
+namespace cs::gui {
+class WorldSpaceGuiArea;
+class GuiItem;
+} // namespace cs::gui
+
+namespace cs::core {
+class SolarSystem;
+class GuiManager;
+class InputManager;
+} // namespace cs::core
+
+namespace csp::anchorlabels {
+class AnchorLabel;
+class FrustumProbe;
+
+/// The LabelVisual contains everything which is required to draw an AnchorLabel: A GuiItem showing
+/// anchor_label.html, a WorldSpaceGuiArea and the scene graph nodes. As these are expensive, they
+/// are not owned by the AnchorLabels but by a LabelVisualPool. The pool binds them to the labels
+/// which are currently shown.
+class LabelVisual {
+ public:
+  /// The size of the GuiArea in pixels.
+  static int const WIDTH  = 120;
+  static int const HEIGHT = 30;
+
+  LabelVisual(std::shared_ptr<Plugin::Settings> pluginSettings,
+      std::shared_ptr<cs::core::SolarSystem>    solarSystem,
+      std::shared_ptr<cs::core::GuiManager>     guiManager,
+      std::shared_ptr<cs::core::InputManager>   inputManager,
+      std::shared_ptr<FrustumProbe>             frustumProbe);
+
+  LabelVisual(LabelVisual const& other) = delete;
+  LabelVisual(LabelVisual&& other)      = delete;
+
+  LabelVisual& operator=(LabelVisual const& other) = delete;
+  LabelVisual& operator=(LabelVisual&& other) = delete;
+
+  ~LabelVisual();
+
+  /// An estimate of the memory used by each visual. This is dominated by the GuiItem and its web
+  /// page, the scene graph nodes are comparatively small.
+  static MemoryUsage getMemoryUsage();
+
+  /// The GuiItem is loaded asynchronously. A visual must not be bound to a label before this
+  /// returns true.
+  bool getIsLoaded() const;
+
+  /// Makes this visual represent the given label. Passing nullptr removes the binding. The text of
+  /// the label is sent to the GuiItem by flush(), if it changed.
+  void bind(AnchorLabel const* label);
+
+  /// The label this visual has been bound to most recently. This is kept when the visual is
+  /// released, so that the text does not have to be updated if the label is shown again.
+  AnchorLabel const* getLabel() const;
+
+  /// The following methods only record the requested state. It is applied to the scene graph and
+  /// the GuiItem by the next call to flush(), and only if it differs from what has been applied
+  /// before.
+
+  /// Requests that the transformation computed in AnchorLabel::update() is applied to the scene
+  /// graph. SPICE is not queried again for this.
+  void update();
+
+  void setSortKey(int key);
+
+  /// The number of other labels which are hidden by this label. If this is not zero, the label is
+  /// shown as an aggregate label, for example "Saturn +82".
+  void setClusterSize(std::size_t size);
+
+  /// The position of the label relative to its anchor, as chosen by the DeclutterEngine.
+  void setPlacement(LabelPlacement placement);
+
+  /// Bit i is set if the label should be drawn in the i-th view recorded by the FrustumProbe. See
+  /// ViewDeclutter::getViewMask().
+  void setViewMask(uint32_t mask);
+
+  /// Only enabled visuals are drawn and can be clicked. Disabled visuals are not registered with
+  /// the InputManager, so they do not add to the cost of picking.
+  void setIsEnabled(bool enable);
+  bool getIsEnabled() const;
+
+  /// Applies all changes since the last call. Returns the number of modifications of the scene
+  /// graph and the GuiItem, which is zero if nothing changed.
+  std::size_t flush();
+
+ private:
+  /// A WorldSpaceGuiArea which is only drawn in some views.
+  class MaskedGuiArea;
+
+  /// Moves the GuiArea to the applied placement, above the anchor by the configured label offset.
+  void applyTranslation();
+
+  std::shared_ptr<Plugin::Settings>       mPluginSettings;
+  std::shared_ptr<cs::core::SolarSystem>  mSolarSystem;
+  std::shared_ptr<cs::core::GuiManager>   mGuiManager;
+  std::shared_ptr<cs::core::InputManager> mInputManager;
+
+  std::unique_ptr<MaskedGuiArea>      mGuiArea;
+  std::unique_ptr<VistaTransformNode> mAnchor;
+  std::unique_ptr<cs::gui::GuiItem>   mGuiItem;
+  std::unique_ptr<VistaOpenGLNode>    mGuiNode;
+  std::unique_ptr<VistaTransformNode> mGuiTransform;
+
+  AnchorLabel const* mLabel            = nullptr;
+  bool               mIsLoaded         = false;
+  int                mOffsetConnection = -1;
+
+  // The requested state and the state which has been applied by flush().
+  bool                  mIsEnabled        = false;
+  bool                  mAppliedIsEnabled = false;
+  int                   mSortKey          = 0;
+  std::optional<int>    mAppliedSortKey;
+  uint32_t              mViewMask         = ~0U;
+  uint32_t              mAppliedViewMask  = ~0U;
+  std::size_t           mClusterSize      = 0;
+  LabelPlacement        mPlacement        = LabelPlacement::eDefault;
+  LabelPlacement        mAppliedPlacement = LabelPlacement::eDefault;
+  std::string           mAppliedText;
+  bool                  mIsUpdatePending = false;
+};
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_LABEL_VISUAL_HPP
@@ -0,0 +1,209 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "LabelVisualPool.hpp"
+
+#include "AnchorLabel.hpp"
+#include "LabelVisual.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace csp::anchorlabels {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+LabelVisualPool::LabelVisualPool(std::shared_ptr<Plugin::Settings> pluginSettings,
+    std::shared_ptr<cs::core::SolarSystem>                         solarSystem,
+    std::shared_ptr<cs::core::GuiManager>                          guiManager,
+    std::shared_ptr<cs::core::InputManager>                        inputManager,
+    std::shared_ptr<FrustumProbe>                                  frustumProbe)
+    : mPluginSettings(std::move(pluginSettings))
+    , mSolarSystem(std::move(solarSystem))
+    , mGuiManager(std::move(guiManager))
+    , mInputManager(std::move(inputManager))
+    , mFrustumProbe(std::move(frustumProbe)) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+LabelVisualPool::~LabelVisualPool() = default;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+LabelVisual* LabelVisualPool::acquire(AnchorLabel const* label) {
+  auto used = mUsed.find(label);
+  if (used != mUsed.end()) {
+    return used->second;
+  }
+
+  LabelVisual* visual = nullptr;
+
+  // Prefer the visual which has been bound to this label before.
+  auto cached = mCached.find(label);
+  if (cached != mCached.end()) {
+    visual = *cached->second;
+    mFree.erase(cached->second);
+    mCached.erase(cached);
+  } else if (!mFree.empty()) {
+    // Freshly loaded visuals are at the front of the list, so they are used before visuals which
+    // are still bound to another label.
+    visual = mFree.front();
+    mFree.pop_front();
+    mCached.erase(visual->getLabel());
+  } else {
+    ++mMissing;
+    return nullptr;
+  }
+
+  visual->bind(label);
+  mUsed.emplace(label, visual);
+
+  return visual;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelVisualPool::release(AnchorLabel const* label) {
+  auto used = mUsed.find(label);
+  if (used == mUsed.end()) {
+    return;
+  }
+
+  LabelVisual* visual = used->second;
+  mUsed.erase(used);
+
+  visual->setIsEnabled(false);
+  mCached[label] = mFree.insert(mFree.end(), visual);
+
+  trim();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelVisualPool::releaseAll() {
+  while (!mUsed.empty()) {
+    release(mUsed.begin()->first);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelVisualPool::forget(AnchorLabel const* label) {
+  release(label);
+
+  auto cached = mCached.find(label);
+  if (cached != mCached.end()) {
+    (*cached->second)->bind(nullptr);
+    mCached.erase(cached);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+LabelVisual* LabelVisualPool::get(AnchorLabel const* label) const {
+  auto used = mUsed.find(label);
+  return used == mUsed.end() ? nullptr : used->second;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelVisualPool::update(std::chrono::steady_clock::time_point const& deadline) {
+  for (auto it = mLoading.begin(); it != mLoading.end();) {
+    if ((*it)->getIsLoaded()) {
+      mFree.push_front(*it);
+      it = mLoading.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  // Visuals which are still loading will satisfy some of the requests.
+  std::size_t missing = mMissing > mLoading.size() ? mMissing - mLoading.size() : 0;
+  mMissing            = 0;
+
+  while (missing > 0 && mVisuals.size() < mMaxSize &&
+         std::chrono::steady_clock::now() < deadline) {
+    mVisuals.emplace_back(std::make_unique<LabelVisual>(
+        mPluginSettings, mSolarSystem, mGuiManager, mInputManager, mFrustumProbe));
+    mLoading.push_back(mVisuals.back().get());
+    --missing;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t LabelVisualPool::flush() {
+  std::size_t mutations = 0;
+
+  for (auto const& visual : mVisuals) {
+    mutations += visual->flush();
+  }
+
+  return mutations;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelVisualPool::setMaxSize(std::size_t maxSize) {
+  mMaxSize = maxSize;
+
+  // Released visuals are destroyed right away by trim(), as the pool is still too large.
+  if (mUsed.size() > mMaxSize) {
+    std::vector<AnchorLabel const*> labels;
+    labels.reserve(mUsed.size());
+    for (auto const& used : mUsed) {
+      labels.push_back(used.first);
+    }
+
+    std::size_t const count = labels.size() - mMaxSize;
+    std::nth_element(labels.begin(), labels.begin() + static_cast<std::ptrdiff_t>(count),
+        labels.end(),
+        [](auto const* a, auto const* b) { return a->getPriority() < b->getPriority(); });
+
+    for (std::size_t i = 0; i < count; ++i) {
+      release(labels[i]);
+    }
+  }
+
+  trim();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t LabelVisualPool::getMaxSize() const {
+  return mMaxSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t LabelVisualPool::getSize() const {
+  return mVisuals.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+MemoryUsage LabelVisualPool::getMemoryUsage() const {
+  MemoryUsage const perVisual = LabelVisual::getMemoryUsage();
+  return {perVisual.mMainMemory * mVisuals.size(), perVisual.mTextureMemory * mVisuals.size()};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelVisualPool::trim() {
+  while (mVisuals.size() > mMaxSize && !mFree.empty()) {
+    LabelVisual* visual = mFree.front();
+    mFree.pop_front();
+    mCached.erase(visual->getLabel());
+
+    mVisuals.erase(std::find_if(mVisuals.begin(), mVisuals.end(),
+        [visual](auto const& v) { return v.get() == visual; }));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
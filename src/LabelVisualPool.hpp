@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_LABEL_VISUAL_POOL_HPP
+#define CSP_ANCHOR_LABELS_LABEL_VISUAL_POOL_HPP
+
+#include "Plugin.hpp"
+#include "engine/MemoryUsage.hpp"
+
+#include <chrono>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace cs::core {
+class SolarSystem;
+class GuiManager;
+class InputManager;
+} // namespace cs::core
+
+namespace csp::anchorlabels {
+class AnchorLabel;
+class FrustumProbe;
+class LabelVisual;
+
+/// The LabelVisualPool owns all LabelVisuals and hands them out to the AnchorLabels which are
+/// currently shown. Visuals are created lazily until the maximum pool size is reached. Afterwards,
+/// released visuals are reused, starting with the one which has been unused for the longest time.
+/// New visuals load their web page asynchronously and are only handed out once loading finished.
+/// A label which gets shown again will get its previous visual back if it has not been reused in
+/// the meantime, which saves the JavaScript call for updating the text.
+class LabelVisualPool {
+ public:
+  LabelVisualPool(std::shared_ptr<Plugin::Settings> pluginSettings,
+      std::shared_ptr<cs::core::SolarSystem>        solarSystem,
+      std::shared_ptr<cs::core::GuiManager>         guiManager,
+      std::shared_ptr<cs::core::InputManager>       inputManager,
+      std::shared_ptr<FrustumProbe>                 frustumProbe);
+
+  LabelVisualPool(LabelVisualPool const& other) = delete;
+  LabelVisualPool(LabelVisualPool&& other)      = delete;
+
+  LabelVisualPool& operator=(LabelVisualPool const& other) = delete;
+  LabelVisualPool& operator=(LabelVisualPool&& other) = delete;
+
+  ~LabelVisualPool();
+
+  /// Returns the visual which is bound to the given label. If the label has no visual yet, a free
+  /// one is bound to it. If there is no free visual, nullptr is returned and a new visual will be
+  /// created in one of the next calls to update(), unless the pool has reached its maximum size.
+  LabelVisual* acquire(AnchorLabel const* label);
+
+  /// Returns the visual of the given label to the pool and disables it. The visual stays bound to
+  /// the label until it is acquired by another label. Does nothing if the label has no visual.
+  void release(AnchorLabel const* label);
+
+  /// Releases all visuals.
+  void releaseAll();
+
+  /// Must be called before a label is destroyed. This removes all references to it.
+  void forget(AnchorLabel const* label);
+
+  /// Returns the visual which is currently bound to the given label or nullptr.
+  LabelVisual* get(AnchorLabel const* label) const;
+
+  /// Creates the visuals which were requested by acquire() since the last call and makes visuals
+  /// which finished loading available. No new visual is started once the deadline has passed.
+  void update(std::chrono::steady_clock::time_point const& deadline);
+
+  /// Applies the changes of all visuals to the scene graph and the GuiItems. This should be called
+  /// once at the end of each frame. Returns the number of modifications, which is zero if no
+  /// visual changed.
+  std::size_t flush();
+
+  /// Sets the maximum number of visuals. If the pool currently contains more visuals, the free
+  /// ones are destroyed first, starting with the one which has been unused for the longest time.
+  /// If this is not enough, the shown labels with the lowest priority lose their visuals. New
+  /// visuals are created again once the maximum size grows.
+  void setMaxSize(std::size_t maxSize);
+  std::size_t getMaxSize() const;
+
+  /// The number of visuals which currently exist.
+  std::size_t getSize() const;
+
+  /// An estimate of the memory used by all visuals, see LabelVisual::getMemoryUsage().
+  MemoryUsage getMemoryUsage() const;
+
+ private:
+  void trim();
+
+  std::shared_ptr<Plugin::Settings>       mPluginSettings;
+  std::shared_ptr<cs::core::SolarSystem>  mSolarSystem;
+  std::shared_ptr<cs::core::GuiManager>   mGuiManager;
+  std::shared_ptr<cs::core::InputManager> mInputManager;
+  std::shared_ptr<FrustumProbe>           mFrustumProbe;
+
+  std::vector<std::unique_ptr<LabelVisual>> mVisuals;
+
+  /// Visuals whose web page is still loading.
+  std::vector<LabelVisual*> mLoading;
+
+  /// The number of acquire() calls which could not be satisfied since the last update().
+  std::size_t mMissing = 0;
+
+  /// Visuals which are currently shown, keyed by their label.
+  std::unordered_map<AnchorLabel const*, LabelVisual*> mUsed;
+
+  /// Visuals which are not shown, the least recently used one is at the front.
+  std::list<LabelVisual*> mFree;
+
+  /// Free visuals which are still bound to a label, keyed by this label.
+  std::unordered_map<AnchorLabel const*, std::list<LabelVisual*>::iterator> mCached;
+
+  std::size_t mMaxSize = 0;
+};
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_LABEL_VISUAL_POOL_HPP
@@ -6,15 +6,33 @@
 
 #include "Plugin.hpp"
 #include "AnchorLabel.hpp"
+#include "CatalogLabelSource.hpp"
+#include "FrustumProbe.hpp"
+#include "LabelBatch.hpp"
+#include "LabelVisual.hpp"
+#include "LabelVisualPool.hpp"
 
 #include "../../../src/cs-core/GuiManager.hpp"
 #include "../../../src/cs-core/PluginBase.hpp"
 #include "../../../src/cs-core/SolarSystem.hpp"
+#include "../../../src/cs-scene/CelestialAnchor.hpp"
+#include "../../../src/cs-utils/FrameTimings.hpp"
 #include "../../../src/cs-utils/logger.hpp"
 #include "../../../src/cs-utils/utils.hpp"
 #include "logger.hpp"
 
+#include <VistaBase/VistaVectorMath.h>
+#include <VistaKernel/GraphicsManager/VistaGraphicsManager.h>
+#include <VistaKernel/GraphicsManager/VistaSceneGraph.h>
+#include <VistaKernel/VistaSystem.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <thread>
+#include <unordered_map>
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -32,24 +50,105 @@ EXPORT_FN void destroy(cs::core::PluginBase* pluginBase) {
 
 namespace csp::anchorlabels {
 
+namespace {
+
+/// Measures a phase of Plugin::update() for the frame timing overlay and for the trace file.
+class PhaseTimer {
+ public:
+  PhaseTimer(std::string const& name, double& duration)
+      : mTimer(name, cs::utils::FrameTimings::QueryMode::eCPU)
+      , mDuration(duration) {
+  }
+
+ private:
+  cs::utils::FrameTimings::ScopedTimer mTimer;
+  ScopedDuration                       mDuration;
+};
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void from_json(nlohmann::json const& j, LabelRule& o) {
+  // Omitted patterns match all names.
+  std::optional<std::string> center;
+  std::optional<std::string> frame;
+  cs::core::Settings::deserialize(j, "center", center);
+  cs::core::Settings::deserialize(j, "frame", frame);
+  o.mCenter = center.value_or("*");
+  o.mFrame  = frame.value_or("*");
+
+  cs::core::Settings::deserialize(j, "show", o.mShow);
+  cs::core::Settings::deserialize(j, "priority", o.mPriority);
+}
+
+void to_json(nlohmann::json& j, LabelRule const& o) {
+  cs::core::Settings::serialize(j, "center", o.mCenter);
+  cs::core::Settings::serialize(j, "frame", o.mFrame);
+  cs::core::Settings::serialize(j, "show", o.mShow);
+  cs::core::Settings::serialize(j, "priority", o.mPriority);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void from_json(nlohmann::json const& j, Plugin::Settings& o) {
   cs::core::Settings::deserialize(j, "enabled", o.mEnabled);
+  cs::core::Settings::deserialize(j, "enableCulling", o.mEnableCulling);
   cs::core::Settings::deserialize(j, "enableDepthOverlap", o.mEnableDepthOverlap);
   cs::core::Settings::deserialize(j, "ignoreOverlapThreshold", o.mIgnoreOverlapThreshold);
+  cs::core::Settings::deserialize(j, "enableClustering", o.mEnableClustering);
   cs::core::Settings::deserialize(j, "labelScale", o.mLabelScale);
   cs::core::Settings::deserialize(j, "depthScale", o.mDepthScale);
   cs::core::Settings::deserialize(j, "labelOffset", o.mLabelOffset);
+  cs::core::Settings::deserialize(j, "labelPoolSize", o.mLabelPoolSize);
+  cs::core::Settings::deserialize(j, "memoryBudget", o.mMemoryBudget);
+  cs::core::Settings::deserialize(j, "textAtlas", o.mTextAtlas);
+  cs::core::Settings::deserialize(j, "creationBudget", o.mCreationBudget);
+  cs::core::Settings::deserialize(j, "incrementalUpdates", o.mIncrementalUpdates);
+  cs::core::Settings::deserialize(j, "hysteresis", o.mHysteresis);
+  cs::core::Settings::deserialize(j, "candidatePlacement", o.mCandidatePlacement);
+  cs::core::Settings::deserialize(j, "placementBudget", o.mPlacementBudget);
+  cs::core::Settings::deserialize(j, "threadCount", o.mThreadCount);
+  cs::core::Settings::deserialize(j, "pipelinedDeclutter", o.mPipelinedDeclutter);
+  cs::core::Settings::deserialize(j, "scheduleUpdates", o.mScheduleUpdates);
+  cs::core::Settings::deserialize(j, "maxLabelUpdates", o.mMaxLabelUpdates);
+  cs::core::Settings::deserialize(j, "ephemerisPrefetch", o.mEphemerisPrefetch);
+  cs::core::Settings::deserialize(j, "labelRules", o.mLabelRules);
+  cs::core::Settings::deserialize(j, "catalogs", o.mCatalogs);
+  cs::core::Settings::deserialize(j, "catalogLabelCount", o.mCatalogLabelCount);
+  cs::core::Settings::deserialize(j, "sortKeyRange", o.mSortKeyRange);
+  cs::core::Settings::deserialize(j, "traceFile", o.mTraceFile);
+  cs::core::Settings::deserialize(j, "cameraPathFile", o.mCameraPathFile);
 }
 
 void to_json(nlohmann::json& j, Plugin::Settings const& o) {
   cs::core::Settings::serialize(j, "enabled", o.mEnabled);
+  cs::core::Settings::serialize(j, "enableCulling", o.mEnableCulling);
   cs::core::Settings::serialize(j, "enableDepthOverlap", o.mEnableDepthOverlap);
   cs::core::Settings::serialize(j, "ignoreOverlapThreshold", o.mIgnoreOverlapThreshold);
+  cs::core::Settings::serialize(j, "enableClustering", o.mEnableClustering);
   cs::core::Settings::serialize(j, "labelScale", o.mLabelScale);
   cs::core::Settings::serialize(j, "depthScale", o.mDepthScale);
   cs::core::Settings::serialize(j, "labelOffset", o.mLabelOffset);
+  cs::core::Settings::serialize(j, "labelPoolSize", o.mLabelPoolSize);
+  cs::core::Settings::serialize(j, "memoryBudget", o.mMemoryBudget);
+  cs::core::Settings::serialize(j, "textAtlas", o.mTextAtlas);
+  cs::core::Settings::serialize(j, "creationBudget", o.mCreationBudget);
+  cs::core::Settings::serialize(j, "incrementalUpdates", o.mIncrementalUpdates);
+  cs::core::Settings::serialize(j, "hysteresis", o.mHysteresis);
+  cs::core::Settings::serialize(j, "candidatePlacement", o.mCandidatePlacement);
+  cs::core::Settings::serialize(j, "placementBudget", o.mPlacementBudget);
+  cs::core::Settings::serialize(j, "threadCount", o.mThreadCount);
+  cs::core::Settings::serialize(j, "pipelinedDeclutter", o.mPipelinedDeclutter);
+  cs::core::Settings::serialize(j, "scheduleUpdates", o.mScheduleUpdates);
+  cs::core::Settings::serialize(j, "maxLabelUpdates", o.mMaxLabelUpdates);
+  cs::core::Settings::serialize(j, "ephemerisPrefetch", o.mEphemerisPrefetch);
+  cs::core::Settings::serialize(j, "labelRules", o.mLabelRules);
+  cs::core::Settings::serialize(j, "catalogs", o.mCatalogs);
+  cs::core::Settings::serialize(j, "catalogLabelCount", o.mCatalogLabelCount);
+  cs::core::Settings::serialize(j, "sortKeyRange", o.mSortKeyRange);
+  cs::core::Settings::serialize(j, "traceFile", o.mTraceFile);
+  cs::core::Settings::serialize(j, "cameraPathFile", o.mCameraPathFile);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -67,28 +166,75 @@ void Plugin::init() {
 
   mGuiManager->addScriptToGuiFromJS("../share/resources/gui/js/csp-anchor-labels.js");
 
-  // Create labels for all bodies that already exist
-  for (auto const& body : mSolarSystem->getBodies()) {
-    mAnchorLabels.emplace_back(std::make_unique<AnchorLabel>(
-        body.get(), mPluginSettings, mSolarSystem, mGuiManager, mTimeControl, mInputManager));
+  mFrustumProbe = std::make_shared<FrustumProbe>();
+
+  // The size of the pool is set in each frame by updateMemoryUsage(), as it depends on the memory
+  // used by everything else.
+  mVisualPool = std::make_unique<LabelVisualPool>(
+      mPluginSettings, mSolarSystem, mGuiManager, mInputManager, mFrustumProbe);
+
+  mLabelBatch = std::make_unique<LabelBatch>(mPluginSettings, mFrustumProbe);
+  mPluginSettings->mTextAtlas.connect([this](bool /*enable*/) { mNeedsUpdate = true; });
+
+  mPluginSettings->mThreadCount.connectAndTouch([this](uint32_t /*count*/) { updateThreads(); });
+  mPluginSettings->mPipelinedDeclutter.connectAndTouch(
+      [this](bool /*enable*/) { updateThreads(); });
+
+  // The samples are computed on the main thread in update(), before the labels are updated on the
+  // worker threads. So SPICE is never queried by two threads at the same time.
+  mEphemerisPrefetcher.setEphemeris(
+      [](EphemerisFrame const& reference, EphemerisFrame const& frame, double time) {
+        cs::scene::CelestialAnchor referenceAnchor(reference.mCenter, reference.mFrame);
+        cs::scene::CelestialAnchor anchor(frame.mCenter, frame.mFrame);
+        glm::dmat4 transform = referenceAnchor.getRelativeTransform(time, anchor);
+
+        Transform result{};
+        std::copy_n(glm::value_ptr(transform), result.size(), result.begin());
+        return result;
+      });
 
-    mNeedsResort = true;
+  mPluginSettings->mTraceFile.connectAndTouch([this](std::string const& fileName) {
+    if (fileName.empty()) {
+      mTraceWriter.close();
+    } else if (!mTraceWriter.open(fileName)) {
+      logger().warn("Failed to open trace file '{}'!", fileName);
+    }
+  });
+  mPluginSettings->mCameraPathFile.connectAndTouch([this](std::string const& fileName) {
+    if (fileName.empty()) {
+      mCameraPathWriter.close();
+    } else if (!mCameraPathWriter.open(fileName)) {
+      logger().warn("Failed to open camera path file '{}'!", fileName);
+    }
+  });
+
+  mPluginSettings->mCatalogs.connectAndTouch(
+      [this](std::vector<std::string> const& fileNames) { loadCatalogs(fileNames); });
+  mPluginSettings->mCatalogLabelCount.connect([this](uint32_t) { mCatalogFrameState.reset(); });
+
+  // Create labels for all bodies that already exist. This is done in the update method, so that
+  // the work can be distributed over several frames.
+  for (auto const& body : mSolarSystem->getBodies()) {
+    mPendingBodies.push_back(body.get());
+    mPendingBodySet.insert(body.get());
   }
 
+  // The rules are compiled once here and again whenever they are changed by the settings.
+  mPluginSettings->mLabelRules.connectAndTouch(
+      [this](std::vector<LabelRule> const& rules) { applyLabelRules(rules); });
+
   // For all bodies that will be created in the future we also create a label
   addListenerId = mSolarSystem->registerAddBodyListener([this](auto const& body) {
-    mAnchorLabels.emplace_back(std::make_unique<AnchorLabel>(
-        body.get(), mPluginSettings, mSolarSystem, mGuiManager, mTimeControl, mInputManager));
-
-    mNeedsResort = true;
+    mPendingBodies.push_back(body.get());
+    mPendingBodySet.insert(body.get());
   });
 
-  // If a body gets dropped from the solar system remove the label too
+  // If a body gets dropped from the solar system remove the label too. Both take constant or
+  // logarithmic time, so that many bodies can be removed at once. The order of the remaining
+  // labels is updated in the next frame.
   removeListenerId = mSolarSystem->registerRemoveBodyListener([this](auto const& body) {
-    mAnchorLabels.erase(
-        std::remove_if(mAnchorLabels.begin(), mAnchorLabels.end(),
-            [body](auto const& label) { return body->getCenterName() == label->getCenterName(); }),
-        mAnchorLabels.end());
+    mPendingBodySet.erase(body.get());
+    removeLabel(body.get());
   });
 
   mGuiManager->getGui()->registerCallback("anchorLabels.setEnabled",
@@ -138,76 +284,335 @@ void Plugin::init() {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void Plugin::update() {
+  // The views drawn in the last frame are used for culling and decluttering in this frame.
+  mFrustumProbe->nextFrame();
+
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::duration<double, std::milli>(mPluginSettings->mCreationBudget.get());
+
+  createPendingLabels(deadline);
+
   if (mPluginSettings->mEnabled.get()) {
+    updateCatalogLabels();
+  }
+
+  updateLabelOrder();
 
-    if (mNeedsResort) {
-      std::sort(mAnchorLabels.begin(), mAnchorLabels.end(),
-          [](std::unique_ptr<AnchorLabel>& l1, std::unique_ptr<AnchorLabel>& l2) {
-            return l1->bodySize() > l2->bodySize();
-          });
-      mNeedsResort = false;
+  mStatistics             = {};
+  mStatistics.mLabelCount = mAnchorLabels.size();
+
+  updateMemoryUsage();
+
+  if (mPluginSettings->mEnabled.get()) {
+    mVisualPool->update(deadline);
+    updateHighlightedLabel();
+    updateLabels();
+    mStatistics.mVisibleCount = mDeclutterResult.size();
+  } else {
+    mVisualPool->releaseAll();
+    mLabelBatch->clear();
+    mNeedsUpdate = true;
+  }
+
+  // All changes to the scene graph and the GuiItems are applied at once. If nothing changed in
+  // this frame, this does not modify anything.
+  {
+    PhaseTimer timer("Anchor Labels Flush", mStatistics.mFlushTime);
+    mStatistics.mSceneGraphMutations = mVisualPool->flush() + mLabelBatch->flush();
+  }
+
+  mTraceWriter.write(mFrameCount++, mStatistics);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t Plugin::getSceneGraphMutations() const {
+  return mStatistics.mSceneGraphMutations;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FrameStatistics const& Plugin::getStatistics() const {
+  return mStatistics;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+MemoryUsage const& Plugin::getMemoryUsage() const {
+  return mMemoryUsage;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::updateLabels() {
+  // If neither the observer nor the simulation time changed, all labels would end up at the
+  // same position as in the last frame. In this case, there is nothing to do, unless the result
+  // of the pipelined declutter pass for the last frame arrived.
+  FrameState frameState = getFrameState();
+  if (mPluginSettings->mIncrementalUpdates.get() && !mNeedsUpdate &&
+      frameState == mLastFrameState) {
+    if (mDeclutterPipeline.isPending() && fetchDeclutterResult()) {
+      commitLabels(true);
     }
+    return;
+  }
+
+  bool const pipelined = mDeclutterPipeline.isRunning();
+
+  // After a jump in time, the velocities of the labels are meaningless. This is the case if the
+  // simulation time differs from the one expected from the time speed by more than the expected
+  // change. While the observer is flying to a body, it may move to any place, so all labels are
+  // updated in both cases.
+  auto         now       = std::chrono::steady_clock::now();
+  double const timeSpeed = mTimeControl->pTimeSpeed.get();
+  double const expectedChange =
+      timeSpeed * std::chrono::duration<double>(now - mLastUpdateTime).count();
+  double const timeError =
+      frameState.mSimulationTime - mLastFrameState.mSimulationTime - expectedChange;
+
+  bool const forceUpdate = std::abs(timeError) > 1.0 + std::abs(expectedChange) ||
+                           timeSpeed != mLastTimeSpeed ||
+                           mSolarSystem->getObserver().isAnimationInProgress() ||
+                           frameState.mObserverCenter != mLastFrameState.mObserverCenter ||
+                           frameState.mObserverFrame != mLastFrameState.mObserverFrame;
+
+  mLastUpdateTime = now;
+  mLastTimeSpeed  = timeSpeed;
+  mLastFrameState = frameState;
+  mNeedsUpdate    = false;
+
+  // Compute phase: Each label only writes to its own members and its own entry of the label
+  // store, so the labels can be processed in parallel. Only the scheduled labels are updated, the
+  // positions of all others are extrapolated.
+  {
+    PhaseTimer timer("Anchor Labels Positions", mStatistics.mPositionTime);
+
+    // The cached frame transformations are only valid for the current observer and time.
+    mTransformCache.clear();
 
-    for (auto&& label : mAnchorLabels) {
-      label->update();
+    // During time warps, the frame transformations are interpolated from prefetched samples. These
+    // are discarded after time jumps and changes of the time speed. New samples are computed here
+    // within a small budget.
+    PrefetchSettings prefetchSettings;
+    prefetchSettings.mEnabled = mPluginSettings->mEphemerisPrefetch.get();
+    mEphemerisPrefetcher.update({frameState.mObserverCenter, frameState.mObserverFrame},
+        frameState.mSimulationTime, timeSpeed, prefetchSettings);
+
+    // The positions are extrapolated in the frame of the observer, so that turning and zooming
+    // do not change the velocities of the labels.
+    glm::dmat4 toScheduler = glm::scale(
+        glm::mat4_cast(frameState.mObserverRotation), glm::dvec3(frameState.mObserverScale));
+
+    Transform observerToScheduler{};
+    std::copy_n(glm::value_ptr(toScheduler), observerToScheduler.size(),
+        observerToScheduler.begin());
+
+    SchedulerSettings schedulerSettings;
+    schedulerSettings.mEnabled    = mPluginSettings->mScheduleUpdates.get();
+    schedulerSettings.mMaxUpdates = mPluginSettings->mMaxLabelUpdates.get();
+
+    // Shown labels need an exact scale and rotation.
+    for (std::size_t label : mDeclutterResult.mVisibleLabels) {
+      mUpdateScheduler.request(label);
     }
 
-    std::unordered_set<AnchorLabel*> labelsToDraw;
-    for (auto const& label : mAnchorLabels) {
-      if (label->shouldBeHidden()) {
-        continue;
-      }
+    auto const& dueLabels = mUpdateScheduler.schedule(
+        mAnchorLabels.size(), observerToScheduler, forceUpdate, schedulerSettings);
+
+    mWorkerPool.parallelFor(
+        dueLabels.size(), [this, &dueLabels](std::size_t begin, std::size_t end) {
+          for (std::size_t i = begin; i < end; ++i) {
+            auto& label = mAnchorLabels[dueLabels[i]];
+            label->update(mTransformCache, mEphemerisPrefetcher, mSpiceMutex);
 
-      glm::dvec4 A             = label->getScreenSpaceBB();
-      double     distToCameraA = label->distanceToCamera();
-
-      bool canBeAdded = true;
-      for (auto&& drawLabel : labelsToDraw) {
-        if (mPluginSettings->mEnableDepthOverlap.get()) {
-          // Check the distance relative to each other. If they are far apart we can display both.
-          double distToCameraB    = drawLabel->distanceToCamera();
-          double relativeDistance = distToCameraA < distToCameraB ? distToCameraB / distToCameraA
-                                                                  : distToCameraA / distToCameraB;
-          if (relativeDistance > 1 + mPluginSettings->mIgnoreOverlapThreshold.get() * 0.1) {
-            continue;
+            auto const& position = label->getRelativePosition();
+            mUpdateScheduler.setPosition(dueLabels[i], position.x, position.y, position.z);
           }
-        }
-
-        // Check if they are colliding. If they collide the bigger label survives. Since the list
-        // is sorted by body size, it is assured that the bigger label gets displayed.
-        glm::dvec4 B   = drawLabel->getScreenSpaceBB();
-        bool collision = B.x + B.z > A.x && B.y + B.w > A.y && A.x + A.z > B.x && A.y + A.w > B.y;
-        if (collision) {
-          canBeAdded = false;
-          break;
-        }
-      }
+        });
 
-      if (canBeAdded) {
-        labelsToDraw.insert(label.get());
-      }
+    // In pipelined mode, the positions are written to the snapshot directly.
+    LabelStore& labels = pipelined ? mDeclutterPipeline.getSnapshot().mLabels : mLabelStore;
+
+    labels.resize(mAnchorLabels.size());
+    mUpdateScheduler.extrapolate(labels);
+
+    for (std::size_t i = 0; i < mAnchorLabels.size(); ++i) {
+      labels.mPriority[i] = mAnchorLabels[i]->getPriority();
+      labels.mRadius[i]   = mAnchorLabels[i]->bodySize();
+      labels.mBodyId[i]   = mLabelBodyIds[i];
+      labels.mFlags[i]    = mAnchorLabels[i]->shouldBeHidden() ? eHidden : 0;
+    }
+
+    mStatistics.mUpdatedCount         = dueLabels.size();
+    mStatistics.mTransformCacheHits   = mTransformCache.getHits();
+    mStatistics.mTransformCacheMisses = mTransformCache.getMisses();
+    mStatistics.mPrefetchHits         = mEphemerisPrefetcher.getHits();
+    mStatistics.mPrefetchMisses       = mEphemerisPrefetcher.getMisses();
+
+    reportEphemerisStatistics();
+
+    recordCameraPath(frameState, labels);
+  }
+
+  bool visibleLabelsChanged = false;
+
+  if (pipelined) {
+    publishDeclutterSnapshot(frameState);
+    visibleLabelsChanged = fetchDeclutterResult();
+  } else {
+    // Labels outside of the field of view or behind other bodies do not take part in the overlap
+    // test. The positions are scaled by the observer, the radii are not. In stereo and
+    // multi-window setups, this is done for each view in parallel.
+    {
+      PhaseTimer timer("Anchor Labels Culling", mStatistics.mCullingTime);
+      mViewDeclutter.setViews(frameState.mViews);
+      mViewDeclutter.cull(
+          mLabelStore, 1.0 / frameState.mObserverScale, frameState.mCullingSettings, mWorkerPool);
+      mStatistics.mCulledCount = mViewDeclutter.getCulledCount();
+    }
+
+    {
+      PhaseTimer timer("Anchor Labels Declutter", mStatistics.mDeclutterTime);
+      visibleLabelsChanged = mViewDeclutter.update(frameState.mLabelScale,
+          static_cast<double>(LabelVisual::WIDTH), static_cast<double>(LabelVisual::HEIGHT),
+          frameState.mDeclutterSettings, mWorkerPool);
+      mDeclutterResult.assign(mViewDeclutter);
+      mStatistics.mPairTestCount = mViewDeclutter.getPairTestCount();
+    }
+  }
+
+  commitLabels(visibleLabelsChanged);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::publishDeclutterSnapshot(FrameState const& frameState) {
+  // The positions have been written to the snapshot already. The ids only have to be copied if
+  // the labels changed since this snapshot was used last.
+  auto& snapshot = mDeclutterPipeline.getSnapshot();
+  if (snapshot.mGeneration != mLabelGeneration) {
+    snapshot.mIds        = mLabelIds;
+    snapshot.mGeneration = mLabelGeneration;
+  }
+
+  snapshot.mViews             = frameState.mViews;
+  snapshot.mRadiusScale       = 1.0 / frameState.mObserverScale;
+  snapshot.mCullingSettings   = frameState.mCullingSettings;
+  snapshot.mLabelScale        = frameState.mLabelScale;
+  snapshot.mWidth             = static_cast<double>(LabelVisual::WIDTH);
+  snapshot.mHeight            = static_cast<double>(LabelVisual::HEIGHT);
+  snapshot.mDeclutterSettings = frameState.mDeclutterSettings;
+
+  mDeclutterPipeline.publish();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Plugin::fetchDeclutterResult() {
+  if (!mDeclutterPipeline.fetch()) {
+    return false;
+  }
+
+  auto const& result = mDeclutterPipeline.getResult();
+
+  // The timings of the background thread are reported for the frame in which its result is used.
+  mStatistics.mCullingTime += result.mCullingTime;
+  mStatistics.mDeclutterTime += result.mDeclutterTime;
+  mStatistics.mCulledCount   = result.mCulledCount;
+  mStatistics.mPairTestCount = result.mPairTestCount;
+
+  if (result.mGeneration == mLabelGeneration) {
+    mDeclutterResult = result.mResult;
+    return true;
+  }
+
+  // Labels have been added or removed since the snapshot was taken, so the result is translated
+  // to the current order by the ids of the labels. This only happens in the frame after a change.
+  std::unordered_map<uint32_t, std::size_t> indices;
+  for (std::size_t i = 0; i < mLabelIds.size(); ++i) {
+    indices.emplace(mLabelIds[i], i);
+  }
+
+  auto const& source = result.mResult;
+  mDeclutterResult.clear();
+
+  for (std::size_t i = 0; i < source.size(); ++i) {
+    auto index = indices.find(result.mIds[source.mVisibleLabels[i]]);
+    if (index == indices.end()) {
+      continue;
+    }
+
+    mDeclutterResult.mVisibleLabels.push_back(index->second);
+    mDeclutterResult.mSortKeys.push_back(source.mSortKeys[i]);
+    mDeclutterResult.mClusterSizes.push_back(source.mClusterSizes[i]);
+    mDeclutterResult.mPlacements.push_back(source.mPlacements[i]);
+    mDeclutterResult.mViewMasks.push_back(source.mViewMasks[i]);
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::commitLabels(bool visibleLabelsChanged) {
+  // Commit phase: The changes are recorded on the main thread and applied to the scene graph at
+  // the end of the frame.
+  PhaseTimer timer("Anchor Labels Commit", mStatistics.mCommitTime);
+
+  auto const& visibleLabels = mDeclutterResult.mVisibleLabels;
+
+  // Labels which are not drawn anymore return their visual to the pool first, so that it can be
+  // reused by the labels which became visible in this frame. This is only required if the
+  // result of the declutter pass changed.
+  if (visibleLabelsChanged) {
+    std::vector<bool> isVisible(mAnchorLabels.size(), false);
+    for (std::size_t label : visibleLabels) {
+      isVisible[label] = true;
     }
 
-    for (auto&& label : mAnchorLabels) {
-      if (labelsToDraw.find(label.get()) != labelsToDraw.end()) {
-        label->enable();
-      } else {
-        label->disable();
+    for (std::size_t i = 0; i < mAnchorLabels.size(); ++i) {
+      if (!isVisible[i]) {
+        mVisualPool->release(mAnchorLabels[i]);
       }
     }
+  }
+
+  // With the text atlas, all visible labels are drawn by the batch, except for the one under the
+  // pointer, which gets a visual so that it can be highlighted and clicked.
+  bool const useTextAtlas = mPluginSettings->mTextAtlas.get() && mLabelBatch->getIsReady();
+  mLabelBatch->clear();
+  mLabelBatch->setHiddenLabel(nullptr);
 
-    std::vector<AnchorLabel*> sortedLabels(labelsToDraw.begin(), labelsToDraw.end());
-    std::sort(sortedLabels.begin(), sortedLabels.end(), [](AnchorLabel* a, AnchorLabel* b) {
-      return a->distanceToCamera() < b->distanceToCamera();
-    });
+  // The visible labels are sorted by distance, so if the pool is exhausted, the labels closest to
+  // the observer are shown. If a label does not get a visual, we try again in the next frame.
+  for (std::size_t i = 0; i < visibleLabels.size(); ++i) {
+    auto const*          label       = mAnchorLabels[visibleLabels[i]];
+    std::size_t const    clusterSize = mDeclutterResult.mClusterSizes[i];
+    LabelPlacement const placement   = mDeclutterResult.mPlacements[i];
+    uint32_t const       viewMask    = mDeclutterResult.mViewMasks[i];
 
-    for (int i = 0; i < static_cast<int>(sortedLabels.size()); ++i) {
-      // a little bit hacky... It probably breaks, when more than 100 labels are present.
-      sortedLabels[i]->setSortKey(static_cast<int>(cs::utils::DrawOrder::eTransparentItems) - i);
+    if (useTextAtlas) {
+      mLabelBatch->add(label, clusterSize, placement, viewMask);
+      if (label != mHighlightedLabel) {
+        mVisualPool->release(label);
+        continue;
+      }
     }
-  } else {
-    for (auto&& label : mAnchorLabels) {
-      label->disable();
+
+    auto* visual = mVisualPool->acquire(label);
+    if (visual) {
+      visual->update();
+      visual->setSortKey(mDeclutterResult.mSortKeys[i]);
+      visual->setClusterSize(clusterSize);
+      visual->setPlacement(placement);
+      visual->setViewMask(viewMask);
+      visual->setIsEnabled(true);
+
+      if (useTextAtlas) {
+        mLabelBatch->setHiddenLabel(label);
+      }
+    } else {
+      mNeedsUpdate = true;
     }
   }
 }
@@ -217,7 +622,19 @@ void Plugin::update() {
 void Plugin::deInit() {
   logger().info("Unloading plugin...");
 
+  mDeclutterPipeline.stop();
+  mEphemerisPrefetcher.setEphemeris(nullptr);
+
+  mVisualPool.reset();
+  mLabelBatch.reset();
+  mFrustumProbe.reset();
   mAnchorLabels.clear();
+  mLabelSlots.clear();
+  mLabelMemory   = 0;
+  mLabelRegistry = LabelRegistry();
+  mCatalogSources.clear();
+  mPendingBodies.clear();
+  mPendingBodySet.clear();
 
   mSolarSystem->unregisterAddBodyListener(addListenerId);
   mSolarSystem->unregisterRemoveBodyListener(removeListenerId);
@@ -239,6 +656,462 @@ void Plugin::deInit() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void Plugin::createPendingLabels(std::chrono::steady_clock::time_point const& deadline) {
+  if (mPendingBodies.empty()) {
+    return;
+  }
+
+  std::vector<std::unique_ptr<AnchorLabel>> labels;
+  std::vector<LabelRegistry::Key>           keys;
+
+  // At least one label is created per frame, so that there is progress even with a tiny budget.
+  // Bodies which have been removed in the meantime or which are hidden by a rule are skipped.
+  do {
+    auto const* body = mPendingBodies.front();
+    mPendingBodies.pop_front();
+
+    if (mPendingBodySet.erase(body) > 0 && !mLabelRegistry.find(body)) {
+      auto const rule = mLabelRuleSet.match(body->getCenterName(), body->getFrameName());
+      if (!rule.mShow) {
+        continue;
+      }
+
+      labels.emplace_back(std::make_unique<AnchorLabel>(
+          body, mPluginSettings, mSolarSystem, mTimeControl, rule.mPriority));
+      keys.push_back(body);
+    }
+  } while (!mPendingBodies.empty() && std::chrono::steady_clock::now() < deadline);
+
+  addLabels(keys, labels);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::updateCatalogLabels() {
+  // The entries in the field of view only change if the observer, the time or the projection
+  // changed.
+  FrameState frameState = getFrameState();
+  if (mCatalogSources.empty() || frameState == mCatalogFrameState) {
+    return;
+  }
+
+  mCatalogFrameState = frameState;
+
+  std::vector<std::unique_ptr<AnchorLabel>> labels;
+  std::vector<LabelRegistry::Key>           keys;
+
+  for (auto const& source : mCatalogSources) {
+    source->update(frameState.mSimulationTime, mSolarSystem->getObserver(),
+        frameState.mViewProjection, frameState.mCullingSettings.mFrustumMargin,
+        mPluginSettings->mCatalogLabelCount.get());
+
+    auto const& catalog = source->getCatalog();
+
+    // Removing labels first allows the new ones to reuse their slots.
+    for (uint32_t entry : source->getRemovedEntries()) {
+      removeLabel(catalog.getKey(entry));
+    }
+
+    for (uint32_t entry : source->getAddedEntries()) {
+      uint32_t const reference = catalog.getReference(entry);
+      auto const     position  = catalog.getPosition(entry);
+
+      labels.emplace_back(std::make_unique<AnchorLabel>(std::string(catalog.getName(entry)),
+          std::string(catalog.getCenterName(reference)),
+          std::string(catalog.getFrameName(reference)),
+          glm::dvec3(position[0], position[1], position[2]), catalog.getPriority(entry),
+          mPluginSettings, mSolarSystem, mTimeControl));
+      keys.push_back(catalog.getKey(entry));
+    }
+  }
+
+  addLabels(keys, labels);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::loadCatalogs(std::vector<std::string> const& fileNames) {
+  // The keys of the labels point into the mapped files, so the labels have to be removed before
+  // the catalogs are closed.
+  for (auto const& source : mCatalogSources) {
+    for (uint32_t entry : source->getActiveEntries()) {
+      removeLabel(source->getCatalog().getKey(entry));
+    }
+  }
+
+  mCatalogSources.clear();
+  mCatalogFrameState.reset();
+
+  for (auto const& fileName : fileNames) {
+    auto source = std::make_unique<CatalogLabelSource>();
+    if (!source->open(fileName)) {
+      logger().warn("Failed to load point catalog '{}'!", fileName);
+      continue;
+    }
+
+    logger().info("Loaded {} entries from point catalog '{}'.", source->getCatalog().size(),
+        fileName);
+    mCatalogSources.push_back(std::move(source));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::addLabels(std::vector<LabelRegistry::Key> const& keys,
+    std::vector<std::unique_ptr<AnchorLabel>>&                labels) {
+  if (labels.empty()) {
+    return;
+  }
+
+  std::vector<std::pair<LabelRegistry::Key, double>> entries;
+  for (std::size_t i = 0; i < labels.size(); ++i) {
+    entries.emplace_back(keys[i], labels[i]->getPriority());
+    mLabelMemory += labels[i]->getMemoryUsage();
+  }
+
+  std::vector<LabelHandle> handles;
+  mLabelRegistry.add(entries, handles);
+
+  mLabelSlots.resize(mLabelRegistry.getSlotCount());
+  for (std::size_t i = 0; i < handles.size(); ++i) {
+    mLabelSlots[handles[i].mSlot] = std::move(labels[i]);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Plugin::removeLabel(LabelRegistry::Key key) {
+  auto handle = mLabelRegistry.find(key);
+  if (!handle) {
+    return false;
+  }
+
+  auto const* label = mLabelSlots[handle->mSlot].get();
+  mLabelMemory -= label->getMemoryUsage();
+  mVisualPool->forget(label);
+  mLabelBatch->forget(label);
+  if (mHighlightedLabel == label) {
+    mHighlightedLabel = nullptr;
+  }
+
+  mLabelSlots[handle->mSlot].reset();
+  return mLabelRegistry.remove(key);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::applyLabelRules(std::vector<LabelRule> const& rules) {
+  mLabelRuleSet.compile(rules);
+
+  for (std::size_t rule : mLabelRuleSet.getInvalidRules()) {
+    logger().warn("Ignoring label rule {} as it contains an invalid regular expression!", rule);
+  }
+
+  // Pending bodies are matched against the new rules when their label is created. All others are
+  // matched here, which is cheap compared to creating their labels.
+  for (auto const& body : mSolarSystem->getBodies()) {
+    if (mPendingBodySet.count(body.get()) > 0) {
+      continue;
+    }
+
+    auto const rule   = mLabelRuleSet.match(body->getCenterName(), body->getFrameName());
+    auto const handle = mLabelRegistry.find(body.get());
+
+    if (handle) {
+      if (rule.mShow && mLabelSlots[handle->mSlot]->getFixedPriority() == rule.mPriority) {
+        continue;
+      }
+
+      removeLabel(body.get());
+    }
+
+    if (rule.mShow) {
+      mPendingBodies.push_back(body.get());
+      mPendingBodySet.insert(body.get());
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::updateLabelOrder() {
+  if (!mLabelRegistry.hasChanged()) {
+    return;
+  }
+
+  // If the labels are passed to the DeclutterEngine in order of priority, it does not have to
+  // reorder them internally.
+  auto const& order = mLabelRegistry.getOrder();
+  mAnchorLabels.resize(order.size());
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    mAnchorLabels[i] = mLabelSlots[order[i]].get();
+  }
+
+  // Labels which already existed keep their sort keys and their update schedule, so that adding
+  // or removing bodies does not require all labels to be updated at once.
+  auto const& previousIndices = mLabelRegistry.getPreviousIndices();
+  mViewDeclutter.remapLabels(previousIndices);
+  mDeclutterResult.remapLabels(previousIndices);
+  mUpdateScheduler.remap(previousIndices);
+  mNeedsUpdate = true;
+
+  std::vector<uint32_t> ids(order.size());
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    ids[i] = previousIndices[i] < mLabelIds.size() ? mLabelIds[previousIndices[i]] : mNextLabelId++;
+  }
+  mLabelIds = std::move(ids);
+  ++mLabelGeneration;
+
+  // The labels of points on a body share the id of its center, so that the body does not occlude
+  // them.
+  mLabelBodyIds.resize(mAnchorLabels.size());
+  for (std::size_t i = 0; i < mAnchorLabels.size(); ++i) {
+    auto const id = static_cast<uint32_t>(mBodyIds.size() + 1);
+    mLabelBodyIds[i] = mBodyIds.emplace(mAnchorLabels[i]->getCenterName(), id).first->second;
+  }
+
+  std::vector<EphemerisFrame> frames(mAnchorLabels.size());
+  for (std::size_t i = 0; i < mAnchorLabels.size(); ++i) {
+    frames[i] = {mAnchorLabels[i]->getCenterName(), mAnchorLabels[i]->getFrameName()};
+  }
+  mEphemerisPrefetcher.setFrames(frames);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::recordCameraPath(FrameState const& frameState, LabelStore const& labels) {
+  if (!mCameraPathWriter.isOpen()) {
+    return;
+  }
+
+  auto const& position = frameState.mObserverPosition;
+  auto const& rotation = frameState.mObserverRotation;
+
+  auto& frame             = mCameraPathFrame;
+  frame.mSimulationTime   = frameState.mSimulationTime;
+  frame.mObserverPosition = {position.x, position.y, position.z};
+  frame.mObserverRotation = {rotation.x, rotation.y, rotation.z, rotation.w};
+  frame.mObserverScale    = frameState.mObserverScale;
+  frame.mLabelScale       = frameState.mLabelScale;
+  frame.mViewProjection   = frameState.mViewProjection;
+
+  // The positions are stored in the frame of the observer, so that they only change if the
+  // bodies move.
+  frame.mLabels.resize(mAnchorLabels.size());
+  for (std::size_t i = 0; i < mAnchorLabels.size(); ++i) {
+    auto& label     = frame.mLabels[i];
+    label.mId       = mLabelIds[i];
+    label.mFlags    = labels.mFlags[i];
+    label.mPriority = labels.mPriority[i];
+    label.mRadius   = labels.mRadius[i];
+    label.mPosition =
+        frame.fromObserver({labels.mPositionX[i], labels.mPositionY[i], labels.mPositionZ[i]});
+  }
+
+  mCameraPathWriter.write(frame);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::updateHighlightedLabel() {
+  AnchorLabel const* label = nullptr;
+
+  // The labels in the batch are not part of the scene graph, so the InputManager cannot find them.
+  // Instead, the pointer ray is intersected with them here.
+  if (mPluginSettings->mTextAtlas.get() && mLabelBatch->getIsReady()) {
+    auto* selection =
+        GetVistaSystem()->GetGraphicsManager()->GetSceneGraph()->GetNode("SELECTION_NODE");
+
+    if (selection) {
+      VistaTransformMatrix matrix;
+      selection->GetWorldTransform(matrix);
+
+      VistaVector3D const origin    = matrix.TransformPoint(VistaVector3D(0, 0, 0));
+      VistaVector3D const direction = matrix.TransformVector(VistaVector3D(0, 0, -1));
+
+      label = mLabelBatch->pick(glm::dvec3(origin[0], origin[1], origin[2]),
+          glm::dvec3(direction[0], direction[1], direction[2]));
+    }
+  }
+
+  if (label != mHighlightedLabel) {
+    if (mHighlightedLabel) {
+      mVisualPool->release(mHighlightedLabel);
+    }
+
+    mHighlightedLabel = label;
+    mNeedsUpdate      = true;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::updateMemoryUsage() {
+  // Everything but the visuals is needed to place the labels, so only the visuals are limited by
+  // the budget.
+  MemoryUsage fixed;
+  fixed.mMainMemory = mLabelMemory + csp::anchorlabels::getMemoryUsage(mLabelSlots) +
+                      csp::anchorlabels::getMemoryUsage(mAnchorLabels) +
+                      mLabelStore.getMemoryUsage() + mViewDeclutter.getMemoryUsage() +
+                      mDeclutterResult.getMemoryUsage();
+  if (mDeclutterPipeline.isRunning()) {
+    fixed.mMainMemory += mDeclutterPipeline.getResult().mMemoryUsage;
+  }
+  fixed.mMainMemory += mEphemerisPrefetcher.getMemoryUsage();
+  fixed += mLabelBatch->getMemoryUsage();
+
+  std::size_t const mebibyte = 1024 * 1024;
+  std::size_t const budget   = mPluginSettings->mMemoryBudget.get();
+  std::size_t const poolSize = mPluginSettings->mLabelPoolSize.get();
+  std::size_t const maxSize  = getCountWithinBudget(budget * mebibyte, fixed.getTotal(),
+      LabelVisual::getMemoryUsage().getTotal(), poolSize);
+
+  if (maxSize != mVisualPool->getMaxSize()) {
+    if (maxSize < poolSize) {
+      logger().info("Limiting the number of label web pages to {} to stay within the memory "
+                    "budget of {} MiB.",
+          maxSize, budget);
+    }
+
+    mVisualPool->setMaxSize(maxSize);
+    mNeedsUpdate = true;
+  }
+
+  bool const isOverBudget = budget > 0 && fixed.getTotal() > budget * mebibyte;
+  if (isOverBudget && !mIsOverBudget) {
+    logger().warn("The labels need {:.1f} MiB without any web pages, which exceeds the memory "
+                  "budget of {} MiB!",
+        static_cast<double>(fixed.getTotal()) / mebibyte, budget);
+  }
+  mIsOverBudget = isOverBudget;
+
+  mMemoryUsage = fixed;
+  mMemoryUsage += mVisualPool->getMemoryUsage();
+
+  mStatistics.mMainMemory    = mMemoryUsage.mMainMemory;
+  mStatistics.mTextureMemory = mMemoryUsage.mTextureMemory;
+
+  // The average memory of a label includes its share of the pooled web pages.
+  std::size_t const kibibyte    = 1024;
+  std::size_t const labelCount  = std::max<std::size_t>(1, mAnchorLabels.size());
+  std::size_t const labelMemory = mLabelMemory + mVisualPool->getMemoryUsage().getTotal();
+  double const      perLabel =
+      static_cast<double>(labelMemory) / static_cast<double>(labelCount * kibibyte);
+
+  // The settings panel shows tenths of a MiB and of a KiB, so it is only updated if one of them
+  // changed. The totals are logged at the same time.
+  std::size_t const step = mebibyte / 10;
+  MemoryUsage const reported{mMemoryUsage.mMainMemory / step, mMemoryUsage.mTextureMemory / step};
+  std::size_t const reportedPerLabel = static_cast<std::size_t>(perLabel * 10.0);
+  if (reported != mReportedMemoryUsage || reportedPerLabel != mReportedLabelMemory) {
+    double const mainMemory    = static_cast<double>(mMemoryUsage.mMainMemory) / mebibyte;
+    double const textureMemory = static_cast<double>(mMemoryUsage.mTextureMemory) / mebibyte;
+
+    mGuiManager->getGui()->callJavascript("CosmoScout.anchorLabels.setMemoryUsage", mainMemory,
+        textureMemory, perLabel, budget);
+    logger().debug("The labels use {:.1f} MiB RAM and {:.1f} MiB GPU memory, {:.1f} KiB per "
+                   "label on average.",
+        mainMemory, textureMemory, perLabel);
+
+    mReportedMemoryUsage = reported;
+    mReportedLabelMemory = reportedPerLabel;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::updateThreads() {
+  std::size_t threadCount = mPluginSettings->mThreadCount.get();
+  if (threadCount == 0) {
+    threadCount = std::max(1U, std::thread::hardware_concurrency());
+  }
+
+  if (!mPluginSettings->mPipelinedDeclutter.get()) {
+    mDeclutterPipeline.stop();
+    mWorkerPool.setThreadCount(threadCount);
+    mNeedsUpdate = true;
+    return;
+  }
+
+  // The background thread of the pipeline runs while the main thread computes the positions of
+  // the next frame, so the threads are split between both pools.
+  std::size_t const pipelineThreads = std::max<std::size_t>(threadCount / 2, 1);
+  mWorkerPool.setThreadCount(std::max<std::size_t>(threadCount - pipelineThreads, 1));
+  mDeclutterPipeline.start(pipelineThreads);
+  mNeedsUpdate = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::reportEphemerisStatistics() {
+  auto getPercentage = [](uint64_t hits, uint64_t misses) {
+    return hits + misses > 0 ? static_cast<int>(100 * hits / (hits + misses)) : 0;
+  };
+
+  // Frames without label updates do not change the reported rates.
+  if (mStatistics.mUpdatedCount == 0) {
+    return;
+  }
+
+  std::pair<int, int> const rates{
+      getPercentage(mStatistics.mTransformCacheHits, mStatistics.mTransformCacheMisses),
+      mEphemerisPrefetcher.isActive()
+          ? getPercentage(mStatistics.mPrefetchHits, mStatistics.mPrefetchMisses)
+          : -1};
+
+  if (rates != mReportedHitRates) {
+    mGuiManager->getGui()->callJavascript(
+        "CosmoScout.anchorLabels.setEphemerisStatistics", rates.first, rates.second);
+    mReportedHitRates = rates;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Plugin::FrameState Plugin::getFrameState() const {
+  auto const& observer = mSolarSystem->getObserver();
+
+  FrameState state;
+  state.mSimulationTime   = mTimeControl->pSimulationTime.get();
+  state.mObserverCenter   = observer.getCenterName();
+  state.mObserverFrame    = observer.getFrameName();
+  state.mObserverPosition = observer.getAnchorPosition();
+  state.mObserverRotation = observer.getAnchorRotation();
+  state.mObserverScale    = observer.getAnchorScale();
+  state.mLabelScale       = mPluginSettings->mLabelScale.get();
+  state.mDepthScale       = mPluginSettings->mDepthScale.get();
+
+  state.mViewProjection           = mFrustumProbe->getViewProjection();
+  state.mViews                    = mFrustumProbe->getViews();
+  state.mCullingSettings.mEnabled = mPluginSettings->mEnableCulling.get();
+
+  auto& settings                   = state.mDeclutterSettings;
+  settings.mEnableDepthOverlap     = mPluginSettings->mEnableDepthOverlap.get();
+  settings.mIgnoreOverlapThreshold = mPluginSettings->mIgnoreOverlapThreshold.get();
+  settings.mMaxSortKey             = static_cast<int>(cs::utils::DrawOrder::eTransparentItems);
+  settings.mSortKeyRange           = mPluginSettings->mSortKeyRange.get();
+  settings.mEnableClustering       = mPluginSettings->mEnableClustering.get();
+  settings.mIncremental            = mPluginSettings->mIncrementalUpdates.get();
+  settings.mHysteresis             = mPluginSettings->mHysteresis.get();
+  settings.mCandidatePlacement     = mPluginSettings->mCandidatePlacement.get();
+  settings.mPlacementBudget        = mPluginSettings->mPlacementBudget.get();
+
+  return state;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Plugin::FrameState::operator==(FrameState const& other) const {
+  return mSimulationTime == other.mSimulationTime && mObserverCenter == other.mObserverCenter &&
+         mObserverFrame == other.mObserverFrame && mObserverPosition == other.mObserverPosition &&
+         mObserverRotation == other.mObserverRotation && mObserverScale == other.mObserverScale &&
+         mLabelScale == other.mLabelScale && mDepthScale == other.mDepthScale &&
+         mViews == other.mViews && mCullingSettings == other.mCullingSettings &&
+         mDeclutterSettings == other.mDeclutterSettings;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void Plugin::onLoad() {
   // Read settings from JSON.
   from_json(mAllSettings->mPlugins.at("csp-anchor-labels"), *mPluginSettings);
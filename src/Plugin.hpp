@@ -10,15 +10,51 @@
 #include "../../../src/cs-core/PluginBase.hpp"
 #include "../../../src/cs-core/Settings.hpp"
 #include "../../../src/cs-utils/Property.hpp"
+#include "engine/CameraPath.hpp"
+#include "engine/Culler.hpp"
+#include "engine/DeclutterEngine.hpp"
+#include "engine/DeclutterPipeline.hpp"
+#include "engine/EphemerisPrefetcher.hpp"
+#include "engine/LabelRegistry.hpp"
+#include "engine/LabelRuleSet.hpp"
+#include "engine/LabelStore.hpp"
+#include "engine/MemoryUsage.hpp"
+#include "engine/TraceWriter.hpp"
+#include "engine/TransformCache.hpp"
+#include "engine/UpdateScheduler.hpp"
+#include "engine/ViewDeclutter.hpp"
+#include "engine/WorkerPool.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
+namespace cs::scene {
+class CelestialBody;
+} // namespace cs::scene
+
 namespace csp::anchorlabels {
 class AnchorLabel;
+class CatalogLabelSource;
+class FrustumProbe;
+class LabelBatch;
+class LabelVisualPool;
 
 /// This plugin puts labels over anchors in space. It uses the anchors center names as text. If
-/// you click on the label you ar being flown to the anchor. The plugin is configurable via the
-/// application config file. See README.md for details.
+/// you click on the label you ar being flown to the anchor. Entries of point catalogs can be
+/// labeled as well. The plugin is configurable via the application config file. See README.md
+/// for details.
 class Plugin : public cs::core::PluginBase {
  public:
   struct Settings {
@@ -28,6 +64,10 @@ class Plugin : public cs::core::PluginBase {
     /// The general size of the anchor labels.
     cs::utils::DefaultProperty<double> mLabelScale{0.1};
 
+    /// If set to true, labels outside of the field of view and labels behind other bodies are
+    /// removed before the overlap test.
+    cs::utils::DefaultProperty<bool> mEnableCulling{true};
+
     /// If set to false, labels will never overlap.
     cs::utils::DefaultProperty<bool> mEnableDepthOverlap{true};
 
@@ -40,6 +80,10 @@ class Plugin : public cs::core::PluginBase {
     ///       than the threshold.
     cs::utils::DefaultProperty<double> mIgnoreOverlapThreshold{0.025};
 
+    /// If set to true, a label which hides other labels shows how many, for example "Saturn +82".
+    /// Clicking such a label flies to the body of the label.
+    cs::utils::DefaultProperty<bool> mEnableClustering{true};
+
     /// A factor that determines how much smaller further away labels are. With a value of 1.0 all
     /// labels are the same size regardless of distance from the observer, with a value smaller than
     /// 1.0 the farther away labels are smaller than the nearer ones.
@@ -47,19 +91,287 @@ class Plugin : public cs::core::PluginBase {
 
     /// The value describes the labels height over the anchor.
     cs::utils::DefaultProperty<double> mLabelOffset{0.2};
+
+    /// The maximum number of labels which can be shown at the same time. Each shown label requires
+    /// its own web page, so this limits the load of the GUI processes. With the text atlas, this
+    /// only limits the number of cached web pages.
+    cs::utils::DefaultProperty<uint32_t> mLabelPoolSize{200};
+
+    /// The estimated memory in MiB which may be used by the plugin, including the web pages of the
+    /// labels and their textures. If more would be needed, fewer labels get a web page: The pages
+    /// which have not been shown for the longest time are released first, then those of the shown
+    /// labels with the lowest priority. With a value of 0, there is no limit.
+    cs::utils::DefaultProperty<uint32_t> mMemoryBudget{0};
+
+    /// If set to true, the texts of all labels are packed into a shared texture atlas and drawn at
+    /// once. Only the label under the pointer gets its own web page, so that it can be highlighted
+    /// and clicked. The number of shown labels is then not limited by mLabelPoolSize.
+    cs::utils::DefaultProperty<bool> mTextAtlas{false};
+
+    /// The time in milliseconds which may be spent per frame on creating new labels. Labels which
+    /// do not fit into this budget are created in one of the following frames.
+    cs::utils::DefaultProperty<double> mCreationBudget{1.0};
+
+    /// If set to true, the results of the previous frame are reused as far as possible. If the
+    /// observer and the simulation time do not change, the labels are not updated at all.
+    cs::utils::DefaultProperty<bool> mIncrementalUpdates{true};
+
+    /// In incremental mode, visible labels are tested for overlap with a box which is smaller by
+    /// this fraction. This prevents labels from flickering when they are about to touch.
+    cs::utils::DefaultProperty<double> mHysteresis{0.1};
+
+    /// If set to true, a label which overlaps another label is moved next to its anchor, for
+    /// example below or to the left of it, if there is free space. Otherwise it is hidden.
+    cs::utils::DefaultProperty<bool> mCandidatePlacement{false};
+
+    /// The maximum number of alternative label positions which are tested per frame. Labels which
+    /// do not fit into this budget are hidden until one of the following frames.
+    cs::utils::DefaultProperty<uint32_t> mPlacementBudget{1000};
+
+    /// The number of threads which compute the positions of the labels. With a value of 0, one
+    /// thread per hardware thread is used. With a value of 1, everything runs on the main thread.
+    /// If the declutter pass is pipelined, half of the threads are used by the pipeline.
+    cs::utils::DefaultProperty<uint32_t> mThreadCount{0};
+
+    /// If set to true, the culling and the overlap test run on a background thread while the main
+    /// thread continues with the next frame. The main thread then applies the most recent result,
+    /// so its cost hardly depends on the number of labels. In exchange, labels may appear and
+    /// disappear one frame late.
+    cs::utils::DefaultProperty<bool> mPipelinedDeclutter{false};
+
+    /// If set to true, labels which barely move on screen, for example those of distant bodies,
+    /// are updated less often. In between, their positions are extrapolated.
+    cs::utils::DefaultProperty<bool> mScheduleUpdates{true};
+
+    /// If updates are scheduled, this is the maximum number of labels whose position is computed
+    /// per frame. All other labels are extrapolated. With a value of 0, there is no limit. The
+    /// limit is ignored after time jumps and while the observer is flying to a body.
+    cs::utils::DefaultProperty<uint32_t> mMaxLabelUpdates{0};
+
+    /// If set to true, the positions of the bodies are sampled ahead of the simulation time while
+    /// the time runs at least ten times faster than real time. The labels then interpolate between
+    /// these samples instead of querying SPICE in each frame.
+    cs::utils::DefaultProperty<bool> mEphemerisPrefetch{false};
+
+    /// Rules which decide which bodies get a label and which priority their labels have, for
+    /// example to hide all barycenters or to prefer spacecraft over moons. Bodies which are hidden
+    /// by a rule never get a label. See LabelRule for the syntax of the patterns.
+    cs::utils::DefaultProperty<std::vector<LabelRule>> mLabelRules{{}};
+
+    /// Binary point catalogs, for example of asteroids or ground stations, whose entries are
+    /// labeled as well. They can be created with csp-anchor-labels-catalog-converter.
+    cs::utils::DefaultProperty<std::vector<std::string>> mCatalogs{{}};
+
+    /// The maximum number of entries of each catalog which have a label at the same time. These
+    /// are the entries with the highest priority in the field of view.
+    cs::utils::DefaultProperty<uint32_t> mCatalogLabelCount{500};
+
+    /// The number of draw order sort keys below DrawOrder::eTransparentItems which are used by the
+    /// labels. If more labels are visible, several labels share the same key. Larger values may
+    /// collide with the draw orders of other items.
+    cs::utils::DefaultProperty<uint32_t> mSortKeyRange{50};
+
+    /// If not empty, timings and counters of each frame are written to this file. If the name ends
+    /// with ".json", one JSON object is written per line. Else the file is written as CSV.
+    cs::utils::DefaultProperty<std::string> mTraceFile{""};
+
+    /// If not empty, the observer, the simulation time and the labels of each frame in which the
+    /// labels are updated are recorded to this file. It can be replayed without CosmoScout VR by
+    /// csp-anchor-labels-replay.
+    cs::utils::DefaultProperty<std::string> mCameraPathFile{""};
   };
 
   void init() override;
   void deInit() override;
   void update() override;
 
+  /// The number of modifications of the scene graph and the GuiItems in the last frame. If the
+  /// observer and the simulation time did not change, this is zero.
+  std::size_t getSceneGraphMutations() const;
+
+  /// Timings and counters of the last frame. These are written to the trace file as well.
+  FrameStatistics const& getStatistics() const;
+
+  /// The estimated memory used by the labels, their web pages, the text atlas and the declutter
+  /// pass in the last frame.
+  MemoryUsage const& getMemoryUsage() const;
+
  private:
   void onLoad();
 
-  std::shared_ptr<Settings>                 mPluginSettings = std::make_shared<Settings>();
-  std::vector<std::unique_ptr<AnchorLabel>> mAnchorLabels;
+  /// Everything which influences the placement of the labels apart from the labels themselves.
+  /// If this does not change from one frame to the next, no label needs to be updated.
+  struct FrameState {
+    double      mSimulationTime = 0.0;
+    std::string mObserverCenter;
+    std::string mObserverFrame;
+    glm::dvec3  mObserverPosition{};
+    glm::dquat  mObserverRotation{};
+    double      mObserverScale = 1.0;
+    double      mLabelScale    = 1.0;
+    double      mDepthScale    = 1.0;
+
+    /// The labels are culled and decluttered for each view. Catalogs are queried and camera paths
+    /// are recorded for the first view only, whose view-projection matrix is stored separately.
+    std::optional<Transform> mViewProjection;
+    std::vector<View>        mViews;
+    CullingSettings          mCullingSettings;
+    DeclutterSettings        mDeclutterSettings;
+
+    bool operator==(FrameState const& other) const;
+  };
+
+  /// Computes the positions of all labels, runs the declutter pass and requests the resulting
+  /// changes from the visuals. This returns early if nothing changed since the last frame.
+  void updateLabels();
+
+  /// Fills a snapshot of the labels for the DeclutterPipeline and publishes it.
+  void publishDeclutterSnapshot(FrameState const& frameState);
+
+  /// Applies the most recent result of the DeclutterPipeline to mDeclutterResult. Returns false if
+  /// there is no new result.
+  bool fetchDeclutterResult();
+
+  /// Releases the visuals of labels which are not visible anymore and updates the visuals of the
+  /// labels in mDeclutterResult.
+  void commitLabels(bool visibleLabelsChanged);
+
+  /// Creates labels for the bodies in mPendingBodies until the deadline has passed.
+  void createPendingLabels(std::chrono::steady_clock::time_point const& deadline);
+
+  /// Adds and removes the labels of catalog entries which entered or left the field of view.
+  void updateCatalogLabels();
+
+  /// Removes the labels of all current catalogs and opens the given ones.
+  void loadCatalogs(std::vector<std::string> const& fileNames);
+
+  /// Adds the given labels to the registry. The keys identify the labels, for example by their
+  /// body.
+  void addLabels(std::vector<LabelRegistry::Key> const& keys,
+      std::vector<std::unique_ptr<AnchorLabel>>&        labels);
+
+  /// Removes the label with the given key and releases its visual. Returns false if there is no
+  /// such label.
+  bool removeLabel(LabelRegistry::Key key);
+
+  /// Compiles the given rules and updates the labels of all bodies accordingly. Labels whose body
+  /// is hidden now or whose priority changed are removed, the others are created again in the
+  /// next frames.
+  void applyLabelRules(std::vector<LabelRule> const& rules);
+
+  /// Rebuilds mAnchorLabels if labels have been added or removed since the last frame.
+  void updateLabelOrder();
+
+  /// Writes the observer and the given labels of the current frame to the camera path file.
+  void recordCameraPath(FrameState const& frameState, LabelStore const& labels);
+
+  /// Finds the label under the pointer if the text atlas is used. If it changed, the labels are
+  /// updated in this frame, so that the label gets a LabelVisual which can be clicked.
+  void updateHighlightedLabel();
+
+  /// Sums up the memory used by the plugin and reports it to the settings panel. The number of
+  /// LabelVisuals is limited so that everything fits into the memory budget.
+  void updateMemoryUsage();
+
+  /// Sizes the WorkerPool and the pool of the DeclutterPipeline according to the thread count
+  /// and starts or stops the pipeline.
+  void updateThreads();
+
+  /// Reports the hit rates of the transformation cache and of the prefetched ephemeris of the
+  /// current frame to the settings panel.
+  void reportEphemerisStatistics();
+
+  FrameState getFrameState() const;
+
+  std::shared_ptr<Settings> mPluginSettings = std::make_shared<Settings>();
+
+  /// All labels, indexed by the slot of their handle. The registry is keyed by the body of each
+  /// label or by the catalog entry and keeps them ordered by decreasing priority.
+  LabelRegistry                             mLabelRegistry;
+  std::vector<std::unique_ptr<AnchorLabel>> mLabelSlots;
+
+  /// The labels in order of decreasing priority, which is the order in which the DeclutterEngine
+  /// processes them. This is rebuilt in the frame after labels were added or removed.
+  std::vector<AnchorLabel*>        mAnchorLabels;
+  std::unique_ptr<LabelVisualPool> mVisualPool;
+
+  /// If the text atlas is used, all labels but the one under the pointer are drawn by the batch.
+  std::unique_ptr<LabelBatch> mLabelBatch;
+  AnchorLabel const*          mHighlightedLabel = nullptr;
+
+  /// Bodies which have been added to the solar system but do not have a label yet. Bodies which
+  /// are removed before their label is created are only removed from the set.
+  std::deque<cs::scene::CelestialBody const*>         mPendingBodies;
+  std::unordered_set<cs::scene::CelestialBody const*> mPendingBodySet;
+
+  /// The compiled version of Settings::mLabelRules. It is applied when a label is created.
+  LabelRuleSet mLabelRuleSet;
+
+  /// The catalogs are only queried again if the frame state changed.
+  std::vector<std::unique_ptr<CatalogLabelSource>> mCatalogSources;
+  std::optional<FrameState>                        mCatalogFrameState;
+
+  /// The probe records all views of a frame. The visuals and the batch ask it which view is drawn.
+  std::shared_ptr<FrustumProbe> mFrustumProbe;
+
+  ViewDeclutter mViewDeclutter;
+  LabelStore    mLabelStore; ///< Declutter input, one entry per element of mAnchorLabels.
+
+  /// If the declutter pass is pipelined, mViewDeclutter and mLabelStore are not used. Instead, the
+  /// input is written to a snapshot of the pipeline. In both cases, the result is copied to
+  /// mDeclutterResult, whose indices refer to mAnchorLabels.
+  DeclutterPipeline mDeclutterPipeline;
+  DeclutterResult   mDeclutterResult;
+
+  /// The labels are updated in parallel by these threads. The scene graph is only modified by the
+  /// main thread afterwards. SPICE is not thread-safe, so the queries of the labels are serialized.
+  /// They only run while the main thread waits for the labels in update(), so no other part of
+  /// CosmoScout VR queries SPICE at the same time. Frame transformations are shared between labels
+  /// for the duration of one frame. During time warps, they are prefetched on the main thread
+  /// within a budget per frame.
+  WorkerPool          mWorkerPool;
+  std::mutex          mSpiceMutex;
+  TransformCache      mTransformCache;
+  EphemerisPrefetcher mEphemerisPrefetcher;
+
+  FrameState mLastFrameState;
+  bool       mNeedsUpdate = true; ///< Forces an update even if the frame state did not change.
+
+  /// Decides which labels are updated in a frame. Time jumps are detected by comparing the
+  /// simulation time with the one expected from the time speed.
+  UpdateScheduler                       mUpdateScheduler;
+  std::chrono::steady_clock::time_point mLastUpdateTime;
+  double                                mLastTimeSpeed = 0.0;
+
+  /// The memory used by all AnchorLabels. This is updated when labels are added or removed.
+  std::size_t mLabelMemory = 0;
+  MemoryUsage mMemoryUsage;
+  MemoryUsage mReportedMemoryUsage;     ///< In tenths of a MiB, as shown in the settings panel.
+  std::size_t mReportedLabelMemory = 0; ///< The average per label, in tenths of a KiB.
+  bool        mIsOverBudget        = false;
+
+  FrameStatistics mStatistics;
+  TraceWriter     mTraceWriter;
+  uint64_t        mFrameCount = 0;
+
+  /// The hit rates in percent as shown in the settings panel. The second one is -1 while the
+  /// prefetched samples are not used.
+  std::pair<int, int> mReportedHitRates{-1, -1};
+
+  CameraPathWriter mCameraPathWriter;
+  CameraPathFrame  mCameraPathFrame;
+
+  /// Labels are identified in the camera path and in the DeclutterPipeline by an id which is not
+  /// reused when labels are removed. The ids are stored in the order of mAnchorLabels. The
+  /// generation is incremented whenever this order changes.
+  std::vector<uint32_t> mLabelIds;
+  uint32_t              mNextLabelId     = 0;
+  uint64_t              mLabelGeneration = 0;
 
-  bool mNeedsResort = true; ///< When a new label gets added resort the vector
+  /// Each SPICE center gets an id for the occlusion culling, see LabelStore::mBodyId. These are
+  /// stored in the order of mAnchorLabels as well.
+  std::unordered_map<std::string, uint32_t> mBodyIds;
+  std::vector<uint32_t>                     mLabelBodyIds;
 
   uint64_t addListenerId{};
   uint64_t removeListenerId{};
@@ -0,0 +1,37 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_ENGINE_BOUNDING_BOX_HPP
+#define CSP_ANCHOR_LABELS_ENGINE_BOUNDING_BOX_HPP
+
+#include <cmath>
+
+namespace csp::anchorlabels {
+
+/// An axis aligned rectangle in screen space. The position refers to the corner with the
+/// smallest coordinates.
+struct BoundingBox {
+  double mX      = 0.0;
+  double mY      = 0.0;
+  double mWidth  = 0.0;
+  double mHeight = 0.0;
+
+  /// Returns true if the two boxes overlap. Boxes which only touch do not overlap. Boxes with a
+  /// non-finite position never overlap anything.
+  bool intersects(BoundingBox const& other) const {
+    return other.mX + other.mWidth > mX && other.mY + other.mHeight > mY &&
+           mX + mWidth > other.mX && mY + mHeight > other.mY;
+  }
+
+  bool isFinite() const {
+    return std::isfinite(mX) && std::isfinite(mY) && std::isfinite(mWidth) &&
+           std::isfinite(mHeight);
+  }
+};
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_ENGINE_BOUNDING_BOX_HPP
@@ -0,0 +1,298 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "CameraPath.hpp"
+
+#include <algorithm>
+
+namespace csp::anchorlabels {
+
+namespace {
+
+std::array<char, 8> const MAGIC   = {'C', 'S', 'P', 'L', 'P', 'A', 'T', 'H'};
+uint32_t const            VERSION = 1;
+
+using Vector = std::array<double, 3>;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Rotates the vector by the quaternion. If inverse is set, the conjugate quaternion is used.
+Vector rotate(std::array<double, 4> const& q, Vector const& v, bool inverse) {
+  double const x = inverse ? -q[0] : q[0];
+  double const y = inverse ? -q[1] : q[1];
+  double const z = inverse ? -q[2] : q[2];
+  double const w = q[3];
+
+  Vector const t = {
+      2.0 * (y * v[2] - z * v[1]), 2.0 * (z * v[0] - x * v[2]), 2.0 * (x * v[1] - y * v[0])};
+
+  return {v[0] + w * t[0] + y * t[2] - z * t[1], v[1] + w * t[1] + z * t[0] - x * t[2],
+      v[2] + w * t[2] + x * t[1] - y * t[0]};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+void writeValue(std::ofstream& file, T const& value) {
+  file.write(reinterpret_cast<char const*>(&value), sizeof(T));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+bool readValue(std::ifstream& file, T& value) {
+  return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns true if the label has to be written again.
+bool isChanged(
+    CameraPathLabel const& previous, CameraPathLabel const& label, Vector const& observer) {
+  if (previous.mFlags != label.mFlags || previous.mPriority != label.mPriority ||
+      previous.mRadius != label.mRadius) {
+    return true;
+  }
+
+  double distance = 0.0;
+  double change   = 0.0;
+  for (std::size_t i = 0; i < 3; ++i) {
+    distance += (label.mPosition[i] - observer[i]) * (label.mPosition[i] - observer[i]);
+    change += (label.mPosition[i] - previous.mPosition[i]) *
+              (label.mPosition[i] - previous.mPosition[i]);
+  }
+
+  double const tolerance = CameraPathWriter::POSITION_TOLERANCE;
+
+  // Written this way, NaN values are always treated as a change.
+  return !(change <= tolerance * tolerance * distance);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double const CameraPathWriter::POSITION_TOLERANCE = 1e-9;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::array<double, 3> CameraPathFrame::toObserver(std::array<double, 3> const& position) const {
+  Vector v = rotate(mObserverRotation,
+      {position[0] - mObserverPosition[0], position[1] - mObserverPosition[1],
+          position[2] - mObserverPosition[2]},
+      true);
+
+  return {v[0] / mObserverScale, v[1] / mObserverScale, v[2] / mObserverScale};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::array<double, 3> CameraPathFrame::fromObserver(std::array<double, 3> const& position) const {
+  Vector v = rotate(mObserverRotation,
+      {position[0] * mObserverScale, position[1] * mObserverScale, position[2] * mObserverScale},
+      false);
+
+  return {v[0] + mObserverPosition[0], v[1] + mObserverPosition[1], v[2] + mObserverPosition[2]};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool CameraPathWriter::open(std::string const& fileName) {
+  close();
+
+  mFile.open(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!mFile) {
+    return false;
+  }
+
+  mFile.write(MAGIC.data(), MAGIC.size());
+  writeValue(mFile, VERSION);
+
+  return static_cast<bool>(mFile);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void CameraPathWriter::close() {
+  if (mFile.is_open()) {
+    mFile.close();
+  }
+  mFile.clear();
+
+  mFrameCount = 0;
+  mLabels.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool CameraPathWriter::isOpen() const {
+  return mFile.is_open();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void CameraPathWriter::write(CameraPathFrame const& frame) {
+  if (!mFile.is_open()) {
+    return;
+  }
+
+  ++mFrameCount;
+
+  // Labels which are not part of this frame anymore are removed, all others are only written if
+  // they changed.
+  mChanged.clear();
+  for (auto const& label : frame.mLabels) {
+    auto [it, inserted] = mLabels.try_emplace(label.mId);
+    if (inserted || isChanged(it->second.mLabel, label, frame.mObserverPosition)) {
+      it->second.mLabel = label;
+      mChanged.push_back(label);
+    }
+    it->second.mFrame = mFrameCount;
+  }
+
+  mRemoved.clear();
+  for (auto it = mLabels.begin(); it != mLabels.end();) {
+    if (it->second.mFrame != mFrameCount) {
+      mRemoved.push_back(it->first);
+      it = mLabels.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  writeValue(mFile, frame.mSimulationTime);
+  writeValue(mFile, frame.mObserverPosition);
+  writeValue(mFile, frame.mObserverRotation);
+  writeValue(mFile, frame.mObserverScale);
+  writeValue(mFile, frame.mLabelScale);
+
+  writeValue(mFile, static_cast<uint8_t>(frame.mViewProjection ? 1 : 0));
+  if (frame.mViewProjection) {
+    writeValue(mFile, *frame.mViewProjection);
+  }
+
+  writeValue(mFile, static_cast<uint32_t>(mRemoved.size()));
+  for (uint32_t id : mRemoved) {
+    writeValue(mFile, id);
+  }
+
+  writeValue(mFile, static_cast<uint32_t>(mChanged.size()));
+  for (auto const& label : mChanged) {
+    writeValue(mFile, label.mId);
+    writeValue(mFile, label.mFlags);
+    writeValue(mFile, label.mPriority);
+    writeValue(mFile, label.mRadius);
+    writeValue(mFile, label.mPosition);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool CameraPathReader::open(std::string const& fileName) {
+  close();
+
+  mFile.open(fileName, std::ios::in | std::ios::binary);
+  if (!mFile) {
+    return false;
+  }
+
+  std::array<char, 8> magic{};
+  uint32_t            version = 0;
+  if (!mFile.read(magic.data(), magic.size()) || !readValue(mFile, version) || magic != MAGIC ||
+      version != VERSION) {
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void CameraPathReader::close() {
+  if (mFile.is_open()) {
+    mFile.close();
+  }
+  mFile.clear();
+
+  mLabels.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool CameraPathReader::read(CameraPathFrame& frame) {
+  if (!mFile.is_open()) {
+    return false;
+  }
+
+  uint8_t hasViewProjection = 0;
+  if (!readValue(mFile, frame.mSimulationTime) || !readValue(mFile, frame.mObserverPosition) ||
+      !readValue(mFile, frame.mObserverRotation) || !readValue(mFile, frame.mObserverScale) ||
+      !readValue(mFile, frame.mLabelScale) || !readValue(mFile, hasViewProjection)) {
+    return false;
+  }
+
+  frame.mViewProjection.reset();
+  if (hasViewProjection) {
+    Transform viewProjection{};
+    if (!readValue(mFile, viewProjection)) {
+      return false;
+    }
+    frame.mViewProjection = viewProjection;
+  }
+
+  frame.mLabelsChanged = false;
+
+  uint32_t removedCount = 0;
+  if (!readValue(mFile, removedCount)) {
+    return false;
+  }
+
+  for (uint32_t i = 0; i < removedCount; ++i) {
+    uint32_t id = 0;
+    if (!readValue(mFile, id)) {
+      return false;
+    }
+    frame.mLabelsChanged = mLabels.erase(id) > 0 || frame.mLabelsChanged;
+  }
+
+  uint32_t changedCount = 0;
+  if (!readValue(mFile, changedCount)) {
+    return false;
+  }
+
+  for (uint32_t i = 0; i < changedCount; ++i) {
+    CameraPathLabel label;
+    if (!readValue(mFile, label.mId) || !readValue(mFile, label.mFlags) ||
+        !readValue(mFile, label.mPriority) || !readValue(mFile, label.mRadius) ||
+        !readValue(mFile, label.mPosition)) {
+      return false;
+    }
+
+    auto [it, inserted] = mLabels.try_emplace(label.mId, label);
+    frame.mLabelsChanged =
+        inserted || it->second.mPriority != label.mPriority || frame.mLabelsChanged;
+    it->second = label;
+  }
+
+  // The plugin passes the labels in order of decreasing priority. Labels with equal priority are
+  // ordered by id, so that the order is the same in each replay.
+  frame.mLabels.clear();
+  for (auto const& [id, label] : mLabels) {
+    frame.mLabels.push_back(label);
+  }
+
+  std::stable_sort(frame.mLabels.begin(), frame.mLabels.end(),
+      [](auto const& a, auto const& b) { return a.mPriority > b.mPriority; });
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
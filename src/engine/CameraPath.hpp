@@ -0,0 +1,117 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_ENGINE_CAMERA_PATH_HPP
+#define CSP_ANCHOR_LABELS_ENGINE_CAMERA_PATH_HPP
+
+#include "Transform.hpp"
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace csp::anchorlabels {
+
+/// The state of one label in a recorded frame.
+struct CameraPathLabel {
+  /// Identifies the label over all frames of a path. Ids of removed labels may be reused.
+  uint32_t mId = 0;
+
+  /// The LabelFlags, the priority and the radius as stored in the LabelStore.
+  uint8_t mFlags    = 0;
+  double  mPriority = 0.0;
+  double  mRadius   = 0.0;
+
+  /// The position of the anchor in the SPICE frame of the observer. Unlike observer-relative
+  /// positions, these do not change if only the observer moves.
+  std::array<double, 3> mPosition{};
+};
+
+/// Everything the label update depends on in one frame. Observer-relative positions are
+/// computed as in cs::scene::CelestialObserver: The observer is placed at mObserverPosition in
+/// its SPICE frame, rotated by mObserverRotation and scaled by mObserverScale.
+struct CameraPathFrame {
+  double                mSimulationTime = 0.0;
+  std::array<double, 3> mObserverPosition{};
+  std::array<double, 4> mObserverRotation{0.0, 0.0, 0.0, 1.0}; ///< A quaternion x, y, z, w.
+  double                mObserverScale = 1.0;
+  double                mLabelScale    = 1.0;
+
+  std::optional<Transform> mViewProjection;
+
+  /// All labels which exist in this frame. CameraPathReader returns them in order of decreasing
+  /// priority, like the plugin passes them to the DeclutterEngine.
+  std::vector<CameraPathLabel> mLabels;
+
+  /// Set by CameraPathReader if labels were added or removed or a priority changed since the
+  /// previous frame.
+  bool mLabelsChanged = false;
+
+  /// Transforms a position in the SPICE frame of the observer to observer-relative space.
+  std::array<double, 3> toObserver(std::array<double, 3> const& position) const;
+
+  /// The inverse of toObserver().
+  std::array<double, 3> fromObserver(std::array<double, 3> const& position) const;
+};
+
+/// Writes the frames of a camera path to a compact binary file. Only the labels which were added,
+/// removed or changed since the previous frame are stored, so a path through a static scene only
+/// costs a few hundred bytes per frame, regardless of the number of labels. Positions which moved
+/// by less than POSITION_TOLERANCE times their distance to the observer are not written again, as
+/// positions reconstructed from observer-relative ones are never exactly the same.
+///
+/// The file is little-endian and starts with a magic number and a version. Each frame stores the
+/// observer, the simulation time and the view-projection matrix, followed by the ids of the
+/// removed labels and the complete state of all added and changed labels.
+class CameraPathWriter {
+ public:
+  static double const POSITION_TOLERANCE;
+
+  /// Closes the current file and opens the given one. An existing file is overwritten. Returns
+  /// false if the file could not be opened.
+  bool open(std::string const& fileName);
+  void close();
+  bool isOpen() const;
+
+  void write(CameraPathFrame const& frame);
+
+ private:
+  struct WrittenLabel {
+    CameraPathLabel mLabel;
+    uint64_t        mFrame = 0; ///< The last frame which contained the label.
+  };
+
+  std::ofstream                              mFile;
+  uint64_t                                   mFrameCount = 0;
+  std::unordered_map<uint32_t, WrittenLabel> mLabels;
+  std::vector<uint32_t>                      mRemoved;
+  std::vector<CameraPathLabel>               mChanged;
+};
+
+/// Reads the files written by CameraPathWriter frame by frame.
+class CameraPathReader {
+ public:
+  /// Closes the current file and opens the given one. Returns false if the file could not be
+  /// opened or is not a camera path.
+  bool open(std::string const& fileName);
+  void close();
+
+  /// Reads the next frame. Returns false at the end of the file or if the file is corrupt.
+  bool read(CameraPathFrame& frame);
+
+ private:
+  std::ifstream                       mFile;
+  std::map<uint32_t, CameraPathLabel> mLabels;
+};
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_ENGINE_CAMERA_PATH_HPP
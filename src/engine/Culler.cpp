@@ -0,0 +1,197 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Culler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace csp::anchorlabels {
+
+namespace {
+
+// Points on the surface of a body are only culled by the body itself if the angle between the
+// surface normal and the direction to the observer exceeds 90 degrees by more than about three
+// degrees. This keeps points close to the horizon visible, whose normal is not exactly radial.
+double const HORIZON_MARGIN = 0.05;
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool CullingSettings::operator==(CullingSettings const& other) const {
+  return mEnabled == other.mEnabled && mFrustumMargin == other.mFrustumMargin &&
+         mMaxOccluders == other.mMaxOccluders && mMinOccluderSize == other.mMinOccluderSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool CullingSettings::operator!=(CullingSettings const& other) const {
+  return !(*this == other);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Culler::setViewProjection(std::optional<Transform> const& viewProjection) {
+  mViewProjection = viewProjection;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Culler::cull(LabelStore& labels, double radiusScale, CullingSettings const& settings) {
+  std::size_t const count = labels.size();
+
+  mCulledCount = 0;
+
+  for (auto& flags : labels.mFlags) {
+    flags = static_cast<uint8_t>(flags & ~eCulled);
+  }
+
+  if (!settings.mEnabled) {
+    return;
+  }
+
+  for (std::size_t i = 0; i < count; ++i) {
+    if (!labels.isHidden(i) && isOutsideFrustum(labels, i, settings.mFrustumMargin)) {
+      labels.mFlags[i] = static_cast<uint8_t>(labels.mFlags[i] | eCulled);
+      ++mCulledCount;
+    }
+  }
+
+  // Bodies outside of the frustum may still cover parts of the screen, so they are considered as
+  // occluders as well. If the observer is inside of a body, it cannot occlude anything.
+  mCandidates.clear();
+  for (std::size_t i = 0; i < count; ++i) {
+    double const radius = labels.mRadius[i] * radiusScale;
+    if ((labels.mFlags[i] & eHidden) != 0 || !(radius > 0.0)) {
+      continue;
+    }
+
+    double const distance = std::sqrt(labels.mPositionX[i] * labels.mPositionX[i] +
+                                      labels.mPositionY[i] * labels.mPositionY[i] +
+                                      labels.mPositionZ[i] * labels.mPositionZ[i]);
+
+    if (distance > radius && radius / distance >= settings.mMinOccluderSize) {
+      mCandidates.emplace_back(radius / distance, i);
+    }
+  }
+
+  if (mCandidates.size() > settings.mMaxOccluders) {
+    std::nth_element(mCandidates.begin(), mCandidates.begin() + settings.mMaxOccluders,
+        mCandidates.end(), [](auto const& a, auto const& b) { return a.first > b.first; });
+    mCandidates.resize(settings.mMaxOccluders);
+  }
+
+  std::size_t const occluderCount = mCandidates.size();
+  mOccluderIds.resize(occluderCount);
+  mOccluderBodyIds.resize(occluderCount);
+  mOccluderX.resize(occluderCount);
+  mOccluderY.resize(occluderCount);
+  mOccluderZ.resize(occluderCount);
+  mOccluderRadiusSq.resize(occluderCount);
+
+  for (std::size_t j = 0; j < occluderCount; ++j) {
+    std::size_t const id = mCandidates[j].second;
+    double const      r  = labels.mRadius[id] * radiusScale;
+    mOccluderIds[j]      = id;
+    mOccluderBodyIds[j]  = labels.mBodyId[id];
+    mOccluderX[j]        = labels.mPositionX[id];
+    mOccluderY[j]        = labels.mPositionY[id];
+    mOccluderZ[j]        = labels.mPositionZ[id];
+    mOccluderRadiusSq[j] = r * r;
+  }
+
+  if (occluderCount == 0) {
+    return;
+  }
+
+  // A label is occluded if the segment between the observer and its anchor enters a sphere. With
+  // t being the projection of the sphere's center C onto the segment to the anchor P, this is the
+  // case if the sphere is in front of the observer, the line passes the center closer than the
+  // radius r, and the point where the line enters the sphere is closer than the anchor. The
+  // latter is true if the closest point on the line is before the anchor or if the anchor is
+  // inside the sphere. All terms are multiplied with |P|² to avoid divisions and square roots.
+  //
+  // The radius of a body is its largest radius, so points on its surface are usually inside the
+  // sphere. Hence labels of the same body are tested against the horizon instead: They are culled
+  // if the vector from the center to the anchor points away from the observer, that is if
+  // P·(P - C) = |P|² - t is larger than HORIZON_MARGIN * |P| * |P - C|. Both sides are squared.
+  for (std::size_t i = 0; i < count; ++i) {
+    if (labels.isHidden(i)) {
+      continue;
+    }
+
+    double const px = labels.mPositionX[i];
+    double const py = labels.mPositionY[i];
+    double const pz = labels.mPositionZ[i];
+    double const p2 = px * px + py * py + pz * pz;
+
+    uint32_t const bodyId = labels.mBodyId[i];
+
+    int occluders = 0;
+
+    for (std::size_t j = 0; j < occluderCount; ++j) {
+      double const cx = mOccluderX[j];
+      double const cy = mOccluderY[j];
+      double const cz = mOccluderZ[j];
+      double const r2 = mOccluderRadiusSq[j];
+
+      double const t  = cx * px + cy * py + cz * pz;
+      double const c2 = cx * cx + cy * cy + cz * cz;
+      double const d2 = (cx - px) * (cx - px) + (cy - py) * (cy - py) + (cz - pz) * (cz - pz);
+
+      bool occludes = false;
+      if (bodyId != 0 && mOccluderBodyIds[j] == bodyId) {
+        double const h = p2 - t;
+        occludes       = h > 0.0 && h * h > HORIZON_MARGIN * HORIZON_MARGIN * d2 * p2;
+      } else {
+        occludes = t > 0.0 && (c2 - r2) * p2 < t * t && (t <= p2 || d2 < r2) &&
+                   mOccluderIds[j] != i;
+      }
+
+      occluders += occludes ? 1 : 0;
+    }
+
+    if (occluders > 0) {
+      labels.mFlags[i] = static_cast<uint8_t>(labels.mFlags[i] | eCulled);
+      ++mCulledCount;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t Culler::getCulledCount() const {
+  return mCulledCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Culler::isOutsideFrustum(LabelStore const& labels, std::size_t label, double margin) const {
+  double const px = labels.mPositionX[label];
+  double const py = labels.mPositionY[label];
+  double const pz = labels.mPositionZ[label];
+
+  // The observer looks along the negative z-axis.
+  if (!mViewProjection) {
+    return !(pz < 0.0);
+  }
+
+  auto const&  m = *mViewProjection;
+  double const x = m[0] * px + m[4] * py + m[8] * pz + m[12];
+  double const y = m[1] * px + m[5] * py + m[9] * pz + m[13];
+  double const w = m[3] * px + m[7] * py + m[11] * pz + m[15];
+
+  // The screen spans two units in normalized device coordinates.
+  double const limit = w * (1.0 + 2.0 * margin);
+
+  // NaN values are treated as outside.
+  return !(w > 0.0 && std::abs(x) <= limit && std::abs(y) <= limit);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
@@ -0,0 +1,78 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_ENGINE_CULLER_HPP
+#define CSP_ANCHOR_LABELS_ENGINE_CULLER_HPP
+
+#include "LabelStore.hpp"
+#include "Transform.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace csp::anchorlabels {
+
+/// The subset of the plugin settings which influences the culling stage.
+struct CullingSettings {
+  /// See Plugin::Settings::mEnableCulling.
+  bool mEnabled = true;
+
+  /// Labels are only culled if their anchor is further outside of the view frustum than this
+  /// fraction of the screen size, as the label itself may still be partially visible.
+  double mFrustumMargin = 0.2;
+
+  /// Only the bodies with the largest apparent size are used as occluders.
+  std::size_t mMaxOccluders = 32;
+
+  /// Bodies with a smaller apparent radius in radians are not used as occluders.
+  double mMinOccluderSize = 1e-4;
+
+  bool operator==(CullingSettings const& other) const;
+  bool operator!=(CullingSettings const& other) const;
+};
+
+/// The Culler removes labels which cannot be seen before the declutter pass. It sets the eCulled
+/// flag of all labels whose anchor is outside of the view frustum or hidden behind the body of
+/// another label. Culled labels do not take part in the overlap test and are not drawn.
+///
+/// The occlusion test treats the bodies as spheres. The bodies with the largest apparent size are
+/// chosen as occluders and all labels are tested against all of them in a tight loop.
+class Culler {
+ public:
+  /// Sets the column-major matrix which transforms observer-relative positions to clip space. If
+  /// there is none, only labels behind the observer are culled.
+  void setViewProjection(std::optional<Transform> const& viewProjection);
+
+  /// Sets or clears the eCulled flag of all labels. The positions in the store have to be relative
+  /// to the observer. The radii of the bodies are multiplied with radiusScale to convert them to
+  /// the same unit.
+  void cull(LabelStore& labels, double radiusScale, CullingSettings const& settings);
+
+  /// The number of labels which were culled in the last call to cull().
+  std::size_t getCulledCount() const;
+
+ private:
+  bool isOutsideFrustum(LabelStore const& labels, std::size_t label, double margin) const;
+
+  std::optional<Transform> mViewProjection;
+
+  /// The occluders of the current call in a structure-of-arrays layout.
+  std::vector<std::pair<double, std::size_t>> mCandidates;
+  std::vector<std::size_t>                    mOccluderIds;
+  std::vector<uint32_t>                       mOccluderBodyIds;
+  std::vector<double>                         mOccluderX;
+  std::vector<double>                         mOccluderY;
+  std::vector<double>                         mOccluderZ;
+  std::vector<double>                         mOccluderRadiusSq;
+
+  std::size_t mCulledCount = 0;
+};
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_ENGINE_CULLER_HPP
@@ -0,0 +1,508 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "DeclutterEngine.hpp"
+
+#include "MemoryUsage.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+
+namespace csp::anchorlabels {
+
+namespace {
+
+// Maps a distance to an integer with the same order. Negative zero is treated like zero and NaN
+// values are placed after all other values.
+uint64_t getSortKey(double distance) {
+  distance += 0.0;
+
+  uint64_t bits = 0;
+  std::memcpy(&bits, &distance, sizeof(bits));
+
+  uint64_t const sign = uint64_t(1) << 63;
+  return (bits & sign) != 0 ? ~bits : bits | sign;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Sorts the pairs by distance with a radix sort, one byte at a time. Pairs with equal distance
+// keep their order. Bytes which are the same for all pairs are skipped. For the tens of thousands
+// of labels which may be visible with depth overlap, this is several times faster than
+// std::stable_sort.
+void sortByDistance(std::vector<std::pair<double, std::size_t>>& values,
+    std::vector<std::pair<double, std::size_t>>&                 buffer) {
+  std::size_t const bytes = sizeof(uint64_t);
+
+  std::array<std::array<std::size_t, 256>, bytes> counts{};
+  for (auto const& value : values) {
+    uint64_t const key = getSortKey(value.first);
+    for (std::size_t byte = 0; byte < bytes; ++byte) {
+      ++counts[byte][(key >> (byte * 8)) & 0xFF];
+    }
+  }
+
+  buffer.resize(values.size());
+
+  for (std::size_t byte = 0; byte < bytes; ++byte) {
+    auto&       count   = counts[byte];
+    std::size_t offset  = 0;
+    bool        skipped = false;
+
+    for (auto& c : count) {
+      skipped = skipped || c == values.size();
+      offset += c;
+      c = offset - c;
+    }
+
+    if (skipped) {
+      continue;
+    }
+
+    for (auto const& value : values) {
+      buffer[count[(getSortKey(value.first) >> (byte * 8)) & 0xFF]++] = value;
+    }
+    values.swap(buffer);
+  }
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t const DeclutterEngine::NO_CLUSTER = std::numeric_limits<std::size_t>::max();
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool DeclutterSettings::operator==(DeclutterSettings const& other) const {
+  return mEnableDepthOverlap == other.mEnableDepthOverlap &&
+         mIgnoreOverlapThreshold == other.mIgnoreOverlapThreshold &&
+         mMaxSortKey == other.mMaxSortKey && mSortKeyRange == other.mSortKeyRange &&
+         mAllocateSortKeys == other.mAllocateSortKeys &&
+         mEnableClustering == other.mEnableClustering && mIncremental == other.mIncremental &&
+         mEpsilon == other.mEpsilon && mHysteresis == other.mHysteresis &&
+         mCandidatePlacement == other.mCandidatePlacement &&
+         mPlacementBudget == other.mPlacementBudget;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool DeclutterSettings::operator!=(DeclutterSettings const& other) const {
+  return !(*this == other);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DeclutterEngine::invalidatePriorities() {
+  mPrioritiesDirty = true;
+  mKeepSortKeys    = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DeclutterEngine::remapLabels(std::vector<std::size_t> const& previousLabels) {
+  mSortKeyAllocator.remap(previousLabels);
+  mPrioritiesDirty = true;
+  mKeepSortKeys    = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool DeclutterEngine::update(LabelStore const& labels, DeclutterSettings const& settings) {
+  std::size_t const labelCount = labels.size();
+
+  bool const reordered = mPrioritiesDirty || mPriorityOrder.size() != labelCount;
+  if (reordered) {
+    sortByPriority(labels);
+
+    // The label indices may refer to different labels now, unless the keys have been remapped.
+    if (!mKeepSortKeys) {
+      mSortKeyAllocator.reset();
+    }
+    mKeepSortKeys = false;
+  }
+
+  // The previous results can only be reused if neither the labels nor the settings changed.
+  bool const hasPrevious = settings.mIncremental && !reordered && mSettings == settings &&
+                           mTested.size() == labelCount && mIsVisible.size() == labelCount;
+  mSettings = settings;
+
+  std::size_t movedCount = 0;
+
+  // All internal data is stored in order of priority. This way, the main loop below accesses the
+  // memory sequentially. Below, rank refers to the position of a label in this order.
+  if (hasPrevious) {
+    mIsMoved.resize(labelCount);
+    for (std::size_t rank = 0; rank < labelCount; ++rank) {
+      mIsMoved[rank] = isMoved(labels, rank) ? 1 : 0;
+      movedCount += mIsMoved[rank];
+    }
+
+    if (movedCount == 0) {
+      mTestedLabelCount    = 0;
+      mChangedSortKeyCount = 0;
+      mPairTestCount       = 0;
+      mPlacementTestCount  = 0;
+      return false;
+    }
+  } else {
+    mIsMoved.assign(labelCount, 1);
+    mIsVisible.assign(labelCount, 0);
+    mPlacements.assign(labelCount, static_cast<uint8_t>(LabelPlacement::eDefault));
+    mClusters.assign(labelCount, NO_CLUSTER);
+    mTested.resize(labelCount);
+  }
+
+  // If many labels moved, for example because the observer is rotating, testing all labels is
+  // cheaper than tracking the changed regions.
+  bool const testAll = !hasPrevious || movedCount * 4 > labelCount;
+
+  // If the labels are already sorted by priority, all data can be copied at once. Else it has to
+  // be gathered label by label.
+  mChangedBoxes.clear();
+  if (testAll && mIsPriorityOrdered) {
+    mTested = labels;
+  } else {
+    for (std::size_t rank = 0; rank < labelCount; ++rank) {
+      if (mIsMoved[rank]) {
+        if (!testAll) {
+          mChangedBoxes.push_back(getRegion(mTested.getBoundingBox(rank)));
+          mChangedBoxes.push_back(getRegion(labels.getBoundingBox(mPriorityOrder[rank])));
+        }
+        mTested.copy(rank, labels, mPriorityOrder[rank]);
+      }
+    }
+  }
+
+  // The grid cell size is chosen to match the largest label, so that each label touches at most
+  // four cells. The grid covers all finite boxes, including their alternative positions.
+  double      cellSize = 0.0;
+  BoundingBox bounds{0.0, 0.0, -1.0, -1.0};
+  double      maxX = 0.0;
+  double      maxY = 0.0;
+
+  for (std::size_t rank = 0; rank < labelCount; ++rank) {
+    BoundingBox box = getRegion(mTested.getBoundingBox(rank));
+    if (!box.isFinite()) {
+      continue;
+    }
+
+    cellSize = std::max(cellSize, std::max(mTested.mWidth[rank], mTested.mHeight[rank]));
+
+    if (bounds.mWidth < 0.0) {
+      bounds = {box.mX, box.mY, 0.0, 0.0};
+      maxX   = box.mX + box.mWidth;
+      maxY   = box.mY + box.mHeight;
+    } else {
+      bounds.mX = std::min(bounds.mX, box.mX);
+      bounds.mY = std::min(bounds.mY, box.mY);
+      maxX      = std::max(maxX, box.mX + box.mWidth);
+      maxY      = std::max(maxY, box.mY + box.mHeight);
+    }
+  }
+
+  if (bounds.mWidth >= 0.0) {
+    bounds.mWidth  = maxX - bounds.mX;
+    bounds.mHeight = maxY - bounds.mY;
+  }
+
+  // Most cells stay empty, so a few more cells than labels are sufficient.
+  std::size_t const maxCells = labelCount + 64;
+
+  mGrid.reset(cellSize, bounds, maxCells);
+  mChangedGrid.reset(cellSize, bounds, maxCells);
+
+  // The bitmap is much finer than the grid, so that the boxes of neighboring labels rarely share a
+  // cell. A bit per cell is cheap, so it may have many more cells than the grid.
+  if (settings.mCandidatePlacement) {
+    mBitmap.reset(cellSize * 0.25, bounds, maxCells * 16);
+  }
+
+  for (std::size_t i = 0; i < mChangedBoxes.size(); ++i) {
+    mChangedGrid.insert(i, mChangedBoxes[i], 0.0);
+  }
+
+  mVisibleByDistance.clear();
+  mTestedLabelCount   = 0;
+  mPlacementTestCount = 0;
+
+  for (std::size_t rank = 0; rank < labelCount; ++rank) {
+    BoundingBox const bb         = mTested.getBoundingBox(rank);
+    double const      distance   = mTested.mDistance[rank];
+    bool const        wasVisible = mIsVisible[rank] != 0;
+
+    // Labels which did not move keep their previous result, as long as no label which changed in
+    // this frame overlaps them. The changed labels are processed in order of priority as well, so
+    // the regions of all labels which might have an influence on this label are known by now.
+    if (testAll || mIsMoved[rank] || isAffected(bb)) {
+      ++mTestedLabelCount;
+
+      bool canBeAdded = !mTested.isHidden(rank);
+
+      // A label is first tested at the position it had in the previous frame, so that labels only
+      // jump to another position if they have to.
+      auto const previousPlacement = static_cast<LabelPlacement>(mPlacements[rank]);
+      auto       placement         = previousPlacement;
+
+      // Labels which have been visible before are tested with a smaller box. This way, they
+      // disappear a little later than they appear, which prevents flickering.
+      BoundingBox box = getPlacedBox(bb, placement);
+      if (hasPrevious && wasVisible) {
+        box.mX += box.mWidth * settings.mHysteresis * 0.5;
+        box.mY += box.mHeight * settings.mHysteresis * 0.5;
+        box.mWidth *= 1.0 - settings.mHysteresis;
+        box.mHeight *= 1.0 - settings.mHysteresis;
+      }
+
+      // Only labels which share a grid cell with this label may collide with it. If they collide
+      // the bigger label survives. Since the labels are processed in order of priority, it is
+      // assured that the bigger label gets displayed.
+      std::size_t other = 0;
+      if (canBeAdded && findOverlap(box, distance, other)) {
+        canBeAdded = false;
+
+        // The alternative positions are tried in a fixed order until one of them is free or the
+        // budget of this update is used up. The cluster is formed at the previous position.
+        std::size_t blocking = other;
+        for (uint8_t i = 0; settings.mCandidatePlacement &&
+                            i < static_cast<uint8_t>(LabelPlacement::eCount) &&
+                            mPlacementTestCount < settings.mPlacementBudget;
+             ++i) {
+          auto const candidate = static_cast<LabelPlacement>(i);
+          if (candidate == previousPlacement) {
+            continue;
+          }
+
+          ++mPlacementTestCount;
+          if (!findOverlap(getPlacedBox(bb, candidate), distance, blocking)) {
+            placement  = candidate;
+            canBeAdded = true;
+            break;
+          }
+        }
+      }
+
+      if (!canBeAdded) {
+        placement = LabelPlacement::eDefault;
+      }
+
+      // A label which is hidden by another one is merged into the other label's cluster.
+      mClusters[rank] = canBeAdded || mTested.isHidden(rank) ? NO_CLUSTER : other;
+
+      // If the visibility or the position of this label changed, labels with a lower priority in
+      // its vicinity have to be tested again.
+      bool const replaced = canBeAdded && placement != previousPlacement;
+      mPlacements[rank]   = static_cast<uint8_t>(placement);
+
+      if (canBeAdded != wasVisible || replaced) {
+        mIsVisible[rank] = canBeAdded ? 1 : 0;
+
+        if (!testAll) {
+          BoundingBox const region = getRegion(bb);
+          mChangedGrid.insert(mChangedBoxes.size(), region, 0.0);
+          mChangedBoxes.push_back(region);
+        }
+      }
+    }
+
+    if (mIsVisible[rank]) {
+      BoundingBox const placed = getPlacedBox(bb, static_cast<LabelPlacement>(mPlacements[rank]));
+      mVisibleByDistance.emplace_back(distance, mPriorityOrder[rank]);
+      mGrid.insert(rank, placed, distance);
+
+      if (settings.mCandidatePlacement) {
+        mBitmap.mark(placed);
+      }
+    }
+  }
+
+  mPairTestCount = mGrid.getTestCount();
+
+  // Labels which did not change keep their cluster. Their cluster's label cannot have changed
+  // either, as the labels overlapping a changed label are always tested again.
+  mClusterSizes.assign(labelCount, 0);
+  if (settings.mEnableClustering) {
+    for (std::size_t rank = 0; rank < labelCount; ++rank) {
+      std::size_t const cluster = mClusters[rank];
+      if (cluster != NO_CLUSTER && mIsVisible[cluster]) {
+        ++mClusterSizes[cluster];
+      }
+    }
+  }
+
+  // The distances are stored next to the label indices, so that sorting does not require any
+  // indirect memory accesses. Labels with equal distance stay in order of priority.
+  sortByDistance(mVisibleByDistance, mSortBuffer);
+
+  mVisibleLabels.resize(mVisibleByDistance.size());
+  for (std::size_t i = 0; i < mVisibleByDistance.size(); ++i) {
+    mVisibleLabels[i] = mVisibleByDistance[i].second;
+  }
+
+  if (settings.mAllocateSortKeys) {
+    mSortKeyAllocator.allocate(
+        mVisibleLabels, settings.mMaxSortKey, settings.mSortKeyRange, mSortKeys);
+    mChangedSortKeyCount = mSortKeyAllocator.getChangedKeyCount();
+  } else {
+    mSortKeyAllocator.reset();
+    mSortKeys.clear();
+    mChangedSortKeyCount = 0;
+  }
+
+  // Moving labels may change the sort order even if the visible set stays the same.
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<std::size_t> const& DeclutterEngine::getVisibleLabels() const {
+  return mVisibleLabels;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<int> const& DeclutterEngine::getSortKeys() const {
+  return mSortKeys;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t DeclutterEngine::getPairTestCount() const {
+  return mPairTestCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t DeclutterEngine::getChangedSortKeyCount() const {
+  return mChangedSortKeyCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t DeclutterEngine::getClusterSize(std::size_t label) const {
+  return label < mRanks.size() ? mClusterSizes[mRanks[label]] : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool DeclutterEngine::isVisible(std::size_t label) const {
+  return label < mRanks.size() && mIsVisible[mRanks[label]] != 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t DeclutterEngine::getTestedLabelCount() const {
+  return mTestedLabelCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+LabelPlacement DeclutterEngine::getPlacement(std::size_t label) const {
+  return label < mRanks.size() && mIsVisible[mRanks[label]] != 0
+             ? static_cast<LabelPlacement>(mPlacements[mRanks[label]])
+             : LabelPlacement::eDefault;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t DeclutterEngine::getPlacementTestCount() const {
+  return mPlacementTestCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t DeclutterEngine::getMemoryUsage() const {
+  return mTested.getMemoryUsage() + csp::anchorlabels::getMemoryUsage(mPriorityOrder) +
+         csp::anchorlabels::getMemoryUsage(mRanks) +
+         csp::anchorlabels::getMemoryUsage(mVisibleByDistance) +
+         csp::anchorlabels::getMemoryUsage(mSortBuffer) +
+         csp::anchorlabels::getMemoryUsage(mVisibleLabels) +
+         csp::anchorlabels::getMemoryUsage(mSortKeys) +
+         csp::anchorlabels::getMemoryUsage(mIsVisible) +
+         csp::anchorlabels::getMemoryUsage(mPlacements) +
+         csp::anchorlabels::getMemoryUsage(mClusters) +
+         csp::anchorlabels::getMemoryUsage(mClusterSizes) +
+         csp::anchorlabels::getMemoryUsage(mIsMoved);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DeclutterEngine::sortByPriority(LabelStore const& labels) {
+  mPriorityOrder.resize(labels.size());
+  std::iota(mPriorityOrder.begin(), mPriorityOrder.end(), 0);
+  std::stable_sort(mPriorityOrder.begin(), mPriorityOrder.end(),
+      [&labels](std::size_t a, std::size_t b) {
+        return labels.mPriority[a] > labels.mPriority[b];
+      });
+
+  mRanks.resize(labels.size());
+  mIsPriorityOrdered = true;
+  for (std::size_t rank = 0; rank < mPriorityOrder.size(); ++rank) {
+    mRanks[mPriorityOrder[rank]] = rank;
+    mIsPriorityOrdered = mIsPriorityOrdered && mPriorityOrder[rank] == rank;
+  }
+
+  mPrioritiesDirty = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool DeclutterEngine::isMoved(LabelStore const& labels, std::size_t rank) const {
+  std::size_t const label = mPriorityOrder[rank];
+
+  if (labels.mFlags[label] != mTested.mFlags[rank]) {
+    return true;
+  }
+
+  double const previousWidth  = mTested.mWidth[rank];
+  double const previousHeight = mTested.mHeight[rank];
+
+  double const maxBoxChange = mSettings.mEpsilon * std::min(previousWidth, previousHeight);
+  double const maxDistanceChange =
+      mSettings.mEpsilon * mSettings.mIgnoreOverlapThreshold * 0.1 * mTested.mDistance[rank];
+
+  // The comparisons are written so that NaN values are always treated as a change.
+  return !(std::abs(labels.mX[label] - mTested.mX[rank]) <= maxBoxChange &&
+           std::abs(labels.mY[label] - mTested.mY[rank]) <= maxBoxChange &&
+           std::abs(labels.mWidth[label] - previousWidth) <= maxBoxChange &&
+           std::abs(labels.mHeight[label] - previousHeight) <= maxBoxChange &&
+           std::abs(labels.mDistance[label] - mTested.mDistance[rank]) <= maxDistanceChange);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool DeclutterEngine::isAffected(BoundingBox const& bb) const {
+  std::size_t changed = 0;
+  return mChangedGrid.findOverlap(getRegion(bb), 0.0, false, 0.0, changed);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool DeclutterEngine::findOverlap(
+    BoundingBox const& bb, double distance, std::size_t& other) const {
+
+  // If none of the bits touched by the box are set, it cannot overlap any visible label.
+  if (mSettings.mCandidatePlacement && mBitmap.isFree(bb)) {
+    return false;
+  }
+
+  return mGrid.findOverlap(bb, distance, mSettings.mEnableDepthOverlap,
+      1 + mSettings.mIgnoreOverlapThreshold * 0.1, other);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+BoundingBox DeclutterEngine::getRegion(BoundingBox const& bb) const {
+  return mSettings.mCandidatePlacement ? getCandidateBounds(bb) : bb;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
@@ -0,0 +1,194 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_ENGINE_DECLUTTER_ENGINE_HPP
+#define CSP_ANCHOR_LABELS_ENGINE_DECLUTTER_ENGINE_HPP
+
+#include "BoundingBox.hpp"
+#include "LabelPlacement.hpp"
+#include "LabelStore.hpp"
+#include "OccupancyBitmap.hpp"
+#include "ScreenSpaceGrid.hpp"
+#include "SortKeyAllocator.hpp"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace csp::anchorlabels {
+
+/// The subset of the plugin settings which influences the declutter pass.
+struct DeclutterSettings {
+  /// See Plugin::Settings::mEnableDepthOverlap.
+  bool mEnableDepthOverlap = true;
+
+  /// See Plugin::Settings::mIgnoreOverlapThreshold.
+  double mIgnoreOverlapThreshold = 0.025;
+
+  /// The visible labels get sort keys in the range [mMaxSortKey - mSortKeyRange + 1, mMaxSortKey].
+  /// Labels further away get smaller keys so that they are drawn first. See SortKeyAllocator.
+  int         mMaxSortKey   = 0;
+  std::size_t mSortKeyRange = 50;
+
+  /// If not set, no sort keys are allocated and DeclutterEngine::getSortKeys() returns no keys.
+  /// The ViewDeclutter allocates the keys once for the labels merged from all views instead.
+  bool mAllocateSortKeys = true;
+
+  /// If set, labels which are hidden because they overlap a visible label are counted as members
+  /// of this label's cluster. See DeclutterEngine::getClusterSize().
+  bool mEnableClustering = true;
+
+  /// If set, the result of the previous frame is reused and only labels which moved by more than
+  /// mEpsilon or which may be affected by such a label are tested again.
+  bool mIncremental = true;
+
+  /// Changes of a label's bounding box smaller than this fraction of the label size are ignored by
+  /// the incremental mode. Changes in distance are ignored if they are smaller than this fraction
+  /// of the depth overlap threshold.
+  double mEpsilon = 0.01;
+
+  /// In incremental mode, labels which were visible in the previous frame are tested with a
+  /// bounding box which is shrunk by this fraction. This prevents labels from flickering when they
+  /// are close to touching each other.
+  double mHysteresis = 0.1;
+
+  /// If set, a label which collides at its default position is moved to one of the other
+  /// positions of LabelPlacement if one of them is free. At most mPlacementBudget alternative
+  /// positions are tested per update, the remaining labels are hidden as usual.
+  bool        mCandidatePlacement = false;
+  std::size_t mPlacementBudget    = 1000;
+
+  bool operator==(DeclutterSettings const& other) const;
+  bool operator!=(DeclutterSettings const& other) const;
+};
+
+/// The DeclutterEngine decides which labels are drawn and in which order. It does not depend on
+/// any scene graph or GUI classes, so it can be used without a running CosmoScout VR instance.
+///
+/// Labels are processed greedily in order of decreasing priority. A label is drawn if it does not
+/// collide with any label which has been accepted before. If depth overlap is enabled, collisions
+/// are ignored for labels whose distances to the observer differ by more than a threshold.
+///
+/// In incremental mode, the engine keeps the bounding boxes and distances it used in the previous
+/// frame. Labels which did not move significantly keep their previous result, unless a label with
+/// a changed box or a changed visibility overlaps them.
+///
+/// With candidate placement, a label which collides is tried at several positions around its
+/// anchor. An occupancy bitmap of the accepted labels answers most of these tests without looking
+/// at any other box. Only if the bitmap reports a possible collision, the exact test of the grid is
+/// used, so the result is the same as without the bitmap.
+class DeclutterEngine {
+ public:
+  /// Must be called whenever labels are added or removed or their priority changes. The priority
+  /// order is then recomputed during the next call to update().
+  void invalidatePriorities();
+
+  /// Like invalidatePriorities(), but the labels which still exist keep their sort keys.
+  /// previousLabels contains the previous index of each label, or an index out of range for new
+  /// labels.
+  void remapLabels(std::vector<std::size_t> const& previousLabels);
+
+  /// Computes the visible labels and their sort keys. The store has to contain the same labels in
+  /// the same order as in the previous call, unless invalidatePriorities() was called. Only the
+  /// bounding boxes, distances, priorities and flags are used. If the labels are sorted by
+  /// decreasing priority, their data does not have to be reordered internally, which is faster.
+  /// Returns false if no label changed significantly since the previous call. The previous result
+  /// is still valid in this case.
+  bool update(LabelStore const& labels, DeclutterSettings const& settings);
+
+  /// The indices of all labels which should be drawn, sorted by increasing distance to the
+  /// observer.
+  std::vector<std::size_t> const& getVisibleLabels() const;
+
+  /// The sort keys for all labels returned by getVisibleLabels(), in the same order. The keys are
+  /// non-increasing, and strictly decreasing if there are no more labels than keys in the range.
+  /// This is empty if DeclutterSettings::mAllocateSortKeys is not set.
+  std::vector<int> const& getSortKeys() const;
+
+  /// The number of box pairs which were tested for overlap in the last call to update().
+  std::size_t getPairTestCount() const;
+
+  /// The number of sort keys which changed in the last call to update().
+  std::size_t getChangedSortKeyCount() const;
+
+  /// The number of labels which are hidden because they overlap the given visible label. If
+  /// clustering is disabled, this is always zero. The clusters are formed in screen space, a label
+  /// is always assigned to the first visible label it collides with.
+  std::size_t getClusterSize(std::size_t label) const;
+
+  /// Returns true if the label with the given index should be drawn.
+  bool isVisible(std::size_t label) const;
+
+  /// The number of labels which were tested for collisions in the last call to update(). In
+  /// incremental mode, this is usually much smaller than the total number of labels.
+  std::size_t getTestedLabelCount() const;
+
+  /// The position at which the given label should be drawn. This is always
+  /// LabelPlacement::eDefault if candidate placement is disabled or the label is not visible.
+  LabelPlacement getPlacement(std::size_t label) const;
+
+  /// The number of alternative positions which were tested in the last call to update(). This is
+  /// limited by DeclutterSettings::mPlacementBudget.
+  std::size_t getPlacementTestCount() const;
+
+  /// The number of bytes reserved for the per-label buffers. The grids are bounded by the size of
+  /// the screen and are not counted.
+  std::size_t getMemoryUsage() const;
+
+ private:
+  static std::size_t const NO_CLUSTER;
+
+  void sortByPriority(LabelStore const& labels);
+  bool isMoved(LabelStore const& labels, std::size_t rank) const;
+  bool isAffected(BoundingBox const& bb) const;
+  bool findOverlap(BoundingBox const& bb, double distance, std::size_t& other) const;
+
+  /// The region of the screen which a label with the given box may cover. With candidate
+  /// placement, this includes all of its alternative positions.
+  BoundingBox getRegion(BoundingBox const& bb) const;
+
+  /// The label indices in order of decreasing priority and the position of each label in this
+  /// order. All other per-label members are stored in this order. Updates are faster if the
+  /// labels are passed in this order already.
+  std::vector<std::size_t> mPriorityOrder;
+  std::vector<std::size_t> mRanks;
+  bool                     mIsPriorityOrdered = false;
+  bool                     mPrioritiesDirty   = true;
+  bool                     mKeepSortKeys      = false;
+
+  DeclutterSettings mSettings;
+
+  /// The label data which was used for the last test of each label.
+  LabelStore mTested;
+
+  ScreenSpaceGrid                             mGrid;
+  std::vector<std::pair<double, std::size_t>> mVisibleByDistance;
+  std::vector<std::pair<double, std::size_t>> mSortBuffer; ///< Scratch space for the sorting.
+  std::vector<std::size_t>                    mVisibleLabels;
+  std::vector<int>                            mSortKeys;
+  SortKeyAllocator                            mSortKeyAllocator;
+  std::vector<uint8_t>                        mIsVisible;
+  std::vector<uint8_t>                        mPlacements;
+  std::vector<std::size_t>                    mClusters; ///< The rank of the cluster's label.
+  std::vector<std::size_t>                    mClusterSizes;
+  std::size_t                                 mTestedLabelCount    = 0;
+  std::size_t                                 mChangedSortKeyCount = 0;
+  std::size_t                                 mPairTestCount       = 0;
+  std::size_t                                 mPlacementTestCount  = 0;
+
+  /// Contains the boxes of all visible labels if candidate placement is enabled.
+  OccupancyBitmap mBitmap;
+
+  /// Regions of the screen which changed since the last frame. Labels overlapping these regions
+  /// need to be tested again.
+  ScreenSpaceGrid          mChangedGrid;
+  std::vector<BoundingBox> mChangedBoxes;
+  std::vector<uint8_t>     mIsMoved;
+};
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_ENGINE_DECLUTTER_ENGINE_HPP
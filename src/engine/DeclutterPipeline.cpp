@@ -0,0 +1,189 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "DeclutterPipeline.hpp"
+
+#include "MemoryUsage.hpp"
+#include "TraceWriter.hpp"
+
+#include <limits>
+#include <unordered_map>
+
+namespace csp::anchorlabels {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DeclutterPipeline::~DeclutterPipeline() {
+  stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DeclutterPipeline::start(std::size_t threadCount) {
+  stop();
+
+  mPool       = std::make_unique<WorkerPool>(threadCount);
+  mDeclutter  = ViewDeclutter();
+  mGeneration = std::numeric_limits<uint64_t>::max();
+  mIds.clear();
+
+  // Results which have been finished before the pipeline was stopped are ignored.
+  mFetchedSequence = mPublishedSequence;
+  mHasSnapshot     = false;
+  mStop            = false;
+
+  mThread = std::thread([this]() { workerLoop(); });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DeclutterPipeline::stop() {
+  if (!mThread.joinable()) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStop = true;
+  }
+
+  mWakeUp.notify_one();
+  mThread.join();
+  mPool.reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool DeclutterPipeline::isRunning() const {
+  return mThread.joinable();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DeclutterSnapshot& DeclutterPipeline::getSnapshot() {
+  return mSnapshots.getWriteBuffer();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DeclutterPipeline::publish() {
+  mSnapshots.getWriteBuffer().mSequence = ++mPublishedSequence;
+  mSnapshots.publish();
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mHasSnapshot = true;
+  }
+
+  mWakeUp.notify_one();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool DeclutterPipeline::fetch() {
+  if (!mResults.fetch() || mResults.getReadBuffer().mSequence <= mFetchedSequence) {
+    return false;
+  }
+
+  mFetchedSequence = mResults.getReadBuffer().mSequence;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DeclutterPipelineResult const& DeclutterPipeline::getResult() const {
+  return mResults.getReadBuffer();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool DeclutterPipeline::isPending() const {
+  return isRunning() && mFetchedSequence < mPublishedSequence;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DeclutterPipeline::workerLoop() {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mWakeUp.wait(lock, [this]() { return mStop || mHasSnapshot; });
+
+      if (mStop) {
+        return;
+      }
+
+      mHasSnapshot = false;
+    }
+
+    if (mSnapshots.fetch()) {
+      process(mSnapshots.getReadBuffer(), mResults.getWriteBuffer());
+      mResults.publish();
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DeclutterPipeline::process(
+    DeclutterSnapshot const& snapshot, DeclutterPipelineResult& result) {
+
+  // The labels changed since the last snapshot. The incremental state is kept for the labels
+  // which still exist, which are found by their ids.
+  if (snapshot.mGeneration != mGeneration) {
+    std::unordered_map<uint32_t, std::size_t> previousIndices;
+    for (std::size_t i = 0; i < mIds.size(); ++i) {
+      previousIndices.emplace(mIds[i], i);
+    }
+
+    std::vector<std::size_t> previousLabels(
+        snapshot.mIds.size(), std::numeric_limits<std::size_t>::max());
+    for (std::size_t i = 0; i < snapshot.mIds.size(); ++i) {
+      auto previous = previousIndices.find(snapshot.mIds[i]);
+      if (previous != previousIndices.end()) {
+        previousLabels[i] = previous->second;
+      }
+    }
+
+    mDeclutter.remapLabels(previousLabels);
+    mIds        = snapshot.mIds;
+    mGeneration = snapshot.mGeneration;
+  }
+
+  result.mSequence      = snapshot.mSequence;
+  result.mCullingTime   = 0.0;
+  result.mDeclutterTime = 0.0;
+
+  {
+    ScopedDuration duration(result.mCullingTime);
+    mDeclutter.setViews(snapshot.mViews);
+    mDeclutter.cull(
+        snapshot.mLabels, snapshot.mRadiusScale, snapshot.mCullingSettings, *mPool);
+  }
+
+  {
+    ScopedDuration duration(result.mDeclutterTime);
+    mDeclutter.update(snapshot.mLabelScale, snapshot.mWidth, snapshot.mHeight,
+        snapshot.mDeclutterSettings, *mPool);
+    result.mResult.assign(mDeclutter);
+  }
+
+  if (result.mGeneration != mGeneration) {
+    result.mIds        = mIds;
+    result.mGeneration = mGeneration;
+  }
+
+  result.mCulledCount   = mDeclutter.getCulledCount();
+  result.mPairTestCount = mDeclutter.getPairTestCount();
+
+  // The other snapshots are used by the main thread, but they are about as large as this one.
+  result.mMemoryUsage = mDeclutter.getMemoryUsage() + 3 * snapshot.mLabels.getMemoryUsage() +
+                        csp::anchorlabels::getMemoryUsage(mIds);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
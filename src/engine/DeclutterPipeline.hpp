@@ -0,0 +1,136 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_ENGINE_DECLUTTER_PIPELINE_HPP
+#define CSP_ANCHOR_LABELS_ENGINE_DECLUTTER_PIPELINE_HPP
+
+#include "TripleBuffer.hpp"
+#include "ViewDeclutter.hpp"
+#include "WorkerPool.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace csp::anchorlabels {
+
+/// Everything the background thread needs to cull and declutter the labels of one frame. The
+/// labels are identified by ids which are not reused, so that results can be matched to the
+/// labels after labels were added or removed.
+struct DeclutterSnapshot {
+  uint64_t mSequence = 0;
+
+  /// Only the positions, priorities, radii and the eHidden flags are used, see
+  /// ViewDeclutter::cull().
+  LabelStore mLabels;
+
+  /// The id of each label. These only have to be copied if mGeneration changed, which is the case
+  /// whenever labels were added, removed or reordered.
+  uint64_t              mGeneration = 0;
+  std::vector<uint32_t> mIds;
+
+  std::vector<View> mViews;
+  double            mRadiusScale = 1.0;
+  CullingSettings   mCullingSettings;
+
+  double            mLabelScale = 1.0;
+  double            mWidth      = 0.0;
+  double            mHeight     = 0.0;
+  DeclutterSettings mDeclutterSettings;
+};
+
+/// The result for one DeclutterSnapshot. The label indices refer to the order of the labels in
+/// that snapshot. Durations are in milliseconds.
+struct DeclutterPipelineResult {
+  uint64_t              mSequence   = 0;
+  uint64_t              mGeneration = 0;
+  std::vector<uint32_t> mIds;
+  DeclutterResult       mResult;
+
+  double      mCullingTime   = 0.0;
+  double      mDeclutterTime = 0.0;
+  std::size_t mCulledCount   = 0;
+  std::size_t mPairTestCount = 0;
+
+  /// The bytes reserved by the background thread for its snapshots and the declutter pass.
+  std::size_t mMemoryUsage = 0;
+};
+
+/// The DeclutterPipeline runs the ViewDeclutter on a background thread, so that the main thread
+/// does not have to wait for it. Each frame, the main thread fills a snapshot and publishes it.
+/// The background thread always processes the most recent snapshot, snapshots which are replaced
+/// before it gets to them are skipped. The main thread then applies the most recent finished
+/// result, which is usually the one of the previous frame.
+///
+/// Snapshots and results are exchanged with TripleBuffers, so neither thread ever waits for the
+/// other. The mutex is only used to wake up the background thread when a snapshot is published.
+class DeclutterPipeline {
+ public:
+  DeclutterPipeline() = default;
+
+  DeclutterPipeline(DeclutterPipeline const& other) = delete;
+  DeclutterPipeline(DeclutterPipeline&& other)      = delete;
+
+  DeclutterPipeline& operator=(DeclutterPipeline const& other) = delete;
+  DeclutterPipeline& operator=(DeclutterPipeline&& other) = delete;
+
+  ~DeclutterPipeline();
+
+  /// Starts the background thread. The views of each snapshot are distributed to a pool with the
+  /// given number of threads, including the background thread itself. If the pipeline is already
+  /// running, it is restarted. The incremental state of the ViewDeclutter is reset.
+  void start(std::size_t threadCount);
+
+  /// Waits until the background thread has finished its current snapshot and stops it.
+  void stop();
+
+  bool isRunning() const;
+
+  /// The snapshot which is handed to the background thread by the next call to publish(). It still
+  /// contains what has been written to it three snapshots ago.
+  DeclutterSnapshot& getSnapshot();
+
+  /// Hands the snapshot to the background thread. This assigns the sequence number of the snapshot.
+  void publish();
+
+  /// Makes the most recent finished result available via getResult(). Returns false if no result
+  /// has been finished since the last call.
+  bool fetch();
+
+  DeclutterPipelineResult const& getResult() const;
+
+  /// Returns true if the result of the last published snapshot has not been fetched yet.
+  bool isPending() const;
+
+ private:
+  void workerLoop();
+  void process(DeclutterSnapshot const& snapshot, DeclutterPipelineResult& result);
+
+  TripleBuffer<DeclutterSnapshot>       mSnapshots;
+  TripleBuffer<DeclutterPipelineResult> mResults;
+
+  uint64_t mPublishedSequence = 0;
+  uint64_t mFetchedSequence   = 0;
+
+  std::thread             mThread;
+  std::mutex              mMutex;
+  std::condition_variable mWakeUp;
+  bool                    mHasSnapshot = false;
+  bool                    mStop        = false;
+
+  // These are only used by the background thread.
+  std::unique_ptr<WorkerPool> mPool;
+  ViewDeclutter               mDeclutter;
+  uint64_t                    mGeneration = 0;
+  std::vector<uint32_t>       mIds;
+};
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_ENGINE_DECLUTTER_PIPELINE_HPP
@@ -0,0 +1,354 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "EphemerisPrefetcher.hpp"
+
+#include "MemoryUsage.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <utility>
+
+namespace csp::anchorlabels {
+
+namespace {
+
+struct Quaternion {
+  double mW;
+  double mX;
+  double mY;
+  double mZ;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The rotation of a column-major matrix without scale.
+Quaternion toQuaternion(Transform const& m, double scale) {
+  double const r00 = m[0] / scale;
+  double const r10 = m[1] / scale;
+  double const r20 = m[2] / scale;
+  double const r01 = m[4] / scale;
+  double const r11 = m[5] / scale;
+  double const r21 = m[6] / scale;
+  double const r02 = m[8] / scale;
+  double const r12 = m[9] / scale;
+  double const r22 = m[10] / scale;
+
+  double const trace = r00 + r11 + r22;
+
+  if (trace > 0.0) {
+    double const s = std::sqrt(trace + 1.0) * 2.0;
+    return {0.25 * s, (r21 - r12) / s, (r02 - r20) / s, (r10 - r01) / s};
+  }
+
+  if (r00 > r11 && r00 > r22) {
+    double const s = std::sqrt(1.0 + r00 - r11 - r22) * 2.0;
+    return {(r21 - r12) / s, 0.25 * s, (r01 + r10) / s, (r02 + r20) / s};
+  }
+
+  if (r11 > r22) {
+    double const s = std::sqrt(1.0 + r11 - r00 - r22) * 2.0;
+    return {(r02 - r20) / s, (r01 + r10) / s, 0.25 * s, (r12 + r21) / s};
+  }
+
+  double const s = std::sqrt(1.0 + r22 - r00 - r11) * 2.0;
+  return {(r10 - r01) / s, (r02 + r20) / s, (r12 + r21) / s, 0.25 * s};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Spherical linear interpolation along the shorter arc.
+Quaternion slerp(Quaternion const& a, Quaternion b, double t) {
+  double cosAngle = a.mW * b.mW + a.mX * b.mX + a.mY * b.mY + a.mZ * b.mZ;
+  if (cosAngle < 0.0) {
+    b        = {-b.mW, -b.mX, -b.mY, -b.mZ};
+    cosAngle = -cosAngle;
+  }
+
+  double wa = 1.0 - t;
+  double wb = t;
+
+  // For small angles, the linear interpolation is normalized below.
+  if (cosAngle < 0.9995) {
+    double const angle = std::acos(cosAngle);
+    double const sine  = std::sin(angle);
+    wa                 = std::sin((1.0 - t) * angle) / sine;
+    wb                 = std::sin(t * angle) / sine;
+  }
+
+  Quaternion q{wa * a.mW + wb * b.mW, wa * a.mX + wb * b.mX, wa * a.mY + wb * b.mY,
+      wa * a.mZ + wb * b.mZ};
+
+  double const length = std::sqrt(q.mW * q.mW + q.mX * q.mX + q.mY * q.mY + q.mZ * q.mZ);
+  return {q.mW / length, q.mX / length, q.mY / length, q.mZ / length};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Interpolates the translation and the uniform scale linearly and the rotation spherically.
+Transform interpolate(Transform const& a, Transform const& b, double t) {
+  double const scaleA = std::sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+  double const scaleB = std::sqrt(b[0] * b[0] + b[1] * b[1] + b[2] * b[2]);
+  double const scale  = scaleA + t * (scaleB - scaleA);
+
+  Quaternion const q = slerp(toQuaternion(a, scaleA), toQuaternion(b, scaleB), t);
+
+  double const xx = q.mX * q.mX;
+  double const yy = q.mY * q.mY;
+  double const zz = q.mZ * q.mZ;
+  double const xy = q.mX * q.mY;
+  double const xz = q.mX * q.mZ;
+  double const yz = q.mY * q.mZ;
+  double const wx = q.mW * q.mX;
+  double const wy = q.mW * q.mY;
+  double const wz = q.mW * q.mZ;
+
+  Transform result{};
+  result[0]  = scale * (1.0 - 2.0 * (yy + zz));
+  result[1]  = scale * 2.0 * (xy + wz);
+  result[2]  = scale * 2.0 * (xz - wy);
+  result[4]  = scale * 2.0 * (xy - wz);
+  result[5]  = scale * (1.0 - 2.0 * (xx + zz));
+  result[6]  = scale * 2.0 * (yz + wx);
+  result[8]  = scale * 2.0 * (xz + wy);
+  result[9]  = scale * 2.0 * (yz - wx);
+  result[10] = scale * (1.0 - 2.0 * (xx + yy));
+  result[12] = a[12] + t * (b[12] - a[12]);
+  result[13] = a[13] + t * (b[13] - a[13]);
+  result[14] = a[14] + t * (b[14] - a[14]);
+  result[15] = 1.0;
+
+  return result;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool EphemerisFrame::operator==(EphemerisFrame const& other) const {
+  return mCenter == other.mCenter && mFrame == other.mFrame;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool EphemerisFrame::operator!=(EphemerisFrame const& other) const {
+  return !(*this == other);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void EphemerisPrefetcher::setEphemeris(EphemerisFunction compute) {
+  mCompute = std::move(compute);
+  mActive  = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void EphemerisPrefetcher::setFrames(std::vector<EphemerisFrame> const& frames) {
+  std::unordered_map<EphemerisFrame, std::size_t, FrameHash> indices;
+  std::vector<EphemerisFrame>                                unique;
+
+  for (auto const& frame : frames) {
+    if (indices.emplace(frame, unique.size()).second) {
+      unique.push_back(frame);
+    }
+  }
+
+  // The order of the frames does not matter.
+  if (mFrames.size() == unique.size() &&
+      std::all_of(unique.begin(), unique.end(),
+          [this](EphemerisFrame const& frame) { return mFrameIndices.count(frame) > 0; })) {
+    return;
+  }
+
+  mFrames       = std::move(unique);
+  mFrameIndices = std::move(indices);
+  mActive       = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void EphemerisPrefetcher::update(EphemerisFrame const& reference, double time, double timeSpeed,
+    PrefetchSettings const& settings) {
+
+  mHits   = 0;
+  mMisses = 0;
+
+  double const spacing = timeSpeed * settings.mSampleInterval;
+  bool const   useSamples =
+      mCompute && settings.mEnabled && std::abs(timeSpeed) >= settings.mMinTimeSpeed &&
+      std::abs(spacing) <= settings.mMaxSampleSpacing && settings.mSampleCount >= 2;
+
+  if (!useSamples || mFrames.empty()) {
+    mActive = false;
+
+    // At low time speeds, the memory is kept for when the time speed is increased again.
+    if (!settings.mEnabled) {
+      std::vector<Transform>().swap(mSamples);
+    }
+
+    return;
+  }
+
+  double const currentSample = mActive ? (time - mStartTime) / mSpacing : 0.0;
+
+  // Before the first sample, there has been a jump back in time. If there are no samples after
+  // the current time, there has been a jump forward in time or the budget was too small to keep
+  // up. In both cases, sampling starts again at the current time. The first two samples are
+  // awaited before that.
+  bool const isCovered = currentSample >= static_cast<double>(mFirstSample) &&
+                         currentSample < static_cast<double>(
+                                             mFirstSample + std::max<int64_t>(mStoredSamples, 2));
+
+  if (!mActive || !isCovered || spacing != mSpacing || reference != mReference ||
+      settings.mSampleCount != mSampleCount) {
+    mReference   = reference;
+    mSampleCount = settings.mSampleCount;
+    reset(time, spacing);
+  } else {
+    mCurrentSample = currentSample;
+  }
+
+  computeSamples(settings.mBudget);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool EphemerisPrefetcher::get(EphemerisFrame const& frame, double time, Transform& result) const {
+  if (!mActive) {
+    ++mMisses;
+    return false;
+  }
+
+  auto index = mFrameIndices.find(frame);
+  if (index == mFrameIndices.end()) {
+    ++mMisses;
+    return false;
+  }
+
+  double const  sample = (time - mStartTime) / mSpacing;
+  int64_t const first  = static_cast<int64_t>(std::floor(sample));
+
+  if (first < mFirstSample || first + 1 >= mFirstSample + mStoredSamples) {
+    ++mMisses;
+    return false;
+  }
+
+  std::size_t const frameCount = mFrames.size();
+  std::size_t const slotA      = static_cast<std::size_t>(first) % mSampleCount;
+  std::size_t const slotB      = static_cast<std::size_t>(first + 1) % mSampleCount;
+
+  result = interpolate(mSamples[slotA * frameCount + index->second],
+      mSamples[slotB * frameCount + index->second], sample - static_cast<double>(first));
+
+  ++mHits;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool EphemerisPrefetcher::isActive() const {
+  return mActive;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t EphemerisPrefetcher::getHits() const {
+  return mHits;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t EphemerisPrefetcher::getMisses() const {
+  return mMisses;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t EphemerisPrefetcher::getMemoryUsage() const {
+  return csp::anchorlabels::getMemoryUsage(mSamples);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void EphemerisPrefetcher::computeSamples(double budget) {
+  auto const deadline = std::chrono::steady_clock::now() +
+                        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                            std::chrono::duration<double, std::milli>(budget));
+
+  std::size_t const frameCount = mFrames.size();
+
+  while (needsSample()) {
+    int64_t const sample = mFirstSample + mStoredSamples;
+
+    // The oldest sample has been passed by the simulation time already, see needsSample(). Its
+    // slot is overwritten by the new sample.
+    if (mNextFrame == 0 && mStoredSamples == static_cast<int64_t>(mSampleCount)) {
+      ++mFirstSample;
+      --mStoredSamples;
+    }
+
+    double const      time = mStartTime + static_cast<double>(sample) * mSpacing;
+    std::size_t const slot = static_cast<std::size_t>(sample) % mSampleCount;
+
+    // The label updates query the ephemeris themselves, which reports the error as usual.
+    try {
+      mSamples[slot * frameCount + mNextFrame] = mCompute(mReference, mFrames[mNextFrame], time);
+    } catch (...) {
+      mFailed = true;
+      return;
+    }
+
+    if (++mNextFrame == frameCount) {
+      mNextFrame = 0;
+      ++mStoredSamples;
+    }
+
+    if (std::chrono::steady_clock::now() >= deadline) {
+      return;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool EphemerisPrefetcher::needsSample() const {
+  if (!mActive || mFailed) {
+    return false;
+  }
+
+  // The sample before the current time is kept, all others may be replaced.
+  int64_t const current = static_cast<int64_t>(std::floor(mCurrentSample));
+  return mFirstSample + mStoredSamples < current + static_cast<int64_t>(mSampleCount);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void EphemerisPrefetcher::reset(double time, double spacing) {
+  mStartTime     = time;
+  mSpacing       = spacing;
+  mCurrentSample = 0.0;
+  mFirstSample   = 0;
+  mStoredSamples = 0;
+  mNextFrame     = 0;
+  mActive        = true;
+  mFailed        = false;
+
+  mSamples.resize(mSampleCount * mFrames.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t EphemerisPrefetcher::FrameHash::operator()(EphemerisFrame const& frame) const {
+  std::size_t hash = std::hash<std::string>()(frame.mCenter);
+  hash ^= std::hash<std::string>()(frame.mFrame) + 0x9e3779b9 + (hash << 6U) + (hash >> 2U);
+  return hash;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
@@ -0,0 +1,142 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_ENGINE_EPHEMERIS_PREFETCHER_HPP
+#define CSP_ANCHOR_LABELS_ENGINE_EPHEMERIS_PREFETCHER_HPP
+
+#include "Transform.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace csp::anchorlabels {
+
+/// The subset of the plugin settings which influences the ephemeris prefetching.
+struct PrefetchSettings {
+  /// See Plugin::Settings::mEphemerisPrefetch.
+  bool mEnabled = false;
+
+  /// At lower time speeds, the ephemeris is queried each frame as usual.
+  double mMinTimeSpeed = 10.0;
+
+  /// The real time in seconds between two samples. The simulation time between them is this
+  /// multiplied with the time speed.
+  double mSampleInterval = 0.1;
+
+  /// Samples are at most this many seconds of simulation time apart. Bodies rotate too far in
+  /// between otherwise. At higher time speeds, the ephemeris is queried each frame as usual.
+  double mMaxSampleSpacing = 3600.0;
+
+  /// The number of samples of each frame which are kept. The samples reach this many sample
+  /// intervals into the future.
+  std::size_t mSampleCount = 16;
+
+  /// The time in milliseconds which update() may spend on computing samples per frame. A sample
+  /// is computed frame by frame, so it may take several calls to finish it.
+  double mBudget = 1.0;
+};
+
+/// A SPICE center and frame.
+struct EphemerisFrame {
+  std::string mCenter;
+  std::string mFrame;
+
+  bool operator==(EphemerisFrame const& other) const;
+  bool operator!=(EphemerisFrame const& other) const;
+};
+
+/// Computes the transformation of the given frame relative to the reference frame at the given
+/// simulation time.
+using EphemerisFunction = std::function<Transform(
+    EphemerisFrame const& reference, EphemerisFrame const& frame, double time)>;
+
+/// While the simulation time runs faster than real time, the EphemerisPrefetcher samples the
+/// transformations of a set of frames ahead of the simulation time. Label updates then interpolate
+/// between these samples instead of querying SPICE. The samples are evenly spaced in simulation
+/// time and stored in a ring buffer, whose oldest samples are replaced once the simulation time has
+/// passed them. As a sample covers several frames, this needs far fewer queries than the labels.
+///
+/// SPICE is not thread-safe and it is used by other parts of CosmoScout VR on the main thread, so
+/// the samples are computed by update() on the calling thread, within a time budget per frame.
+///
+/// The transformations are relative to a reference frame, usually the center and frame of the
+/// observer, so that they do not change when the observer moves within this frame. All samples
+/// are discarded when the reference frame, the set of frames or the time speed changes, or when
+/// the simulation time jumps to a time which is not covered by the samples.
+class EphemerisPrefetcher {
+ public:
+  /// Sets the function which computes the samples. If it throws, no more samples are computed
+  /// until they are discarded for one of the reasons above. Without a function, no samples are
+  /// computed at all.
+  void setEphemeris(EphemerisFunction compute);
+
+  /// Sets the frames which are sampled. Duplicates are ignored. If the set of frames changed, all
+  /// samples are discarded.
+  void setFrames(std::vector<EphemerisFrame> const& frames);
+
+  /// Must be called once per frame before the labels are updated. This moves the sampled range
+  /// along with the simulation time, discards the samples if required and computes new samples
+  /// until the budget is used up.
+  void update(EphemerisFrame const& reference, double time, double timeSpeed,
+      PrefetchSettings const& settings);
+
+  /// Interpolates the transformation of the given frame relative to the reference frame at the
+  /// given time. Returns false if the prefetcher is inactive or if there are no samples around this
+  /// time yet. This may be called from several threads at the same time, but not during update().
+  bool get(EphemerisFrame const& frame, double time, Transform& result) const;
+
+  /// Returns true if the samples are used at the current time speed.
+  bool isActive() const;
+
+  /// The number of calls to get() which were answered from the samples and which were not, since
+  /// the last call to update().
+  uint64_t getHits() const;
+  uint64_t getMisses() const;
+
+  /// The bytes reserved for the samples.
+  std::size_t getMemoryUsage() const;
+
+ private:
+  struct FrameHash {
+    std::size_t operator()(EphemerisFrame const& frame) const;
+  };
+
+  void computeSamples(double budget);
+  bool needsSample() const;
+  void reset(double time, double spacing);
+
+  EphemerisFunction mCompute;
+  bool              mActive = false;
+  bool              mFailed = false;
+
+  EphemerisFrame                                             mReference;
+  std::vector<EphemerisFrame>                                mFrames;
+  std::unordered_map<EphemerisFrame, std::size_t, FrameHash> mFrameIndices;
+  std::size_t                                                mSampleCount = 0;
+
+  // Sample i is taken at mStartTime + i * mSpacing. The samples mFirstSample to mFirstSample +
+  // mStoredSamples - 1 are stored in the ring buffer. Sample i of frame j is stored at index
+  // (i % mSampleCount) * frames + j. The first mNextFrame frames of the next sample have been
+  // computed already.
+  double                 mStartTime     = 0.0;
+  double                 mSpacing       = 0.0;
+  double                 mCurrentSample = 0.0;
+  int64_t                mFirstSample   = 0;
+  int64_t                mStoredSamples = 0;
+  std::size_t            mNextFrame     = 0;
+  std::vector<Transform> mSamples;
+
+  mutable std::atomic<uint64_t> mHits{0};
+  mutable std::atomic<uint64_t> mMisses{0};
+};
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_ENGINE_EPHEMERIS_PREFETCHER_HPP
@@ -0,0 +1,198 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Kernels.hpp"
+
+#include <cmath>
+
+#if defined(__AVX__)
+#define CSP_ANCHOR_LABELS_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CSP_ANCHOR_LABELS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace csp::anchorlabels::kernels {
+
+namespace {
+
+// The scalar versions are used for the remainder of the vectorized loops and on platforms without
+// SSE2. The order of operations has to match the vectorized versions exactly.
+
+void projectScalar(double px, double py, double pz, double halfWidth, double halfHeight, double& x,
+    double& y, double& distance) {
+  x        = px / pz - halfWidth;
+  y        = py / pz - halfHeight;
+  distance = std::sqrt(px * px + py * py + pz * pz);
+}
+
+bool overlapsScalar(double minX, double minY, double maxX, double maxY, double distance,
+    BoxArrays const& boxes, std::size_t i, bool depthOverlap, double threshold) {
+  if (depthOverlap) {
+    double other = boxes.mDistance[i];
+
+    // Check the distance relative to each other. If they are far apart we can display both.
+    double relativeDistance = distance < other ? other / distance : distance / other;
+    if (relativeDistance > threshold) {
+      return false;
+    }
+  }
+
+  return boxes.mMaxX[i] > minX && boxes.mMaxY[i] > minY && maxX > boxes.mMinX[i] &&
+         maxY > boxes.mMinY[i];
+}
+
+[[maybe_unused]] int firstSetBit(int mask) {
+  int bit = 0;
+  while ((mask & (1 << bit)) == 0) {
+    ++bit;
+  }
+  return bit;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+char const* getInstructionSet() {
+#if defined(CSP_ANCHOR_LABELS_AVX)
+  return "AVX";
+#elif defined(CSP_ANCHOR_LABELS_SSE2)
+  return "SSE2";
+#else
+  return "scalar";
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void project(double const* positionX, double const* positionY, double const* positionZ,
+    std::size_t count, double width, double height, double* x, double* y, double* distance) {
+  double const halfWidth  = width / 2.0;
+  double const halfHeight = height / 2.0;
+
+  std::size_t i = 0;
+
+#if defined(CSP_ANCHOR_LABELS_AVX)
+  __m256d const hw = _mm256_set1_pd(halfWidth);
+  __m256d const hh = _mm256_set1_pd(halfHeight);
+
+  for (; i + 4 <= count; i += 4) {
+    __m256d px = _mm256_loadu_pd(positionX + i);
+    __m256d py = _mm256_loadu_pd(positionY + i);
+    __m256d pz = _mm256_loadu_pd(positionZ + i);
+
+    _mm256_storeu_pd(x + i, _mm256_sub_pd(_mm256_div_pd(px, pz), hw));
+    _mm256_storeu_pd(y + i, _mm256_sub_pd(_mm256_div_pd(py, pz), hh));
+
+    __m256d sq = _mm256_add_pd(_mm256_mul_pd(px, px), _mm256_mul_pd(py, py));
+    sq         = _mm256_add_pd(sq, _mm256_mul_pd(pz, pz));
+    _mm256_storeu_pd(distance + i, _mm256_sqrt_pd(sq));
+  }
+#elif defined(CSP_ANCHOR_LABELS_SSE2)
+  __m128d const hw = _mm_set1_pd(halfWidth);
+  __m128d const hh = _mm_set1_pd(halfHeight);
+
+  for (; i + 2 <= count; i += 2) {
+    __m128d px = _mm_loadu_pd(positionX + i);
+    __m128d py = _mm_loadu_pd(positionY + i);
+    __m128d pz = _mm_loadu_pd(positionZ + i);
+
+    _mm_storeu_pd(x + i, _mm_sub_pd(_mm_div_pd(px, pz), hw));
+    _mm_storeu_pd(y + i, _mm_sub_pd(_mm_div_pd(py, pz), hh));
+
+    __m128d sq = _mm_add_pd(_mm_mul_pd(px, px), _mm_mul_pd(py, py));
+    sq         = _mm_add_pd(sq, _mm_mul_pd(pz, pz));
+    _mm_storeu_pd(distance + i, _mm_sqrt_pd(sq));
+  }
+#endif
+
+  for (; i < count; ++i) {
+    projectScalar(positionX[i], positionY[i], positionZ[i], halfWidth, halfHeight, x[i], y[i],
+        distance[i]);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t findOverlap(double minX, double minY, double maxX, double maxY, double distance,
+    BoxArrays const& boxes, std::size_t count, bool depthOverlap, double threshold) {
+  std::size_t i = 0;
+
+  // All comparisons are ordered, so that NaN values never produce an overlap, just like in the
+  // scalar version.
+#if defined(CSP_ANCHOR_LABELS_AVX)
+  __m256d const aMinX = _mm256_set1_pd(minX);
+  __m256d const aMinY = _mm256_set1_pd(minY);
+  __m256d const aMaxX = _mm256_set1_pd(maxX);
+  __m256d const aMaxY = _mm256_set1_pd(maxY);
+  __m256d const aDist = _mm256_set1_pd(distance);
+  __m256d const limit = _mm256_set1_pd(threshold);
+
+  for (; i + 4 <= count; i += 4) {
+    __m256d overlap = _mm256_and_pd(
+        _mm256_cmp_pd(_mm256_loadu_pd(boxes.mMaxX + i), aMinX, _CMP_GT_OQ),
+        _mm256_cmp_pd(_mm256_loadu_pd(boxes.mMaxY + i), aMinY, _CMP_GT_OQ));
+    overlap = _mm256_and_pd(
+        overlap, _mm256_cmp_pd(aMaxX, _mm256_loadu_pd(boxes.mMinX + i), _CMP_GT_OQ));
+    overlap = _mm256_and_pd(
+        overlap, _mm256_cmp_pd(aMaxY, _mm256_loadu_pd(boxes.mMinY + i), _CMP_GT_OQ));
+
+    if (depthOverlap) {
+      __m256d bDist    = _mm256_loadu_pd(boxes.mDistance + i);
+      __m256d closer   = _mm256_cmp_pd(aDist, bDist, _CMP_LT_OQ);
+      __m256d relative = _mm256_blendv_pd(
+          _mm256_div_pd(aDist, bDist), _mm256_div_pd(bDist, aDist), closer);
+      overlap = _mm256_andnot_pd(_mm256_cmp_pd(relative, limit, _CMP_GT_OQ), overlap);
+    }
+
+    int mask = _mm256_movemask_pd(overlap);
+    if (mask != 0) {
+      return i + static_cast<std::size_t>(firstSetBit(mask));
+    }
+  }
+#elif defined(CSP_ANCHOR_LABELS_SSE2)
+  __m128d const aMinX = _mm_set1_pd(minX);
+  __m128d const aMinY = _mm_set1_pd(minY);
+  __m128d const aMaxX = _mm_set1_pd(maxX);
+  __m128d const aMaxY = _mm_set1_pd(maxY);
+  __m128d const aDist = _mm_set1_pd(distance);
+  __m128d const limit = _mm_set1_pd(threshold);
+
+  for (; i + 2 <= count; i += 2) {
+    __m128d overlap = _mm_and_pd(_mm_cmpgt_pd(_mm_loadu_pd(boxes.mMaxX + i), aMinX),
+        _mm_cmpgt_pd(_mm_loadu_pd(boxes.mMaxY + i), aMinY));
+    overlap = _mm_and_pd(overlap, _mm_cmpgt_pd(aMaxX, _mm_loadu_pd(boxes.mMinX + i)));
+    overlap = _mm_and_pd(overlap, _mm_cmpgt_pd(aMaxY, _mm_loadu_pd(boxes.mMinY + i)));
+
+    if (depthOverlap) {
+      __m128d bDist    = _mm_loadu_pd(boxes.mDistance + i);
+      __m128d closer   = _mm_cmplt_pd(aDist, bDist);
+      __m128d relative = _mm_or_pd(_mm_and_pd(closer, _mm_div_pd(bDist, aDist)),
+          _mm_andnot_pd(closer, _mm_div_pd(aDist, bDist)));
+      overlap = _mm_andnot_pd(_mm_cmpgt_pd(relative, limit), overlap);
+    }
+
+    int mask = _mm_movemask_pd(overlap);
+    if (mask != 0) {
+      return i + static_cast<std::size_t>(firstSetBit(mask));
+    }
+  }
+#endif
+
+  for (; i < count; ++i) {
+    if (overlapsScalar(minX, minY, maxX, maxY, distance, boxes, i, depthOverlap, threshold)) {
+      return i;
+    }
+  }
+
+  return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels::kernels
@@ -0,0 +1,43 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_ENGINE_KERNELS_HPP
+#define CSP_ANCHOR_LABELS_ENGINE_KERNELS_HPP
+
+#include <cstddef>
+
+/// The inner loops of the declutter pass. They operate on plain arrays and are vectorized with AVX
+/// or SSE2, depending on the instruction sets the engine is compiled for. A scalar implementation
+/// is used on all other platforms. All implementations produce bit-identical results.
+namespace csp::anchorlabels::kernels {
+
+/// Returns the name of the instruction set the kernels have been compiled for.
+char const* getInstructionSet();
+
+/// Projects count observer-relative positions onto the screen. Each label is centered on its
+/// projected position and gets the given size. The distance to the observer is stored as well.
+void project(double const* positionX, double const* positionY, double const* positionZ,
+    std::size_t count, double width, double height, double* x, double* y, double* distance);
+
+/// A set of boxes to test against. The boxes are stored by their minimum and maximum corners, so
+/// that no additions are required during the test.
+struct BoxArrays {
+  double const* mMinX;
+  double const* mMinY;
+  double const* mMaxX;
+  double const* mMaxY;
+  double const* mDistance;
+};
+
+/// Returns the index of the first of the count boxes which overlaps the box given by its corners
+/// or count if there is none. If depthOverlap is set, boxes are ignored if the ratio of their
+/// distance and the given distance is larger than threshold.
+std::size_t findOverlap(double minX, double minY, double maxX, double maxY, double distance,
+    BoxArrays const& boxes, std::size_t count, bool depthOverlap, double threshold);
+
+} // namespace csp::anchorlabels::kernels
+
+#endif // CSP_ANCHOR_LABELS_ENGINE_KERNELS_HPP
@@ -0,0 +1,62 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_ENGINE_LABEL_PLACEMENT_HPP
+#define CSP_ANCHOR_LABELS_ENGINE_LABEL_PLACEMENT_HPP
+
+#include "BoundingBox.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace csp::anchorlabels {
+
+/// The positions at which a label can be placed. eDefault is the position above the anchor which
+/// is used if candidate placement is disabled. All other positions are shifted by one label width
+/// or height in the given direction. The candidates are tried in this order.
+enum class LabelPlacement : uint8_t {
+  eDefault,
+  eAbove,
+  eBelow,
+  eLeft,
+  eRight,
+  eAboveLeft,
+  eAboveRight,
+  eBelowLeft,
+  eBelowRight,
+  eCount
+};
+
+/// The shift of a placement in label widths and heights. The x-axis points to the right of the
+/// screen, the y-axis upwards.
+struct PlacementOffset {
+  double mX = 0.0;
+  double mY = 0.0;
+};
+
+inline PlacementOffset getPlacementOffset(LabelPlacement placement) {
+  static std::array<PlacementOffset, static_cast<std::size_t>(LabelPlacement::eCount)> const
+      offsets = {{{0.0, 0.0}, {0.0, 1.0}, {0.0, -1.0}, {-1.0, 0.0}, {1.0, 0.0}, {-1.0, 1.0},
+          {1.0, 1.0}, {-1.0, -1.0}, {1.0, -1.0}}};
+
+  return offsets[static_cast<std::size_t>(placement)];
+}
+
+/// Shifts a box of the LabelStore to the given placement. The projection divides by the negative
+/// z-coordinate, so the axes of the boxes point to the left and downwards.
+inline BoundingBox getPlacedBox(BoundingBox const& bb, LabelPlacement placement) {
+  PlacementOffset const offset = getPlacementOffset(placement);
+  return {bb.mX - offset.mX * bb.mWidth, bb.mY - offset.mY * bb.mHeight, bb.mWidth, bb.mHeight};
+}
+
+/// The smallest box containing all placements of a label.
+inline BoundingBox getCandidateBounds(BoundingBox const& bb) {
+  return {bb.mX - bb.mWidth, bb.mY - bb.mHeight, bb.mWidth * 3.0, bb.mHeight * 3.0};
+}
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_ENGINE_LABEL_PLACEMENT_HPP
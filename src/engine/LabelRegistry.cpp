@@ -0,0 +1,216 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "LabelRegistry.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace csp::anchorlabels {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t const LabelRegistry::NO_INDEX = std::numeric_limits<std::size_t>::max();
+uint32_t const    LabelRegistry::NO_SLOT  = std::numeric_limits<uint32_t>::max();
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LabelHandle::operator==(LabelHandle const& other) const {
+  return mSlot == other.mSlot && mGeneration == other.mGeneration;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LabelHandle::operator!=(LabelHandle const& other) const {
+  return !(*this == other);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LabelRegistry::OrderKey::operator<(OrderKey const& other) const {
+  if (mPriority != other.mPriority) {
+    return mPriority > other.mPriority;
+  }
+  return mSequence < other.mSequence;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+LabelHandle LabelRegistry::add(Key key, double priority) {
+  auto existing = mSlotsByKey.find(key);
+  if (existing != mSlotsByKey.end()) {
+    return {existing->second, mSlots[existing->second].mGeneration};
+  }
+
+  uint32_t slot = 0;
+  if (mFreeSlots.empty()) {
+    slot = static_cast<uint32_t>(mSlots.size());
+    mSlots.emplace_back();
+  } else {
+    slot = mFreeSlots.back();
+    mFreeSlots.pop_back();
+  }
+
+  // NaN would break the strict weak ordering of the index.
+  if (priority != priority) {
+    priority = 0.0;
+  }
+
+  Slot& entry     = mSlots[slot];
+  entry.mKey      = key;
+  entry.mPriority = priority;
+  entry.mSequence = mNextSequence++;
+  entry.mIsUsed   = true;
+
+  mSlotsByKey.emplace(key, slot);
+  mAddedKeys.push_back({priority, entry.mSequence, slot, NO_INDEX});
+  mChanged = true;
+
+  return {slot, entry.mGeneration};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelRegistry::add(
+    std::vector<std::pair<Key, double>> const& labels, std::vector<LabelHandle>& handles) {
+  mSlotsByKey.reserve(mSlotsByKey.size() + labels.size());
+  handles.reserve(handles.size() + labels.size());
+
+  for (auto const& [key, priority] : labels) {
+    handles.push_back(add(key, priority));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LabelRegistry::remove(Key key) {
+  auto existing = mSlotsByKey.find(key);
+  if (existing == mSlotsByKey.end()) {
+    return false;
+  }
+
+  uint32_t const slot  = existing->second;
+  Slot&          entry = mSlots[slot];
+
+  // The key is either part of the current order, which is sorted, or it has been added since the
+  // order was updated last.
+  OrderKey const orderKey{entry.mPriority, entry.mSequence, slot, NO_INDEX};
+  auto           ordered = std::lower_bound(mOrderKeys.begin(), mOrderKeys.end(), orderKey);
+  if (ordered != mOrderKeys.end() && ordered->mSequence == orderKey.mSequence) {
+    ordered->mSlot = NO_SLOT;
+  } else {
+    auto added = std::find_if(mAddedKeys.begin(), mAddedKeys.end(),
+        [&orderKey](OrderKey const& other) { return other.mSequence == orderKey.mSequence; });
+    added->mSlot = NO_SLOT;
+  }
+
+  mHasRemovedKeys = true;
+  mSlotsByKey.erase(existing);
+
+  // Handles to the removed label become invalid.
+  entry.mKey    = nullptr;
+  entry.mIsUsed = false;
+  ++entry.mGeneration;
+  mFreeSlots.push_back(slot);
+  mChanged = true;
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t LabelRegistry::remove(std::vector<Key> const& keys) {
+  std::size_t removed = 0;
+  for (Key key : keys) {
+    removed += remove(key) ? 1 : 0;
+  }
+  return removed;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<LabelHandle> LabelRegistry::find(Key key) const {
+  auto existing = mSlotsByKey.find(key);
+  if (existing == mSlotsByKey.end()) {
+    return std::nullopt;
+  }
+  return LabelHandle{existing->second, mSlots[existing->second].mGeneration};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LabelRegistry::isValid(LabelHandle const& handle) const {
+  return handle.mSlot < mSlots.size() && mSlots[handle.mSlot].mIsUsed &&
+         mSlots[handle.mSlot].mGeneration == handle.mGeneration;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t LabelRegistry::size() const {
+  return mSlotsByKey.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t LabelRegistry::getSlotCount() const {
+  return mSlots.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LabelRegistry::hasChanged() const {
+  return mChanged;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<uint32_t> const& LabelRegistry::getOrder() {
+  if (!mChanged) {
+    return mOrder;
+  }
+
+  auto isRemoved = [](OrderKey const& key) { return key.mSlot == NO_SLOT; };
+
+  if (mHasRemovedKeys) {
+    mOrderKeys.erase(
+        std::remove_if(mOrderKeys.begin(), mOrderKeys.end(), isRemoved), mOrderKeys.end());
+    mAddedKeys.erase(
+        std::remove_if(mAddedKeys.begin(), mAddedKeys.end(), isRemoved), mAddedKeys.end());
+    mHasRemovedKeys = false;
+  }
+
+  // The existing keys are sorted already, so only the new ones have to be sorted.
+  std::sort(mAddedKeys.begin(), mAddedKeys.end());
+
+  mMergedKeys.resize(mOrderKeys.size() + mAddedKeys.size());
+  std::merge(mOrderKeys.begin(), mOrderKeys.end(), mAddedKeys.begin(), mAddedKeys.end(),
+      mMergedKeys.begin());
+  mOrderKeys.swap(mMergedKeys);
+  mAddedKeys.clear();
+
+  mOrder.resize(mOrderKeys.size());
+  mPreviousIndices.resize(mOrderKeys.size());
+
+  for (std::size_t i = 0; i < mOrderKeys.size(); ++i) {
+    mOrder[i]            = mOrderKeys[i].mSlot;
+    mPreviousIndices[i]  = mOrderKeys[i].mIndex;
+    mOrderKeys[i].mIndex = i;
+  }
+
+  mChanged = false;
+
+  return mOrder;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<std::size_t> const& LabelRegistry::getPreviousIndices() const {
+  return mPreviousIndices;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
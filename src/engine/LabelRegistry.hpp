@@ -0,0 +1,123 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_ENGINE_LABEL_REGISTRY_HPP
+#define CSP_ANCHOR_LABELS_ENGINE_LABEL_REGISTRY_HPP
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace csp::anchorlabels {
+
+/// Refers to a label in the LabelRegistry. The slot can be used to store per-label data in a
+/// vector. Slots of removed labels are reused, the generation tells the old and the new label
+/// apart.
+struct LabelHandle {
+  uint32_t mSlot       = 0;
+  uint32_t mGeneration = 0;
+
+  bool operator==(LabelHandle const& other) const;
+  bool operator!=(LabelHandle const& other) const;
+};
+
+/// The LabelRegistry keeps track of all labels and of their order of decreasing priority, which
+/// is the order in which they are passed to the DeclutterEngine. Labels are identified by an
+/// arbitrary key, for example the pointer to their body. Finding and adding a label takes O(1),
+/// removing one O(log n). Labels with the same priority keep the order in which they were added.
+///
+/// The order is only updated when it is requested after a change. The new labels are sorted and
+/// merged into the existing order, so adding k and removing any number of labels costs
+/// O(n + k log k) once per frame. All passes over the order access the memory sequentially, which
+/// is much faster than walking a tree of n nodes.
+class LabelRegistry {
+ public:
+  using Key = void const*;
+
+  /// Used in getPreviousIndices() for labels which have been added since the last call to
+  /// getOrder().
+  static std::size_t const NO_INDEX;
+
+  /// Adds a label with the given priority. If there already is a label with this key, its handle
+  /// is returned and nothing is changed.
+  LabelHandle add(Key key, double priority);
+
+  /// Adds several labels at once. The handles are appended to the given vector in the same order.
+  void add(std::vector<std::pair<Key, double>> const& labels, std::vector<LabelHandle>& handles);
+
+  /// Removes the label with the given key. Returns false if there is none.
+  bool remove(Key key);
+
+  /// Removes several labels at once. Returns the number of labels which have actually been
+  /// removed.
+  std::size_t remove(std::vector<Key> const& keys);
+
+  /// Returns the handle of the label with the given key, if there is one.
+  std::optional<LabelHandle> find(Key key) const;
+
+  /// Returns true if the handle refers to a label which has not been removed.
+  bool isValid(LabelHandle const& handle) const;
+
+  /// The number of labels.
+  std::size_t size() const;
+
+  /// The highest slot number plus one. Vectors indexed by slot need this size.
+  std::size_t getSlotCount() const;
+
+  /// Returns true if labels have been added or removed since the last call to getOrder().
+  bool hasChanged() const;
+
+  /// The slots of all labels in order of decreasing priority.
+  std::vector<uint32_t> const& getOrder();
+
+  /// For each entry of getOrder(), the index of the same label in the order before the last
+  /// change, or NO_INDEX if the label is new. This can be used to keep data which is stored in
+  /// label order. It is updated by getOrder().
+  std::vector<std::size_t> const& getPreviousIndices() const;
+
+ private:
+  /// An entry of the order. The sequence number identifies a label uniquely, even if its slot is
+  /// reused later.
+  struct OrderKey {
+    double      mPriority;
+    uint64_t    mSequence;
+    uint32_t    mSlot;
+    std::size_t mIndex; ///< The position in the last order or NO_INDEX.
+
+    bool operator<(OrderKey const& other) const;
+  };
+
+  struct Slot {
+    Key      mKey        = nullptr;
+    double   mPriority   = 0.0;
+    uint64_t mSequence   = 0;
+    uint32_t mGeneration = 0;
+    bool     mIsUsed     = false;
+  };
+
+  std::vector<Slot>                 mSlots;
+  std::vector<uint32_t>             mFreeSlots;
+  std::unordered_map<Key, uint32_t> mSlotsByKey;
+  uint64_t                          mNextSequence = 0;
+
+  /// The current order and the labels which have not been merged into it yet. The keys of
+  /// removed labels are marked with NO_SLOT and dropped in the next call to getOrder().
+  static uint32_t const NO_SLOT;
+  std::vector<OrderKey> mOrderKeys;
+  std::vector<OrderKey> mAddedKeys;
+  std::vector<OrderKey> mMergedKeys;
+  bool                  mHasRemovedKeys = false;
+
+  std::vector<uint32_t>    mOrder;
+  std::vector<std::size_t> mPreviousIndices;
+  bool                     mChanged = false;
+};
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_ENGINE_LABEL_REGISTRY_HPP
@@ -0,0 +1,190 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "LabelRuleSet.hpp"
+
+#include <algorithm>
+
+namespace csp::anchorlabels {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LabelRule::operator==(LabelRule const& other) const {
+  return mCenter == other.mCenter && mFrame == other.mFrame && mShow == other.mShow &&
+         mPriority == other.mPriority;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LabelRule::operator!=(LabelRule const& other) const {
+  return !(*this == other);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelRuleSet::compile(std::vector<LabelRule> const& rules) {
+  mRules.clear();
+  mInvalidRules.clear();
+
+  for (std::size_t i = 0; i < rules.size(); ++i) {
+    CompiledRule rule;
+    rule.mShow     = rules[i].mShow;
+    rule.mPriority = rules[i].mPriority;
+
+    if (!rule.mCenter.compile(rules[i].mCenter) || !rule.mFrame.compile(rules[i].mFrame)) {
+      mInvalidRules.push_back(i);
+      continue;
+    }
+
+    // Rules which do not change anything do not have to be matched at all.
+    if (rule.mShow || rule.mPriority) {
+      mRules.push_back(std::move(rule));
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<std::size_t> const& LabelRuleSet::getInvalidRules() const {
+  return mInvalidRules;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t LabelRuleSet::size() const {
+  return mRules.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+LabelRuleResult LabelRuleSet::match(std::string_view center, std::string_view frame) const {
+  LabelRuleResult     result;
+  std::optional<bool> show;
+
+  for (auto const& rule : mRules) {
+    bool const needed = (!show && rule.mShow) || (!result.mPriority && rule.mPriority);
+    if (!needed || !rule.mCenter.matches(center) || !rule.mFrame.matches(frame)) {
+      continue;
+    }
+
+    if (!show) {
+      show = rule.mShow;
+    }
+
+    if (!result.mPriority) {
+      result.mPriority = rule.mPriority;
+    }
+
+    // The priority of a body without a label does not matter.
+    if ((show && result.mPriority) || (show && !*show)) {
+      break;
+    }
+  }
+
+  result.mShow = show.value_or(true);
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LabelRuleSet::matchGlob(std::string_view glob, std::string_view name) {
+  // The classic greedy algorithm: On a mismatch, the last * consumes one more character. This is
+  // linear in the length of the name for patterns with a single *.
+  std::size_t g     = 0;
+  std::size_t n     = 0;
+  std::size_t starG = std::string_view::npos;
+  std::size_t starN = 0;
+
+  while (n < name.size()) {
+    if (g < glob.size() && (glob[g] == '?' || glob[g] == name[n])) {
+      ++g;
+      ++n;
+    } else if (g < glob.size() && glob[g] == '*') {
+      starG = g++;
+      starN = n;
+    } else if (starG != std::string_view::npos) {
+      g = starG + 1;
+      n = ++starN;
+    } else {
+      return false;
+    }
+  }
+
+  while (g < glob.size() && glob[g] == '*') {
+    ++g;
+  }
+
+  return g == glob.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LabelRuleSet::Pattern::compile(std::string const& pattern) {
+  if (pattern.size() >= 2 && pattern.front() == '/' && pattern.back() == '/') {
+    try {
+      mRegex = std::regex(pattern.substr(1, pattern.size() - 2),
+          std::regex::ECMAScript | std::regex::optimize | std::regex::nosubs);
+    } catch (std::regex_error const&) {
+      return false;
+    }
+
+    mType = Type::eRegex;
+    return true;
+  }
+
+  std::size_t const stars     = std::count(pattern.begin(), pattern.end(), '*');
+  bool const        wildcards = pattern.find('?') != std::string::npos;
+
+  if (!wildcards && !pattern.empty() && stars == pattern.size()) {
+    mType = Type::eAny;
+  } else if (!wildcards && stars == 0) {
+    mType = Type::eExact;
+    mText = pattern;
+  } else if (!wildcards && stars == 1 && pattern.back() == '*') {
+    mType = Type::ePrefix;
+    mText = pattern.substr(0, pattern.size() - 1);
+  } else if (!wildcards && stars == 1 && pattern.front() == '*') {
+    mType = Type::eSuffix;
+    mText = pattern.substr(1);
+  } else if (!wildcards && stars == 2 && pattern.front() == '*' && pattern.back() == '*') {
+    mType = Type::eContains;
+    mText = pattern.substr(1, pattern.size() - 2);
+  } else {
+    mType = Type::eGlob;
+    mText = pattern;
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LabelRuleSet::Pattern::matches(std::string_view name) const {
+  std::string_view const text(mText);
+
+  switch (mType) {
+  case Type::eAny:
+    return true;
+  case Type::eExact:
+    return name == text;
+  case Type::ePrefix:
+    return name.substr(0, text.size()) == text;
+  case Type::eSuffix:
+    return name.size() >= text.size() && name.substr(name.size() - text.size()) == text;
+  case Type::eContains:
+    return name.find(text) != std::string_view::npos;
+  case Type::eGlob:
+    return matchGlob(text, name);
+  case Type::eRegex:
+    return std::regex_search(name.begin(), name.end(), mRegex);
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
@@ -0,0 +1,93 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_ENGINE_LABEL_RULE_SET_HPP
+#define CSP_ANCHOR_LABELS_ENGINE_LABEL_RULE_SET_HPP
+
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace csp::anchorlabels {
+
+/// A rule which decides whether a body gets a label and which priority the label has. The center
+/// and frame names of the body are matched against patterns, which are case-sensitive globs with
+/// the wildcards * and ? by default. Patterns enclosed in slashes, like "/^C/", are ECMAScript
+/// regular expressions which have to match a part of the name.
+struct LabelRule {
+  std::string mCenter = "*";
+  std::string mFrame  = "*";
+
+  /// If set, matching bodies get a label (true) or never get one (false).
+  std::optional<bool> mShow;
+
+  /// If set, this replaces the visible radius of matching bodies as their priority.
+  std::optional<double> mPriority;
+
+  bool operator==(LabelRule const& other) const;
+  bool operator!=(LabelRule const& other) const;
+};
+
+/// What the rules decided for a body.
+struct LabelRuleResult {
+  bool                  mShow = true;
+  std::optional<double> mPriority;
+};
+
+/// The LabelRuleSet compiles a list of LabelRules once and then matches names against them. Globs
+/// without wildcards, with a single trailing or leading * or enclosed in * are compared without any
+/// backtracking, and regular expressions are only constructed once.
+///
+/// The rules are evaluated in order. For each of mShow and mPriority, the first matching rule
+/// which sets it decides. Bodies which are not matched by any rule get a label with their default
+/// priority.
+class LabelRuleSet {
+ public:
+  /// Replaces all rules. Rules with an invalid regular expression are ignored, their indices are
+  /// returned by getInvalidRules().
+  void compile(std::vector<LabelRule> const& rules);
+
+  std::vector<std::size_t> const& getInvalidRules() const;
+
+  /// The number of rules which were compiled successfully.
+  std::size_t size() const;
+
+  LabelRuleResult match(std::string_view center, std::string_view frame) const;
+
+  /// Matches a name against a single glob. This is the slow path of the compiled patterns.
+  static bool matchGlob(std::string_view glob, std::string_view name);
+
+ private:
+  class Pattern {
+   public:
+    /// Returns false if the pattern is an invalid regular expression.
+    bool compile(std::string const& pattern);
+    bool matches(std::string_view name) const;
+
+   private:
+    enum class Type { eAny, eExact, ePrefix, eSuffix, eContains, eGlob, eRegex };
+
+    Type        mType = Type::eAny;
+    std::string mText;
+    std::regex  mRegex;
+  };
+
+  struct CompiledRule {
+    Pattern               mCenter;
+    Pattern               mFrame;
+    std::optional<bool>   mShow;
+    std::optional<double> mPriority;
+  };
+
+  std::vector<CompiledRule> mRules;
+  std::vector<std::size_t>  mInvalidRules;
+};
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_ENGINE_LABEL_RULE_SET_HPP
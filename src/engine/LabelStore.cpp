@@ -0,0 +1,104 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "LabelStore.hpp"
+
+#include "Kernels.hpp"
+
+#include <algorithm>
+
+namespace csp::anchorlabels {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelStore::resize(std::size_t size) {
+  mPositionX.resize(size);
+  mPositionY.resize(size);
+  mPositionZ.resize(size);
+  mX.resize(size);
+  mY.resize(size);
+  mWidth.resize(size);
+  mHeight.resize(size);
+  mDistance.resize(size);
+  mPriority.resize(size);
+  mRadius.resize(size);
+  mBodyId.resize(size);
+  mFlags.resize(size);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t LabelStore::size() const {
+  return mFlags.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t LabelStore::getMemoryUsage() const {
+  std::size_t bytes = mFlags.capacity() * sizeof(uint8_t) + mBodyId.capacity() * sizeof(uint32_t);
+
+  for (auto const* values : {&mPositionX, &mPositionY, &mPositionZ, &mX, &mY, &mWidth, &mHeight,
+           &mDistance, &mPriority, &mRadius}) {
+    bytes += values->capacity() * sizeof(double);
+  }
+
+  return bytes;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelStore::project(double labelScale, double width, double height) {
+  double const scaledWidth  = labelScale * width * 0.0005;
+  double const scaledHeight = labelScale * height * 0.0005;
+
+  kernels::project(mPositionX.data(), mPositionY.data(), mPositionZ.data(), size(), scaledWidth,
+      scaledHeight, mX.data(), mY.data(), mDistance.data());
+
+  std::fill(mWidth.begin(), mWidth.end(), scaledWidth);
+  std::fill(mHeight.begin(), mHeight.end(), scaledHeight);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+BoundingBox LabelStore::getBoundingBox(std::size_t label) const {
+  return {mX[label], mY[label], mWidth[label], mHeight[label]};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelStore::setBoundingBox(std::size_t label, BoundingBox const& bb) {
+  mX[label]      = bb.mX;
+  mY[label]      = bb.mY;
+  mWidth[label]  = bb.mWidth;
+  mHeight[label] = bb.mHeight;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LabelStore::isHidden(std::size_t label) const {
+  return (mFlags[label] & (eHidden | eCulled)) != 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelStore::copy(std::size_t label, LabelStore const& other, std::size_t otherLabel) {
+  mPositionX[label] = other.mPositionX[otherLabel];
+  mPositionY[label] = other.mPositionY[otherLabel];
+  mPositionZ[label] = other.mPositionZ[otherLabel];
+  mX[label]         = other.mX[otherLabel];
+  mY[label]         = other.mY[otherLabel];
+  mWidth[label]     = other.mWidth[otherLabel];
+  mHeight[label]    = other.mHeight[otherLabel];
+  mDistance[label]  = other.mDistance[otherLabel];
+  mPriority[label]  = other.mPriority[otherLabel];
+  mRadius[label]    = other.mRadius[otherLabel];
+  mBodyId[label]    = other.mBodyId[otherLabel];
+  mFlags[label]     = other.mFlags[otherLabel];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
@@ -0,0 +1,86 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_ENGINE_LABEL_STORE_HPP
+#define CSP_ANCHOR_LABELS_ENGINE_LABEL_STORE_HPP
+
+#include "BoundingBox.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace csp::anchorlabels {
+
+/// Flags which can be set per label in the LabelStore.
+enum LabelFlags : uint8_t {
+  /// Hidden labels are never drawn and do not take part in the overlap test.
+  eHidden = 1U << 0U,
+
+  /// Culled labels are outside of the view frustum or behind another body. They are treated like
+  /// hidden labels. This is set by the Culler.
+  eCulled = 1U << 1U,
+};
+
+/// The LabelStore contains everything the declutter pass needs to know about the labels in a
+/// structure-of-arrays layout. This way, the per-label data can be processed in a cache-friendly
+/// manner and with SIMD instructions. All vectors always have the same size.
+struct LabelStore {
+  /// The position of the label's anchor relative to the observer. These are the inputs of
+  /// project().
+  std::vector<double> mPositionX;
+  std::vector<double> mPositionY;
+  std::vector<double> mPositionZ;
+
+  /// The screen-space bounding boxes of the labels. The position refers to the corner with the
+  /// smallest coordinates.
+  std::vector<double> mX;
+  std::vector<double> mY;
+  std::vector<double> mWidth;
+  std::vector<double> mHeight;
+
+  /// The distance between the label's anchor and the observer.
+  std::vector<double> mDistance;
+
+  /// If two labels collide, the one with the higher priority survives. For celestial bodies this
+  /// is their visible radius.
+  std::vector<double> mPriority;
+
+  /// The radius of the label's body in meters. Bodies with a radius larger than zero may occlude
+  /// other labels.
+  std::vector<double> mRadius;
+
+  /// Identifies the body a label belongs to. The label of a body and the labels of points on its
+  /// surface share the same id, and a body does not occlude the labels of its own points. Zero if
+  /// the body is unknown.
+  std::vector<uint32_t> mBodyId;
+
+  /// A combination of LabelFlags.
+  std::vector<uint8_t> mFlags;
+
+  void        resize(std::size_t size);
+  std::size_t size() const;
+
+  /// The number of bytes reserved by all vectors.
+  std::size_t getMemoryUsage() const;
+
+  /// Computes the bounding boxes and distances of all labels from their observer-relative
+  /// positions. The width and height are given in pixels.
+  void project(double labelScale, double width, double height);
+
+  BoundingBox getBoundingBox(std::size_t label) const;
+  void        setBoundingBox(std::size_t label, BoundingBox const& bb);
+
+  /// Returns true if the label is hidden or culled.
+  bool isHidden(std::size_t label) const;
+
+  /// Copies all data of a label from another store. The label may be stored at a different index
+  /// in the other store.
+  void copy(std::size_t label, LabelStore const& other, std::size_t otherLabel);
+};
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_ENGINE_LABEL_STORE_HPP
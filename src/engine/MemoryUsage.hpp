@@ -0,0 +1,80 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_ENGINE_MEMORY_USAGE_HPP
+#define CSP_ANCHOR_LABELS_ENGINE_MEMORY_USAGE_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace csp::anchorlabels {
+
+/// An estimate of the memory used by a part of the plugin in bytes. Memory which is owned by the
+/// GUI processes, like the web page behind a GuiItem, is counted as main memory.
+struct MemoryUsage {
+  std::size_t mMainMemory    = 0;
+  std::size_t mTextureMemory = 0;
+
+  std::size_t getTotal() const {
+    return mMainMemory + mTextureMemory;
+  }
+
+  MemoryUsage& operator+=(MemoryUsage const& other) {
+    mMainMemory += other.mMainMemory;
+    mTextureMemory += other.mTextureMemory;
+    return *this;
+  }
+
+  MemoryUsage& operator-=(MemoryUsage const& other) {
+    mMainMemory -= other.mMainMemory;
+    mTextureMemory -= other.mTextureMemory;
+    return *this;
+  }
+
+  bool operator==(MemoryUsage const& other) const {
+    return mMainMemory == other.mMainMemory && mTextureMemory == other.mTextureMemory;
+  }
+
+  bool operator!=(MemoryUsage const& other) const {
+    return !(*this == other);
+  }
+};
+
+/// A rough estimate of the memory used by a GuiItem of the given size in pixels. Its pixels are
+/// stored in a texture and in a buffer in main memory, and the web page itself needs a few
+/// megabytes in the GUI process.
+inline MemoryUsage estimateGuiItemMemory(std::size_t width, std::size_t height) {
+  std::size_t const pageMemory  = 2 * 1024 * 1024;
+  std::size_t const pixelMemory = width * height * 4;
+  return {pageMemory + pixelMemory, pixelMemory};
+}
+
+/// The memory which is reserved by the given vector.
+template <typename T>
+std::size_t getMemoryUsage(std::vector<T> const& vector) {
+  return vector.capacity() * sizeof(T);
+}
+
+/// Returns how many items of the given size fit into the budget if the given amount of it is
+/// already used by other things. A budget of zero means that there is no limit, in which case
+/// maxCount is returned.
+inline std::size_t getCountWithinBudget(std::size_t budget, std::size_t used,
+    std::size_t itemSize, std::size_t maxCount) {
+  if (budget == 0 || itemSize == 0) {
+    return maxCount;
+  }
+
+  if (used >= budget) {
+    return 0;
+  }
+
+  std::size_t const count = (budget - used) / itemSize;
+  return count < maxCount ? count : maxCount;
+}
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_ENGINE_MEMORY_USAGE_HPP
@@ -0,0 +1,126 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "OccupancyBitmap.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace csp::anchorlabels {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void OccupancyBitmap::reset(double cellSize, BoundingBox const& bounds, std::size_t maxCells) {
+  cellSize = cellSize > 0.0 && std::isfinite(cellSize) ? cellSize : 1.0;
+  mOriginX = std::isfinite(bounds.mX) ? bounds.mX : 0.0;
+  mOriginY = std::isfinite(bounds.mY) ? bounds.mY : 0.0;
+  maxCells = std::max<std::size_t>(maxCells, 1);
+
+  // Like in the ScreenSpaceGrid, labels far off-screen may stretch the bounds enormously. Larger
+  // cells only lead to more exact tests.
+  double cellsX = 1.0;
+  double cellsY = 1.0;
+  if (bounds.isFinite() && bounds.mWidth >= 0.0 && bounds.mHeight >= 0.0) {
+    for (int i = 0; i < 2; ++i) {
+      cellsX = std::floor(bounds.mWidth / cellSize) + 1.0;
+      cellsY = std::floor(bounds.mHeight / cellSize) + 1.0;
+
+      double const cellCount = cellsX * cellsY;
+      if (cellCount <= static_cast<double>(maxCells)) {
+        break;
+      }
+      cellSize *= std::sqrt(cellCount / static_cast<double>(maxCells));
+    }
+  }
+
+  mInverseCellSize = 1.0 / cellSize;
+
+  mCellsX = static_cast<std::size_t>(std::clamp(cellsX, 1.0, static_cast<double>(maxCells)));
+  mCellsY = static_cast<std::size_t>(std::clamp(cellsY, 1.0, static_cast<double>(maxCells)));
+  mCellsY = std::max<std::size_t>(std::min(mCellsY, maxCells / mCellsX), 1);
+
+  mWordsPerRow = (mCellsX + 63) / 64;
+  mWords.assign(mWordsPerRow * mCellsY, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void OccupancyBitmap::mark(BoundingBox const& bb) {
+  CellRange range{};
+  if (!getCellRange(bb, range)) {
+    return;
+  }
+
+  for (std::size_t y = range.mMinY; y <= range.mMaxY; ++y) {
+    uint64_t* row = mWords.data() + y * mWordsPerRow;
+    for (std::size_t word = range.mMinX / 64; word <= range.mMaxX / 64; ++word) {
+      row[word] |= getMask(word, range);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool OccupancyBitmap::isFree(BoundingBox const& bb) const {
+  CellRange range{};
+  if (!getCellRange(bb, range)) {
+    return true;
+  }
+
+  for (std::size_t y = range.mMinY; y <= range.mMaxY; ++y) {
+    uint64_t const* row = mWords.data() + y * mWordsPerRow;
+    for (std::size_t word = range.mMinX / 64; word <= range.mMaxX / 64; ++word) {
+      if ((row[word] & getMask(word, range)) != 0) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool OccupancyBitmap::getCellRange(BoundingBox const& bb, CellRange& range) const {
+  if (!bb.isFinite() || mWords.empty()) {
+    return false;
+  }
+
+  range.mMinX = toCell(bb.mX, mOriginX, mCellsX);
+  range.mMinY = toCell(bb.mY, mOriginY, mCellsY);
+  range.mMaxX = toCell(bb.mX + bb.mWidth, mOriginX, mCellsX);
+  range.mMaxY = toCell(bb.mY + bb.mHeight, mOriginY, mCellsY);
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t OccupancyBitmap::toCell(double value, double origin, std::size_t cellCount) const {
+  // The clamping is done in floating point, as the cell index may be out of range of any integer.
+  // Within the range, truncation is the same as rounding down. NaN values end up in the first cell.
+  double const cell = (value - origin) * mInverseCellSize;
+  if (!(cell > 0.0)) {
+    return 0;
+  }
+  return cell < static_cast<double>(cellCount - 1) ? static_cast<std::size_t>(cell) : cellCount - 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t OccupancyBitmap::getMask(std::size_t word, CellRange const& range) const {
+  // The bits of the given word which lie in the column range of the cell range.
+  std::size_t const first = std::max(range.mMinX, word * 64) - word * 64;
+  std::size_t const last  = std::min(range.mMaxX, word * 64 + 63) - word * 64;
+
+  uint64_t const upper = last == 63 ? ~uint64_t(0) : (uint64_t(1) << (last + 1)) - 1;
+  uint64_t const lower = (uint64_t(1) << first) - 1;
+  return upper & ~lower;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
@@ -0,0 +1,61 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_ENGINE_OCCUPANCY_BITMAP_HPP
+#define CSP_ANCHOR_LABELS_ENGINE_OCCUPANCY_BITMAP_HPP
+
+#include "BoundingBox.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace csp::anchorlabels {
+
+/// The OccupancyBitmap is a coarse raster of the screen with one bit per cell. A bit is set if any
+/// box which has been marked touches the cell. If none of the cells touched by a box are set, the
+/// box cannot overlap any of the marked boxes. Testing a box only requires a few word operations,
+/// so most free positions are found without looking at any other box. If a bit is set, the boxes
+/// may or may not overlap and an exact test is required.
+class OccupancyBitmap {
+ public:
+  /// Clears all bits and prepares the bitmap for boxes within the given bounds. The cell size is
+  /// increased if the bitmap would have more than maxCells cells. Boxes outside of the bounds are
+  /// clamped to the border cells.
+  void reset(double cellSize, BoundingBox const& bounds, std::size_t maxCells);
+
+  /// Sets the bits of all cells touched by the box. Boxes with non-finite coordinates are ignored,
+  /// as they can never collide with any other box.
+  void mark(BoundingBox const& bb);
+
+  /// Returns true if none of the cells touched by the box are set.
+  bool isFree(BoundingBox const& bb) const;
+
+ private:
+  struct CellRange {
+    std::size_t mMinX;
+    std::size_t mMinY;
+    std::size_t mMaxX;
+    std::size_t mMaxY;
+  };
+
+  bool        getCellRange(BoundingBox const& bb, CellRange& range) const;
+  std::size_t toCell(double value, double origin, std::size_t cellCount) const;
+  uint64_t    getMask(std::size_t word, CellRange const& range) const;
+
+  double      mInverseCellSize = 1.0;
+  double      mOriginX         = 0.0;
+  double      mOriginY         = 0.0;
+  std::size_t mCellsX          = 0;
+  std::size_t mCellsY          = 0;
+  std::size_t mWordsPerRow     = 0;
+
+  /// The bits are stored row by row, each row starts with a new word.
+  std::vector<uint64_t> mWords;
+};
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_ENGINE_OCCUPANCY_BITMAP_HPP
@@ -0,0 +1,370 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "PointCatalog.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <numeric>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace csp::anchorlabels {
+
+namespace {
+
+std::array<char, 8> const MAGIC   = {'C', 'S', 'P', 'L', 'C', 'A', 'T', '\0'};
+uint32_t const            VERSION = 1;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Spreads the lower 21 bits of the value so that there are two zero bits between each of them.
+uint64_t spreadBits(uint64_t value) {
+  value &= 0x1fffffU;
+  value = (value | value << 32U) & 0x1f00000000ffffU;
+  value = (value | value << 16U) & 0x1f0000ff0000ffU;
+  value = (value | value << 8U) & 0x100f00f00f00f00fU;
+  value = (value | value << 4U) & 0x10c30c30c30c30c3U;
+  value = (value | value << 2U) & 0x1249249249249249U;
+  return value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+PointCatalog::~PointCatalog() {
+  close();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool PointCatalog::open(std::string const& fileName) {
+  close();
+
+#ifdef _WIN32
+  mFile = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (mFile == INVALID_HANDLE_VALUE) {
+    mFile = nullptr;
+    return false;
+  }
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(mFile, &size) || size.QuadPart == 0) {
+    close();
+    return false;
+  }
+
+  mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mMapping) {
+    close();
+    return false;
+  }
+
+  mData = static_cast<char const*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+  mSize = static_cast<std::size_t>(size.QuadPart);
+#else
+  int file = ::open(fileName.c_str(), O_RDONLY);
+  if (file < 0) {
+    return false;
+  }
+
+  struct stat info {};
+  if (fstat(file, &info) != 0 || info.st_size == 0) {
+    ::close(file);
+    return false;
+  }
+
+  auto  size = static_cast<std::size_t>(info.st_size);
+  void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+
+  // The mapping stays valid after the file has been closed.
+  ::close(file);
+
+  if (data != MAP_FAILED) {
+    mData = static_cast<char const*>(data);
+    mSize = size;
+  }
+#endif
+
+  if (!mData || !validate()) {
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void PointCatalog::close() {
+#ifdef _WIN32
+  if (mData) {
+    UnmapViewOfFile(mData);
+  }
+  if (mMapping) {
+    CloseHandle(mMapping);
+  }
+  if (mFile) {
+    CloseHandle(mFile);
+  }
+  mMapping = nullptr;
+  mFile    = nullptr;
+#else
+  if (mData) {
+    munmap(const_cast<char*>(mData), mSize); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+  }
+#endif
+
+  mData       = nullptr;
+  mSize       = 0;
+  mHeader     = nullptr;
+  mReferences = nullptr;
+  mEntries    = nullptr;
+  mNames      = nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool PointCatalog::isOpen() const {
+  return mHeader != nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t PointCatalog::size() const {
+  return mHeader ? static_cast<std::size_t>(mHeader->mEntryCount) : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string_view PointCatalog::getName(std::size_t entry) const {
+  return {mNames + mEntries[entry].mNameOffset, mEntries[entry].mNameLength};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::array<double, 3> PointCatalog::getPosition(std::size_t entry) const {
+  return mEntries[entry].mPosition;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float PointCatalog::getPriority(std::size_t entry) const {
+  return mEntries[entry].mPriority;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t PointCatalog::getReference(std::size_t entry) const {
+  return mEntries[entry].mReference;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t PointCatalog::getReferenceCount() const {
+  return mHeader ? mHeader->mReferenceCount : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string_view PointCatalog::getCenterName(uint32_t reference) const {
+  return {mNames + mReferences[reference].mCenterOffset, mReferences[reference].mCenterLength};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string_view PointCatalog::getFrameName(uint32_t reference) const {
+  return {mNames + mReferences[reference].mFrameOffset, mReferences[reference].mFrameLength};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void const* PointCatalog::getKey(std::size_t entry) const {
+  return mEntries + entry;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool PointCatalog::write(std::string const& fileName, std::vector<CatalogEntry> const& entries) {
+  // Each combination of center and frame is stored once.
+  std::map<std::pair<std::string, std::string>, uint32_t> referenceIds;
+  std::vector<std::pair<std::string, std::string> const*> references;
+  std::vector<uint32_t>                                   entryReferences(entries.size());
+
+  for (std::size_t i = 0; i < entries.size(); ++i) {
+    auto result = referenceIds.emplace(
+        std::make_pair(entries[i].mCenter, entries[i].mFrame), references.size());
+    if (result.second) {
+      references.push_back(&result.first->first);
+    }
+    entryReferences[i] = result.first->second;
+  }
+
+  // The entries of each reference are sorted along a Z-order curve through their bounding box.
+  std::vector<std::array<double, 6>> bounds(references.size(),
+      {std::numeric_limits<double>::max(), std::numeric_limits<double>::max(),
+          std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest(),
+          std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest()});
+
+  for (std::size_t i = 0; i < entries.size(); ++i) {
+    auto& box = bounds[entryReferences[i]];
+    for (std::size_t axis = 0; axis < 3; ++axis) {
+      box[axis]     = std::min(box[axis], entries[i].mPosition[axis]);
+      box[axis + 3] = std::max(box[axis + 3], entries[i].mPosition[axis]);
+    }
+  }
+
+  std::vector<uint64_t> codes(entries.size());
+  for (std::size_t i = 0; i < entries.size(); ++i) {
+    auto const& box  = bounds[entryReferences[i]];
+    uint64_t    code = 0;
+    for (std::size_t axis = 0; axis < 3; ++axis) {
+      double const extent = box[axis + 3] - box[axis];
+      double const t = extent > 0.0 ? (entries[i].mPosition[axis] - box[axis]) / extent : 0.0;
+      auto const   q = static_cast<uint64_t>(std::clamp(t, 0.0, 1.0) * 2097151.0);
+      code |= spreadBits(q) << axis;
+    }
+    codes[i] = code;
+  }
+
+  std::vector<std::size_t> order(entries.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+    if (entryReferences[a] != entryReferences[b]) {
+      return entryReferences[a] < entryReferences[b];
+    }
+    return codes[a] < codes[b];
+  });
+
+  // All strings are stored in one table. Offsets are 32 bit, so it must not exceed 4 GiB.
+  std::string names;
+
+  auto addName = [&names](std::string const& name, uint32_t& offset, uint32_t& length) {
+    offset = static_cast<uint32_t>(names.size());
+    length = static_cast<uint32_t>(name.size());
+    names += name;
+  };
+
+  std::vector<Reference> referenceTable(references.size());
+  for (std::size_t i = 0; i < references.size(); ++i) {
+    addName(references[i]->first, referenceTable[i].mCenterOffset,
+        referenceTable[i].mCenterLength);
+    addName(references[i]->second, referenceTable[i].mFrameOffset, referenceTable[i].mFrameLength);
+  }
+
+  std::vector<Entry> entryTable(entries.size());
+  for (std::size_t i = 0; i < entries.size(); ++i) {
+    CatalogEntry const& source = entries[order[i]];
+    Entry&              entry  = entryTable[i];
+
+    entry.mPosition  = source.mPosition;
+    entry.mPriority  = source.mPriority;
+    entry.mReference = entryReferences[order[i]];
+    addName(source.mName, entry.mNameOffset, entry.mNameLength);
+  }
+
+  if (names.size() > std::numeric_limits<uint32_t>::max()) {
+    return false;
+  }
+
+  Header header{};
+  header.mMagic            = MAGIC;
+  header.mVersion          = VERSION;
+  header.mReferenceCount   = static_cast<uint32_t>(referenceTable.size());
+  header.mEntryCount       = entryTable.size();
+  header.mReferencesOffset = sizeof(Header);
+  header.mEntriesOffset    = header.mReferencesOffset + referenceTable.size() * sizeof(Reference);
+  header.mNamesOffset      = header.mEntriesOffset + entryTable.size() * sizeof(Entry);
+  header.mNamesSize        = names.size();
+
+  std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<char const*>(&header), sizeof(Header));
+  file.write(reinterpret_cast<char const*>(referenceTable.data()),
+      static_cast<std::streamsize>(referenceTable.size() * sizeof(Reference)));
+  file.write(reinterpret_cast<char const*>(entryTable.data()),
+      static_cast<std::streamsize>(entryTable.size() * sizeof(Entry)));
+  file.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+  return static_cast<bool>(file);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool PointCatalog::validate() {
+  if (mSize < sizeof(Header)) {
+    return false;
+  }
+
+  auto const* header = reinterpret_cast<Header const*>(mData);
+  if (header->mMagic != MAGIC || header->mVersion != VERSION) {
+    return false;
+  }
+
+  // Each table has to fit into the file. The divisions prevent overflows for broken counts.
+  auto fits = [this](uint64_t offset, uint64_t count, uint64_t size) {
+    return offset <= mSize && count <= (mSize - offset) / size;
+  };
+
+  if (!fits(header->mReferencesOffset, header->mReferenceCount, sizeof(Reference)) ||
+      !fits(header->mEntriesOffset, header->mEntryCount, sizeof(Entry)) ||
+      !fits(header->mNamesOffset, header->mNamesSize, 1) ||
+      header->mReferencesOffset % alignof(Reference) != 0 ||
+      header->mEntriesOffset % alignof(Entry) != 0) {
+    return false;
+  }
+
+  auto const* references = reinterpret_cast<Reference const*>(mData + header->mReferencesOffset);
+  auto const* entries    = reinterpret_cast<Entry const*>(mData + header->mEntriesOffset);
+
+  auto isName = [header](uint64_t offset, uint64_t length) {
+    return offset + length <= header->mNamesSize;
+  };
+
+  for (uint32_t i = 0; i < header->mReferenceCount; ++i) {
+    if (!isName(references[i].mCenterOffset, references[i].mCenterLength) ||
+        !isName(references[i].mFrameOffset, references[i].mFrameLength)) {
+      return false;
+    }
+  }
+
+  for (uint64_t i = 0; i < header->mEntryCount; ++i) {
+    if (!isName(entries[i].mNameOffset, entries[i].mNameLength) ||
+        entries[i].mReference >= header->mReferenceCount) {
+      return false;
+    }
+  }
+
+  mHeader     = header;
+  mReferences = references;
+  mEntries    = entries;
+  mNames      = mData + header->mNamesOffset;
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
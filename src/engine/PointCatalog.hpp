@@ -0,0 +1,136 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_ENGINE_POINT_CATALOG_HPP
+#define CSP_ANCHOR_LABELS_ENGINE_POINT_CATALOG_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace csp::anchorlabels {
+
+/// One entry of a point catalog as it is passed to PointCatalog::write().
+struct CatalogEntry {
+  std::string mName;
+
+  /// The SPICE center and frame in which the position is given.
+  std::string mCenter;
+  std::string mFrame;
+
+  /// The position in meters relative to the center.
+  std::array<double, 3> mPosition{};
+
+  /// Labels with a higher priority win if labels overlap. For celestial bodies, the priority is
+  /// their radius in meters, so this should be given in the same unit.
+  float mPriority = 0.F;
+};
+
+/// A PointCatalog provides read-only access to a binary catalog of labeled points, for example
+/// asteroids, stars or ground stations. The file is memory-mapped, so nothing is copied when it is
+/// opened. Opening a catalog only reads the entry table to validate it, the names are loaded by
+/// the operating system when they are accessed for the first time.
+///
+/// The file is little-endian and consists of a header, a table of references to SPICE centers and
+/// frames, the entries and a table of names. Each entry stores its position, its priority, its
+/// reference and the location of its name in the name table. The entries of one reference are
+/// stored consecutively and sorted along a space-filling curve, so that neighboring entries are
+/// close to each other in space. The file can be created with write() or with the
+/// csp-anchor-labels-catalog-converter tool.
+class PointCatalog {
+ public:
+  PointCatalog() = default;
+
+  PointCatalog(PointCatalog const& other) = delete;
+  PointCatalog(PointCatalog&& other)      = delete;
+
+  PointCatalog& operator=(PointCatalog const& other) = delete;
+  PointCatalog& operator=(PointCatalog&& other) = delete;
+
+  ~PointCatalog();
+
+  /// Closes the current file and maps the given one. Returns false if the file could not be mapped
+  /// or is not a valid catalog.
+  bool open(std::string const& fileName);
+  void close();
+  bool isOpen() const;
+
+  /// The number of entries.
+  std::size_t size() const;
+
+  std::string_view      getName(std::size_t entry) const;
+  std::array<double, 3> getPosition(std::size_t entry) const;
+  float                 getPriority(std::size_t entry) const;
+
+  /// The index of the center and frame in which the position of the entry is given.
+  uint32_t getReference(std::size_t entry) const;
+
+  std::size_t      getReferenceCount() const;
+  std::string_view getCenterName(uint32_t reference) const;
+  std::string_view getFrameName(uint32_t reference) const;
+
+  /// An address which identifies the entry while the catalog is open. This can be used as a key
+  /// for the LabelRegistry.
+  void const* getKey(std::size_t entry) const;
+
+  /// Writes a catalog with the given entries. Returns false if the file could not be written.
+  static bool write(std::string const& fileName, std::vector<CatalogEntry> const& entries);
+
+ private:
+  struct Header {
+    std::array<char, 8> mMagic;
+    uint32_t            mVersion;
+    uint32_t            mReferenceCount;
+    uint64_t            mEntryCount;
+    uint64_t            mReferencesOffset;
+    uint64_t            mEntriesOffset;
+    uint64_t            mNamesOffset;
+    uint64_t            mNamesSize;
+    uint64_t            mReserved;
+  };
+
+  /// The strings are stored in the name table.
+  struct Reference {
+    uint32_t mCenterOffset;
+    uint32_t mCenterLength;
+    uint32_t mFrameOffset;
+    uint32_t mFrameLength;
+  };
+
+  struct Entry {
+    std::array<double, 3> mPosition;
+    float                 mPriority;
+    uint32_t              mReference;
+    uint32_t              mNameOffset;
+    uint32_t              mNameLength;
+  };
+
+  static_assert(sizeof(Header) == 64, "The catalog header must not contain padding.");
+  static_assert(sizeof(Reference) == 16, "Catalog references must not contain padding.");
+  static_assert(sizeof(Entry) == 40, "Catalog entries must not contain padding.");
+
+  /// Checks that all offsets of the mapped file are within its bounds and sets up the pointers to
+  /// the tables.
+  bool validate();
+
+  char const*      mData = nullptr;
+  std::size_t      mSize = 0;
+  Header const*    mHeader{};
+  Reference const* mReferences{};
+  Entry const*     mEntries{};
+  char const*      mNames{};
+
+#ifdef _WIN32
+  void* mFile    = nullptr;
+  void* mMapping = nullptr;
+#endif
+};
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_ENGINE_POINT_CATALOG_HPP
@@ -0,0 +1,374 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "PointCatalogIndex.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <utility>
+
+namespace csp::anchorlabels {
+
+namespace {
+
+/// An entry found by the query. Entries with the same priority are ordered by their index, so that
+/// the result does not depend on the order in which the nodes are visited.
+struct Candidate {
+  float    mPriority;
+  uint32_t mEntry;
+};
+
+bool isBetter(Candidate const& a, Candidate const& b) {
+  return a.mPriority > b.mPriority || (a.mPriority == b.mPriority && a.mEntry < b.mEntry);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Applies an affine column-major matrix to a point.
+std::array<double, 3> transformPoint(Transform const& m, std::array<double, 3> const& p) {
+  return {m[0] * p[0] + m[4] * p[1] + m[8] * p[2] + m[12],
+      m[1] * p[0] + m[5] * p[1] + m[9] * p[2] + m[13],
+      m[2] * p[0] + m[6] * p[1] + m[10] * p[2] + m[14]};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The largest factor by which the matrix scales a distance.
+double getMaxScale(Transform const& m) {
+  double maxSq = 0.0;
+  for (std::size_t column = 0; column < 3; ++column) {
+    double const x = m[column * 4];
+    double const y = m[column * 4 + 1];
+    double const z = m[column * 4 + 2];
+    maxSq          = std::max(maxSq, x * x + y * y + z * z);
+  }
+  return std::sqrt(maxSq);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double distance(std::array<double, 3> const& a, std::array<double, 3> const& b) {
+  double const x = b[0] - a[0];
+  double const y = b[1] - a[1];
+  double const z = b[2] - a[2];
+  return std::sqrt(x * x + y * y + z * z);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t const PointCatalogIndex::LEAF_SIZE = 32;
+uint32_t const PointCatalogIndex::NO_NODE   = std::numeric_limits<uint32_t>::max();
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void PointCatalogIndex::build(PointCatalog const& catalog) {
+  clear();
+
+  // Entries beyond the range of the node indices are not indexed.
+  auto const entryCount = static_cast<uint32_t>(
+      std::min<std::size_t>(catalog.size(), std::numeric_limits<uint32_t>::max()));
+
+  std::vector<uint32_t> level;
+  std::vector<uint32_t> nextLevel;
+
+  uint32_t runBegin = 0;
+  while (runBegin < entryCount) {
+    uint32_t const reference = catalog.getReference(runBegin);
+
+    // The leaves of one reference cover runs of up to LEAF_SIZE consecutive entries.
+    level.clear();
+    uint32_t first = runBegin;
+    while (first < entryCount && catalog.getReference(first) == reference) {
+      uint32_t count = 0;
+      while (count < LEAF_SIZE && first + count < entryCount &&
+             catalog.getReference(first + count) == reference) {
+        ++count;
+      }
+
+      std::array<double, 3> lower{std::numeric_limits<double>::max(),
+          std::numeric_limits<double>::max(), std::numeric_limits<double>::max()};
+      std::array<double, 3> upper{std::numeric_limits<double>::lowest(),
+          std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest()};
+      float maxPriority = std::numeric_limits<float>::lowest();
+
+      for (uint32_t i = first; i < first + count; ++i) {
+        auto const position = catalog.getPosition(i);
+        for (std::size_t axis = 0; axis < 3; ++axis) {
+          lower[axis] = std::min(lower[axis], position[axis]);
+          upper[axis] = std::max(upper[axis], position[axis]);
+        }
+        maxPriority = std::max(maxPriority, catalog.getPriority(i));
+      }
+
+      Node leaf{};
+      leaf.mCenter      = {(lower[0] + upper[0]) * 0.5, (lower[1] + upper[1]) * 0.5,
+          (lower[2] + upper[2]) * 0.5};
+      leaf.mMaxPriority = maxPriority;
+      leaf.mReference   = reference;
+      leaf.mFirst       = first;
+      leaf.mCount       = count;
+      leaf.mLeft        = NO_NODE;
+      leaf.mRight       = NO_NODE;
+
+      for (uint32_t i = first; i < first + count; ++i) {
+        leaf.mRadius = std::max(leaf.mRadius, distance(leaf.mCenter, catalog.getPosition(i)));
+      }
+
+      level.push_back(addNode(leaf));
+      first += count;
+    }
+
+    // Neighboring nodes are merged pairwise until there is a single root. As the entries are
+    // sorted along a space-filling curve, neighbors are close to each other.
+    while (level.size() > 1) {
+      nextLevel.clear();
+
+      for (std::size_t i = 0; i + 1 < level.size(); i += 2) {
+        Node const& a = mNodes[level[i]];
+        Node const& b = mNodes[level[i + 1]];
+
+        Node parent{};
+        parent.mMaxPriority = std::max(a.mMaxPriority, b.mMaxPriority);
+        parent.mReference   = reference;
+        parent.mFirst       = a.mFirst;
+        parent.mCount       = a.mCount + b.mCount;
+        parent.mLeft        = level[i];
+        parent.mRight       = level[i + 1];
+
+        // The smallest sphere which contains both child spheres.
+        double const d = distance(a.mCenter, b.mCenter);
+        if (d + b.mRadius <= a.mRadius) {
+          parent.mCenter = a.mCenter;
+          parent.mRadius = a.mRadius;
+        } else if (d + a.mRadius <= b.mRadius) {
+          parent.mCenter = b.mCenter;
+          parent.mRadius = b.mRadius;
+        } else {
+          parent.mRadius = (d + a.mRadius + b.mRadius) * 0.5;
+          double const t = (parent.mRadius - a.mRadius) / d;
+          parent.mCenter = {a.mCenter[0] + (b.mCenter[0] - a.mCenter[0]) * t,
+              a.mCenter[1] + (b.mCenter[1] - a.mCenter[1]) * t,
+              a.mCenter[2] + (b.mCenter[2] - a.mCenter[2]) * t};
+        }
+
+        nextLevel.push_back(addNode(parent));
+      }
+
+      if (level.size() % 2 == 1) {
+        nextLevel.push_back(level.back());
+      }
+
+      level.swap(nextLevel);
+    }
+
+    mRoots.push_back(level.front());
+    runBegin = first;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void PointCatalogIndex::clear() {
+  mNodes.clear();
+  mRoots.clear();
+  mVisitedNodeCount = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void PointCatalogIndex::query(PointCatalog const& catalog,
+    std::vector<std::optional<Transform>> const& toObserver,
+    std::optional<Transform> const& viewProjection, double frustumMargin, std::size_t maxCount,
+    std::vector<uint32_t>& entries) {
+
+  mVisitedNodeCount = 0;
+
+  if (maxCount == 0) {
+    return;
+  }
+
+  // The side planes of the frustum are derived from the rows of the view-projection matrix. A
+  // point is inside if w > 0 and |x|, |y| <= w * (1 + 2 * margin). The observer looks along the
+  // negative z-axis.
+  Frustum frustum;
+  frustum.mViewProjection = viewProjection;
+  frustum.mMargin         = frustumMargin;
+
+  if (viewProjection) {
+    auto const&  m      = *viewProjection;
+    double const factor = 1.0 + 2.0 * frustumMargin;
+
+    auto row = [&m](std::size_t i) {
+      return std::array<double, 4>{m[i], m[4 + i], m[8 + i], m[12 + i]};
+    };
+
+    auto const x = row(0);
+    auto const y = row(1);
+    auto const w = row(3);
+
+    for (double sign : {-1.0, 1.0}) {
+      for (auto const& side : {x, y}) {
+        frustum.mPlanes.push_back({factor * w[0] + sign * side[0],
+            factor * w[1] + sign * side[1], factor * w[2] + sign * side[2],
+            factor * w[3] + sign * side[3]});
+      }
+    }
+    frustum.mPlanes.push_back(w);
+
+    for (auto& plane : frustum.mPlanes) {
+      double const length =
+          std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+      if (length > 0.0) {
+        for (double& value : plane) {
+          value /= length;
+        }
+      }
+    }
+  } else {
+    frustum.mPlanes.push_back({0.0, 0.0, -1.0, 0.0});
+  }
+
+  std::vector<double> scales(toObserver.size());
+  for (std::size_t i = 0; i < toObserver.size(); ++i) {
+    scales[i] = toObserver[i] ? getMaxScale(*toObserver[i]) : 0.0;
+  }
+
+  // The best entries found so far. The front of the heap is the worst of them.
+  std::vector<Candidate> results;
+  results.reserve(maxCount + 1);
+
+  auto isFull = [&]() { return results.size() >= maxCount; };
+
+  // A node can only contribute if it may contain an entry which is better than the worst result.
+  auto mayContribute = [&](Node const& node) {
+    return !isFull() || node.mMaxPriority >= results.front().mPriority;
+  };
+
+  // Nodes are visited in order of their highest priority.
+  std::priority_queue<std::pair<float, uint32_t>> queue;
+
+  auto push = [&](uint32_t nodeIndex) {
+    Node const&  node   = mNodes[nodeIndex];
+    auto const   center = transformPoint(*toObserver[node.mReference], node.mCenter);
+    double const radius = node.mRadius * scales[node.mReference];
+
+    if (mayContribute(node) && !frustum.isOutside(center, radius)) {
+      queue.emplace(node.mMaxPriority, nodeIndex);
+    }
+  };
+
+  for (uint32_t root : mRoots) {
+    uint32_t const reference = mNodes[root].mReference;
+    if (reference < toObserver.size() && toObserver[reference]) {
+      push(root);
+    }
+  }
+
+  while (!queue.empty()) {
+    Node const& node = mNodes[queue.top().second];
+    queue.pop();
+    ++mVisitedNodeCount;
+
+    // All remaining nodes have a lower priority.
+    if (!mayContribute(node)) {
+      break;
+    }
+
+    if (node.mLeft != NO_NODE) {
+      push(node.mLeft);
+      push(node.mRight);
+      continue;
+    }
+
+    auto const& m = *toObserver[node.mReference];
+    for (uint32_t i = node.mFirst; i < node.mFirst + node.mCount; ++i) {
+      Candidate const candidate{catalog.getPriority(i), i};
+      if (isFull() && !isBetter(candidate, results.front())) {
+        continue;
+      }
+
+      if (frustum.isOutside(transformPoint(m, catalog.getPosition(i)))) {
+        continue;
+      }
+
+      results.push_back(candidate);
+      std::push_heap(results.begin(), results.end(), isBetter);
+
+      if (results.size() > maxCount) {
+        std::pop_heap(results.begin(), results.end(), isBetter);
+        results.pop_back();
+      }
+    }
+  }
+
+  std::sort(results.begin(), results.end(), isBetter);
+  for (auto const& result : results) {
+    entries.push_back(result.mEntry);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t PointCatalogIndex::getNodeCount() const {
+  return mNodes.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t PointCatalogIndex::getVisitedNodeCount() const {
+  return mVisitedNodeCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t PointCatalogIndex::addNode(Node const& node) {
+  mNodes.push_back(node);
+  return static_cast<uint32_t>(mNodes.size() - 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool PointCatalogIndex::Frustum::isOutside(std::array<double, 3> const& point) const {
+  // This is the same test as in Culler::isOutsideFrustum().
+  if (!mViewProjection) {
+    return !(point[2] < 0.0);
+  }
+
+  auto const&  m = *mViewProjection;
+  double const x = m[0] * point[0] + m[4] * point[1] + m[8] * point[2] + m[12];
+  double const y = m[1] * point[0] + m[5] * point[1] + m[9] * point[2] + m[13];
+  double const w = m[3] * point[0] + m[7] * point[1] + m[11] * point[2] + m[15];
+
+  double const limit = w * (1.0 + 2.0 * mMargin);
+
+  // NaN values are treated as outside.
+  return !(w > 0.0 && std::abs(x) <= limit && std::abs(y) <= limit);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool PointCatalogIndex::Frustum::isOutside(
+    std::array<double, 3> const& center, double radius) const {
+  // The sphere is outside if it is completely behind one of the planes. This is conservative, a
+  // sphere near a corner of the frustum may not be culled although it is outside.
+  for (auto const& plane : mPlanes) {
+    double const d = plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3];
+    if (d < -radius) {
+      return true;
+    }
+  }
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
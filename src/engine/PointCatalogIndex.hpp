@@ -0,0 +1,87 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_ENGINE_POINT_CATALOG_INDEX_HPP
+#define CSP_ANCHOR_LABELS_ENGINE_POINT_CATALOG_INDEX_HPP
+
+#include "PointCatalog.hpp"
+#include "Transform.hpp"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace csp::anchorlabels {
+
+/// The PointCatalogIndex finds the entries of a PointCatalog with the highest priority which are
+/// inside of the view frustum, without looking at all of them. Only these entries get a label, so
+/// catalogs with millions of entries can be used.
+///
+/// The index is a tree of bounding spheres over consecutive entries of the catalog. As the entries
+/// of each reference are sorted along a space-filling curve, neighboring entries are close to each
+/// other in space. Each node stores the highest priority below it, so the tree is searched
+/// best-first and the search stops as soon as no remaining node can contain a better entry.
+class PointCatalogIndex {
+ public:
+  /// The maximum number of entries in a leaf node.
+  static uint32_t const LEAF_SIZE;
+
+  /// Builds the tree for the given catalog. This accesses all entries once. The catalog must not
+  /// be closed while the index is used.
+  void build(PointCatalog const& catalog);
+  void clear();
+
+  /// Appends the indices of the at most maxCount entries with the highest priority which are
+  /// inside of the view frustum to the given vector, sorted by decreasing priority. toObserver
+  /// contains the matrix which transforms positions of each reference of the catalog to the
+  /// observer-relative space of the Culler. References without a matrix are skipped. If there is
+  /// no view-projection matrix, only entries behind the observer are skipped. The frustum margin
+  /// has the same meaning as in CullingSettings.
+  void query(PointCatalog const& catalog, std::vector<std::optional<Transform>> const& toObserver,
+      std::optional<Transform> const& viewProjection, double frustumMargin, std::size_t maxCount,
+      std::vector<uint32_t>& entries);
+
+  std::size_t getNodeCount() const;
+
+  /// The number of nodes which were visited by the last call to query().
+  std::size_t getVisitedNodeCount() const;
+
+ private:
+  static uint32_t const NO_NODE;
+
+  struct Node {
+    std::array<double, 3> mCenter;
+    double                mRadius;
+    float                 mMaxPriority;
+    uint32_t              mReference;
+    uint32_t              mFirst;
+    uint32_t              mCount;
+    uint32_t              mLeft;
+    uint32_t              mRight;
+  };
+
+  /// The tested planes of the view frustum in observer-relative space. Each plane points inwards
+  /// and is normalized.
+  struct Frustum {
+    std::vector<std::array<double, 4>> mPlanes;
+    std::optional<Transform>           mViewProjection;
+    double                             mMargin = 0.0;
+
+    bool isOutside(std::array<double, 3> const& point) const;
+    bool isOutside(std::array<double, 3> const& center, double radius) const;
+  };
+
+  uint32_t addNode(Node const& node);
+
+  std::vector<Node>     mNodes;
+  std::vector<uint32_t> mRoots;
+  std::size_t           mVisitedNodeCount = 0;
+};
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_ENGINE_POINT_CATALOG_INDEX_HPP
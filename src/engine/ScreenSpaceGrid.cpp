@@ -0,0 +1,240 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ScreenSpaceGrid.hpp"
+
+#include "Kernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace csp::anchorlabels {
+
+namespace {
+
+// The distance range which is searched for boxes at a similar depth is widened by this factor to
+// account for rounding errors. The exact test is done by the kernel anyways.
+double const DEPTH_RANGE_TOLERANCE = 1e-9;
+
+bool isOrderable(double distance) {
+  return std::isfinite(distance) && distance > 0.0;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double* ScreenSpaceGrid::Cell::get(Array array) {
+  return mData.data() + array * mCapacity;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double const* ScreenSpaceGrid::Cell::get(Array array) const {
+  return mData.data() + array * mCapacity;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ScreenSpaceGrid::Cell::insert(std::size_t id, BoundingBox const& bb, double distance) {
+  if (mSize == mCapacity) {
+    std::size_t         capacity = std::max<std::size_t>(4, mCapacity * 2);
+    std::vector<double> data(eCount * capacity);
+    for (std::size_t array = 0; array < eCount; ++array) {
+      std::copy_n(mData.data() + array * mCapacity, mSize, data.data() + array * capacity);
+    }
+    mData.swap(data);
+    mCapacity = capacity;
+  }
+
+  if (!isOrderable(distance)) {
+    mSorted = false;
+  }
+
+  // Boxes with equal distance are appended, so inserting boxes with a constant distance is cheap.
+  std::size_t const pos = static_cast<std::size_t>(
+      std::upper_bound(get(eDistance), get(eDistance) + mSize, distance) - get(eDistance));
+
+  double const values[eCount] = {bb.mX, bb.mY, bb.mX + bb.mWidth, bb.mY + bb.mHeight, distance};
+  for (std::size_t array = 0; array < eCount; ++array) {
+    double* first = get(static_cast<Array>(array));
+    std::copy_backward(first + pos, first + mSize, first + mSize + 1);
+    first[pos] = values[array];
+  }
+
+  mIds.insert(mIds.begin() + static_cast<std::ptrdiff_t>(pos), id);
+  ++mSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ScreenSpaceGrid::Cell::clear() {
+  mIds.clear();
+  mSize   = 0;
+  mSorted = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ScreenSpaceGrid::reset(double cellSize, BoundingBox const& bounds, std::size_t maxCells) {
+  for (std::size_t cell : mUsedCells) {
+    mCells[cell].clear();
+  }
+  mUsedCells.clear();
+  mTestCount = 0;
+
+  mCellSize = cellSize > 0.0 && std::isfinite(cellSize) ? cellSize : 1.0;
+  mOriginX  = std::isfinite(bounds.mX) ? bounds.mX : 0.0;
+  mOriginY  = std::isfinite(bounds.mY) ? bounds.mY : 0.0;
+  maxCells  = std::max<std::size_t>(maxCells, 1);
+
+  // Labels far off-screen may stretch the bounds enormously. In this case the cells are enlarged,
+  // which only costs some additional narrow phase tests but never drops a collision.
+  double cellsX = 1.0;
+  double cellsY = 1.0;
+  if (bounds.isFinite() && bounds.mWidth >= 0.0 && bounds.mHeight >= 0.0) {
+    for (int i = 0; i < 2; ++i) {
+      cellsX = std::floor(bounds.mWidth / mCellSize) + 1.0;
+      cellsY = std::floor(bounds.mHeight / mCellSize) + 1.0;
+
+      double const cellCount = cellsX * cellsY;
+      if (cellCount <= static_cast<double>(maxCells)) {
+        break;
+      }
+      mCellSize *= std::sqrt(cellCount / static_cast<double>(maxCells));
+    }
+  }
+
+  mInverseCellSize = 1.0 / mCellSize;
+
+  mCellsX = static_cast<std::size_t>(std::clamp(cellsX, 1.0, static_cast<double>(maxCells)));
+  mCellsY = static_cast<std::size_t>(std::clamp(cellsY, 1.0, static_cast<double>(maxCells)));
+  mCellsY = std::max<std::size_t>(std::min(mCellsY, maxCells / mCellsX), 1);
+
+  if (mCells.size() < mCellsX * mCellsY) {
+    mCells.resize(mCellsX * mCellsY);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ScreenSpaceGrid::insert(std::size_t id, BoundingBox const& bb, double distance) {
+  CellRange range{};
+  if (!getCellRange(bb, range)) {
+    return;
+  }
+
+  for (std::size_t y = range.mMinY; y <= range.mMaxY; ++y) {
+    for (std::size_t x = range.mMinX; x <= range.mMaxX; ++x) {
+      std::size_t index = y * mCellsX + x;
+      Cell&       cell  = mCells[index];
+
+      if (cell.mSize == 0) {
+        mUsedCells.push_back(index);
+      }
+
+      cell.insert(id, bb, distance);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool ScreenSpaceGrid::findOverlap(BoundingBox const& bb, double distance, bool depthOverlap,
+    double threshold, std::size_t& result) const {
+  CellRange range{};
+  if (mUsedCells.empty() || !getCellRange(bb, range)) {
+    return false;
+  }
+
+  double const maxX = bb.mX + bb.mWidth;
+  double const maxY = bb.mY + bb.mHeight;
+
+  // Boxes whose distance ratio exceeds the threshold are skipped anyways, so only the range of
+  // similar distances has to be passed to the kernel.
+  bool const useDepthRange =
+      depthOverlap && isOrderable(distance) && std::isfinite(threshold) && threshold >= 1.0;
+  double const minDistance = distance / threshold * (1.0 - DEPTH_RANGE_TOLERANCE);
+  double const maxDistance = distance * threshold * (1.0 + DEPTH_RANGE_TOLERANCE);
+
+  for (std::size_t y = range.mMinY; y <= range.mMaxY; ++y) {
+    for (std::size_t x = range.mMinX; x <= range.mMaxX; ++x) {
+      Cell const& cell  = mCells[y * mCellsX + x];
+      std::size_t begin = 0;
+      std::size_t end   = cell.mSize;
+
+      if (end > 0 && useDepthRange && cell.mSorted) {
+        double const* first = cell.get(Cell::eDistance);
+        begin = static_cast<std::size_t>(std::lower_bound(first, first + end, minDistance) - first);
+        end   = static_cast<std::size_t>(
+            std::upper_bound(first + begin, first + end, maxDistance) - first);
+      }
+
+      if (begin >= end) {
+        continue;
+      }
+
+      kernels::BoxArrays boxes{cell.get(Cell::eMinX) + begin, cell.get(Cell::eMinY) + begin,
+          cell.get(Cell::eMaxX) + begin, cell.get(Cell::eMaxY) + begin,
+          cell.get(Cell::eDistance) + begin};
+
+      std::size_t count = end - begin;
+      mTestCount += count;
+
+      std::size_t i = kernels::findOverlap(
+          bb.mX, bb.mY, maxX, maxY, distance, boxes, count, depthOverlap, threshold);
+      if (i < count) {
+        result = cell.mIds[begin + i];
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool ScreenSpaceGrid::empty() const {
+  return mUsedCells.empty();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t ScreenSpaceGrid::getTestCount() const {
+  return mTestCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool ScreenSpaceGrid::getCellRange(BoundingBox const& bb, CellRange& range) const {
+  if (!bb.isFinite()) {
+    return false;
+  }
+
+  range.mMinX = toCell(bb.mX, mOriginX, mCellsX);
+  range.mMinY = toCell(bb.mY, mOriginY, mCellsY);
+  range.mMaxX = toCell(bb.mX + bb.mWidth, mOriginX, mCellsX);
+  range.mMaxY = toCell(bb.mY + bb.mHeight, mOriginY, mCellsY);
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t ScreenSpaceGrid::toCell(double value, double origin, std::size_t cellCount) const {
+  // The clamping is done in floating point, as the cell index may be out of range of any integer.
+  // Within the range, truncation is the same as rounding down. NaN values end up in the first cell.
+  double const cell = (value - origin) * mInverseCellSize;
+  if (!(cell > 0.0)) {
+    return 0;
+  }
+  return cell < static_cast<double>(cellCount - 1) ? static_cast<std::size_t>(cell) : cellCount - 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
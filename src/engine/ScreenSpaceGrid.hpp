@@ -0,0 +1,99 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_ENGINE_SCREEN_SPACE_GRID_HPP
+#define CSP_ANCHOR_LABELS_ENGINE_SCREEN_SPACE_GRID_HPP
+
+#include "BoundingBox.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace csp::anchorlabels {
+
+/// A uniform grid over screen space which is used as broad phase for the label overlap test.
+/// Each inserted box is copied to every cell it touches. The boxes of a cell are stored in a
+/// structure-of-arrays layout, so that the narrow phase can test them with SIMD instructions.
+/// They are sorted by distance, so that only boxes at a similar depth have to be tested if depth
+/// overlap is enabled. The grid is meant to be rebuilt once per frame.
+class ScreenSpaceGrid {
+ public:
+  /// Removes all entries and prepares the grid for boxes within the given bounds. Choosing the
+  /// cell size close to the size of the inserted boxes makes each box touch at most four cells.
+  /// If this would result in more than maxCells cells, the cell size is increased. Boxes outside
+  /// of the bounds are stored in the border cells.
+  void reset(double cellSize, BoundingBox const& bounds, std::size_t maxCells);
+
+  /// Adds the given box to all cells it touches. Boxes with non-finite coordinates are ignored, as
+  /// they can never collide with any other box.
+  void insert(std::size_t id, BoundingBox const& bb, double distance);
+
+  /// Returns true if any inserted box overlaps the given box and stores its id in result. If
+  /// depthOverlap is set, boxes are ignored if the ratio of their distance and the given distance
+  /// is larger than threshold.
+  bool findOverlap(BoundingBox const& bb, double distance, bool depthOverlap, double threshold,
+      std::size_t& result) const;
+
+  /// Returns true if nothing has been inserted since the last reset().
+  bool empty() const;
+
+  /// The number of boxes which have been passed to the narrow phase by findOverlap() since the
+  /// last reset().
+  std::size_t getTestCount() const;
+
+ private:
+  /// The boxes of a cell are stored in a single allocation, one array after the other, so that a
+  /// query touches as few cache lines as possible. The ids are only needed if an overlap is found.
+  struct Cell {
+    enum Array { eMinX, eMinY, eMaxX, eMaxY, eDistance, eCount };
+
+    std::vector<double>      mData;
+    std::vector<std::size_t> mIds;
+    std::size_t              mSize     = 0;
+    std::size_t              mCapacity = 0;
+
+    /// This is cleared if a box with a distance which cannot be ordered has been inserted. The
+    /// whole cell has to be tested then.
+    bool mSorted = true;
+
+    double*       get(Array array);
+    double const* get(Array array) const;
+
+    void insert(std::size_t id, BoundingBox const& bb, double distance);
+    void clear();
+  };
+
+  struct CellRange {
+    std::size_t mMinX;
+    std::size_t mMinY;
+    std::size_t mMaxX;
+    std::size_t mMaxY;
+  };
+
+  bool        getCellRange(BoundingBox const& bb, CellRange& range) const;
+  std::size_t toCell(double value, double origin, std::size_t cellCount) const;
+
+  double      mCellSize        = 1.0;
+  double      mInverseCellSize = 1.0;
+  double      mOriginX         = 0.0;
+  double      mOriginY         = 0.0;
+  std::size_t mCellsX          = 0;
+  std::size_t mCellsY          = 0;
+
+  /// The cells are stored row by row. The vector is never shrunk, so that the allocations of the
+  /// cells can be reused in the next frame.
+  std::vector<Cell> mCells;
+
+  /// The indices of all cells which are not empty.
+  std::vector<std::size_t> mUsedCells;
+
+  /// This is only statistics, so it may be updated by the const findOverlap().
+  mutable std::size_t mTestCount = 0;
+};
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_ENGINE_SCREEN_SPACE_GRID_HPP
@@ -0,0 +1,186 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "SortKeyAllocator.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace csp::anchorlabels {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int const SortKeyAllocator::NO_KEY = std::numeric_limits<int>::min();
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SortKeyAllocator::reset() {
+  mKeys.clear();
+  mLabels.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SortKeyAllocator::remap(std::vector<std::size_t> const& previousLabels) {
+  std::vector<int> keys(previousLabels.size(), NO_KEY);
+
+  mLabels.clear();
+  for (std::size_t i = 0; i < previousLabels.size(); ++i) {
+    if (previousLabels[i] < mKeys.size() && mKeys[previousLabels[i]] != NO_KEY) {
+      keys[i] = mKeys[previousLabels[i]];
+      mLabels.push_back(i);
+    }
+  }
+
+  mKeys.swap(keys);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SortKeyAllocator::allocate(std::vector<std::size_t> const& labels, int maxKey,
+    std::size_t range, std::vector<int>& keys) {
+  range = std::max<std::size_t>(range, 1);
+
+  std::size_t const count  = labels.size();
+  std::size_t const none   = std::numeric_limits<std::size_t>::max();
+  int64_t const     minKey = static_cast<int64_t>(maxKey) - static_cast<int64_t>(range) + 1;
+
+  keys.resize(count);
+
+  // Keys outside of the current range, for example because the range has been changed, cannot be
+  // reused.
+  mPreviousKeys.resize(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    int key = labels[i] < mKeys.size() ? mKeys[labels[i]] : NO_KEY;
+    if (key < minKey || key > maxKey) {
+      key = NO_KEY;
+    }
+    mPreviousKeys[i] = key;
+  }
+
+  // With at most range labels, each label gets its own key. Else neighbors may share a key.
+  bool const strict = count <= range;
+
+  // Find the longest subsequence of labels whose previous keys are still in the right order.
+  // These labels keep their keys. mTails[l] is the last label of the best subsequence of length
+  // l + 1 found so far, which is the one with the largest last key.
+  mTails.clear();
+  mPredecessors.assign(count, none);
+
+  for (std::size_t i = 0; i < count; ++i) {
+    int const key = mPreviousKeys[i];
+    if (key == NO_KEY) {
+      continue;
+    }
+
+    auto tail = strict ? std::lower_bound(mTails.begin(), mTails.end(), key,
+                             [this](std::size_t label, int k) { return mPreviousKeys[label] > k; })
+                       : std::upper_bound(mTails.begin(), mTails.end(), key,
+                             [this](int k, std::size_t label) { return k > mPreviousKeys[label]; });
+
+    if (tail != mTails.begin()) {
+      mPredecessors[i] = *(tail - 1);
+    }
+
+    if (tail == mTails.end()) {
+      mTails.push_back(i);
+    } else {
+      *tail = i;
+    }
+  }
+
+  mIsKept.assign(count, 0);
+  for (std::size_t i = mTails.empty() ? none : mTails.back(); i != none; i = mPredecessors[i]) {
+    mIsKept[i] = 1;
+  }
+
+  // The other labels get keys between their kept neighbors. In strict mode, they are distributed
+  // evenly over the free keys. If there are not enough free keys, all labels are renumbered.
+  // Else each label gets the key of its bucket, clamped to the keys of its neighbors.
+  bool        allocated  = true;
+  std::size_t runStart   = 0;
+  int64_t     upperBound = static_cast<int64_t>(maxKey) + (strict ? 1 : 0);
+
+  for (std::size_t i = 0; i <= count; ++i) {
+    if (i < count && !mIsKept[i]) {
+      continue;
+    }
+
+    int64_t const lowerBound = i < count ? mPreviousKeys[i] : minKey - (strict ? 1 : 0);
+    auto const    runLength  = static_cast<int64_t>(i - runStart);
+    int64_t const gap        = upperBound - lowerBound;
+
+    if (strict) {
+      if (gap - 1 < runLength) {
+        allocated = false;
+        break;
+      }
+
+      for (int64_t j = 0; j < runLength; ++j) {
+        keys[runStart + j] = static_cast<int>(upperBound - (j + 1) * gap / (runLength + 1));
+      }
+    } else {
+      for (std::size_t j = runStart; j < i; ++j) {
+        int64_t bucketKey = static_cast<int64_t>(maxKey) - static_cast<int64_t>(j * range / count);
+        keys[j]           = static_cast<int>(std::clamp(bucketKey, lowerBound, upperBound));
+      }
+    }
+
+    if (i < count) {
+      keys[i]    = mPreviousKeys[i];
+      upperBound = lowerBound;
+      runStart   = i + 1;
+    }
+  }
+
+  if (!allocated) {
+    spread(labels, maxKey, range, keys);
+  }
+
+  // Remember the keys for the next call.
+  for (std::size_t label : mLabels) {
+    if (label < mKeys.size()) {
+      mKeys[label] = NO_KEY;
+    }
+  }
+
+  mChangedKeyCount = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    if (keys[i] != mPreviousKeys[i]) {
+      ++mChangedKeyCount;
+    }
+
+    if (labels[i] >= mKeys.size()) {
+      mKeys.resize(labels[i] + 1, NO_KEY);
+    }
+    mKeys[labels[i]] = keys[i];
+  }
+
+  mLabels = labels;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t SortKeyAllocator::getChangedKeyCount() const {
+  return mChangedKeyCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SortKeyAllocator::spread(std::vector<std::size_t> const& labels, int maxKey,
+    std::size_t range, std::vector<int>& keys) const {
+  std::size_t const count = labels.size();
+
+  // With at most range labels, consecutive keys differ by at least one.
+  for (std::size_t i = 0; i < count; ++i) {
+    auto const offset = static_cast<int64_t>(i * range / count);
+    keys[i]           = static_cast<int>(static_cast<int64_t>(maxKey) - offset);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
@@ -0,0 +1,67 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_ENGINE_SORT_KEY_ALLOCATOR_HPP
+#define CSP_ANCHOR_LABELS_ENGINE_SORT_KEY_ALLOCATOR_HPP
+
+#include <cstdint>
+#include <vector>
+
+namespace csp::anchorlabels {
+
+/// Assigns draw order sort keys to the visible labels. The keys are taken from a fixed range, so
+/// that they never collide with the draw orders of other items. Labels closer to the observer get
+/// larger keys, so that they are drawn after the labels behind them.
+///
+/// If there are at most as many labels as keys, each label gets its own key. The keys of the
+/// previous call are kept wherever this is possible without breaking the order, so that only
+/// labels which actually moved past another label are renumbered. The free keys are distributed
+/// evenly, which leaves room for labels which become visible later. If there are more labels than
+/// keys, neighboring labels share a key. Their relative order is undefined then.
+class SortKeyAllocator {
+ public:
+  /// Forgets all previous keys. Must be called if the label indices change their meaning.
+  void reset();
+
+  /// Keeps the keys of labels which still exist after labels have been added or removed.
+  /// previousLabels contains the previous index of each label, or an index out of range for new
+  /// labels.
+  void remap(std::vector<std::size_t> const& previousLabels);
+
+  /// Computes keys in the range [maxKey - range + 1, maxKey] for the given labels, which have to
+  /// be sorted by increasing distance to the observer. The keys are non-increasing and strictly
+  /// decreasing if there are at most range labels. This takes O(k log k) for k labels.
+  void allocate(std::vector<std::size_t> const& labels, int maxKey, std::size_t range,
+      std::vector<int>& keys);
+
+  /// The number of labels whose key changed in the last call to allocate(). This includes labels
+  /// which did not have a key before.
+  std::size_t getChangedKeyCount() const;
+
+ private:
+  /// Assigns evenly spaced keys to all labels.
+  void spread(std::vector<std::size_t> const& labels, int maxKey, std::size_t range,
+      std::vector<int>& keys) const;
+
+  /// The key of each label in the last call or NO_KEY, indexed by label.
+  static int const NO_KEY;
+  std::vector<int> mKeys;
+
+  /// The labels of the last call, used to reset their entries in mKeys.
+  std::vector<std::size_t> mLabels;
+
+  // Temporary data of allocate(), kept to avoid allocations.
+  std::vector<int>         mPreviousKeys;
+  std::vector<std::size_t> mTails;
+  std::vector<std::size_t> mPredecessors;
+  std::vector<uint8_t>     mIsKept;
+
+  std::size_t mChangedKeyCount = 0;
+};
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_ENGINE_SORT_KEY_ALLOCATOR_HPP
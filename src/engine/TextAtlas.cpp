@@ -0,0 +1,338 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "TextAtlas.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace csp::anchorlabels {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t const TextAtlas::NO_ENTRY = std::numeric_limits<uint32_t>::max();
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double FontMetrics::measure(std::string const& text) const {
+  double width = 0.0;
+
+  for (char c : text) {
+    auto const byte = static_cast<unsigned char>(c);
+
+    if (byte >= 32 && byte <= 126) {
+      width += mAdvances[byte - 32];
+    } else if (byte >= 0xC0) {
+      // The first byte of a multi-byte character, the following bytes are in the range
+      // 0x80 - 0xBF and are skipped.
+      width += mDefaultAdvance;
+    }
+  }
+
+  return width;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TextAtlas::reset(FontMetrics const& metrics, uint32_t pageSize, uint32_t padding) {
+  mMetrics   = metrics;
+  mPageSize  = std::max<uint32_t>(pageSize, 1);
+  mPadding   = std::min(padding, mPageSize / 4);
+  mRowHeight = static_cast<uint32_t>(std::ceil(std::max(metrics.mLineHeight, 1.F))) + 2 * mPadding;
+  mRowHeight = std::min(mRowHeight, mPageSize);
+
+  mEntries.clear();
+  mFreeEntries.clear();
+  mLookup.clear();
+  mPages.clear();
+
+  mLiveArea    = 0;
+  mDeadArea    = 0;
+  mRepackCount = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t TextAtlas::add(std::string const& text) {
+  auto it = mLookup.find(text);
+  if (it != mLookup.end()) {
+    ++mEntries[it->second].mReferences;
+    return it->second;
+  }
+
+  uint32_t const entry = createEntry(text);
+  place(entry);
+  return entry;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TextAtlas::add(std::vector<std::string> const& texts, std::vector<uint32_t>& entries) {
+  std::vector<uint32_t> created;
+  entries.reserve(entries.size() + texts.size());
+
+  for (auto const& text : texts) {
+    auto it = mLookup.find(text);
+    if (it != mLookup.end()) {
+      ++mEntries[it->second].mReferences;
+      entries.push_back(it->second);
+    } else {
+      created.push_back(createEntry(text));
+      entries.push_back(created.back());
+    }
+  }
+
+  std::stable_sort(created.begin(), created.end(), [this](uint32_t a, uint32_t b) {
+    return mEntries[a].mRect.mWidth > mEntries[b].mRect.mWidth;
+  });
+
+  for (uint32_t entry : created) {
+    place(entry);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TextAtlas::release(uint32_t entry) {
+  auto& e = mEntries[entry];
+  if (e.mReferences == 0 || --e.mReferences > 0) {
+    return;
+  }
+
+  uint64_t const area = static_cast<uint64_t>(e.mRect.mWidth) * e.mRect.mHeight;
+  mLiveArea -= area;
+
+  // The space stays occupied until the atlas is repacked.
+  if (e.mPlaced) {
+    mDeadArea += area;
+    e.mPlaced = false;
+  }
+
+  mLookup.erase(e.mText);
+  mFreeEntries.push_back(entry);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string const& TextAtlas::getText(uint32_t entry) const {
+  return mEntries[entry].mText;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+AtlasRect const& TextAtlas::getRect(uint32_t entry) const {
+  return mEntries[entry].mRect;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TextLayout TextAtlas::getLayout(uint32_t entry, double areaWidth, double areaHeight) const {
+  auto const& rect = mEntries[entry].mRect;
+
+  double const textWidth  = rect.mWidth - 2.0 * mPadding;
+  double const textHeight = rect.mHeight - 2.0 * mPadding;
+
+  // The text is centered in the area, the parts which overflow it are clipped.
+  double const x = 0.5 * (areaWidth - textWidth);
+  double const y = 0.5 * (areaHeight - textHeight);
+
+  double const minX = std::max(x, 0.0);
+  double const minY = std::max(y, 0.0);
+  double const maxX = std::min(x + textWidth, areaWidth);
+  double const maxY = std::min(y + textHeight, areaHeight);
+
+  TextLayout layout;
+  layout.mX      = minX;
+  layout.mY      = minY;
+  layout.mWidth  = std::max(maxX - minX, 0.0);
+  layout.mHeight = std::max(maxY - minY, 0.0);
+
+  double const scale = 1.0 / mPageSize;
+  layout.mU          = (rect.mX + mPadding + minX - x) * scale;
+  layout.mV          = (rect.mY + mPadding + minY - y) * scale;
+  layout.mUWidth     = layout.mWidth * scale;
+  layout.mVHeight    = layout.mHeight * scale;
+
+  return layout;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t TextAtlas::getPageSize() const {
+  return mPageSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t TextAtlas::getPadding() const {
+  return mPadding;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t TextAtlas::getPageCount() const {
+  return mPages.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t TextAtlas::getPageVersion(uint32_t page) const {
+  return mPages[page].mVersion;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TextAtlas::getPageEntries(uint32_t page, std::vector<uint32_t>& entries) const {
+  for (std::size_t i = 0; i < mEntries.size(); ++i) {
+    if (mEntries[i].mPlaced && mEntries[i].mRect.mPage == page) {
+      entries.push_back(static_cast<uint32_t>(i));
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t TextAtlas::getEntryCount() const {
+  return mLookup.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double TextAtlas::getFillRatio() const {
+  if (mPages.empty()) {
+    return 0.0;
+  }
+
+  double const pageArea = static_cast<double>(mPageSize) * mPageSize;
+  return static_cast<double>(mLiveArea) / (pageArea * static_cast<double>(mPages.size()));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t TextAtlas::getRepackCount() const {
+  return mRepackCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t TextAtlas::createEntry(std::string const& text) {
+  uint32_t entry = 0;
+  if (mFreeEntries.empty()) {
+    entry = static_cast<uint32_t>(mEntries.size());
+    mEntries.emplace_back();
+  } else {
+    entry = mFreeEntries.back();
+    mFreeEntries.pop_back();
+  }
+
+  // Texts which are wider than a page are clipped.
+  double const width = std::ceil(mMetrics.measure(text)) + 2.0 * mPadding;
+
+  auto& e         = mEntries[entry];
+  e.mText         = text;
+  e.mReferences   = 1;
+  e.mPlaced       = false;
+  e.mRect         = AtlasRect{};
+  e.mRect.mWidth  = static_cast<uint32_t>(std::min(width, static_cast<double>(mPageSize)));
+  e.mRect.mHeight = mRowHeight;
+
+  mLiveArea += static_cast<uint64_t>(e.mRect.mWidth) * e.mRect.mHeight;
+  mLookup.emplace(text, entry);
+
+  return entry;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TextAtlas::place(uint32_t entry) {
+  // A repack during a batch of additions places all pending entries at once.
+  if (mEntries[entry].mPlaced || tryPlace(entry)) {
+    return;
+  }
+
+  double const pageArea = static_cast<double>(mPageSize) * mPageSize;
+  if (static_cast<double>(mDeadArea) > 0.25 * pageArea * static_cast<double>(mPages.size())) {
+    repack();
+    return;
+  }
+
+  addPage();
+  tryPlace(entry);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TextAtlas::tryPlace(uint32_t entry) {
+  auto& rect = mEntries[entry].mRect;
+
+  for (std::size_t p = 0; p < mPages.size(); ++p) {
+    auto& page = mPages[p];
+    if (page.mMaxFree < rect.mWidth) {
+      continue;
+    }
+
+    for (std::size_t row = 0; row < page.mRowFill.size(); ++row) {
+      if (mPageSize - page.mRowFill[row] < rect.mWidth) {
+        continue;
+      }
+
+      rect.mPage = static_cast<uint32_t>(p);
+      rect.mX    = page.mRowFill[row];
+      rect.mY    = static_cast<uint32_t>(row) * mRowHeight;
+      page.mRowFill[row] += rect.mWidth;
+
+      page.mMaxFree = mPageSize - *std::min_element(page.mRowFill.begin(), page.mRowFill.end());
+      page.mVersion = ++mVersionCounter;
+
+      mEntries[entry].mPlaced = true;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TextAtlas::addPage() {
+  Page page;
+  page.mRowFill.assign(std::max<uint32_t>(mPageSize / mRowHeight, 1), 0);
+  page.mMaxFree = mPageSize;
+  page.mVersion = ++mVersionCounter;
+  mPages.push_back(std::move(page));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TextAtlas::repack() {
+  std::vector<uint32_t> live;
+  for (std::size_t i = 0; i < mEntries.size(); ++i) {
+    mEntries[i].mPlaced = false;
+    if (mEntries[i].mReferences > 0) {
+      live.push_back(static_cast<uint32_t>(i));
+    }
+  }
+
+  std::stable_sort(live.begin(), live.end(), [this](uint32_t a, uint32_t b) {
+    return mEntries[a].mRect.mWidth > mEntries[b].mRect.mWidth;
+  });
+
+  mPages.clear();
+  for (uint32_t entry : live) {
+    if (!tryPlace(entry)) {
+      addPage();
+      tryPlace(entry);
+    }
+  }
+
+  mDeadArea = 0;
+  ++mRepackCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
@@ -0,0 +1,154 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_ENGINE_TEXT_ATLAS_HPP
+#define CSP_ANCHOR_LABELS_ENGINE_TEXT_ATLAS_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace csp::anchorlabels {
+
+/// The metrics of the font which is used to rasterize the atlas. They are measured once by the
+/// page which draws the atlas.
+struct FontMetrics {
+  /// The advance widths in pixels of the printable ASCII characters, starting with the space.
+  std::array<float, 95> mAdvances{};
+
+  /// The advance width which is used for all other characters.
+  float mDefaultAdvance = 0.F;
+
+  /// The height of a line of text in pixels.
+  float mLineHeight = 0.F;
+
+  /// Returns the width of the UTF-8 encoded text in pixels.
+  double measure(std::string const& text) const;
+};
+
+/// The location of a text in the atlas in pixels, including the padding.
+struct AtlasRect {
+  uint32_t mPage   = 0;
+  uint32_t mX      = 0;
+  uint32_t mY      = 0;
+  uint32_t mWidth  = 0;
+  uint32_t mHeight = 0;
+};
+
+/// Where a text is drawn within the area of a label and which part of the atlas is sampled for
+/// it. Like in anchor_label.html, the text is centered and clipped to the area. Both rectangles
+/// have their origin in the top left corner.
+struct TextLayout {
+  /// In pixels of the label area.
+  double mX      = 0.0;
+  double mY      = 0.0;
+  double mWidth  = 0.0;
+  double mHeight = 0.0;
+
+  /// In texture coordinates of the atlas page.
+  double mU       = 0.0;
+  double mV       = 0.0;
+  double mUWidth  = 0.0;
+  double mVHeight = 0.0;
+};
+
+/// The TextAtlas packs the texts of the labels into a few square pages, so that all labels can be
+/// drawn from a shared texture instead of one GuiItem per label. It only computes where each text
+/// is placed, the pages are rasterized by the renderer.
+///
+/// All texts have the height of one line, so the pages are divided into rows of equal height
+/// which are filled from left to right. Each text is placed in the first row with enough space
+/// left. Texts are reference-counted, so labels with the same text share an entry. The space of
+/// released texts is reclaimed by repacking all pages once a new text does not fit anymore and a
+/// quarter of the atlas is unused.
+class TextAtlas {
+ public:
+  static uint32_t const NO_ENTRY;
+
+  /// Removes all entries and pages. The size of the pages and the padding around each text are
+  /// given in pixels.
+  void reset(FontMetrics const& metrics, uint32_t pageSize, uint32_t padding);
+
+  /// Returns the entry of the given text and increases its reference count. If there is no such
+  /// entry yet, the text is placed in the atlas.
+  uint32_t add(std::string const& text);
+
+  /// Adds several texts at once and appends their entries to the given vector in the same order.
+  /// The new texts are placed from the widest to the narrowest one, which packs tighter than
+  /// adding them one by one.
+  void add(std::vector<std::string> const& texts, std::vector<uint32_t>& entries);
+
+  /// Decreases the reference count of the entry. Once it reaches zero, the entry id may be reused
+  /// for another text.
+  void release(uint32_t entry);
+
+  std::string const& getText(uint32_t entry) const;
+  AtlasRect const&   getRect(uint32_t entry) const;
+
+  /// Computes where the text of the entry is drawn in a label area of the given size in pixels.
+  TextLayout getLayout(uint32_t entry, double areaWidth, double areaHeight) const;
+
+  uint32_t    getPageSize() const;
+  uint32_t    getPadding() const;
+  std::size_t getPageCount() const;
+
+  /// The version of a page changes whenever a text is placed on it or the atlas is repacked. The
+  /// renderer has to rasterize a page again if its version changed.
+  uint64_t getPageVersion(uint32_t page) const;
+
+  /// Appends all entries which are placed on the given page to the vector.
+  void getPageEntries(uint32_t page, std::vector<uint32_t>& entries) const;
+
+  /// The number of entries which are referenced.
+  std::size_t getEntryCount() const;
+
+  /// The fraction of the area of all pages which is covered by referenced texts.
+  double getFillRatio() const;
+
+  /// The number of times the atlas has been repacked since the last reset().
+  std::size_t getRepackCount() const;
+
+ private:
+  struct Entry {
+    std::string mText;
+    AtlasRect   mRect;
+    uint32_t    mReferences = 0;
+    bool        mPlaced     = false;
+  };
+
+  struct Page {
+    std::vector<uint32_t> mRowFill; ///< The used width of each row.
+    uint32_t              mMaxFree = 0;
+    uint64_t              mVersion = 0;
+  };
+
+  uint32_t createEntry(std::string const& text);
+  void     place(uint32_t entry);
+  bool     tryPlace(uint32_t entry);
+  void     addPage();
+  void     repack();
+
+  FontMetrics mMetrics;
+  uint32_t    mPageSize  = 1024;
+  uint32_t    mPadding   = 2;
+  uint32_t    mRowHeight = 1;
+
+  std::vector<Entry>                        mEntries;
+  std::vector<uint32_t>                     mFreeEntries;
+  std::unordered_map<std::string, uint32_t> mLookup;
+
+  std::vector<Page> mPages;
+  uint64_t          mVersionCounter = 0;
+  uint64_t          mLiveArea       = 0;
+  uint64_t          mDeadArea       = 0; ///< Occupied by released entries until the next repack.
+  std::size_t       mRepackCount    = 0;
+};
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_ENGINE_TEXT_ATLAS_HPP
@@ -0,0 +1,95 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "TraceWriter.hpp"
+
+namespace csp::anchorlabels {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ScopedDuration::ScopedDuration(double& duration)
+    : mDuration(duration)
+    , mStart(std::chrono::steady_clock::now()) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ScopedDuration::~ScopedDuration() {
+  mDuration +=
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mStart).count();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TraceWriter::open(std::string const& fileName) {
+  close();
+
+  std::string const extension = ".json";
+  mIsJSON = fileName.size() >= extension.size() &&
+            fileName.compare(fileName.size() - extension.size(), extension.size(), extension) == 0;
+
+  mFile.open(fileName, std::ios::out | std::ios::trunc);
+  if (!mFile) {
+    return false;
+  }
+
+  if (!mIsJSON) {
+    mFile << "frame,positionTime,cullingTime,declutterTime,commitTime,flushTime,labels,updated,"
+             "culled,visible,pairTests,sceneGraphMutations,transformCacheHits,transformCacheMisses,"
+             "prefetchHits,prefetchMisses,mainMemory,textureMemory\n";
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TraceWriter::close() {
+  if (mFile.is_open()) {
+    mFile.close();
+  }
+  mFile.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TraceWriter::isOpen() const {
+  return mFile.is_open();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TraceWriter::write(uint64_t frame, FrameStatistics const& s) {
+  if (!mFile.is_open()) {
+    return;
+  }
+
+  if (mIsJSON) {
+    mFile << "{\"frame\":" << frame << ",\"positionTime\":" << s.mPositionTime
+          << ",\"cullingTime\":" << s.mCullingTime << ",\"declutterTime\":" << s.mDeclutterTime
+          << ",\"commitTime\":" << s.mCommitTime << ",\"flushTime\":" << s.mFlushTime
+          << ",\"labels\":" << s.mLabelCount << ",\"updated\":" << s.mUpdatedCount
+          << ",\"culled\":" << s.mCulledCount << ",\"visible\":" << s.mVisibleCount
+          << ",\"pairTests\":" << s.mPairTestCount
+          << ",\"sceneGraphMutations\":" << s.mSceneGraphMutations
+          << ",\"transformCacheHits\":" << s.mTransformCacheHits
+          << ",\"transformCacheMisses\":" << s.mTransformCacheMisses
+          << ",\"prefetchHits\":" << s.mPrefetchHits << ",\"prefetchMisses\":" << s.mPrefetchMisses
+          << ",\"mainMemory\":" << s.mMainMemory << ",\"textureMemory\":" << s.mTextureMemory
+          << "}\n";
+  } else {
+    mFile << frame << "," << s.mPositionTime << "," << s.mCullingTime << "," << s.mDeclutterTime
+          << "," << s.mCommitTime << "," << s.mFlushTime << "," << s.mLabelCount << ","
+          << s.mUpdatedCount << "," << s.mCulledCount << "," << s.mVisibleCount << ","
+          << s.mPairTestCount << "," << s.mSceneGraphMutations << "," << s.mTransformCacheHits
+          << "," << s.mTransformCacheMisses << "," << s.mPrefetchHits << "," << s.mPrefetchMisses
+          << "," << s.mMainMemory << "," << s.mTextureMemory << "\n";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
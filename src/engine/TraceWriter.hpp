@@ -0,0 +1,84 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_ENGINE_TRACE_WRITER_HPP
+#define CSP_ANCHOR_LABELS_ENGINE_TRACE_WRITER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+namespace csp::anchorlabels {
+
+/// What the plugin did in one frame. All durations are in milliseconds. If the declutter pass is
+/// pipelined, the culling and declutter times and counts are those of the background thread for
+/// the result which has been applied in this frame.
+struct FrameStatistics {
+  double mPositionTime  = 0.0; ///< Computing the observer-relative positions of all labels.
+  double mCullingTime   = 0.0; ///< Frustum and occlusion culling.
+  double mDeclutterTime = 0.0; ///< The overlap test and the sort key allocation.
+  double mCommitTime    = 0.0; ///< Binding visuals to labels and recording their state.
+  double mFlushTime     = 0.0; ///< Applying the recorded state to the scene graph and the GUI.
+
+  std::size_t mLabelCount          = 0;
+  std::size_t mUpdatedCount        = 0; ///< Labels whose position was computed, not extrapolated.
+  std::size_t mCulledCount         = 0;
+  std::size_t mVisibleCount        = 0;
+  std::size_t mPairTestCount       = 0;
+  std::size_t mSceneGraphMutations = 0;
+
+  /// Frame transformations answered by the TransformCache and the EphemerisPrefetcher and the ones
+  /// which had to be computed or were not covered by the samples.
+  uint64_t mTransformCacheHits   = 0;
+  uint64_t mTransformCacheMisses = 0;
+  uint64_t mPrefetchHits         = 0;
+  uint64_t mPrefetchMisses       = 0;
+
+  /// The estimated memory used by the plugin in bytes, see Plugin::getMemoryUsage().
+  std::size_t mMainMemory    = 0;
+  std::size_t mTextureMemory = 0;
+};
+
+/// Adds the time between its construction and its destruction to the given duration in
+/// milliseconds.
+class ScopedDuration {
+ public:
+  explicit ScopedDuration(double& duration);
+
+  ScopedDuration(ScopedDuration const& other) = delete;
+  ScopedDuration(ScopedDuration&& other)      = delete;
+
+  ScopedDuration& operator=(ScopedDuration const& other) = delete;
+  ScopedDuration& operator=(ScopedDuration&& other) = delete;
+
+  ~ScopedDuration();
+
+ private:
+  double&                               mDuration;
+  std::chrono::steady_clock::time_point mStart;
+};
+
+/// Writes one line of FrameStatistics per frame to a file. If the file name ends with ".json",
+/// each line is a JSON object. Else the file is written as CSV with a header line.
+class TraceWriter {
+ public:
+  /// Closes the current file and opens the given one. An existing file is overwritten. Returns
+  /// false if the file could not be opened.
+  bool open(std::string const& fileName);
+  void close();
+  bool isOpen() const;
+
+  void write(uint64_t frame, FrameStatistics const& statistics);
+
+ private:
+  std::ofstream mFile;
+  bool          mIsJSON = false;
+};
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_ENGINE_TRACE_WRITER_HPP
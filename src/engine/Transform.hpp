@@ -0,0 +1,19 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_ENGINE_TRANSFORM_HPP
+#define CSP_ANCHOR_LABELS_ENGINE_TRANSFORM_HPP
+
+#include <array>
+
+namespace csp::anchorlabels {
+
+/// A column-major 4x4 matrix, which has the same memory layout as a glm::dmat4.
+using Transform = std::array<double, 16>;
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_ENGINE_TRANSFORM_HPP
@@ -0,0 +1,82 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "TransformCache.hpp"
+
+#include <mutex>
+
+namespace csp::anchorlabels {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Transform TransformCache::get(std::string const& center, std::string const& frame, double time,
+    std::function<Transform()> const& compute) {
+  Key key{center, frame, time};
+
+  {
+    std::shared_lock<std::shared_mutex> lock(mMutex);
+    auto                                entry = mEntries.find(key);
+    if (entry != mEntries.end()) {
+      ++mHits;
+      return entry->second;
+    }
+  }
+
+  ++mMisses;
+  Transform transform = compute();
+
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  mEntries.emplace(std::move(key), transform);
+
+  return transform;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TransformCache::clear() {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  mEntries.clear();
+  mHits   = 0;
+  mMisses = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t TransformCache::getHits() const {
+  return mHits;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t TransformCache::getMisses() const {
+  return mMisses;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t TransformCache::getSize() const {
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  return mEntries.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TransformCache::Key::operator==(Key const& other) const {
+  return mTime == other.mTime && mCenter == other.mCenter && mFrame == other.mFrame;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t TransformCache::KeyHash::operator()(Key const& key) const {
+  std::size_t hash = std::hash<std::string>()(key.mCenter);
+  hash ^= std::hash<std::string>()(key.mFrame) + 0x9e3779b9 + (hash << 6U) + (hash >> 2U);
+  hash ^= std::hash<double>()(key.mTime) + 0x9e3779b9 + (hash << 6U) + (hash >> 2U);
+  return hash;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
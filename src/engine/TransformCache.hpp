@@ -0,0 +1,67 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_ENGINE_TRANSFORM_CACHE_HPP
+#define CSP_ANCHOR_LABELS_ENGINE_TRANSFORM_CACHE_HPP
+
+#include "Transform.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace csp::anchorlabels {
+
+/// Caches the observer-relative transformations of SPICE frames. Many labels share the same center
+/// and frame, and each label needs its transformation more than once per frame. With this cache,
+/// each transformation is computed only once per frame. The cache has to be cleared whenever the
+/// observer changes. It may be used from several threads at the same time.
+class TransformCache {
+ public:
+  /// Returns the cached transformation for the given center, frame and simulation time. If there is
+  /// none, compute() is called and its result is stored. The compute function is called without
+  /// holding any lock, so it may happen that two threads compute the same entry at the same time.
+  Transform get(std::string const& center, std::string const& frame, double time,
+      std::function<Transform()> const& compute);
+
+  /// Removes all entries. The hit and miss counters are reset as well.
+  void clear();
+
+  /// The number of calls to get() since the last clear() which were answered from the cache.
+  uint64_t getHits() const;
+
+  /// The number of calls to get() since the last clear() which required a call to compute().
+  uint64_t getMisses() const;
+
+  /// The number of stored transformations.
+  std::size_t getSize() const;
+
+ private:
+  struct Key {
+    std::string mCenter;
+    std::string mFrame;
+    double      mTime;
+
+    bool operator==(Key const& other) const;
+  };
+
+  struct KeyHash {
+    std::size_t operator()(Key const& key) const;
+  };
+
+  mutable std::shared_mutex                   mMutex;
+  std::unordered_map<Key, Transform, KeyHash> mEntries;
+
+  std::atomic<uint64_t> mHits{0};
+  std::atomic<uint64_t> mMisses{0};
+};
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_ENGINE_TRANSFORM_CACHE_HPP
@@ -0,0 +1,72 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_ENGINE_TRIPLE_BUFFER_HPP
+#define CSP_ANCHOR_LABELS_ENGINE_TRIPLE_BUFFER_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace csp::anchorlabels {
+
+/// Passes objects from one producer thread to one consumer thread without locks and without
+/// copying. The producer fills the write buffer and publishes it, the consumer fetches the most
+/// recently published buffer. Neither of them ever waits for the other one: If the producer is
+/// faster, buffers which have not been fetched are overwritten. The third buffer is the one which
+/// has been published last. Buffers are reused, so their allocations survive from one round to
+/// the next.
+template <typename T>
+class TripleBuffer {
+ public:
+  /// The buffer which is published by the next call to publish(). Only the producer may use it.
+  T& getWriteBuffer() {
+    return mBuffers[mWriteIndex];
+  }
+
+  /// Hands the write buffer to the consumer and returns a new write buffer. This contains what has
+  /// been written to it two rounds ago. Returns false if the previously published buffer has not
+  /// been fetched and is overwritten now.
+  bool publish() {
+    uint8_t const previous = mShared.exchange(mWriteIndex | FRESH, std::memory_order_acq_rel);
+    mWriteIndex            = previous & INDEX;
+    return (previous & FRESH) == 0;
+  }
+
+  /// Makes the most recently published buffer the read buffer. Returns false if nothing has been
+  /// published since the last call, in which case the read buffer stays the same.
+  bool fetch() {
+    if ((mShared.load(std::memory_order_relaxed) & FRESH) == 0) {
+      return false;
+    }
+
+    uint8_t const previous = mShared.exchange(mReadIndex, std::memory_order_acq_rel);
+    mReadIndex             = previous & INDEX;
+    return true;
+  }
+
+  /// The buffer returned by the last call to fetch(). Only the consumer may use it.
+  T& getReadBuffer() {
+    return mBuffers[mReadIndex];
+  }
+
+  T const& getReadBuffer() const {
+    return mBuffers[mReadIndex];
+  }
+
+ private:
+  static uint8_t const INDEX = 3;
+  static uint8_t const FRESH = 4;
+
+  std::array<T, 3>     mBuffers;
+  uint8_t              mWriteIndex = 0;
+  uint8_t              mReadIndex  = 1;
+  std::atomic<uint8_t> mShared{2};
+};
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_ENGINE_TRIPLE_BUFFER_HPP
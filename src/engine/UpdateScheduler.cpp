@@ -0,0 +1,214 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "UpdateScheduler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace csp::anchorlabels {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void UpdateScheduler::invalidate() {
+  mInvalid = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void UpdateScheduler::remap(std::vector<std::size_t> const& previousLabels) {
+  std::size_t const count = previousLabels.size();
+
+  std::vector<Vector>   positions(count);
+  std::vector<Vector>   velocities(count);
+  std::vector<uint64_t> lastUpdates(count);
+  std::vector<uint64_t> nextUpdates(count);
+  std::vector<uint8_t>  hasPosition(count, 0);
+
+  if (!mInvalid) {
+    for (std::size_t i = 0; i < count; ++i) {
+      std::size_t const previous = previousLabels[i];
+      if (previous < mPositions.size()) {
+        positions[i]   = mPositions[previous];
+        velocities[i]  = mVelocities[previous];
+        lastUpdates[i] = mLastUpdates[previous];
+        nextUpdates[i] = mNextUpdates[previous];
+        hasPosition[i] = mHasPosition[previous];
+      }
+    }
+  }
+
+  mPositions.swap(positions);
+  mVelocities.swap(velocities);
+  mLastUpdates.swap(lastUpdates);
+  mNextUpdates.swap(nextUpdates);
+  mHasPosition.swap(hasPosition);
+  mRequested.assign(count, 0);
+  mInvalid = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void UpdateScheduler::request(std::size_t label) {
+  if (label < mRequested.size()) {
+    mRequested[label] = 1;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<std::size_t> const& UpdateScheduler::schedule(std::size_t labelCount,
+    Transform const& observerToScheduler, bool force, SchedulerSettings const& settings) {
+
+  if (mInvalid || labelCount != mPositions.size()) {
+    mPositions.resize(labelCount);
+    mVelocities.resize(labelCount);
+    mLastUpdates.resize(labelCount);
+    mNextUpdates.resize(labelCount);
+    mHasPosition.assign(labelCount, 0);
+    mRequested.assign(labelCount, 0);
+    mInvalid = false;
+  }
+
+  ++mFrame;
+  mSettings    = settings;
+  mToScheduler = observerToScheduler;
+
+  // The inverse of the upper 3x3 part. The translation is ignored.
+  auto const&  m   = mToScheduler;
+  double const c0  = m[5] * m[10] - m[9] * m[6];
+  double const c1  = m[9] * m[2] - m[1] * m[10];
+  double const c2  = m[1] * m[6] - m[5] * m[2];
+  double const det = m[0] * c0 + m[4] * c1 + m[8] * c2;
+  double const f   = det != 0.0 ? 1.0 / det : 0.0;
+
+  mToObserver     = {};
+  mToObserver[0]  = c0 * f;
+  mToObserver[1]  = c1 * f;
+  mToObserver[2]  = c2 * f;
+  mToObserver[4]  = (m[8] * m[6] - m[4] * m[10]) * f;
+  mToObserver[5]  = (m[0] * m[10] - m[8] * m[2]) * f;
+  mToObserver[6]  = (m[4] * m[2] - m[0] * m[6]) * f;
+  mToObserver[8]  = (m[4] * m[9] - m[8] * m[5]) * f;
+  mToObserver[9]  = (m[8] * m[1] - m[0] * m[9]) * f;
+  mToObserver[10] = (m[0] * m[5] - m[4] * m[1]) * f;
+  mToObserver[15] = 1.0;
+
+  // Labels without a position are always updated, as there is nothing to extrapolate. Requested
+  // labels come first if the budget is exhausted, then the labels which are overdue the longest.
+  bool const all = force || !settings.mEnabled;
+
+  mDue.clear();
+  std::size_t mandatoryCount = 0;
+
+  for (std::size_t i = 0; i < labelCount; ++i) {
+    if (all || !mHasPosition[i]) {
+      mDue.push_back(i);
+      ++mandatoryCount;
+    } else if (mRequested[i] || mNextUpdates[i] <= mFrame) {
+      mDue.push_back(i);
+    }
+  }
+
+  if (!all && settings.mMaxUpdates > 0 && mDue.size() > settings.mMaxUpdates) {
+    std::size_t const budget = std::max<std::size_t>(settings.mMaxUpdates, mandatoryCount);
+
+    std::nth_element(mDue.begin(), mDue.begin() + budget, mDue.end(),
+        [this](std::size_t a, std::size_t b) {
+          if (mHasPosition[a] != mHasPosition[b]) {
+            return mHasPosition[a] < mHasPosition[b];
+          }
+          if (mRequested[a] != mRequested[b]) {
+            return mRequested[a] > mRequested[b];
+          }
+          return mNextUpdates[a] < mNextUpdates[b];
+        });
+
+    mDue.resize(budget);
+  }
+
+  std::fill(mRequested.begin(), mRequested.end(), 0);
+
+  return mDue;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void UpdateScheduler::setPosition(std::size_t label, double x, double y, double z) {
+  Vector const p = toScheduler(x, y, z);
+
+  // The interval is chosen so that the label moves by about mMaxAngle between two updates. The
+  // first update only provides a position, so the label is updated again in the next frame to
+  // get its velocity.
+  uint32_t interval = 1;
+
+  if (mHasPosition[label]) {
+    Vector const& last = mPositions[label];
+    auto const    dt   = static_cast<double>(mFrame - mLastUpdates[label]);
+
+    Vector v{(p.mX - last.mX) / dt, (p.mY - last.mY) / dt, (p.mZ - last.mZ) / dt};
+
+    double const speed    = std::sqrt(v.mX * v.mX + v.mY * v.mY + v.mZ * v.mZ);
+    double const distance = std::sqrt(p.mX * p.mX + p.mY * p.mY + p.mZ * p.mZ);
+    double const frames   = mSettings.mMaxAngle * distance / speed;
+
+    // This is false for NaN as well.
+    interval = frames < mSettings.mMaxInterval ? static_cast<uint32_t>(std::max(frames, 1.0))
+                                                 : mSettings.mMaxInterval;
+
+    mVelocities[label] = v;
+  } else {
+    mVelocities[label] = {0.0, 0.0, 0.0};
+  }
+
+  mPositions[label]   = p;
+  mLastUpdates[label] = mFrame;
+  mNextUpdates[label] = mFrame + std::max<uint32_t>(interval, 1);
+  mHasPosition[label] = 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void UpdateScheduler::extrapolate(LabelStore& labels) const {
+  std::size_t const count = std::min(labels.size(), mPositions.size());
+
+  for (std::size_t i = 0; i < count; ++i) {
+    if (!mHasPosition[i]) {
+      continue;
+    }
+
+    auto const    dt = static_cast<double>(mFrame - mLastUpdates[i]);
+    Vector const& p  = mPositions[i];
+    Vector const& v  = mVelocities[i];
+
+    Vector const position =
+        toObserver({p.mX + v.mX * dt, p.mY + v.mY * dt, p.mZ + v.mZ * dt});
+
+    labels.mPositionX[i] = position.mX;
+    labels.mPositionY[i] = position.mY;
+    labels.mPositionZ[i] = position.mZ;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+UpdateScheduler::Vector UpdateScheduler::toScheduler(double x, double y, double z) const {
+  auto const& m = mToScheduler;
+  return {m[0] * x + m[4] * y + m[8] * z, m[1] * x + m[5] * y + m[9] * z,
+      m[2] * x + m[6] * y + m[10] * z};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+UpdateScheduler::Vector UpdateScheduler::toObserver(Vector const& v) const {
+  auto const& m = mToObserver;
+  return {m[0] * v.mX + m[4] * v.mY + m[8] * v.mZ, m[1] * v.mX + m[5] * v.mY + m[9] * v.mZ,
+      m[2] * v.mX + m[6] * v.mY + m[10] * v.mZ};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
@@ -0,0 +1,102 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_ENGINE_UPDATE_SCHEDULER_HPP
+#define CSP_ANCHOR_LABELS_ENGINE_UPDATE_SCHEDULER_HPP
+
+#include "LabelStore.hpp"
+#include "Transform.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace csp::anchorlabels {
+
+/// The subset of the plugin settings which influences the update scheduling.
+struct SchedulerSettings {
+  /// See Plugin::Settings::mScheduleUpdates. If this is false, all labels are updated each frame.
+  bool mEnabled = true;
+
+  /// A label is updated again once it has moved by roughly this angle in radians, as seen from the
+  /// observer. In between, its position is extrapolated.
+  double mMaxAngle = 0.005;
+
+  /// Labels are updated at least every mMaxInterval frames.
+  uint32_t mMaxInterval = 60;
+
+  /// See Plugin::Settings::mMaxLabelUpdates. Zero means no limit.
+  uint32_t mMaxUpdates = 0;
+};
+
+/// The UpdateScheduler decides which labels are fully updated in a frame. Labels which move
+/// quickly across the screen are updated every frame, while labels of distant bodies may be
+/// updated only every few frames. The positions of all other labels are extrapolated linearly.
+///
+/// The positions are stored in a space which does not rotate or scale with the observer, so that
+/// turning or zooming does not require any label to be updated. Only the translation between the
+/// observer and the labels is extrapolated.
+class UpdateScheduler {
+ public:
+  /// Must be called whenever labels are added or removed. All labels are updated in the next
+  /// frame then.
+  void invalidate();
+
+  /// Keeps the schedule of labels which still exist after labels have been added or removed.
+  /// previousLabels contains the previous index of each label, or an index out of range for new
+  /// labels. These are updated in the next frame.
+  void remap(std::vector<std::size_t> const& previousLabels);
+
+  /// Makes sure that the given label is updated in the next call to schedule(), even if the
+  /// budget is exhausted. This is used for labels which are currently shown.
+  void request(std::size_t label);
+
+  /// Starts a new frame and returns the labels which have to be updated in it. The given matrix
+  /// transforms observer-relative positions to the space in which the positions are extrapolated.
+  /// It must not contain a translation. If force is set, all labels are updated.
+  std::vector<std::size_t> const& schedule(std::size_t labelCount,
+      Transform const& observerToScheduler, bool force, SchedulerSettings const& settings);
+
+  /// Stores the exact observer-relative position of a label which has been updated in this frame.
+  /// This may be called for different labels in parallel.
+  void setPosition(std::size_t label, double x, double y, double z);
+
+  /// Writes the observer-relative positions of all labels to the store. Labels which were updated
+  /// in this frame get their exact position, all others an extrapolated one.
+  void extrapolate(LabelStore& labels) const;
+
+ private:
+  struct Vector {
+    double mX;
+    double mY;
+    double mZ;
+  };
+
+  Vector toScheduler(double x, double y, double z) const;
+  Vector toObserver(Vector const& v) const;
+
+  uint64_t          mFrame = 0;
+  SchedulerSettings mSettings;
+  bool              mInvalid = true;
+
+  Transform mToScheduler{};
+  Transform mToObserver{};
+
+  /// The last exact position and the velocity per frame of each label in scheduler space.
+  std::vector<Vector> mPositions;
+  std::vector<Vector> mVelocities;
+
+  /// The frame in which each label has been updated last and the frame in which it is due again.
+  std::vector<uint64_t> mLastUpdates;
+  std::vector<uint64_t> mNextUpdates;
+  std::vector<uint8_t>  mHasPosition;
+  std::vector<uint8_t>  mRequested;
+
+  std::vector<std::size_t> mDue;
+};
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_ENGINE_UPDATE_SCHEDULER_HPP
@@ -0,0 +1,385 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ViewDeclutter.hpp"
+
+#include "MemoryUsage.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace csp::anchorlabels {
+
+namespace {
+uint8_t const NO_VIEW = std::numeric_limits<uint8_t>::max();
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t const ViewDeclutter::MAX_VIEWS;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool View::operator==(View const& other) const {
+  return mModelView == other.mModelView && mProjection == other.mProjection;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool View::operator!=(View const& other) const {
+  return !(*this == other);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ViewDeclutter::setViews(std::vector<View> const& views) {
+  std::size_t const count = std::clamp<std::size_t>(views.size(), 1, MAX_VIEWS);
+
+  while (mViews.size() > count) {
+    mViews.pop_back();
+  }
+
+  while (mViews.size() < count) {
+    mViews.push_back(std::make_unique<ViewState>());
+  }
+
+  for (std::size_t i = 0; i < count && i < views.size(); ++i) {
+    mViews[i]->mView = views[i];
+  }
+
+  if (views.empty()) {
+    mViews[0]->mView = View();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t ViewDeclutter::getViewCount() const {
+  return std::max<std::size_t>(mViews.size(), 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ViewDeclutter::remapLabels(std::vector<std::size_t> const& previousLabels) {
+  for (auto& view : mViews) {
+    view->mEngine.remapLabels(previousLabels);
+  }
+
+  mSortKeyAllocator.remap(previousLabels);
+  mKeepSortKeys = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ViewDeclutter::cull(LabelStore const& labels, double radiusScale,
+    CullingSettings const& settings, WorkerPool& pool) {
+
+  if (mViews.empty()) {
+    setViews({});
+  }
+
+  // Each view is processed by one thread. The views do not share any mutable state.
+  pool.parallelFor(
+      mViews.size(),
+      [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+          cullView(*mViews[i], labels, radiusScale, settings);
+        }
+      },
+      1);
+
+  mDistances.resize(labels.size());
+  for (std::size_t i = 0; i < labels.size(); ++i) {
+    mDistances[i] = std::sqrt(labels.mPositionX[i] * labels.mPositionX[i] +
+                              labels.mPositionY[i] * labels.mPositionY[i] +
+                              labels.mPositionZ[i] * labels.mPositionZ[i]);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool ViewDeclutter::update(double labelScale, double width, double height,
+    DeclutterSettings const& settings, WorkerPool& pool) {
+
+  // The sort keys are only allocated by merge().
+  DeclutterSettings viewSettings = settings;
+  viewSettings.mAllocateSortKeys = false;
+
+  pool.parallelFor(
+      mViews.size(),
+      [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+          mViews[i]->mStore.project(labelScale, width, height);
+          mViews[i]->mChanged = mViews[i]->mEngine.update(mViews[i]->mStore, viewSettings);
+        }
+      },
+      1);
+
+  bool changed = mViewMasks.size() != mDistances.size();
+  for (auto const& view : mViews) {
+    changed = changed || view->mChanged;
+  }
+
+  if (changed) {
+    merge(settings);
+  }
+
+  return changed;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<std::size_t> const& ViewDeclutter::getVisibleLabels() const {
+  return mVisibleLabels;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<int> const& ViewDeclutter::getSortKeys() const {
+  return mSortKeys;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t ViewDeclutter::getViewMask(std::size_t label) const {
+  return label < mViewMasks.size() ? mViewMasks[label] : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool ViewDeclutter::isVisible(std::size_t label) const {
+  return getViewMask(label) != 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t ViewDeclutter::getClusterSize(std::size_t label) const {
+  if (!isVisible(label)) {
+    return 0;
+  }
+
+  return mViews[mPrimaryViews[label]]->mEngine.getClusterSize(label);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+LabelPlacement ViewDeclutter::getPlacement(std::size_t label) const {
+  if (!isVisible(label)) {
+    return LabelPlacement::eDefault;
+  }
+
+  return mViews[mPrimaryViews[label]]->mEngine.getPlacement(label);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DeclutterEngine const& ViewDeclutter::getEngine(std::size_t view) const {
+  return mViews[view]->mEngine;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+LabelStore const& ViewDeclutter::getStore(std::size_t view) const {
+  return mViews[view]->mStore;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t ViewDeclutter::getCulledCount() const {
+  std::size_t count = 0;
+  for (auto const& view : mViews) {
+    count += view->mCuller.getCulledCount();
+  }
+  return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t ViewDeclutter::getPairTestCount() const {
+  std::size_t count = 0;
+  for (auto const& view : mViews) {
+    count += view->mEngine.getPairTestCount();
+  }
+  return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t ViewDeclutter::getMemoryUsage() const {
+  std::size_t bytes = csp::anchorlabels::getMemoryUsage(mDistances) +
+                      csp::anchorlabels::getMemoryUsage(mViewMasks) +
+                      csp::anchorlabels::getMemoryUsage(mPrimaryViews) +
+                      csp::anchorlabels::getMemoryUsage(mVisibleLabels) +
+                      csp::anchorlabels::getMemoryUsage(mSortKeys);
+
+  for (auto const& view : mViews) {
+    bytes += view->mStore.getMemoryUsage() + view->mEngine.getMemoryUsage();
+  }
+
+  return bytes;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ViewDeclutter::cullView(ViewState& state, LabelStore const& labels, double radiusScale,
+    CullingSettings const& settings) const {
+
+  std::size_t const count = labels.size();
+  Transform const&  m     = state.mView.mModelView;
+  LabelStore&       store = state.mStore;
+
+  store.resize(count);
+
+  // The labels are moved to the eye of the view, so that the culler only needs the projection and
+  // the boxes are computed as seen from this eye.
+  for (std::size_t i = 0; i < count; ++i) {
+    double const x = labels.mPositionX[i];
+    double const y = labels.mPositionY[i];
+    double const z = labels.mPositionZ[i];
+
+    store.mPositionX[i] = m[0] * x + m[4] * y + m[8] * z + m[12];
+    store.mPositionY[i] = m[1] * x + m[5] * y + m[9] * z + m[13];
+    store.mPositionZ[i] = m[2] * x + m[6] * y + m[10] * z + m[14];
+    store.mPriority[i]  = labels.mPriority[i];
+    store.mRadius[i]    = labels.mRadius[i];
+    store.mBodyId[i]    = labels.mBodyId[i];
+    store.mFlags[i]     = static_cast<uint8_t>(labels.mFlags[i] & eHidden);
+  }
+
+  state.mCuller.setViewProjection(state.mView.mProjection);
+  state.mCuller.cull(store, radiusScale, settings);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ViewDeclutter::merge(DeclutterSettings const& settings) {
+  std::size_t const count = mDistances.size();
+
+  // The label indices may refer to different labels now, unless the keys have been remapped.
+  if (count != mViewMasks.size() && !mKeepSortKeys) {
+    mSortKeyAllocator.reset();
+  }
+  mKeepSortKeys = false;
+
+  mViewMasks.assign(count, 0);
+  mPrimaryViews.assign(count, NO_VIEW);
+
+  for (std::size_t v = 0; v < mViews.size(); ++v) {
+    for (std::size_t label : mViews[v]->mEngine.getVisibleLabels()) {
+      mViewMasks[label] |= 1U << v;
+
+      if (mPrimaryViews[label] == NO_VIEW) {
+        mPrimaryViews[label] = static_cast<uint8_t>(v);
+      }
+    }
+  }
+
+  std::vector<std::pair<double, std::size_t>> distances;
+  for (std::size_t i = 0; i < count; ++i) {
+    if (mViewMasks[i] != 0) {
+      distances.emplace_back(mDistances[i], i);
+    }
+  }
+
+  std::sort(distances.begin(), distances.end());
+
+  mVisibleLabels.resize(distances.size());
+  for (std::size_t i = 0; i < distances.size(); ++i) {
+    mVisibleLabels[i] = distances[i].second;
+  }
+
+  mSortKeyAllocator.allocate(
+      mVisibleLabels, settings.mMaxSortKey, settings.mSortKeyRange, mSortKeys);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DeclutterResult::assign(ViewDeclutter const& declutter) {
+  mVisibleLabels = declutter.getVisibleLabels();
+  mSortKeys      = declutter.getSortKeys();
+
+  mClusterSizes.resize(mVisibleLabels.size());
+  mPlacements.resize(mVisibleLabels.size());
+  mViewMasks.resize(mVisibleLabels.size());
+
+  for (std::size_t i = 0; i < mVisibleLabels.size(); ++i) {
+    mClusterSizes[i] = declutter.getClusterSize(mVisibleLabels[i]);
+    mPlacements[i]   = declutter.getPlacement(mVisibleLabels[i]);
+    mViewMasks[i]    = declutter.getViewMask(mVisibleLabels[i]);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DeclutterResult::remapLabels(std::vector<std::size_t> const& previousLabels) {
+  std::size_t const noLabel = std::numeric_limits<std::size_t>::max();
+
+  // The previous index of each label is inverted, so that each visible label can be looked up.
+  std::vector<std::size_t> newLabels;
+  for (std::size_t i = 0; i < previousLabels.size(); ++i) {
+    if (previousLabels[i] == noLabel) {
+      continue;
+    }
+
+    if (previousLabels[i] >= newLabels.size()) {
+      newLabels.resize(previousLabels[i] + 1, noLabel);
+    }
+    newLabels[previousLabels[i]] = i;
+  }
+
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < mVisibleLabels.size(); ++i) {
+    std::size_t const label = mVisibleLabels[i];
+    if (label >= newLabels.size() || newLabels[label] == noLabel) {
+      continue;
+    }
+
+    mVisibleLabels[count] = newLabels[label];
+    mSortKeys[count]      = mSortKeys[i];
+    mClusterSizes[count]  = mClusterSizes[i];
+    mPlacements[count]    = mPlacements[i];
+    mViewMasks[count]     = mViewMasks[i];
+    ++count;
+  }
+
+  mVisibleLabels.resize(count);
+  mSortKeys.resize(count);
+  mClusterSizes.resize(count);
+  mPlacements.resize(count);
+  mViewMasks.resize(count);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DeclutterResult::clear() {
+  mVisibleLabels.clear();
+  mSortKeys.clear();
+  mClusterSizes.clear();
+  mPlacements.clear();
+  mViewMasks.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t DeclutterResult::size() const {
+  return mVisibleLabels.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t DeclutterResult::getMemoryUsage() const {
+  return csp::anchorlabels::getMemoryUsage(mVisibleLabels) +
+         csp::anchorlabels::getMemoryUsage(mSortKeys) +
+         csp::anchorlabels::getMemoryUsage(mClusterSizes) +
+         csp::anchorlabels::getMemoryUsage(mPlacements) +
+         csp::anchorlabels::getMemoryUsage(mViewMasks);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
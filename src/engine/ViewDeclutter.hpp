@@ -0,0 +1,154 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_ENGINE_VIEW_DECLUTTER_HPP
+#define CSP_ANCHOR_LABELS_ENGINE_VIEW_DECLUTTER_HPP
+
+#include "Culler.hpp"
+#include "DeclutterEngine.hpp"
+#include "LabelStore.hpp"
+#include "SortKeyAllocator.hpp"
+#include "Transform.hpp"
+#include "WorkerPool.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace csp::anchorlabels {
+
+/// A view from which the labels are seen, for example one eye of a stereo setup, one window of a
+/// multi-display installation or one viewport of a cluster node.
+struct View {
+  /// The column-major matrix which transforms observer-relative positions to the eye of the view.
+  Transform mModelView{
+      1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0};
+
+  /// The column-major projection matrix of the view. If there is none, only labels behind the eye
+  /// are culled.
+  std::optional<Transform> mProjection;
+
+  bool operator==(View const& other) const;
+  bool operator!=(View const& other) const;
+};
+
+/// The ViewDeclutter runs the Culler and the DeclutterEngine for each view separately, so that
+/// labels do not overlap in any of them. The views are processed in parallel. Each view keeps its
+/// own incremental state, so the views should be passed in the same order in each frame.
+///
+/// The results are merged into one list of labels which are visible in at least one view. For
+/// each of them, a bit mask tells in which views it should be drawn. The cluster size and the
+/// placement are taken from the first view in which the label is visible. The sort keys are
+/// allocated for the merged list, so that they follow the distance to the observer in all views.
+class ViewDeclutter {
+ public:
+  /// The view masks have one bit per view, so only this many views are decluttered. Further views
+  /// should draw all labels which are visible in any view.
+  static std::size_t const MAX_VIEWS = 32;
+
+  /// Sets the views for the next call to update(). If there are none, a single view at the
+  /// observer without projection is used. Views which have been set before keep their state.
+  void setViews(std::vector<View> const& views);
+
+  std::size_t getViewCount() const;
+
+  /// See DeclutterEngine::remapLabels().
+  void remapLabels(std::vector<std::size_t> const& previousLabels);
+
+  /// Moves the labels to the eye of each view and culls them there. The positions in the store have
+  /// to be relative to the observer. Only the positions, priorities, radii and the eHidden flags
+  /// are used. The views are distributed to the given pool.
+  void cull(LabelStore const& labels, double radiusScale, CullingSettings const& settings,
+      WorkerPool& pool);
+
+  /// Computes the boxes of the labels which were passed to cull() and declutters them for each
+  /// view. Returns false if the result did not change in any view.
+  bool update(double labelScale, double width, double height, DeclutterSettings const& settings,
+      WorkerPool& pool);
+
+  /// The labels which are visible in at least one view, sorted by increasing distance to the
+  /// observer.
+  std::vector<std::size_t> const& getVisibleLabels() const;
+
+  /// The sort keys for all labels returned by getVisibleLabels(), in the same order.
+  std::vector<int> const& getSortKeys() const;
+
+  /// Bit i is set if the label should be drawn in view i. This is zero for labels which are not
+  /// visible in any view.
+  uint32_t getViewMask(std::size_t label) const;
+
+  bool           isVisible(std::size_t label) const;
+  std::size_t    getClusterSize(std::size_t label) const;
+  LabelPlacement getPlacement(std::size_t label) const;
+
+  /// The result of a single view.
+  DeclutterEngine const& getEngine(std::size_t view) const;
+  LabelStore const&      getStore(std::size_t view) const;
+
+  /// These are summed over all views.
+  std::size_t getCulledCount() const;
+  std::size_t getPairTestCount() const;
+
+  /// The number of bytes reserved for the per-label buffers of all views.
+  std::size_t getMemoryUsage() const;
+
+ private:
+  struct ViewState {
+    View            mView;
+    LabelStore      mStore;
+    Culler          mCuller;
+    DeclutterEngine mEngine;
+    bool            mChanged = false;
+  };
+
+  void cullView(ViewState& state, LabelStore const& labels, double radiusScale,
+      CullingSettings const& settings) const;
+  void merge(DeclutterSettings const& settings);
+
+  std::vector<std::unique_ptr<ViewState>> mViews;
+
+  /// The distances of the labels to the observer, which define the order of mVisibleLabels.
+  std::vector<double> mDistances;
+
+  std::vector<uint32_t>    mViewMasks;
+  std::vector<uint8_t>     mPrimaryViews; ///< The first view in which each label is visible.
+  std::vector<std::size_t> mVisibleLabels;
+  std::vector<int>         mSortKeys;
+
+  /// The sort keys of the engines of the views are not used, as they are only ordered within
+  /// their view.
+  SortKeyAllocator mSortKeyAllocator;
+  bool             mKeepSortKeys = false;
+};
+
+/// A copy of everything the plugin needs from a ViewDeclutter to draw the labels. All vectors
+/// have one entry per visible label, sorted by increasing distance to the observer. This can be
+/// passed to another thread and be kept while the labels are added and removed.
+struct DeclutterResult {
+  std::vector<std::size_t>    mVisibleLabels;
+  std::vector<int>            mSortKeys;
+  std::vector<std::size_t>    mClusterSizes;
+  std::vector<LabelPlacement> mPlacements;
+  std::vector<uint32_t>       mViewMasks;
+
+  /// Replaces the contents with the current result of the given ViewDeclutter.
+  void assign(ViewDeclutter const& declutter);
+
+  /// Changes the label indices like ViewDeclutter::remapLabels(). Labels which do not exist
+  /// anymore are removed.
+  void remapLabels(std::vector<std::size_t> const& previousLabels);
+
+  void        clear();
+  std::size_t size() const;
+
+  /// The bytes reserved for the result.
+  std::size_t getMemoryUsage() const;
+};
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_ENGINE_VIEW_DECLUTTER_HPP
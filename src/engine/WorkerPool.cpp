@@ -0,0 +1,170 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+
+namespace csp::anchorlabels {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+WorkerPool::WorkerPool(std::size_t threadCount) {
+  setThreadCount(threadCount);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+WorkerPool::~WorkerPool() {
+  stopThreads();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WorkerPool::setThreadCount(std::size_t threadCount) {
+  stopThreads();
+
+  if (threadCount == 0) {
+    threadCount = std::max(1U, std::thread::hardware_concurrency());
+  }
+
+  // The generation is not reset when the threads are restarted. The new threads have to start
+  // with the current one, as they would run the last loop again otherwise. It is read here, since
+  // a thread which starts late would miss the next loop if it read the generation itself.
+  uint64_t generation = 0;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    generation = mGeneration;
+  }
+
+  // The calling thread is one of the threads.
+  for (std::size_t i = 1; i < threadCount; ++i) {
+    mThreads.emplace_back([this, generation]() { workerLoop(generation); });
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t WorkerPool::getThreadCount() const {
+  return mThreads.size() + 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WorkerPool::parallelFor(std::size_t count,
+    std::function<void(std::size_t, std::size_t)> const& func, std::size_t minChunkSize) {
+  minChunkSize = std::max<std::size_t>(minChunkSize, 1);
+
+  // Small loops are not worth waking up the workers.
+  if (mThreads.empty() || count <= minChunkSize) {
+    if (count > 0) {
+      func(0, count);
+    }
+    return;
+  }
+
+  // Each thread gets several chunks on average, so that threads which are delayed by the operating
+  // system do not stall the entire loop.
+  std::size_t const chunkCount = getThreadCount() * 4;
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFunc      = &func;
+    mCount     = count;
+    mChunkSize = std::max(minChunkSize, (count + chunkCount - 1) / chunkCount);
+    mNextIndex = 0;
+    mException = nullptr;
+
+    mBusyWorkers = mThreads.size();
+    ++mGeneration;
+  }
+
+  mWakeUp.notify_all();
+
+  processChunks();
+
+  std::exception_ptr exception;
+
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mDone.wait(lock, [this]() { return mBusyWorkers == 0; });
+    mFunc     = nullptr;
+    exception = mException;
+  }
+
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WorkerPool::workerLoop(uint64_t generation) {
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  while (true) {
+    mWakeUp.wait(lock, [this, &generation]() { return mStop || mGeneration != generation; });
+
+    if (mStop) {
+      return;
+    }
+
+    generation = mGeneration;
+
+    lock.unlock();
+    processChunks();
+    lock.lock();
+
+    if (--mBusyWorkers == 0) {
+      mDone.notify_one();
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WorkerPool::processChunks() {
+  while (true) {
+    std::size_t begin = mNextIndex.fetch_add(mChunkSize);
+    if (begin >= mCount) {
+      return;
+    }
+
+    try {
+      (*mFunc)(begin, std::min(begin + mChunkSize, mCount));
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mMutex);
+      if (!mException) {
+        mException = std::current_exception();
+      }
+
+      // Skip all remaining chunks.
+      mNextIndex = mCount;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WorkerPool::stopThreads() {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStop = true;
+  }
+
+  mWakeUp.notify_all();
+
+  for (auto& thread : mThreads) {
+    thread.join();
+  }
+
+  mThreads.clear();
+  mStop = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
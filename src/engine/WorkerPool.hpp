@@ -0,0 +1,75 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_ENGINE_WORKER_POOL_HPP
+#define CSP_ANCHOR_LABELS_ENGINE_WORKER_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace csp::anchorlabels {
+
+/// A fixed set of worker threads which execute parallel loops. The calling thread takes part in
+/// the work, so a pool with a thread count of one does not start any additional threads and runs
+/// everything on the calling thread.
+class WorkerPool {
+ public:
+  /// A thread count of zero uses one thread per hardware thread.
+  explicit WorkerPool(std::size_t threadCount = 1);
+
+  WorkerPool(WorkerPool const& other) = delete;
+  WorkerPool(WorkerPool&& other)      = delete;
+
+  WorkerPool& operator=(WorkerPool const& other) = delete;
+  WorkerPool& operator=(WorkerPool&& other) = delete;
+
+  ~WorkerPool();
+
+  /// Stops all worker threads and starts the given number of new ones. A thread count of zero uses
+  /// one thread per hardware thread. Must not be called during parallelFor().
+  void        setThreadCount(std::size_t threadCount);
+  std::size_t getThreadCount() const;
+
+  /// Calls func(begin, end) for consecutive ranges which together cover [0, count). The ranges
+  /// contain at least minChunkSize elements and are processed in parallel. This returns once all
+  /// ranges have been processed. If func throws, the remaining ranges are skipped and the first
+  /// exception is rethrown on the calling thread.
+  void parallelFor(std::size_t count, std::function<void(std::size_t, std::size_t)> const& func,
+      std::size_t minChunkSize = 64);
+
+ private:
+  void workerLoop(uint64_t generation);
+  void processChunks();
+  void stopThreads();
+
+  std::vector<std::thread> mThreads;
+
+  std::mutex              mMutex;
+  std::condition_variable mWakeUp;
+  std::condition_variable mDone;
+
+  // The current loop. These are written by parallelFor() while holding the mutex before the
+  // workers are woken up.
+  std::function<void(std::size_t, std::size_t)> const* mFunc = nullptr;
+  std::size_t                                          mCount     = 0;
+  std::size_t                                          mChunkSize = 1;
+  std::atomic<std::size_t>                             mNextIndex{0};
+  std::exception_ptr                                   mException;
+
+  uint64_t    mGeneration  = 0;
+  std::size_t mBusyWorkers = 0;
+  bool        mStop        = false;
+};
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_ENGINE_WORKER_POOL_HPP
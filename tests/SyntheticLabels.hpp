@@ -0,0 +1,185 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_TESTS_SYNTHETIC_LABELS_HPP
+#define CSP_ANCHOR_LABELS_TESTS_SYNTHETIC_LABELS_HPP
+
+// Synthetic label sets and the original overlap test, shared by the tests and the benchmarks.
+
+#include "../src/engine/DeclutterEngine.hpp"
+#include "../src/engine/LabelStore.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace csp::anchorlabels::synthetic {
+
+// Typical values of the plugin settings and the anchor label GUI area.
+double const LABEL_SCALE  = 1.2;
+double const LABEL_WIDTH  = 120.0;
+double const LABEL_HEIGHT = 30.0;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline void addLabel(
+    LabelStore& store, double x, double y, double z, double priority, uint8_t flags = 0) {
+  std::size_t const i = store.size();
+  store.resize(i + 1);
+  store.mPositionX[i] = x;
+  store.mPositionY[i] = y;
+  store.mPositionZ[i] = z;
+  store.mPriority[i]  = priority;
+  store.mFlags[i]     = flags;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Like in the plugin, the labels have to be sorted by decreasing priority. As the positions are
+// random anyway, only the priorities are sorted.
+inline void sortPriorities(LabelStore& store) {
+  std::sort(store.mPriority.begin(), store.mPriority.end(), std::greater<>());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Creates labels in front of the observer. Distances and priorities are distributed
+// logarithmically, as they are in a real solar system.
+inline void createLabelsInFront(std::size_t count, std::mt19937& rng, LabelStore& store) {
+  std::uniform_real_distribution<double> direction(-1.0, 1.0);
+  std::uniform_real_distribution<double> logDistance(3.0, 12.0);
+  std::uniform_real_distribution<double> logPriority(2.0, 8.0);
+
+  store = LabelStore();
+  for (std::size_t i = 0; i < count; ++i) {
+    double const distance = std::pow(10.0, logDistance(rng));
+    double const x        = direction(rng) * distance;
+    double const y        = direction(rng) * distance;
+    addLabel(store, x, y, -distance, std::pow(10.0, logPriority(rng)));
+  }
+
+  sortPriorities(store);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Creates labels in all directions around the observer. Distances and apparent sizes are
+// distributed logarithmically, so that a few bodies occlude others. The priority of each label is
+// its radius.
+inline void createLabelsAround(std::size_t count, std::mt19937& rng, LabelStore& store) {
+  std::normal_distribution<double>       direction(0.0, 1.0);
+  std::uniform_real_distribution<double> logDistance(3.0, 12.0);
+  std::uniform_real_distribution<double> logSize(-7.0, -2.0);
+
+  store.resize(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    double x = direction(rng);
+    double y = direction(rng);
+    double z = direction(rng);
+
+    double const length   = std::sqrt(x * x + y * y + z * z);
+    double const logDist  = logDistance(rng);
+    double const distance = std::pow(10.0, logDist) / length;
+
+    store.mPositionX[i] = x * distance;
+    store.mPositionY[i] = y * distance;
+    store.mPositionZ[i] = z * distance;
+    store.mRadius[i]    = std::pow(10.0, logDist + logSize(rng));
+    store.mPriority[i]  = store.mRadius[i];
+    store.mFlags[i]     = 0;
+  }
+
+  sortPriorities(store);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Writes the labels rotated by the given angle around the y-axis to the target. This simulates
+// the motion of the camera.
+inline void rotateLabels(LabelStore const& labels, double angle, LabelStore& target) {
+  double const c = std::cos(angle);
+  double const s = std::sin(angle);
+
+  target.resize(labels.size());
+  for (std::size_t i = 0; i < labels.size(); ++i) {
+    target.mPositionX[i] = c * labels.mPositionX[i] + s * labels.mPositionZ[i];
+    target.mPositionY[i] = labels.mPositionY[i];
+    target.mPositionZ[i] = c * labels.mPositionZ[i] - s * labels.mPositionX[i];
+    target.mRadius[i]    = labels.mRadius[i];
+    target.mPriority[i]  = labels.mPriority[i];
+    target.mFlags[i]     = labels.mFlags[i];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The projection and the quadratic overlap test as they were implemented in AnchorLabel and
+// Plugin::update() before the DeclutterEngine existed. Returns 1 for each visible label.
+inline std::vector<uint8_t> computeReference(
+    LabelStore const& store, DeclutterSettings const& settings) {
+  std::vector<BoundingBox> boxes(store.size());
+  std::vector<double>      distances(store.size());
+
+  for (std::size_t i = 0; i < store.size(); ++i) {
+    double x = store.mPositionX[i];
+    double y = store.mPositionY[i];
+    double z = store.mPositionZ[i];
+
+    double const scaledWidth  = LABEL_SCALE * LABEL_WIDTH * 0.0005;
+    double const scaledHeight = LABEL_SCALE * LABEL_HEIGHT * 0.0005;
+
+    boxes[i]     = {x / z - (scaledWidth / 2.0), y / z - (scaledHeight / 2.0), scaledWidth,
+        scaledHeight};
+    distances[i] = std::sqrt(x * x + y * y + z * z);
+  }
+
+  std::vector<std::size_t> order(store.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&store](std::size_t a, std::size_t b) {
+    return store.mPriority[a] > store.mPriority[b];
+  });
+
+  std::vector<std::size_t> drawn;
+  std::vector<uint8_t>     visible(store.size(), 0);
+
+  for (std::size_t i : order) {
+    if (store.isHidden(i)) {
+      continue;
+    }
+
+    bool canBeAdded = true;
+    for (std::size_t j : drawn) {
+      double distA = distances[i];
+      double distB = distances[j];
+      if (settings.mEnableDepthOverlap) {
+        double relativeDistance = distA < distB ? distB / distA : distA / distB;
+        if (relativeDistance > 1 + settings.mIgnoreOverlapThreshold * 0.1) {
+          continue;
+        }
+      }
+
+      if (boxes[i].intersects(boxes[j])) {
+        canBeAdded = false;
+        break;
+      }
+    }
+
+    if (canBeAdded) {
+      drawn.push_back(i);
+      visible[i] = 1;
+    }
+  }
+
+  return visible;
+}
+
+} // namespace csp::anchorlabels::synthetic
+
+#endif // CSP_ANCHOR_LABELS_TESTS_SYNTHETIC_LABELS_HPP
@@ -0,0 +1,179 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// This test culls the labels of points on the surface of an oblate planet, like the ground
+// stations of a point catalog, seen from several distances. The radius of the planet is its
+// equatorial radius, so most points are inside of its sphere. Points facing the observer have to
+// stay visible, points on the far side have to be culled. A moon in front of the planet has to
+// cull the points behind it.
+
+#include "../src/engine/Culler.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace csp::anchorlabels;
+
+namespace {
+
+double const RADIUS     = 6378137.0;
+double const FLATTENING = 1.0 / 298.257;
+
+double const MOON_RADIUS = 0.1 * RADIUS;
+
+uint32_t const PLANET_ID = 1;
+uint32_t const MOON_ID   = 2;
+
+std::size_t const POINT_COUNT = 10000;
+
+struct SurfacePoint {
+  double mX, mY, mZ;    ///< Relative to the center of the planet.
+  double mNX, mNY, mNZ; ///< The normal of the surface.
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Creates points on the surface of the planet up to nine kilometers above sea level.
+std::vector<SurfacePoint> createPoints(std::mt19937& rng) {
+  std::normal_distribution<double>       direction(0.0, 1.0);
+  std::uniform_real_distribution<double> elevation(0.0, 9000.0);
+
+  std::vector<SurfacePoint> points(POINT_COUNT);
+  for (auto& p : points) {
+    double x = direction(rng);
+    double y = direction(rng);
+    double z = direction(rng);
+
+    double const length = std::sqrt(x * x + y * y + z * z);
+    x /= length;
+    y /= length;
+    z /= length;
+
+    // The y-axis is the axis of rotation. The normal of an ellipsoid at a point is the gradient
+    // of its implicit equation.
+    double const a = RADIUS;
+    double const b = RADIUS * (1.0 - FLATTENING);
+    double const h = elevation(rng);
+
+    double nx = x / (a * a);
+    double ny = y / (b * b);
+    double nz = z / (a * a);
+
+    double const scale = 1.0 / std::sqrt(x * x / (a * a) + y * y / (b * b) + z * z / (a * a));
+    double const n     = std::sqrt(nx * nx + ny * ny + nz * nz);
+    nx /= n;
+    ny /= n;
+    nz /= n;
+
+    p = {x * scale + nx * h, y * scale + ny * h, z * scale + nz * h, nx, ny, nz};
+  }
+
+  return points;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Places the planet at the given distance in front of the observer and the moon halfway between
+// the observer and the surface if requested, and culls all labels. Returns false if a point is
+// culled which is clearly visible, or if a point is not culled which is clearly hidden.
+bool test(std::vector<SurfacePoint> const& points, double distance, bool withMoon) {
+  LabelStore labels;
+  labels.resize(points.size() + 2);
+
+  std::size_t const planet = points.size();
+  std::size_t const moon   = points.size() + 1;
+
+  // The moon is placed to the side, so that it does not occlude the center of the planet.
+  double const cz = -distance;
+  double const mx = 2.0 * MOON_RADIUS;
+  double const mz = -0.5 * (distance - RADIUS);
+
+  labels.mPositionZ[planet] = cz;
+  labels.mRadius[planet]    = RADIUS;
+  labels.mBodyId[planet]    = PLANET_ID;
+
+  labels.mPositionX[moon] = mx;
+  labels.mPositionZ[moon] = mz;
+  labels.mRadius[moon]    = MOON_RADIUS;
+  labels.mBodyId[moon]    = MOON_ID;
+  labels.mFlags[moon]     = withMoon ? 0 : eHidden;
+
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    labels.mPositionX[i] = points[i].mX;
+    labels.mPositionY[i] = points[i].mY;
+    labels.mPositionZ[i] = points[i].mZ + cz;
+    labels.mBodyId[i]    = PLANET_ID;
+  }
+
+  Culler culler;
+  culler.cull(labels, 1.0, CullingSettings());
+
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    auto const& p = points[i];
+
+    double const px = labels.mPositionX[i];
+    double const py = labels.mPositionY[i];
+    double const pz = labels.mPositionZ[i];
+    double const pl = std::sqrt(px * px + py * py + pz * pz);
+
+    // The cosine of the angle between the surface normal and the direction to the observer.
+    double const facing = -(p.mNX * px + p.mNY * py + p.mNZ * pz) / pl;
+
+    // The distance between the line of sight and the center of the moon at the depth of the moon.
+    double const t          = mz / pz;
+    double const moonX      = t * px - mx;
+    double const moonY      = t * py;
+    double const moonOffset = std::sqrt(moonX * moonX + moonY * moonY);
+
+    bool const behindMoon = withMoon && moonOffset < 0.9 * MOON_RADIUS;
+    bool const besideMoon = !withMoon || moonOffset > 1.1 * MOON_RADIUS;
+
+    bool const culled = (labels.mFlags[i] & eCulled) != 0;
+
+    if (culled && facing > 0.1 && besideMoon) {
+      std::printf("Distance %.0f km: a visible point was culled!\n", distance * 1e-3);
+      return false;
+    }
+
+    if (!culled && (facing < -0.1 || behindMoon)) {
+      std::printf("Distance %.0f km: a hidden point was not culled!\n", distance * 1e-3);
+      return false;
+    }
+  }
+
+  if ((labels.mFlags[planet] & eCulled) != 0) {
+    std::printf("Distance %.0f km: the planet culled its own label!\n", distance * 1e-3);
+    return false;
+  }
+
+  return true;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  std::mt19937 rng(42); // NOLINT
+
+  auto const points = createPoints(rng);
+
+  bool success = true;
+
+  for (double distance : {1.5 * RADIUS, 3.0 * RADIUS, 60.0 * RADIUS}) {
+    success &= test(points, distance, false);
+    success &= test(points, distance, true);
+  }
+
+  if (!success) {
+    return 1;
+  }
+
+  std::printf("All surface points were culled correctly.\n");
+  return 0;
+}
@@ -0,0 +1,147 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// This test checks that the DeclutterEngine shows the same labels as the projection and the
+// quadratic overlap test which were implemented in AnchorLabel and Plugin::update() before the
+// engine existed. It uses a few hand-made scenes and random label sets with hidden labels, equal
+// priorities and both settings of the depth overlap.
+
+#include "SyntheticLabels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace csp::anchorlabels;
+using namespace csp::anchorlabels::synthetic;
+
+namespace {
+
+// Runs the engine and the reference on the store and prints the first difference.
+bool compare(char const* name, LabelStore& store, DeclutterSettings const& settings) {
+  store.project(LABEL_SCALE, LABEL_WIDTH, LABEL_HEIGHT);
+
+  DeclutterEngine engine;
+  engine.update(store, settings);
+
+  auto const reference = computeReference(store, settings);
+  for (std::size_t i = 0; i < store.size(); ++i) {
+    if (engine.isVisible(i) != (reference[i] != 0)) {
+      std::printf("%s: label %zu is %s, but should be %s!\n", name, i,
+          engine.isVisible(i) ? "visible" : "hidden", reference[i] ? "visible" : "hidden");
+      return false;
+    }
+  }
+
+  // The visible labels are returned once each, sorted by increasing distance.
+  auto const& visible = engine.getVisibleLabels();
+  auto const  count   = std::count(reference.begin(), reference.end(), 1);
+  if (visible.size() != static_cast<std::size_t>(count)) {
+    std::printf("%s: wrong number of visible labels!\n", name);
+    return false;
+  }
+
+  for (std::size_t i = 1; i < visible.size(); ++i) {
+    if (store.mDistance[visible[i]] < store.mDistance[visible[i - 1]]) {
+      std::printf("%s: visible labels are not sorted by distance!\n", name);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Creates labels in front of the observer. A few labels share their priority and a few are hidden.
+void createLabels(std::size_t count, std::mt19937& rng, LabelStore& store) {
+  std::uniform_int_distribution<int> chance(0, 19);
+
+  createLabelsInFront(count, rng, store);
+  for (std::size_t i = 0; i < count; ++i) {
+    if (chance(rng) == 0 && i > 0) {
+      store.mPriority[i] = store.mPriority[i - 1];
+    }
+
+    store.mFlags[i] = chance(rng) == 0 ? eHidden : 0;
+  }
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  DeclutterSettings settings;
+  settings.mIncremental = false;
+
+  bool success = true;
+
+  // Two labels at the same position and distance. Only the one with the higher priority survives,
+  // regardless of the order in the store.
+  {
+    LabelStore store;
+    addLabel(store, 0.0, 0.0, -1e6, 1.0);
+    addLabel(store, 0.0, 0.0, -1e6, 2.0);
+    success &= compare("same position", store, settings);
+  }
+
+  // Two overlapping labels at very different distances are both shown with depth overlap.
+  {
+    LabelStore store;
+    addLabel(store, 0.0, 0.0, -1e6, 2.0);
+    addLabel(store, 0.0, 0.0, -1e9, 1.0);
+
+    settings.mEnableDepthOverlap = true;
+    success &= compare("depth overlap on", store, settings);
+    settings.mEnableDepthOverlap = false;
+    success &= compare("depth overlap off", store, settings);
+  }
+
+  // A hidden label does not hide the labels below it.
+  {
+    LabelStore store;
+    addLabel(store, 0.0, 0.0, -1e6, 2.0, eHidden);
+    addLabel(store, 0.0, 0.0, -1e6, 1.0);
+    success &= compare("hidden label", store, settings);
+  }
+
+  // Labels next to each other which barely touch or barely miss each other.
+  {
+    double const width = LABEL_SCALE * LABEL_WIDTH * 0.0005 * 1e6;
+
+    LabelStore store;
+    addLabel(store, 0.0, 0.0, -1e6, 3.0);
+    addLabel(store, width * 0.999, 0.0, -1e6, 2.0);
+    addLabel(store, -width * 1.001, 0.0, -1e6, 1.0);
+    success &= compare("adjacent labels", store, settings);
+  }
+
+  std::mt19937 rng(42); // NOLINT
+
+  for (std::size_t count : {1, 10, 100, 1000, 5000}) {
+    for (bool depthOverlap : {true, false}) {
+      settings.mEnableDepthOverlap = depthOverlap;
+
+      LabelStore store;
+      createLabels(count, rng, store);
+
+      char name[64];
+      std::snprintf(name, sizeof(name), "%zu random labels, depth overlap %s", count,
+          depthOverlap ? "on" : "off");
+      success &= compare(name, store, settings);
+    }
+  }
+
+  if (!success) {
+    return 1;
+  }
+
+  std::printf("All visible sets match the reference.\n");
+  return 0;
+}
@@ -0,0 +1,95 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// This test runs parallel loops on a WorkerPool whose thread count is changed in between, like it
+// is when the thread count of the plugin is changed in the settings. Each loop has to process every
+// element exactly once and must not return before all workers have finished.
+
+#include "../src/engine/WorkerPool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace csp::anchorlabels;
+
+namespace {
+
+std::size_t const COUNT = 10000;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Runs a loop which increments each element of a vector. The chunks are slowed down, so that a
+// worker which is still running when parallelFor() returns changes the vector afterwards.
+bool runLoop(WorkerPool& pool) {
+  std::vector<std::atomic<int>> counts(COUNT);
+
+  pool.parallelFor(
+      COUNT,
+      [&counts](std::size_t begin, std::size_t end) {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+        for (std::size_t i = begin; i < end; ++i) {
+          ++counts[i];
+        }
+      },
+      16);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  for (auto const& count : counts) {
+    if (count != 1) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+  WorkerPool pool(4);
+
+  for (std::size_t round = 0; round < 20; ++round) {
+    if (!runLoop(pool)) {
+      std::printf("Round %zu: elements were not processed exactly once!\n", round);
+      return 1;
+    }
+
+    // Restart the threads, sometimes with the same number of threads.
+    pool.setThreadCount(2 + round % 3);
+
+    if (!runLoop(pool)) {
+      std::printf("Round %zu: elements were not processed exactly once after a restart!\n", round);
+      return 1;
+    }
+  }
+
+  // An exception in one of the chunks is rethrown on the calling thread and the pool stays usable.
+  bool thrown = false;
+  try {
+    pool.parallelFor(COUNT, [](std::size_t begin, std::size_t /*end*/) {
+      if (begin > COUNT / 2) {
+        throw std::runtime_error("Test");
+      }
+    });
+  } catch (std::runtime_error const&) {
+    thrown = true;
+  }
+
+  if (!thrown || !runLoop(pool)) {
+    std::printf("Exceptions are not handled correctly!\n");
+    return 1;
+  }
+
+  std::printf("All loops processed every element exactly once.\n");
+  return 0;
+}
@@ -0,0 +1,783 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// This tool replays camera paths through the label engine without Vista, CEF or SPICE and reports
+// percentiles of the time needed by each phase of the label update. The paths are recorded by the
+// plugin, see the "cameraPathFile" setting. In addition, a few canonical paths through synthetic
+// scenes can be replayed by name. Besides the timings, the tool counts the visible, culled and
+// tested labels and the overlap tests. These counters do not depend on the machine, so they can
+// be compared to an expected set in continuous integration. The timings can be compared to a
+// baseline which has been recorded on the same machine: If the 99th percentile of any phase got
+// slower than allowed, the tool exits with a non-zero code.
+
+#include "../src/engine/CameraPath.hpp"
+#include "../src/engine/Culler.hpp"
+#include "../src/engine/DeclutterEngine.hpp"
+#include "../src/engine/LabelStore.hpp"
+#include "../src/engine/TraceWriter.hpp"
+#include "../src/engine/UpdateScheduler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace csp::anchorlabels;
+
+namespace {
+
+double const PI = 3.14159265358979323846;
+double const AU = 1.496e11;
+
+std::size_t const NEW_LABEL = std::numeric_limits<std::size_t>::max();
+
+// The size of the labels in pixels, see LabelVisual.
+double const LABEL_WIDTH  = 120.0;
+double const LABEL_HEIGHT = 30.0;
+
+using Vector     = std::array<double, 3>;
+using Quaternion = std::array<double, 4>;
+
+enum Phase { ePositions, eCulling, eDeclutter, eTotal, ePhaseCount };
+
+std::array<char const*, ePhaseCount> const PHASE_NAMES = {
+    "positions", "culling", "declutter", "total"};
+
+enum Counter { eVisible, eCulled, eTested, ePairTests, eCounterCount };
+
+std::array<char const*, eCounterCount> const COUNTER_NAMES = {
+    "visible", "culled", "tested", "pairTests"};
+
+struct Options {
+  std::size_t              mRepeat    = 3;
+  double                   mThreshold = 1.2;
+  double                   mMinChange = 0.05; ///< In milliseconds.
+  std::string              mBaseline;
+  std::string              mSaveBaseline;
+  std::string              mCounters;
+  std::string              mSaveCounters;
+  std::string              mWriteDirectory;
+  std::vector<std::string> mPaths;
+};
+
+/// The result of replaying a path. For each phase, the percentiles are the median over all
+/// repetitions.
+struct Result {
+  std::string mName;
+  std::size_t mFrameCount   = 0;
+  double      mLabelCount   = 0.0; ///< Per frame.
+  double      mVisibleCount = 0.0; ///< Per frame.
+
+  std::array<std::array<double, 4>, ePhaseCount> mPercentiles{}; ///< p50, p90, p99, max.
+
+  /// Summed over all frames. These are the same in each repetition.
+  std::array<uint64_t, eCounterCount> mCounters{};
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Vector add(Vector const& a, Vector const& b) {
+  return {a[0] + b[0], a[1] + b[1], a[2] + b[2]};
+}
+
+Vector scale(Vector const& a, double s) {
+  return {a[0] * s, a[1] * s, a[2] * s};
+}
+
+Vector cross(Vector const& a, Vector const& b) {
+  return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+}
+
+double length(Vector const& a) {
+  return std::sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+}
+
+Vector normalize(Vector const& a) {
+  return scale(a, 1.0 / length(a));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The rotation of an observer at eye which looks at target. Observers look along their negative
+// z-axis, the z-axis of the scene is up.
+Quaternion lookAt(Vector const& eye, Vector const& target) {
+  Vector const z = normalize(add(eye, scale(target, -1.0)));
+  Vector const x = normalize(cross({0.0, 0.0, 1.0}, z));
+  Vector const y = cross(z, x);
+
+  // The conversion of the rotation matrix with the columns x, y and z to a quaternion.
+  double const trace = x[0] + y[1] + z[2];
+  if (trace > 0.0) {
+    double const s = 0.5 / std::sqrt(trace + 1.0);
+    return {(y[2] - z[1]) * s, (z[0] - x[2]) * s, (x[1] - y[0]) * s, 0.25 / s};
+  }
+  if (x[0] > y[1] && x[0] > z[2]) {
+    double const s = 2.0 * std::sqrt(1.0 + x[0] - y[1] - z[2]);
+    return {0.25 * s, (y[0] + x[1]) / s, (z[0] + x[2]) / s, (y[2] - z[1]) / s};
+  }
+  if (y[1] > z[2]) {
+    double const s = 2.0 * std::sqrt(1.0 + y[1] - x[0] - z[2]);
+    return {(y[0] + x[1]) / s, 0.25 * s, (z[1] + y[2]) / s, (z[0] - x[2]) / s};
+  }
+  double const s = 2.0 * std::sqrt(1.0 + z[2] - x[0] - y[1]);
+  return {(z[0] + x[2]) / s, (z[1] + y[2]) / s, 0.25 * s, (x[1] - y[0]) / s};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// A perspective projection with a vertical field of view of 60 degrees and an aspect ratio of
+// 16:9.
+Transform getProjection() {
+  double const aspect = 16.0 / 9.0;
+  double const f      = 1.0 / std::tan(PI / 6.0);
+  double const near   = 0.1;
+  double const far    = 1e10;
+
+  Transform m{};
+  m[0]  = f / aspect;
+  m[5]  = f;
+  m[10] = (far + near) / (near - far);
+  m[11] = -1.0;
+  m[14] = 2.0 * far * near / (near - far);
+
+  return m;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Places the observer at eye, looking at target. Like in CosmoScout VR, the observer is scaled
+// with the distance to the target.
+void setObserver(CameraPathFrame& frame, Vector const& eye, Vector const& target) {
+  frame.mObserverPosition = eye;
+  frame.mObserverRotation = lookAt(eye, target);
+  frame.mObserverScale    = std::max(1.0, 0.01 * length(add(eye, scale(target, -1.0))));
+  frame.mViewProjection   = getProjection();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// A circular orbit around the origin.
+struct Orbit {
+  double mRadius;
+  double mPeriod;      ///< In seconds.
+  double mInclination; ///< In radians.
+  double mNode;        ///< The longitude of the ascending node in radians.
+  double mPhase;       ///< The angle at time zero in radians.
+
+  Vector getPosition(double time) const {
+    double const angle = mPhase + 2.0 * PI * time / mPeriod;
+    double const x     = mRadius * std::cos(angle);
+    double const y     = mRadius * std::sin(angle) * std::cos(mInclination);
+    double const z     = mRadius * std::sin(angle) * std::sin(mInclination);
+
+    return {x * std::cos(mNode) - y * std::sin(mNode), x * std::sin(mNode) + y * std::cos(mNode),
+        z};
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The observer flies past Jupiter and its moons within 25 simulated days, one hour per frame. Half
+// way through, a spacecraft label appears for a while.
+bool writeJupiterFlyby(std::string const& fileName) {
+  CameraPathWriter writer;
+  if (!writer.open(fileName)) {
+    return false;
+  }
+
+  double const gm = 1.26687e17;
+  auto getPeriod  = [gm](double r) { return 2.0 * PI * std::sqrt(r * r * r / gm); };
+
+  // The Galilean moons, followed by many small moons on random orbits.
+  std::vector<std::pair<Orbit, double>> moons = {
+      {{4.217e8, getPeriod(4.217e8), 0.0, 0.0, 0.0}, 1.8216e6},
+      {{6.709e8, getPeriod(6.709e8), 0.008, 0.0, 1.0}, 1.5608e6},
+      {{1.0704e9, getPeriod(1.0704e9), 0.003, 0.0, 2.0}, 2.6341e6},
+      {{1.8827e9, getPeriod(1.8827e9), 0.005, 0.0, 3.0}, 2.4103e6}};
+
+  std::mt19937                           rng(42); // NOLINT
+  std::uniform_real_distribution<double> logRadius(8.1, 10.4);
+  std::uniform_real_distribution<double> logSize(3.0, 5.0);
+  std::uniform_real_distribution<double> angle(0.0, 2.0 * PI);
+  std::uniform_real_distribution<double> inclination(0.0, 0.5 * PI);
+
+  for (std::size_t i = 0; i < 91; ++i) {
+    double const radius = std::pow(10.0, logRadius(rng));
+    moons.push_back(
+        {{radius, getPeriod(radius), inclination(rng), angle(rng), angle(rng)},
+            std::pow(10.0, logSize(rng))});
+  }
+
+  for (std::size_t frameIndex = 0; frameIndex < 600; ++frameIndex) {
+    double const t = static_cast<double>(frameIndex) / 599.0;
+
+    CameraPathFrame frame;
+    frame.mSimulationTime = 3600.0 * static_cast<double>(frameIndex);
+    setObserver(frame, {-4e9 + 8e9 * t, 5e8, 1e8}, {0.0, 0.0, 0.0});
+
+    frame.mLabels.push_back({0, 0, 7.1492e7, 7.1492e7, {0.0, 0.0, 0.0}});
+    for (std::size_t i = 0; i < moons.size(); ++i) {
+      auto const& [orbit, radius] = moons[i];
+      frame.mLabels.push_back({static_cast<uint32_t>(i + 1), 0, radius, radius,
+          orbit.getPosition(frame.mSimulationTime)});
+    }
+
+    if (frameIndex >= 200 && frameIndex < 400) {
+      frame.mLabels.push_back({1000, 0, 10.0, 0.0, add(frame.mObserverPosition, {1e6, 0.0, 0.0})});
+    }
+
+    writer.write(frame);
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The observer starts close to the Earth and zooms out to 15 AU while the simulation time is
+// paused. Apart from the Sun and the planets, twenty thousand asteroids are labeled.
+bool writeCatalogZoomOut(std::string const& fileName) {
+  CameraPathWriter writer;
+  if (!writer.open(fileName)) {
+    return false;
+  }
+
+  std::mt19937                           rng(42); // NOLINT
+  std::uniform_real_distribution<double> angle(0.0, 2.0 * PI);
+  std::uniform_real_distribution<double> unit(-1.0, 1.0);
+  std::uniform_real_distribution<double> logSize(3.0, 5.7);
+
+  std::vector<std::pair<double, double>> const planets = {{0.387 * AU, 2.4397e6},
+      {0.723 * AU, 6.0518e6}, {AU, 6.371e6}, {1.524 * AU, 3.3895e6}, {5.203 * AU, 6.9911e7},
+      {9.537 * AU, 5.8232e7}, {19.19 * AU, 2.5362e7}, {30.07 * AU, 2.4622e7}};
+
+  std::vector<CameraPathLabel> labels;
+  labels.push_back({0, 0, 6.9634e8, 6.9634e8, {0.0, 0.0, 0.0}});
+
+  Vector earth{};
+  for (auto const& [distance, radius] : planets) {
+    double const phi = angle(rng);
+    Vector const p   = {distance * std::cos(phi), distance * std::sin(phi), 0.0};
+    labels.push_back({static_cast<uint32_t>(labels.size()), 0, radius, radius, p});
+    earth = distance == AU ? p : earth;
+  }
+
+  for (std::size_t i = 0; i < 20000; ++i) {
+    double const distance = AU * (2.7 + 0.6 * unit(rng));
+    double const phi      = angle(rng);
+    double const radius   = std::pow(10.0, logSize(rng));
+    labels.push_back({static_cast<uint32_t>(labels.size()), 0, radius, radius,
+        {distance * std::cos(phi), distance * std::sin(phi), 0.1 * distance * unit(rng)}});
+  }
+
+  // The observer moves away from the Sun and upwards, so that the whole belt comes into view.
+  Vector const direction = normalize(add(normalize(earth), {0.0, 0.0, 1.0}));
+
+  for (std::size_t frameIndex = 0; frameIndex < 600; ++frameIndex) {
+    double const t        = static_cast<double>(frameIndex) / 599.0;
+    double const distance = 2e7 * std::pow(15.0 * AU / 2e7, t);
+
+    CameraPathFrame frame;
+    setObserver(frame, add(earth, scale(direction, distance)), {0.0, 0.0, 0.0});
+    frame.mLabels = labels;
+
+    writer.write(frame);
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct CanonicalPath {
+  char const* mName;
+  bool (*mWrite)(std::string const& fileName);
+};
+
+std::vector<CanonicalPath> const CANONICAL_PATHS = {
+    {"jupiter-flyby", writeJupiterFlyby}, {"catalog-zoom-out", writeCatalogZoomOut}};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The matrix which transforms observer-relative positions to the space in which the positions
+// are extrapolated. Like in Plugin::updateLabels(), this is the rotation and scale of the
+// observer.
+Transform getObserverToScheduler(CameraPathFrame const& frame) {
+  Transform m{};
+  for (std::size_t column = 0; column < 3; ++column) {
+    Vector axis{};
+    axis[column] = 1.0;
+
+    Vector const v = add(frame.fromObserver(axis), scale(frame.mObserverPosition, -1.0));
+    for (std::size_t row = 0; row < 3; ++row) {
+      m[column * 4 + row] = v[row];
+    }
+  }
+  m[15] = 1.0;
+
+  return m;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The value below which the given fraction of the values lies. The values are sorted in place.
+double getPercentile(std::vector<double>& values, double fraction) {
+  if (values.empty()) {
+    return 0.0;
+  }
+
+  std::sort(values.begin(), values.end());
+  double const rank = std::ceil(fraction * static_cast<double>(values.size()));
+  return values[std::clamp<std::size_t>(static_cast<std::size_t>(rank), 1, values.size()) - 1];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Runs all frames of the path through the scheduler, the culler and the declutter engine like
+// Plugin::updateLabels() does and stores the duration of each phase per frame in milliseconds.
+bool replay(std::string const& fileName, std::array<std::vector<double>, ePhaseCount>& durations,
+    Result& result) {
+  CameraPathReader reader;
+  if (!reader.open(fileName)) {
+    return false;
+  }
+
+  SchedulerSettings schedulerSettings;
+  CullingSettings   cullingSettings;
+  DeclutterSettings declutterSettings;
+  declutterSettings.mMaxSortKey = 700;
+
+  UpdateScheduler scheduler;
+  Culler          culler;
+  DeclutterEngine engine;
+  LabelStore      store;
+
+  // The index of each label in the previous frame, so that the engine can keep its state when
+  // labels are added or removed.
+  std::unordered_map<uint32_t, std::size_t> indices;
+  std::vector<std::size_t>                  previousIndices;
+
+  for (auto& phase : durations) {
+    phase.clear();
+  }
+
+  result.mFrameCount   = 0;
+  result.mLabelCount   = 0.0;
+  result.mVisibleCount = 0.0;
+  result.mCounters.fill(0);
+
+  CameraPathFrame frame;
+  while (reader.read(frame)) {
+    std::size_t const labelCount = frame.mLabels.size();
+
+    if (frame.mLabelsChanged) {
+      previousIndices.resize(labelCount);
+      for (std::size_t i = 0; i < labelCount; ++i) {
+        auto it            = indices.find(frame.mLabels[i].mId);
+        previousIndices[i] = it != indices.end() ? it->second : NEW_LABEL;
+      }
+
+      indices.clear();
+      for (std::size_t i = 0; i < labelCount; ++i) {
+        indices[frame.mLabels[i].mId] = i;
+      }
+
+      engine.remapLabels(previousIndices);
+      scheduler.remap(previousIndices);
+    }
+
+    std::array<double, ePhaseCount> duration{};
+
+    {
+      ScopedDuration timer(duration[ePositions]);
+
+      for (std::size_t label : engine.getVisibleLabels()) {
+        scheduler.request(label);
+      }
+
+      auto const& dueLabels =
+          scheduler.schedule(labelCount, getObserverToScheduler(frame), false, schedulerSettings);
+
+      for (std::size_t label : dueLabels) {
+        Vector const p = frame.toObserver(frame.mLabels[label].mPosition);
+        scheduler.setPosition(label, p[0], p[1], p[2]);
+      }
+
+      store.resize(labelCount);
+      scheduler.extrapolate(store);
+
+      for (std::size_t i = 0; i < labelCount; ++i) {
+        store.mPriority[i] = frame.mLabels[i].mPriority;
+        store.mRadius[i]   = frame.mLabels[i].mRadius;
+        store.mFlags[i]    = frame.mLabels[i].mFlags;
+      }
+    }
+
+    {
+      ScopedDuration timer(duration[eCulling]);
+      culler.setViewProjection(frame.mViewProjection);
+      culler.cull(store, 1.0 / frame.mObserverScale, cullingSettings);
+    }
+
+    {
+      ScopedDuration timer(duration[eDeclutter]);
+      store.project(frame.mLabelScale, LABEL_WIDTH, LABEL_HEIGHT);
+      engine.update(store, declutterSettings);
+    }
+
+    duration[eTotal] = duration[ePositions] + duration[eCulling] + duration[eDeclutter];
+    for (std::size_t phase = 0; phase < ePhaseCount; ++phase) {
+      durations[phase].push_back(duration[phase]);
+    }
+
+    ++result.mFrameCount;
+    result.mLabelCount += static_cast<double>(labelCount);
+    result.mVisibleCount += static_cast<double>(engine.getVisibleLabels().size());
+
+    result.mCounters[eVisible] += engine.getVisibleLabels().size();
+    result.mCounters[eCulled] += culler.getCulledCount();
+    result.mCounters[eTested] += engine.getTestedLabelCount();
+    result.mCounters[ePairTests] += engine.getPairTestCount();
+  }
+
+  if (result.mFrameCount > 0) {
+    result.mLabelCount /= static_cast<double>(result.mFrameCount);
+    result.mVisibleCount /= static_cast<double>(result.mFrameCount);
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Replays the path several times. For each phase and percentile, the median of all repetitions is
+// used, which makes the result less susceptible to other processes.
+bool measure(std::string const& fileName, std::size_t repeat, Result& result) {
+  std::array<std::array<std::vector<double>, 4>, ePhaseCount> percentiles;
+  std::array<std::vector<double>, ePhaseCount>                durations;
+
+  for (std::size_t i = 0; i < repeat; ++i) {
+    if (!replay(fileName, durations, result)) {
+      return false;
+    }
+
+    for (std::size_t phase = 0; phase < ePhaseCount; ++phase) {
+      percentiles[phase][0].push_back(getPercentile(durations[phase], 0.5));
+      percentiles[phase][1].push_back(getPercentile(durations[phase], 0.9));
+      percentiles[phase][2].push_back(getPercentile(durations[phase], 0.99));
+      percentiles[phase][3].push_back(getPercentile(durations[phase], 1.0));
+    }
+  }
+
+  for (std::size_t phase = 0; phase < ePhaseCount; ++phase) {
+    for (std::size_t i = 0; i < 4; ++i) {
+      result.mPercentiles[phase][i] = getPercentile(percentiles[phase][i], 0.5);
+    }
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The baseline file contains one line per path and phase with the 99th percentile in milliseconds.
+std::map<std::pair<std::string, std::string>, double> readBaseline(std::string const& fileName) {
+  std::map<std::pair<std::string, std::string>, double> baseline;
+
+  std::ifstream file(fileName);
+  std::string   line;
+  while (std::getline(file, line)) {
+    std::istringstream stream(line);
+    std::string        name;
+    std::string        phase;
+    double             p99 = 0.0;
+    if (line.empty() || line[0] == '#' || !(stream >> name >> phase >> p99)) {
+      continue;
+    }
+    baseline[{name, phase}] = p99;
+  }
+
+  return baseline;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool writeBaseline(std::string const& fileName, std::vector<Result> const& results) {
+  std::ofstream file(fileName);
+  if (!file) {
+    return false;
+  }
+
+  file << "# path phase p99 [ms]\n";
+  for (auto const& result : results) {
+    for (std::size_t phase = 0; phase < ePhaseCount; ++phase) {
+      file << result.mName << " " << PHASE_NAMES[phase] << " " << result.mPercentiles[phase][2]
+           << "\n";
+    }
+  }
+
+  return static_cast<bool>(file);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The counter file contains one line per path and counter with the sum over all frames.
+std::map<std::pair<std::string, std::string>, uint64_t> readCounters(std::string const& fileName) {
+  std::map<std::pair<std::string, std::string>, uint64_t> counters;
+
+  std::ifstream file(fileName);
+  std::string   line;
+  while (std::getline(file, line)) {
+    std::istringstream stream(line);
+    std::string        name;
+    std::string        counter;
+    uint64_t           value = 0;
+    if (line.empty() || line[0] == '#' || !(stream >> name >> counter >> value)) {
+      continue;
+    }
+    counters[{name, counter}] = value;
+  }
+
+  return counters;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool writeCounters(std::string const& fileName, std::vector<Result> const& results) {
+  std::ofstream file(fileName);
+  if (!file) {
+    return false;
+  }
+
+  file << "# path counter sum\n";
+  for (auto const& result : results) {
+    for (std::size_t counter = 0; counter < eCounterCount; ++counter) {
+      file << result.mName << " " << COUNTER_NAMES[counter] << " " << result.mCounters[counter]
+           << "\n";
+    }
+  }
+
+  return static_cast<bool>(file);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void printUsage() {
+  std::printf("Usage: csp-anchor-labels-replay [options] [path...]\n\n");
+  std::printf("Replays camera paths through the label engine and prints percentiles of the time\n");
+  std::printf("needed by each phase. A path is either a file recorded by the plugin or the name\n");
+  std::printf("of a canonical path. Without any path, all canonical paths are replayed.\n\n");
+  std::printf("Options:\n");
+  std::printf("  --repeat <n>             Replay each path n times (default: 3).\n");
+  std::printf("  --baseline <file>        Compare the 99th percentiles to this baseline.\n");
+  std::printf("  --threshold <factor>     Allowed slowdown relative to the baseline (1.2).\n");
+  std::printf("  --min-change <ms>        Smaller slowdowns are ignored (0.05).\n");
+  std::printf("  --save-baseline <file>   Write the 99th percentiles as a new baseline.\n");
+  std::printf("  --counters <file>        Compare the counters to the expected ones.\n");
+  std::printf("  --save-counters <file>   Write the counters as the expected ones.\n");
+  std::printf("  --write-canonical <dir>  Write the canonical paths to this directory and exit.\n");
+  std::printf("\n");
+  std::printf("Canonical paths:\n");
+  for (auto const& path : CANONICAL_PATHS) {
+    std::printf("  %s\n", path.mName);
+  }
+  std::printf("\nThe exit code is 1 for invalid arguments, 2 if a phase regressed and 3 if a\n");
+  std::printf("counter differs.\n");
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+  Options options;
+
+  try {
+    for (int i = 1; i < argc; ++i) {
+      std::string const argument = argv[i];
+      bool const        hasValue = i + 1 < argc;
+      if (argument == "--repeat" && hasValue) {
+        options.mRepeat = std::max(1UL, std::stoul(argv[++i]));
+      } else if (argument == "--baseline" && hasValue) {
+        options.mBaseline = argv[++i];
+      } else if (argument == "--threshold" && hasValue) {
+        options.mThreshold = std::stod(argv[++i]);
+      } else if (argument == "--min-change" && hasValue) {
+        options.mMinChange = std::stod(argv[++i]);
+      } else if (argument == "--save-baseline" && hasValue) {
+        options.mSaveBaseline = argv[++i];
+      } else if (argument == "--counters" && hasValue) {
+        options.mCounters = argv[++i];
+      } else if (argument == "--save-counters" && hasValue) {
+        options.mSaveCounters = argv[++i];
+      } else if (argument == "--write-canonical" && hasValue) {
+        options.mWriteDirectory = argv[++i];
+      } else if (argument == "--help" || argument == "-h") {
+        printUsage();
+        return 0;
+      } else if (argument.rfind("--", 0) == 0) {
+        printUsage();
+        return 1;
+      } else {
+        options.mPaths.push_back(argument);
+      }
+    }
+  } catch (std::exception const&) {
+    printUsage();
+    return 1;
+  }
+
+  if (!options.mWriteDirectory.empty()) {
+    for (auto const& path : CANONICAL_PATHS) {
+      auto fileName = (std::filesystem::path(options.mWriteDirectory) / path.mName).string();
+      fileName += ".path";
+      if (!path.mWrite(fileName)) {
+        std::printf("Failed to write '%s'!\n", fileName.c_str());
+        return 1;
+      }
+      std::printf("Wrote '%s'.\n", fileName.c_str());
+    }
+    return 0;
+  }
+
+  if (options.mPaths.empty()) {
+    for (auto const& path : CANONICAL_PATHS) {
+      options.mPaths.emplace_back(path.mName);
+    }
+  }
+
+  std::vector<Result> results;
+
+  std::printf("%-20s %7s %9s %8s %10s %9s %9s %9s %9s\n", "path", "frames", "labels", "visible",
+      "phase", "p50 [ms]", "p90 [ms]", "p99 [ms]", "max [ms]");
+
+  for (auto const& path : options.mPaths) {
+    // Canonical paths are written to a temporary file first, so that they take the same route
+    // through the CameraPathReader as recorded ones.
+    std::string fileName  = path;
+    bool        temporary = false;
+    for (auto const& canonical : CANONICAL_PATHS) {
+      if (path == canonical.mName && !std::filesystem::exists(path)) {
+        fileName = (std::filesystem::temp_directory_path() /
+                    ("csp-anchor-labels-" + path + ".path"))
+                       .string();
+        temporary = true;
+        if (!canonical.mWrite(fileName)) {
+          std::printf("Failed to write '%s'!\n", fileName.c_str());
+          return 1;
+        }
+      }
+    }
+
+    // Recorded paths are named after their file, so that a baseline can be used regardless of
+    // where the files are stored.
+    Result result;
+    result.mName = std::filesystem::path(path).stem().string();
+    bool const success = measure(fileName, options.mRepeat, result);
+
+    if (temporary) {
+      std::filesystem::remove(fileName);
+    }
+
+    if (!success) {
+      std::printf("Failed to read '%s'!\n", path.c_str());
+      return 1;
+    }
+
+    for (std::size_t phase = 0; phase < ePhaseCount; ++phase) {
+      auto const& p = result.mPercentiles[phase];
+      std::printf("%-20s %7zu %9.0f %8.1f %10s %9.3f %9.3f %9.3f %9.3f\n", result.mName.c_str(),
+          result.mFrameCount, result.mLabelCount, result.mVisibleCount, PHASE_NAMES[phase], p[0],
+          p[1], p[2], p[3]);
+    }
+
+    std::printf("%-20s %7s", result.mName.c_str(), "counts");
+    for (std::size_t counter = 0; counter < eCounterCount; ++counter) {
+      std::printf(" %s %llu", COUNTER_NAMES[counter],
+          static_cast<unsigned long long>(result.mCounters[counter]));
+    }
+    std::printf("\n");
+
+    results.push_back(std::move(result));
+  }
+
+  if (!options.mSaveBaseline.empty() && !writeBaseline(options.mSaveBaseline, results)) {
+    std::printf("Failed to write '%s'!\n", options.mSaveBaseline.c_str());
+    return 1;
+  }
+
+  if (!options.mSaveCounters.empty() && !writeCounters(options.mSaveCounters, results)) {
+    std::printf("Failed to write '%s'!\n", options.mSaveCounters.c_str());
+    return 1;
+  }
+
+  // The counters are checked first, as a different result makes the timings meaningless.
+  if (!options.mCounters.empty()) {
+    auto const expected = readCounters(options.mCounters);
+    if (expected.empty()) {
+      std::printf("Failed to read the counters '%s'!\n", options.mCounters.c_str());
+      return 1;
+    }
+
+    // Counters of paths which are not part of the file are not compared.
+    bool differs = false;
+    for (auto const& result : results) {
+      for (std::size_t counter = 0; counter < eCounterCount; ++counter) {
+        auto it = expected.find({result.mName, COUNTER_NAMES[counter]});
+        if (it != expected.end() && it->second != result.mCounters[counter]) {
+          std::printf("Mismatch: %s %s is %llu, expected %llu.\n", result.mName.c_str(),
+              COUNTER_NAMES[counter], static_cast<unsigned long long>(result.mCounters[counter]),
+              static_cast<unsigned long long>(it->second));
+          differs = true;
+        }
+      }
+    }
+
+    if (differs) {
+      return 3;
+    }
+  }
+
+  if (options.mBaseline.empty()) {
+    return 0;
+  }
+
+  auto const baseline = readBaseline(options.mBaseline);
+  if (baseline.empty()) {
+    std::printf("Failed to read the baseline '%s'!\n", options.mBaseline.c_str());
+    return 1;
+  }
+
+  // Phases which are not part of the baseline are not compared.
+  bool regressed = false;
+  for (auto const& result : results) {
+    for (std::size_t phase = 0; phase < ePhaseCount; ++phase) {
+      auto it = baseline.find({result.mName, PHASE_NAMES[phase]});
+      if (it == baseline.end()) {
+        continue;
+      }
+
+      double const p99 = result.mPercentiles[phase][2];
+      if (p99 > it->second * options.mThreshold && p99 - it->second > options.mMinChange) {
+        std::printf("Regression: %s %s p99 is %.3f ms, the baseline is %.3f ms.\n",
+            result.mName.c_str(), PHASE_NAMES[phase], p99, it->second);
+        regressed = true;
+      }
+    }
+  }
+
+  return regressed ? 2 : 0;
+}
@@ -0,0 +1,249 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// This tool converts a CSV or JSON file with labeled points to the binary catalog format which is
+// read by the PointCatalog. See README.md for the accepted input formats.
+
+#include "../src/engine/PointCatalog.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace csp::anchorlabels;
+
+namespace {
+
+/// The default center and frame for entries which do not specify them.
+struct Defaults {
+  std::string mCenter = "Sun";
+  std::string mFrame  = "ECLIPJ2000";
+};
+
+double toNumber(std::string const& value, std::size_t line) {
+  try {
+    std::size_t end    = 0;
+    double      result = std::stod(value, &end);
+    if (end == value.size()) {
+      return result;
+    }
+  } catch (std::exception const&) {
+  }
+  throw std::runtime_error("Invalid number '" + value + "' in line " + std::to_string(line) + ".");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Splits a line of a CSV file. Fields may be enclosed in double quotes, which are escaped by
+// doubling them.
+std::vector<std::string> splitCsvLine(std::string const& line) {
+  std::vector<std::string> fields(1);
+  bool                     quoted = false;
+
+  for (std::size_t i = 0; i < line.size(); ++i) {
+    char const c = line[i];
+    if (quoted) {
+      if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+        fields.back() += '"';
+        ++i;
+      } else if (c == '"') {
+        quoted = false;
+      } else {
+        fields.back() += c;
+      }
+    } else if (c == '"') {
+      quoted = true;
+    } else if (c == ',') {
+      fields.emplace_back();
+    } else if (c != '\r') {
+      fields.back() += c;
+    }
+  }
+
+  return fields;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The first line contains the column names. The columns "name", "x", "y" and "z" are required,
+// "center", "frame" and "priority" are optional, empty fields are replaced by the defaults. Other
+// columns are ignored.
+std::vector<CatalogEntry> readCsv(std::istream& stream, Defaults const& defaults) {
+  std::string line;
+  if (!std::getline(stream, line)) {
+    throw std::runtime_error("The file is empty.");
+  }
+
+  auto const  header  = splitCsvLine(line);
+  std::size_t missing = header.size();
+
+  auto column = [&](std::string const& name) {
+    for (std::size_t i = 0; i < header.size(); ++i) {
+      if (header[i] == name) {
+        return i;
+      }
+    }
+    return missing;
+  };
+
+  std::size_t const name     = column("name");
+  std::size_t const center   = column("center");
+  std::size_t const frame    = column("frame");
+  std::size_t const x        = column("x");
+  std::size_t const y        = column("y");
+  std::size_t const z        = column("z");
+  std::size_t const priority = column("priority");
+
+  if (name == missing || x == missing || y == missing || z == missing) {
+    throw std::runtime_error("The columns 'name', 'x', 'y' and 'z' are required.");
+  }
+
+  std::vector<CatalogEntry> entries;
+  std::size_t               lineNumber = 1;
+
+  while (std::getline(stream, line)) {
+    ++lineNumber;
+    if (line.empty() || line == "\r") {
+      continue;
+    }
+
+    auto fields = splitCsvLine(line);
+    fields.resize(header.size());
+
+    auto field = [&](std::size_t column, std::string const& fallback) {
+      return column != missing && !fields[column].empty() ? fields[column] : fallback;
+    };
+
+    CatalogEntry entry;
+    entry.mName     = fields[name];
+    entry.mCenter   = field(center, defaults.mCenter);
+    entry.mFrame    = field(frame, defaults.mFrame);
+    entry.mPosition = {toNumber(fields[x], lineNumber), toNumber(fields[y], lineNumber),
+        toNumber(fields[z], lineNumber)};
+
+    if (priority != missing && !fields[priority].empty()) {
+      entry.mPriority = static_cast<float>(toNumber(fields[priority], lineNumber));
+    }
+
+    entries.push_back(std::move(entry));
+  }
+
+  return entries;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Reads an array of objects with a name, a position and optionally a center, a frame and a
+/// priority. Other members are ignored.
+std::vector<CatalogEntry> readJson(std::istream& stream, Defaults const& defaults) {
+  nlohmann::json const json = nlohmann::json::parse(stream);
+  if (!json.is_array()) {
+    throw std::runtime_error("Expected an array of entries.");
+  }
+
+  std::vector<CatalogEntry> entries;
+  entries.reserve(json.size());
+
+  for (std::size_t i = 0; i < json.size(); ++i) {
+    auto const& object = json[i];
+    if (!object.is_object() || !object.contains("name") || !object.contains("position")) {
+      throw std::runtime_error(
+          "Entry " + std::to_string(i) + " requires a 'name' and a 'position'.");
+    }
+
+    auto const& position = object.at("position");
+    if (!position.is_array() || position.size() != 3) {
+      throw std::runtime_error("The position of entry " + std::to_string(i) +
+                               " is not an array of three numbers.");
+    }
+
+    CatalogEntry entry;
+    entry.mName     = object.at("name").get<std::string>();
+    entry.mCenter   = object.value("center", defaults.mCenter);
+    entry.mFrame    = object.value("frame", defaults.mFrame);
+    entry.mPriority = object.value("priority", entry.mPriority);
+
+    for (std::size_t j = 0; j < 3; ++j) {
+      entry.mPosition[j] = position[j].get<double>();
+    }
+
+    entries.push_back(std::move(entry));
+  }
+
+  return entries;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void printUsage() {
+  std::printf("Usage: csp-anchor-labels-catalog-converter [--center <name>] [--frame <name>] "
+              "<input.csv|input.json> <output>\n\n");
+  std::printf("The center and frame are used for entries which do not specify them. They default "
+              "to 'Sun' and 'ECLIPJ2000'.\n");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv) {
+  Defaults                 defaults;
+  std::vector<std::string> files;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string const argument = argv[i];
+    if (argument == "--center" && i + 1 < argc) {
+      defaults.mCenter = argv[++i];
+    } else if (argument == "--frame" && i + 1 < argc) {
+      defaults.mFrame = argv[++i];
+    } else if (argument == "--help" || argument == "-h") {
+      printUsage();
+      return 0;
+    } else {
+      files.push_back(argument);
+    }
+  }
+
+  if (files.size() != 2) {
+    printUsage();
+    return 1;
+  }
+
+  std::ifstream input(files[0], std::ios::binary);
+  if (!input) {
+    std::printf("Failed to open '%s'!\n", files[0].c_str());
+    return 1;
+  }
+
+  std::vector<CatalogEntry> entries;
+
+  try {
+    std::string const& fileName = files[0];
+    if (fileName.size() >= 5 && fileName.compare(fileName.size() - 5, 5, ".json") == 0) {
+      entries = readJson(input, defaults);
+    } else {
+      entries = readCsv(input, defaults);
+    }
+  } catch (std::exception const& e) {
+    std::printf("Failed to read '%s': %s\n", files[0].c_str(), e.what());
+    return 1;
+  }
+
+  if (!PointCatalog::write(files[1], entries)) {
+    std::printf("Failed to write '%s'!\n", files[1].c_str());
+    return 1;
+  }
+
+  std::printf("Wrote %zu entries to '%s'.\n", entries.size(), files[1].c_str());
+
+  return 0;
+}